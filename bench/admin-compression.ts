@@ -0,0 +1,136 @@
+/**
+ * Admin compression trade-off. A relay (forked, so its CPU can be
+ * measured on its own) holds many sessions while followers join and leave.
+ * Each join or leave sends a dashboard on /admin the full session list.
+ * The bench reports wire bytes against relay CPU for several deflate
+ * settings, and the size of GET /sessions with and without gzip.
+ *
+ *   npx tsx bench/admin-compression.ts [sessions] [churn]
+ */
+import { fork } from 'child_process';
+import { fileURLToPath } from 'url';
+import { get } from 'http';
+import WebSocket from 'ws';
+import type { AdminCompressionOptions } from '../src/relay-server/compression.js';
+
+const SESSIONS = Number(process.argv[2] ?? 100);
+const CHURN = Number(process.argv[3] ?? 300);
+
+const print = (line: string) => process.stdout.write(line + '\n');
+console.log = () => {};
+
+const sleep = (ms: number) => new Promise(resolve => setTimeout(resolve, ms));
+
+// Child: the relay under test
+if (process.argv[2] === 'relay') {
+  const { RelayServer } = await import('../src/relay-server/relay-server.js');
+  const { DEFAULT_COMPRESSION_OPTIONS } = await import('../src/relay-server/compression.js');
+  const admin: AdminCompressionOptions = JSON.parse(process.argv[3]);
+  const relay = new RelayServer(0, {
+    host: '127.0.0.1',
+    sessions: { maxSessionsPerIp: 100000, maxOwnerlessSessions: 100000 },
+    compression: { ...DEFAULT_COMPRESSION_OPTIONS, admin }
+  });
+  await relay.start();
+  let mark = process.cpuUsage();
+  process.on('message', (message: string) => {
+    if (message === 'mark') {
+      mark = process.cpuUsage();
+      process.send!({});
+    }
+    if (message === 'cpu') {
+      const { user, system } = process.cpuUsage(mark);
+      process.send!({ cpuMs: (user + system) / 1000, rssMB: process.memoryUsage().rss / 1e6 });
+    }
+  });
+  process.send!({ port: relay.address() });
+} else {
+  const settings: Record<string, AdminCompressionOptions> = {
+    off: { enabled: false, level: 0, windowBits: 15, memLevel: 8, threshold: 0 },
+    'level1-w12': { enabled: true, level: 1, windowBits: 12, memLevel: 7, threshold: 1024 },
+    'level1-w15': { enabled: true, level: 1, windowBits: 15, memLevel: 7, threshold: 1024 },
+    'level6-w15 (default)': { enabled: true, level: 6, windowBits: 15, memLevel: 7, threshold: 1024 },
+    'level9-w15': { enabled: true, level: 9, windowBits: 15, memLevel: 8, threshold: 1024 }
+  };
+
+  const results: Record<string, any> = {};
+  for (const [name, admin] of Object.entries(settings)) {
+    const child = fork(fileURLToPath(import.meta.url), ['relay', JSON.stringify(admin)], { stdio: ['ignore', 'ignore', 'inherit', 'ipc'] });
+    const request = (message: string) => new Promise<any>(resolve => { child.once('message', resolve); child.send(message); });
+    const { port } = await new Promise<any>(resolve => child.once('message', resolve));
+    const base = `127.0.0.1:${port}`;
+
+    const tokens: string[] = [];
+    for (let i = 0; i < SESSIONS; i++) {
+      const response = await fetch(`http://${base}/create-session`, { method: 'POST' });
+      tokens.push((await response.json()).token);
+    }
+
+    // A session is removed when its last client leaves, so each keeps one follower
+    const join = (token: string, onJoined: (follower: WebSocket) => void) => {
+      const follower = new WebSocket(`ws://${base}`);
+      follower.on('open', () => follower.send(JSON.stringify({ type: 'JOIN', sessionToken: token, role: 'follower' })));
+      follower.on('message', (data: Buffer) => {
+        if (JSON.parse(data.toString()).type === 'JOINED') onJoined(follower);
+      });
+      return follower;
+    };
+    const residents = await Promise.all(tokens.map(token => new Promise<WebSocket>(resolve => join(token, resolve))));
+
+    const dashboard = new WebSocket(`ws://${base}/admin`);
+    await new Promise(resolve => dashboard.on('open', resolve));
+    let payloadBytes = 0;
+    let updates = 0;
+    dashboard.on('message', (data: Buffer) => {
+      payloadBytes += data.length;
+      updates++;
+    });
+    dashboard.send(JSON.stringify({ type: 'ADMIN_SUBSCRIBE', filter: { events: ['sessions'] } }));
+    await sleep(100);
+
+    const wireBefore = (dashboard as any)._socket.bytesRead;
+    payloadBytes = 0;
+    updates = 0;
+    await request('mark');
+
+    // Followers join a session and leave again, 20 at a time
+    for (let i = 0; i < CHURN; i += 20) {
+      await Promise.all(Array.from({ length: Math.min(20, CHURN - i) }, (_, j) => new Promise<void>(resolve => {
+        join(tokens[(i + j) % SESSIONS], follower => follower.close()).on('close', () => resolve());
+      })));
+    }
+    let last = -1;
+    while (updates !== last) {
+      last = updates;
+      await sleep(200);
+    }
+
+    const { cpuMs, rssMB } = await request('cpu');
+    const wireBytes = (dashboard as any)._socket.bytesRead - wireBefore;
+    // Join/leave timing varies a little between runs, so compare per update
+    results[name] = {
+      updates,
+      payloadBytesPerUpdate: Math.round(payloadBytes / updates),
+      wireBytesPerUpdate: Math.round(wireBytes / updates),
+      ratio: +(payloadBytes / wireBytes).toFixed(1),
+      relayCpuMs: Math.round(cpuMs),
+      relayRssMB: Math.round(rssMB)
+    };
+
+    const sizeOf = (gzip: boolean) => new Promise<number>(resolve => {
+      get({ host: '127.0.0.1', port, path: '/sessions', headers: gzip ? { 'Accept-Encoding': 'gzip' } : {} }, response => {
+        let bytes = 0;
+        response.on('data', (chunk: Buffer) => { bytes += chunk.length; });
+        response.on('end', () => resolve(bytes));
+      });
+    });
+    if (name === 'off') results.httpSessions = { plainKB: +((await sizeOf(false)) / 1024).toFixed(1), gzipKB: +((await sizeOf(true)) / 1024).toFixed(1) };
+
+    dashboard.close();
+    residents.forEach(follower => follower.close());
+    child.kill();
+  }
+
+  print(JSON.stringify({ sessions: SESSIONS, churn: CHURN, results }, null, 2));
+  process.exit(0);
+}
@@ -0,0 +1,90 @@
+/**
+ * Admin feed cost: many sessions heartbeat and push status while three
+ * admins watch. An unscoped admin, one scoped to a single session, and one
+ * that only wants warnings. Reports messages and bytes each admin receives
+ * for the traffic, against the events the session manager emitted (each
+ * heartbeat used to reach every admin as a SESSIONS_UPDATE plus a debug
+ * ACTIVITY line).
+ *
+ *   npx tsx bench/admin-feed.ts [sessions]
+ */
+import { SessionManager } from '../src/relay-server/session-manager.js';
+import { OutboundQueue } from '../src/relay-server/outbound-queue.js';
+import type { RelaySocket } from '../src/relay-server/outbound-queue.js';
+import { AdminFeed } from '../src/relay-server/admin-feed.js';
+import type { AdminFilter } from '../src/relay-server/admin-feed.js';
+
+const SESSIONS = Number(process.argv[2] ?? 200);
+const ROUNDS = 20;          // heartbeat rounds, one per simulated 30s
+const INTERVAL_MS = 100;    // traffic flush interval for the bench
+
+const print = (line: string) => process.stdout.write(line + '\n');
+console.log = () => {};
+
+const sleep = (ms: number) => new Promise(resolve => setTimeout(resolve, ms));
+
+function queue(onSend?: (data: string) => void): OutboundQueue {
+  const socket: RelaySocket = {
+    readyState: 1,
+    bufferedAmount: 0,
+    send: (data, cb) => { onSend?.(data); cb?.(); },
+    close: () => {},
+    terminate: () => {}
+  };
+  return new OutboundQueue(socket);
+}
+
+const manager = new SessionManager({ maxSessionsPerIp: SESSIONS, maxOwnerlessSessions: SESSIONS });
+const feed = new AdminFeed(manager, INTERVAL_MS);
+
+// Same wiring as RelayServer
+let emitted = 0;
+manager.on('session_created', (payload: any) => { emitted++; feed.sessionChanged(payload.token, 'session_created', payload); });
+manager.on('session_updated', (payload: any) => { emitted++; feed.sessionChanged(payload.token, 'session_updated', payload); });
+manager.on('activity', (payload: any) => { emitted++; feed.activity(payload.sessionToken, payload.level, payload); });
+manager.on('traffic', (payload: any) => { emitted++; feed.count(payload.sessionToken, payload.kind); });
+
+const admins: Record<string, { messages: number; bytes: number; types: Record<string, number> }> = {};
+function admin(name: string, filter?: AdminFilter): void {
+  const stats = { messages: 0, bytes: 0, types: {} as Record<string, number> };
+  admins[name] = stats;
+  feed.subscribe({}, queue(data => {
+    stats.messages++;
+    stats.bytes += data.length;
+    const type = JSON.parse(data).type;
+    stats.types[type] = (stats.types[type] ?? 0) + 1;
+  }), filter);
+}
+
+const clients: string[] = [];
+const tokens: string[] = [];
+for (let i = 0; i < SESSIONS; i++) {
+  const { token } = manager.findOrCreateSessionByIp(`10.0.${i >> 8}.${i & 255}`, queue(), `controller${i}`, 'controller')!;
+  manager.joinSession(token, queue(), `follower${i}`, 'follower');
+  clients.push(`controller${i}`, `follower${i}`);
+  tokens.push(token);
+}
+
+admin('unscoped');
+admin('oneSession', { sessions: [tokens[0]] });
+admin('warningsOnly', { events: ['activity'], minLevel: 'warn' });
+
+emitted = 0;
+for (let round = 0; round < ROUNDS; round++) {
+  clients.forEach(id => manager.updateHeartbeat(id));
+  for (let i = 0; i < SESSIONS; i++) manager.broadcastStatus(`controller${i}`, { clientRunning: true, processCount: 8 });
+  for (let i = 0; i < SESSIONS; i++) manager.forwardGameStatus(`follower${i}`, false);
+}
+await sleep(INTERVAL_MS * 1.5);
+
+print(JSON.stringify({
+  sessions: SESSIONS,
+  events: emitted,
+  // Before: SESSIONS_UPDATE + ACTIVITY per heartbeat, ACTIVITY per status/game-status push
+  messagesPerAdminBefore: ROUNDS * (clients.length * 2 + SESSIONS * 2),
+  admins
+}, null, 2));
+
+feed.dispose();
+manager.dispose();
+process.exit(admins.oneSession.types.TRAFFIC_COUNTS === 1 && !admins.warningsOnly.messages ? 0 : 1);
@@ -0,0 +1,121 @@
+/**
+ * Acknowledged command delivery. A follower that loses the first copy of
+ * every command gets it redelivered; a controller that repeats each command
+ * under the same ID (as after a reconnect) never makes a follower launch
+ * twice. Reports relay retries/duplicates, follower handler runs and the
+ * controller's ack and completion latency. A burst of finished commands
+ * past maxCommands must not evict one a follower has not acked yet.
+ *
+ *   npx tsx bench/command-ack.ts
+ */
+import WebSocket from 'ws';
+import { RelayServer } from '../src/relay-server/relay-server.js';
+import { SessionClient } from '../src/controller/session-client.js';
+import { CommandTracker } from '../src/relay-server/command-tracker.js';
+import type { OutboundQueue } from '../src/relay-server/outbound-queue.js';
+import { metrics } from '../src/shared/metrics.js';
+
+const COMMANDS = 50;
+const LAUNCH_MS = 20;
+
+const print = (line: string) => process.stdout.write(line + '\n');
+console.log = () => {};
+
+const sleep = (ms: number) => new Promise(resolve => setTimeout(resolve, ms));
+
+const relay = new RelayServer(0, { host: '127.0.0.1', commands: { initialDelayMs: 20 } });
+await relay.start();
+const port = relay.address();
+
+const controller = new SessionClient('127.0.0.1', port, 'controller');
+let token: string | undefined;
+controller.setJoinedCallback(joined => { token = joined; });
+await controller.connect();
+while (!token) await sleep(5);
+
+// Well-behaved follower: a "launch" takes LAUNCH_MS
+const follower = new SessionClient('127.0.0.1', port, 'follower');
+let joined = false;
+let runs = 0;
+follower.setJoinedCallback(() => { joined = true; });
+follower.setClientRestartedCallback(async () => {
+  runs++;
+  await sleep(LAUNCH_MS);
+  return { ok: true, detail: 'client launched' };
+});
+await follower.connect(token);
+while (!joined) await sleep(5);
+
+// Lossy follower: ignores the first copy of each command
+const lossy = new WebSocket(`ws://127.0.0.1:${port}`);
+const seen = new Set<string>();
+let lossyRuns = 0;
+await new Promise(resolve => lossy.on('open', resolve));
+lossy.on('message', (data: Buffer) => {
+  const message = JSON.parse(data.toString());
+  if (message.type !== 'CLIENT_RESTARTED') return;
+  if (!seen.has(message.commandId)) {
+    seen.add(message.commandId);
+    return;
+  }
+  lossyRuns++;
+  lossy.send(JSON.stringify({ type: 'COMMAND_ACK', commandId: message.commandId, stage: 'completed', ok: true }));
+});
+lossy.send(JSON.stringify({ type: 'JOIN', sessionToken: token, role: 'follower' }));
+await sleep(50);
+
+const ids: string[] = [];
+for (let i = 0; i < COMMANDS; i++) {
+  const commandId = controller.broadcastRestart();
+  controller.broadcastRestart(commandId);
+  ids.push(commandId);
+  await sleep(5);
+}
+
+const done = () => ids.every(id => {
+  const summary = controller.commandSummary(id);
+  return summary && summary.followers === 2 && summary.completed === 2;
+});
+const deadline = Date.now() + 10000;
+while (!done() && Date.now() < deadline) await sleep(20);
+
+// Eviction: one unacked command, then a burst of finished ones past the cap
+const tracker = new CommandTracker({ initialDelayMs: 20, maxAttempts: 5, maxCommands: 8 });
+let stuckSends = 0;
+const stuckQueue = { enqueue: () => { stuckSends++; } } as unknown as OutboundQueue;
+const sink = { enqueue: () => {} } as unknown as OutboundQueue;
+tracker.begin('evict', 'stuck', 'CLIENT_RESTARTED');
+tracker.deliver('evict', 'stuck', 'silent', stuckQueue, '{}');
+for (let i = 0; i < 100; i++) {
+  tracker.begin('evict', `done-${i}`, 'CLIENT_RESTARTED');
+  tracker.deliver('evict', `done-${i}`, 'acker', sink, '{}');
+  tracker.ack('evict', 'acker', `done-${i}`, 'completed');
+}
+await sleep(100);
+const pendingKept = tracker.has('evict', 'stuck') && stuckSends > 1;
+tracker.dispose();
+
+const snapshot = metrics.snapshot();
+const round = (value: number) => +value.toFixed(1);
+const ack = snapshot.histograms['controller.commands.ack_ms'];
+const complete = snapshot.histograms['controller.commands.complete_ms'];
+const result = {
+  commands: COMMANDS,
+  allCompleted: done(),
+  followerRuns: runs,
+  lossyFollowerRuns: lossyRuns,
+  relayIssued: snapshot.counters['relay.commands.issued'],
+  relayDuplicates: snapshot.counters['relay.commands.duplicates'],
+  relayRetries: snapshot.counters['relay.commands.retries'],
+  ackP50Ms: round(ack.p50),
+  completeP50Ms: round(complete.p50),
+  completeP99Ms: round(complete.p99),
+  pendingKeptPastCap: pendingKept
+};
+print(JSON.stringify(result, null, 2));
+
+lossy.close();
+follower.disconnect();
+controller.disconnect();
+await relay.stop();
+process.exit(result.allCompleted && runs === COMMANDS && lossyRuns === COMMANDS && pendingKept ? 0 : 1);
@@ -0,0 +1,25 @@
+namespace LeagueMonitor.Core;
+
+/// <summary>
+/// Same surface as the app's Logger, written to stderr instead of the
+/// WPF log view; stdout carries the driver's event lines
+/// </summary>
+public class Logger
+{
+    private readonly string _source;
+
+    public Logger(string source)
+    {
+        _source = source;
+    }
+
+    public void Info(string message) => Write("INFO", message);
+    public void Warn(string message) => Write("WARN", message);
+    public void Error(string message) => Write("ERROR", message);
+    public void Error(string message, Exception ex) => Write("ERROR", $"{message}: {ex.Message}");
+    public void Success(string message) => Write("SUCCESS", message);
+    public void Debug(string message) => Write("DEBUG", message);
+
+    private void Write(string level, string message) =>
+        Console.Error.WriteLine($"[{DateTime.Now:HH:mm:ss}] [{_source}] [{level}] {message}");
+}
@@ -0,0 +1,92 @@
+using LeagueMonitor.Configuration;
+using LeagueMonitor.Network;
+using Newtonsoft.Json;
+using Newtonsoft.Json.Linq;
+
+namespace LeagueMonitor.ConformanceDriver;
+
+/// <summary>
+/// Conformance driver for the C# RelayClient. Reports client events on
+/// stdout as "@driver &lt;event&gt; [json]" lines and takes actions as JSON
+/// lines on stdin ({"do": "restart", "commandId": "..."}).
+/// </summary>
+public static class Program
+{
+    private static readonly object _outputLock = new();
+
+    private static void Report(string ev, object? fields = null)
+    {
+        lock (_outputLock)
+        {
+            Console.Out.WriteLine(fields == null ? $"@driver {ev}" : $"@driver {ev} {JsonConvert.SerializeObject(fields)}");
+            Console.Out.Flush();
+        }
+    }
+
+    public static async Task Main()
+    {
+        var relay = AppConfig.Instance.Relay;
+        relay.Host = Environment.GetEnvironmentVariable("RELAY_HOST") ?? "127.0.0.1";
+        relay.Port = int.Parse(Environment.GetEnvironmentVariable("RELAY_PORT") ?? "8080");
+        relay.UseTls = false;
+        relay.Endpoints.Clear();
+        relay.Multiplex = false;
+
+        var role = Environment.GetEnvironmentVariable("ROLE") == "controller" ? ClientRole.controller : ClientRole.follower;
+        using var client = new RelayClient(role);
+        client.OnJoined += (token, _) => Report("joined", new { sessionToken = token });
+        // Command handlers take this long (and then report commandDone) when set
+        var handlerDelayMs = int.TryParse(Environment.GetEnvironmentVariable("HANDLER_DELAY_MS"), out var delay) ? delay : 0;
+        Func<Task<CommandOutcome>> Handle(string type) => async () =>
+        {
+            Report("command", new { type });
+            if (handlerDelayMs > 0)
+            {
+                await Task.Delay(handlerDelayMs);
+                Report("commandDone", new { type });
+            }
+            return new CommandOutcome(true);
+        };
+        client.OnImmediateStart += Handle("IMMEDIATE_START");
+        client.OnClientRestarted += Handle("CLIENT_RESTARTED");
+        client.OnStatusUpdate += status => Report("statusUpdate", new { status });
+        client.OnStatusRequest += () =>
+        {
+            Report("statusRequest");
+            return Task.FromResult(new ClientStatus { ClientRunning = true, ProcessCount = 3 });
+        };
+        client.OnFollowerGameStatusChanged += running => Report("gameStatus", new { gameRunning = running });
+
+        var token = Environment.GetEnvironmentVariable("SESSION_TOKEN");
+        var connection = client.ConnectAsync(string.IsNullOrEmpty(token) ? null : token);
+        Report("ready", new { pid = Environment.ProcessId });
+
+        string? line;
+        while ((line = await Console.In.ReadLineAsync()) != null)
+        {
+            var action = JObject.Parse(line);
+            var commandId = action.Value<string>("commandId");
+            switch (action.Value<string>("do"))
+            {
+                case "restart":
+                    await client.BroadcastRestartAsync(commandId);
+                    break;
+                case "immediateStart":
+                    await client.BroadcastImmediateStartAsync(commandId);
+                    break;
+                case "status":
+                    await client.SendStatusAsync(action.Value<bool>("clientRunning"), action.Value<int>("processCount"));
+                    break;
+                case "gameStatus":
+                    await client.SendGameStatusAsync(action.Value<bool>("gameRunning"));
+                    break;
+                case "exit":
+                    return;
+                default:
+                    Report("unsupported", new { action = action.Value<string>("do") });
+                    break;
+            }
+        }
+        await connection;
+    }
+}
@@ -0,0 +1,92 @@
+"""Conformance driver for the Python RelayClient.
+
+Reports client events on stdout as "@driver <event> [json]" lines and takes
+actions as JSON lines on stdin ({"do": "restart", "commandId": "..."}).
+
+    RELAY_HOST=127.0.0.1 RELAY_PORT=9080 ROLE=follower [SESSION_TOKEN=...] [HANDLER_DELAY_MS=...] python bench/conformance/drivers/python_driver.py
+"""
+
+import asyncio
+import json
+import os
+import sys
+from pathlib import Path
+
+# Client logs go to stdout by default; keep that for the driver's lines only
+_events = sys.stdout
+sys.stdout = sys.stderr
+
+sys.path.insert(0, str(Path(__file__).resolve().parents[3] / "python"))
+
+from league_monitor.config import get_config  # noqa: E402
+from league_monitor.relay_client import ClientRole, RelayClient  # noqa: E402
+
+
+def report(event: str, fields: dict | None = None) -> None:
+    line = f"@driver {event}" + (f" {json.dumps(fields)}" if fields is not None else "")
+    print(line, file=_events, flush=True)
+
+
+async def read_actions(client: RelayClient) -> None:
+    loop = asyncio.get_running_loop()
+    while True:
+        line = await loop.run_in_executor(None, sys.stdin.readline)
+        if not line:
+            return
+        action = json.loads(line)
+        if action["do"] == "restart":
+            await client.broadcast_restart(action.get("commandId"))
+        elif action["do"] == "immediateStart":
+            await client.broadcast_immediate_start(action.get("commandId"))
+        elif action["do"] == "status":
+            await client.send_status(action["clientRunning"], action["processCount"])
+        elif action["do"] == "exit":
+            os._exit(0)
+        else:
+            report("unsupported", {"action": action["do"]})
+
+
+async def main() -> None:
+    config = get_config()
+    config.relay.host = os.environ.get("RELAY_HOST", "127.0.0.1")
+    config.relay.port = int(os.environ.get("RELAY_PORT", "8080"))
+    config.relay.tls = False
+    config.relay.endpoints = []
+    config.relay.multiplex = False
+
+    role = ClientRole.CONTROLLER if os.environ.get("ROLE") == "controller" else ClientRole.FOLLOWER
+    client = RelayClient(role)
+    client.on_joined(lambda token, info: report("joined", {"sessionToken": token}))
+    # Command handlers take this long (and then report commandDone) when set
+    handler_delay = int(os.environ.get("HANDLER_DELAY_MS") or 0) / 1000
+
+    def handle(command_type: str):
+        def handler():
+            report("command", {"type": command_type})
+            if handler_delay:
+                return finish(command_type)
+            return None
+
+        return handler
+
+    async def finish(command_type: str) -> None:
+        await asyncio.sleep(handler_delay)
+        report("commandDone", {"type": command_type})
+
+    client.on_immediate_start(handle("IMMEDIATE_START"))
+    client.on_client_restarted(handle("CLIENT_RESTARTED"))
+    client.on_status_update(lambda status: report("statusUpdate", {"status": status}))
+
+    def status_request() -> dict:
+        report("statusRequest")
+        return {"clientRunning": True, "processCount": 3}
+
+    client.on_status_request(status_request)
+
+    asyncio.create_task(read_actions(client))
+    report("ready", {"pid": os.getpid()})
+    await client.connect(os.environ.get("SESSION_TOKEN") or None)
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
@@ -0,0 +1,56 @@
+/**
+ * Conformance driver for the TS SessionClient. Reports client events on
+ * stdout as "@driver <event> [json]" lines and takes actions as JSON lines
+ * on stdin ({"do": "restart", "commandId": "..."}).
+ *
+ *   RELAY_HOST=127.0.0.1 RELAY_PORT=9080 ROLE=follower [SESSION_TOKEN=...] [HANDLER_DELAY_MS=...] npx tsx bench/conformance/drivers/ts-driver.ts
+ */
+import readline from 'readline';
+import { SessionClient } from '../../../src/controller/session-client.js';
+
+const report = (event: string, fields?: object) =>
+  process.stdout.write(`@driver ${event}${fields ? ' ' + JSON.stringify(fields) : ''}\n`);
+console.log = () => {};
+console.warn = () => {};
+console.error = () => {};
+
+const role = process.env.ROLE === 'controller' ? 'controller' : 'follower';
+// Command handlers take this long (and then report commandDone) when set
+const handlerDelayMs = Number(process.env.HANDLER_DELAY_MS || 0);
+const handle = (type: string) => async () => {
+  report('command', { type });
+  if (!handlerDelayMs) return;
+  await new Promise(resolve => setTimeout(resolve, handlerDelayMs));
+  report('commandDone', { type });
+};
+const client = new SessionClient(process.env.RELAY_HOST ?? '127.0.0.1', Number(process.env.RELAY_PORT ?? 8080), role);
+client.setJoinedCallback(sessionToken => report('joined', { sessionToken }));
+client.setImmediateStartCallback(handle('IMMEDIATE_START'));
+client.setClientRestartedCallback(handle('CLIENT_RESTARTED'));
+client.setStatusRequestCallback(async () => {
+  report('statusRequest');
+  return { clientRunning: true, processCount: 3 };
+});
+// No callbacks for STATUS_UPDATE or GAME_STATUS; those scenarios are known gaps
+
+readline.createInterface({ input: process.stdin }).on('line', line => {
+  const action = JSON.parse(line);
+  switch (action.do) {
+    case 'restart':
+      client.broadcastRestart(action.commandId);
+      break;
+    case 'immediateStart':
+      client.broadcastImmediateStart(action.commandId);
+      break;
+    case 'status':
+      client.sendStatus(action.clientRunning, action.processCount);
+      break;
+    case 'exit':
+      process.exit(0);
+    default:
+      report('unsupported', { action: action.do });
+  }
+});
+
+await client.connect(process.env.SESSION_TOKEN || undefined);
+report('ready', { pid: process.pid });
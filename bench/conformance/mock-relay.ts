@@ -0,0 +1,123 @@
+import { WebSocketServer, WebSocket } from 'ws';
+
+export interface Frame {
+  message: any;
+  at: number; // performance.now() on arrival
+  connection: number;
+}
+
+/**
+ * A relay stand-in for conformance scenarios: accepts one client at a time,
+ * greets it with CONNECTED like the real relay and otherwise only does what
+ * the scenario script tells it to. Everything the client sends is kept as
+ * timestamped frames that the script consumes with expect().
+ */
+export class MockRelay {
+  private server: WebSocketServer;
+  private socket?: WebSocket;
+  private frames: Frame[] = [];
+  private waiters: Array<() => void> = [];
+  private connectionCount = 0;
+
+  constructor() {
+    this.server = new WebSocketServer({ host: '127.0.0.1', port: 0, maxPayload: 64 * 1024 * 1024 });
+    this.server.on('connection', socket => {
+      const connection = ++this.connectionCount;
+      this.socket = socket;
+      socket.on('message', (data: Buffer) => {
+        let message: any;
+        try {
+          message = JSON.parse(data.toString());
+        } catch {
+          message = { type: 'UNPARSEABLE', raw: data.toString().slice(0, 200) };
+        }
+        this.frames.push({ message, at: performance.now(), connection });
+        this.wake();
+      });
+      socket.on('error', () => {});
+      socket.send(JSON.stringify({ type: 'CONNECTED', clientId: `mock-${connection}`, message: 'Connected to relay server' }));
+      this.wake();
+    });
+  }
+
+  listen(): Promise<number> {
+    return new Promise(resolve => {
+      if (this.server.address()) resolve(this.port);
+      else this.server.once('listening', () => resolve(this.port));
+    });
+  }
+
+  get port(): number {
+    return (this.server.address() as { port: number }).port;
+  }
+
+  get connections(): number {
+    return this.connectionCount;
+  }
+
+  /**
+   * Resolve once the client has opened its nth connection
+   */
+  async connection(n: number, timeoutMs: number): Promise<void> {
+    await this.until(() => this.connectionCount >= n, timeoutMs, `connection #${n}`);
+  }
+
+  /**
+   * Take the oldest unconsumed frame of a type (and matching a predicate)
+   */
+  async expect(type: string, timeoutMs: number, match: (message: any) => boolean = () => true): Promise<Frame> {
+    let found: Frame | undefined;
+    await this.until(() => {
+      const index = this.frames.findIndex(frame => frame.message.type === type && match(frame.message));
+      if (index === -1) return false;
+      found = this.frames.splice(index, 1)[0];
+      return true;
+    }, timeoutMs, type);
+    return found!;
+  }
+
+  /**
+   * Unconsumed frames of a type so far
+   */
+  count(type: string, match: (message: any) => boolean = () => true): number {
+    return this.frames.filter(frame => frame.message.type === type && match(frame.message)).length;
+  }
+
+  send(message: object | string): void {
+    this.socket?.send(typeof message === 'string' ? message : JSON.stringify(message));
+  }
+
+  /**
+   * Cut the client off without a close handshake, like a dead link
+   */
+  drop(): void {
+    this.socket?.terminate();
+    this.socket = undefined;
+  }
+
+  close(): Promise<void> {
+    this.server.clients.forEach(client => client.terminate());
+    return new Promise(resolve => this.server.close(() => resolve()));
+  }
+
+  private async until(done: () => boolean, timeoutMs: number, what: string): Promise<void> {
+    const deadline = performance.now() + timeoutMs;
+    while (!done()) {
+      const left = deadline - performance.now();
+      if (left <= 0) throw new Error(`no ${what} within ${timeoutMs}ms`);
+      await new Promise<void>(resolve => {
+        const timer = setTimeout(resolve, left);
+        this.waiters.push(() => {
+          clearTimeout(timer);
+          resolve();
+        });
+      });
+    }
+  }
+
+  private wake(): void {
+    const waiters = this.waiters;
+    this.waiters = [];
+    waiters.forEach(wake => wake());
+  }
+}
@@ -0,0 +1,511 @@
+/**
+ * Relay protocol conformance for the TS, Python and C# clients.
+ *
+ * Each scenario starts a MockRelay and a fresh driver process for the
+ * client under test (bench/conformance/drivers), then plays the relay's
+ * side from a script: joins, auto-join errors, a stale token, command
+ * bursts with duplicates, a dropped connection (also mid-command), large
+ * and oversized frames, status and game status. A scenario passes when the client sends
+ * and reports what the real relay and the other clients expect.
+ *
+ * Besides correctness it records, per client and scenario, the command
+ * handling latency seen from the relay (command sent to COMMAND_ACK
+ * received), and the driver's CPU time and resident memory from /proc, so
+ * the clients can be compared and a regression in one of them stands out.
+ *
+ *   npx tsx bench/conformance/scenarios.ts [--clients ts,python,csharp] [--only join,burst] [--driver ts="<command>"]
+ *
+ * Known differences between the clients are listed per scenario as gaps:
+ * they are reported as "gap" instead of failing the run, and as
+ * "gap-closed" once the client passes so the entry can be removed.
+ * Linux only (/proc); no GUI is started, the drivers wrap the bare clients.
+ */
+import { spawn, spawnSync } from 'child_process';
+import type { ChildProcess } from 'child_process';
+import { readFileSync } from 'fs';
+import readline from 'readline';
+import { Histogram } from '../../src/shared/metrics.js';
+import { MockRelay } from './mock-relay.js';
+
+const DRIVERS: Record<string, string> = {
+  ts: 'npx tsx bench/conformance/drivers/ts-driver.ts',
+  python: `${process.env.PYTHON ?? 'python3'} bench/conformance/drivers/python_driver.py`,
+  csharp: 'dotnet run --no-build -c Release --project bench/conformance/drivers/csharp'
+};
+// Run once before a client's scenarios; failing makes the client unavailable
+const PREPARE: Record<string, string> = {
+  csharp: 'dotnet build -c Release bench/conformance/drivers/csharp'
+};
+
+const args = process.argv.slice(2);
+const flag = (name: string) => {
+  const index = args.indexOf(`--${name}`);
+  return index >= 0 ? args[index + 1] : undefined;
+};
+args.forEach((arg, index) => {
+  if (arg !== '--driver') return;
+  const [name, ...command] = args[index + 1].split('=');
+  DRIVERS[name] = command.join('=');
+  delete PREPARE[name];
+});
+const clients = (flag('clients') ?? 'ts,python,csharp').split(',');
+const only = flag('only')?.split(',');
+
+const print = (line: string) => process.stdout.write(line + '\n');
+console.log = () => {};
+
+const sleep = (ms: number) => new Promise(resolve => setTimeout(resolve, ms));
+const round = (ms: number) => +ms.toFixed(1);
+
+interface DriverEvent {
+  event: string;
+  fields: any;
+  at: number;
+}
+
+/**
+ * Client process under test, as a queue of timestamped "@driver" events
+ */
+class Driver {
+  private child: ChildProcess;
+  private events: DriverEvent[] = [];
+  private seen: Map<string, number> = new Map();
+  private waiters: Array<() => void> = [];
+  exited = false;
+
+  constructor(command: string, env: Record<string, string>) {
+    this.child = spawn(command, {
+      shell: true,
+      env: { ...process.env, PYTHONDONTWRITEBYTECODE: '1', ...env },
+      stdio: ['pipe', 'pipe', 'ignore'],
+      detached: true // own process group, so stop() reaches past the shell
+    });
+    this.child.on('exit', () => {
+      this.exited = true;
+      this.wake();
+    });
+    readline.createInterface({ input: this.child.stdout! }).on('line', line => {
+      if (!line.startsWith('@driver ')) return;
+      const space = line.indexOf(' ', 8);
+      const event = space === -1 ? line.slice(8) : line.slice(8, space);
+      this.events.push({ event, fields: space === -1 ? {} : JSON.parse(line.slice(space + 1)), at: performance.now() });
+      this.seen.set(event, this.count(event) + 1);
+      this.wake();
+    });
+  }
+
+  /**
+   * Events of this type reported so far, consumed or not
+   */
+  count(event: string): number {
+    return this.seen.get(event) ?? 0;
+  }
+
+  /**
+   * Take the oldest unconsumed event of a type, or undefined on timeout
+   */
+  async next(event: string, timeoutMs: number, match: (fields: any) => boolean = () => true): Promise<DriverEvent | undefined> {
+    const deadline = performance.now() + timeoutMs;
+    for (;;) {
+      const index = this.events.findIndex(e => e.event === event && match(e.fields));
+      if (index !== -1) return this.events.splice(index, 1)[0];
+      const left = deadline - performance.now();
+      if (left <= 0 || this.exited) return undefined;
+      await new Promise<void>(resolve => {
+        const timer = setTimeout(resolve, left);
+        this.waiters.push(() => {
+          clearTimeout(timer);
+          resolve();
+        });
+      });
+    }
+  }
+
+  do(action: object): void {
+    this.child.stdin!.write(JSON.stringify(action) + '\n');
+  }
+
+  stop(): void {
+    try {
+      process.kill(-this.child.pid!);
+    } catch {
+      // already gone
+    }
+  }
+
+  private wake(): void {
+    const waiters = this.waiters;
+    this.waiters = [];
+    waiters.forEach(wake => wake());
+  }
+}
+
+// CPU time and memory of the driver process (the client itself, not the shell or launcher)
+function usage(pid: number): { cpuMs: number; rssMb: number; peakRssMb: number } {
+  const stat = readFileSync(`/proc/${pid}/stat`, 'utf8');
+  const fields = stat.slice(stat.lastIndexOf(')') + 2).split(' ');
+  const ticks = Number(fields[11]) + Number(fields[12]); // utime + stime
+  const status = readFileSync(`/proc/${pid}/status`, 'utf8');
+  const kb = (name: string) => Number(status.match(new RegExp(`^${name}:\\s+(\\d+)`, 'm'))?.[1] ?? 0);
+  return { cpuMs: ticks * 10, rssMb: +(kb('VmRSS') / 1024).toFixed(1), peakRssMb: +(kb('VmHWM') / 1024).toFixed(1) };
+}
+
+interface Context {
+  relay: MockRelay;
+  driver: Driver;
+  role: 'controller' | 'follower';
+  token?: string;
+}
+
+interface Scenario {
+  name: string;
+  role: 'controller' | 'follower';
+  token?: string; // given to the client at startup; none means auto-join by IP
+  env?: Record<string, string>; // extra driver environment, e.g. HANDLER_DELAY_MS
+  gaps?: Record<string, string>; // client -> known difference
+  run: (ctx: Context) => Promise<object>;
+}
+
+const TOKEN = 'CONF1234';
+
+function check(condition: unknown, failure: string): asserts condition {
+  if (!condition) throw new Error(failure);
+}
+
+const joined = (role: string, sessionToken: string, autoJoined?: boolean) =>
+  ({ type: 'JOINED', role, sessionToken, sessionInfo: { hasController: true, followerCount: 1 }, ...(autoJoined ? { autoJoined } : {}) });
+
+/**
+ * Answer the client's JOIN and wait until it reports being in the session
+ */
+async function join(ctx: Context, timeoutMs: number = 5000): Promise<number> {
+  const start = performance.now();
+  const frame = await ctx.relay.expect('JOIN', timeoutMs);
+  check(frame.message.role === ctx.role, `JOIN role ${frame.message.role}, expected ${ctx.role}`);
+  check((frame.message.sessionToken ?? undefined) === ctx.token, `JOIN token ${frame.message.sessionToken}, expected ${ctx.token}`);
+  ctx.relay.send(joined(ctx.role, ctx.token ?? TOKEN, !ctx.token));
+  check(await ctx.driver.next('joined', 3000, fields => fields.sessionToken === (ctx.token ?? TOKEN)), 'client did not report JOINED');
+  return performance.now() - start;
+}
+
+let commandSeq = 0;
+const commandId = () => `cmd-${++commandSeq}`;
+const COMMAND_TYPES = ['IMMEDIATE_START', 'CLIENT_RESTARTED'];
+
+const isAck = (id: string, stage: string) => (message: any) => message.commandId === id && message.stage === stage;
+
+const latencySummary = (histogram: Histogram) => {
+  const { count, p50, p99, max } = histogram.snapshot();
+  return { count, p50Ms: round(p50), p99Ms: round(p99), maxMs: round(max) };
+};
+
+/**
+ * Send one command and time it to the client's "received" ack
+ */
+async function ackLatency(ctx: Context, type: string, extra: object = {}, timeoutMs: number = 3000): Promise<number> {
+  const id = commandId();
+  const start = performance.now();
+  ctx.relay.send({ type, commandId: id, ...extra });
+  const ack = await ctx.relay.expect('COMMAND_ACK', timeoutMs, isAck(id, 'received'));
+  return ack.at - start;
+}
+
+const scenarios: Scenario[] = [
+  {
+    name: 'join',
+    role: 'follower',
+    token: TOKEN,
+    run: async ctx => ({ joinMs: round(await join(ctx)) })
+  },
+  {
+    name: 'auto-join-retry',
+    role: 'follower',
+    // No session for this IP yet: the relay answers with an error and the follower keeps retrying
+    run: async ctx => {
+      const first = await ctx.relay.expect('JOIN', 5000);
+      check(!first.message.sessionToken, 'first JOIN should have no token');
+      ctx.relay.send({ type: 'ERROR', message: 'No session found for your IP. Please provide a session token or start controller first.' });
+      const retry = await ctx.relay.expect('JOIN', 10_000);
+      check(!retry.message.sessionToken, 'retried JOIN should have no token');
+      ctx.relay.send(joined('follower', TOKEN, true));
+      check(await ctx.driver.next('joined', 3000), 'client did not report JOINED');
+      return { retryAfterMs: Math.round(retry.at - first.at) };
+    }
+  },
+  {
+    name: 'stale-token',
+    role: 'controller',
+    token: 'STALE000',
+    gaps: {
+      python: 'only a follower without a token retries after a session error',
+      csharp: 'only a follower without a token retries after a session error'
+    },
+    run: async ctx => {
+      const first = await ctx.relay.expect('JOIN', 5000);
+      ctx.relay.send({ type: 'ERROR', message: 'Session not found' });
+      const retry = await ctx.relay.expect('JOIN', 8000);
+      check(!retry.message.sessionToken, 'controller should fall back to auto-join by IP');
+      return { fallbackAfterMs: Math.round(retry.at - first.at) };
+    }
+  },
+  {
+    name: 'commands',
+    role: 'follower',
+    token: TOKEN,
+    // One at a time: handling latency without queueing
+    run: async ctx => {
+      await join(ctx);
+      const latency = new Histogram(100);
+      for (let i = 0; i < 100; i++) latency.record(await ackLatency(ctx, COMMAND_TYPES[i % 2]));
+      await sleep(500); // let handler reports land
+      check(ctx.driver.count('command') === 100, `handler ran ${ctx.driver.count('command')} times for 100 commands`);
+      return { ack: latencySummary(latency) };
+    }
+  },
+  {
+    name: 'burst',
+    role: 'follower',
+    token: TOKEN,
+    // Back to back, every tenth command delivered twice (as a relay retry would)
+    run: async ctx => {
+      await join(ctx);
+      const unique = 500;
+      const sent: Array<{ id: string; at: number }> = [];
+      const start = performance.now();
+      for (let i = 0; i < unique; i++) {
+        const id = commandId();
+        const message = JSON.stringify({ type: COMMAND_TYPES[i % 2], commandId: id });
+        ctx.relay.send(message);
+        sent.push({ id, at: performance.now() });
+        if (i % 10 === 0) {
+          ctx.relay.send(message);
+          sent.push({ id, at: performance.now() });
+        }
+      }
+
+      const latency = new Histogram(sent.length);
+      for (const { id, at } of sent) {
+        const ack = await ctx.relay.expect('COMMAND_ACK', 15_000, isAck(id, 'received'));
+        latency.record(ack.at - at);
+      }
+      const elapsed = performance.now() - start;
+      await sleep(1000);
+      const completed = new Set<string>();
+      while (ctx.relay.count('COMMAND_ACK', m => m.stage === 'completed') > 0) {
+        completed.add((await ctx.relay.expect('COMMAND_ACK', 0, m => m.stage === 'completed')).message.commandId);
+      }
+      check(ctx.driver.count('command') === unique, `handler ran ${ctx.driver.count('command')} times for ${unique} unique commands`);
+      check(completed.size === unique, `${completed.size} of ${unique} commands acked as completed`);
+      return { frames: sent.length, commandsPerSec: Math.round(sent.length / (elapsed / 1000)), ack: latencySummary(latency) };
+    }
+  },
+  {
+    name: 'disconnect',
+    role: 'controller',
+    token: TOKEN,
+    // The link dies and the controller issues a RESTART while it is down
+    run: async ctx => {
+      await join(ctx);
+      const id = commandId();
+      const start = performance.now();
+      ctx.relay.drop();
+      await sleep(50);
+      ctx.driver.do({ do: 'restart', commandId: id });
+      await ctx.relay.connection(2, 10_000);
+      const rejoinMs = await join(ctx);
+      const restart = await ctx.relay.expect('RESTART', 3000, message => message.commandId === id);
+      return { rejoinMs: round(rejoinMs), commandDeliveredMs: Math.round(restart.at - start) };
+    }
+  },
+  {
+    name: 'ack-after-drop',
+    role: 'follower',
+    token: TOKEN,
+    env: { HANDLER_DELAY_MS: '1000' },
+    // The link dies while a command runs. The relay drops that delivery with the connection,
+    // so the completed ack must not be replayed on the next one (it would match nothing)
+    run: async ctx => {
+      await join(ctx);
+      const id = commandId();
+      ctx.relay.send({ type: 'CLIENT_RESTARTED', commandId: id });
+      await ctx.relay.expect('COMMAND_ACK', 3000, isAck(id, 'received'));
+      ctx.relay.drop();
+      check(await ctx.driver.next('commandDone', 5000), 'handler did not finish');
+      await ctx.relay.connection(2, 15_000);
+      const rejoinMs = await join(ctx);
+      await sleep(1000);
+      const replayed = ctx.relay.count('COMMAND_ACK', message => message.commandId === id);
+      check(replayed === 0, `${replayed} ack(s) of the dropped delivery sent after the rejoin`);
+      return { rejoinMs: round(rejoinMs) };
+    }
+  },
+  {
+    name: 'large-frame',
+    role: 'follower',
+    token: TOKEN,
+    gaps: { csharp: 'the receive loop parses each 8KB read as a whole message' },
+    // A 256KB command (e.g. a long detail string) must still parse
+    run: async ctx => {
+      await join(ctx);
+      return { ackMs: round(await ackLatency(ctx, 'IMMEDIATE_START', { padding: 'x'.repeat(256 * 1024) })) };
+    }
+  },
+  {
+    name: 'oversized-frame',
+    role: 'follower',
+    token: TOKEN,
+    // 4MB of junk status: the client may reject it or even reconnect, but has to carry on
+    run: async ctx => {
+      await join(ctx);
+      ctx.relay.send({ type: 'STATUS_UPDATE', status: { clientRunning: true, processCount: 1, padding: 'x'.repeat(4 * 1024 * 1024) } });
+      const id = commandId();
+      ctx.relay.send({ type: 'IMMEDIATE_START', commandId: id });
+      const start = performance.now();
+      const acked = await ctx.relay.expect('COMMAND_ACK', 2000, isAck(id, 'received')).catch(() => undefined);
+      if (acked) return { reconnected: false, ackMs: round(acked.at - start) };
+
+      // Dropped the connection over it: redeliver after the rejoin, as the relay would
+      await ctx.relay.connection(2, 10_000);
+      await join(ctx);
+      ctx.relay.send({ type: 'IMMEDIATE_START', commandId: id });
+      const redelivered = await ctx.relay.expect('COMMAND_ACK', 3000, isAck(id, 'received'));
+      return { reconnected: true, ackMs: round(redelivered.at - start) };
+    }
+  },
+  {
+    name: 'status-request',
+    role: 'controller',
+    token: TOKEN,
+    run: async ctx => {
+      await join(ctx);
+      const start = performance.now();
+      ctx.relay.send({ type: 'STATUS_REQUEST' });
+      const reply = await ctx.relay.expect('STATUS_UPDATE', 3000);
+      check(reply.message.status?.clientRunning === true && reply.message.status?.processCount === 3,
+        `unexpected status ${JSON.stringify(reply.message.status)}`);
+      return { replyMs: round(reply.at - start) };
+    }
+  },
+  {
+    name: 'status-update',
+    role: 'follower',
+    token: TOKEN,
+    gaps: { ts: 'SessionClient only logs STATUS_UPDATE, there is no callback' },
+    run: async ctx => {
+      await join(ctx);
+      ctx.relay.send({ type: 'STATUS_UPDATE', status: { clientRunning: false, processCount: 2 } });
+      const update = await ctx.driver.next('statusUpdate', 3000);
+      check(update?.fields.status?.processCount === 2, 'client did not report the status update');
+      return {};
+    }
+  },
+  {
+    name: 'game-status-in',
+    role: 'controller',
+    token: TOKEN,
+    gaps: {
+      ts: 'SessionClient does not handle GAME_STATUS',
+      python: 'RelayClient does not handle GAME_STATUS'
+    },
+    run: async ctx => {
+      await join(ctx);
+      ctx.relay.send({ type: 'GAME_STATUS', gameRunning: true });
+      check(await ctx.driver.next('gameStatus', 3000, fields => fields.gameRunning === true), 'client did not report the game status');
+      return {};
+    }
+  },
+  {
+    name: 'game-status-out',
+    role: 'follower',
+    token: TOKEN,
+    gaps: {
+      ts: 'SessionClient cannot send GAME_STATUS',
+      python: 'RelayClient cannot send GAME_STATUS'
+    },
+    run: async ctx => {
+      await join(ctx);
+      ctx.driver.do({ do: 'gameStatus', gameRunning: true });
+      const frame = await ctx.relay.expect('GAME_STATUS', 3000);
+      check(frame.message.gameRunning === true, 'GAME_STATUS without gameRunning');
+      return {};
+    }
+  }
+];
+
+interface Result {
+  scenario: string;
+  result: 'pass' | 'fail' | 'gap' | 'gap-closed';
+  detail?: string;
+  cpuMs?: number;
+  rssMb?: number;
+  peakRssMb?: number;
+  [measurement: string]: unknown;
+}
+
+async function runScenario(client: string, scenario: Scenario): Promise<Result> {
+  const relay = new MockRelay();
+  const port = await relay.listen();
+  const driver = new Driver(DRIVERS[client], {
+    RELAY_HOST: '127.0.0.1',
+    RELAY_PORT: String(port),
+    ROLE: scenario.role,
+    SESSION_TOKEN: scenario.token ?? '',
+    ...scenario.env
+  });
+  const gap = scenario.gaps?.[client];
+  try {
+    const ready = await driver.next('ready', 60_000);
+    if (!ready) throw new Error(`driver did not start (${DRIVERS[client]})`);
+    const pid: number = ready.fields.pid;
+    const before = usage(pid);
+    const measured = await Promise.race([
+      scenario.run({ relay, driver, role: scenario.role, token: scenario.token }),
+      sleep(60_000).then(() => { throw new Error('scenario timed out'); })
+    ]);
+    const after = usage(pid);
+    return {
+      scenario: scenario.name,
+      result: gap ? 'gap-closed' : 'pass',
+      ...measured,
+      cpuMs: after.cpuMs - before.cpuMs,
+      rssMb: after.rssMb,
+      peakRssMb: after.peakRssMb
+    };
+  } catch (error) {
+    const detail = error instanceof Error ? error.message : String(error);
+    return gap ? { scenario: scenario.name, result: 'gap', detail: `${gap} (${detail})` } : { scenario: scenario.name, result: 'fail', detail };
+  } finally {
+    driver.do({ do: 'exit' });
+    driver.stop();
+    await relay.close();
+  }
+}
+
+const report: Record<string, object> = {};
+let failed = false;
+
+for (const client of clients) {
+  if (!DRIVERS[client]) {
+    print(`Unknown client "${client}", expected one of ${Object.keys(DRIVERS).join(', ')} or --driver ${client}="<command>"`);
+    failed = true;
+    continue;
+  }
+  if (PREPARE[client] && spawnSync(PREPARE[client], { shell: true, stdio: 'ignore' }).status !== 0) {
+    print(`${client}: unavailable (${PREPARE[client]} failed)`);
+    report[client] = { unavailable: PREPARE[client] };
+    continue;
+  }
+
+  const results: Result[] = [];
+  for (const scenario of scenarios.filter(s => !only || only.includes(s.name))) {
+    const result = await runScenario(client, scenario);
+    if (result.result === 'fail') failed = true;
+    results.push(result);
+    print(`${client} ${scenario.name}: ${JSON.stringify(result)}`);
+  }
+  const tally = (kind: Result['result']) => results.filter(r => r.result === kind).length;
+  report[client] = { pass: tally('pass'), fail: tally('fail'), gap: tally('gap'), gapClosed: tally('gap-closed'), results };
+}
+
+print(JSON.stringify(report, null, 2));
+process.exit(failed ? 1 : 0);
@@ -0,0 +1,262 @@
+/**
+ * Relay failover under load. The primary relay runs in a child process;
+ * sessions of one controller and a few followers send a RESTART per
+ * session every INTERVAL_MS, and the primary is killed (SIGKILL) midway.
+ * Two setups:
+ *
+ *   restart   no standby; the primary is started again right away (as pm2
+ *             would) and clients reconnect on their own timers
+ *   standby   a hot standby in a second child process follows the primary's
+ *             replication stream; clients list both in relayEndpoints
+ *
+ * Reports, from the kill: when each follower ran its first command again,
+ * when every client had rejoined, and how many follower deliveries of the
+ * commands issued were never run.
+ *
+ * Then pauses the primary (SIGSTOP) instead of killing it: a pause shorter
+ * than timeoutMs must not make the standby take over; a longer one does,
+ * and the primary must step down once it resumes (SIGCONT) and follow the
+ * relay that took over. Last, that relay is restarted with its original
+ * config (as pm2 would): one of the two must end up serving and the other
+ * following it.
+ *
+ *   npx tsx bench/hot-standby.ts
+ */
+import { spawn } from 'child_process';
+import type { ChildProcess } from 'child_process';
+import { mkdtempSync, rmSync } from 'fs';
+import { tmpdir } from 'os';
+import { join } from 'path';
+import { RelayServer } from '../src/relay-server/relay-server.js';
+import { SessionClient } from '../src/controller/session-client.js';
+import { RelaySelector } from '../src/shared/relay-endpoints.js';
+
+const PRIMARY_PORT = 18191;
+const STANDBY_PORT = 18192;
+const SESSIONS = 20;
+const FOLLOWERS = 3;
+const INTERVAL_MS = 200;
+const KILL_AFTER_MS = 3000;
+const RUN_AFTER_KILL_MS = 10_000;
+const DRAIN_MS = 3000;
+const SECRET = 'bench-replication';
+const TIMEOUT_MS = 5000; // the replication timeoutMs default
+
+const print = (line: string) => process.stdout.write(line + '\n');
+console.log = () => {};
+console.warn = () => {};
+console.error = () => {};
+
+const sleep = (ms: number) => new Promise(resolve => setTimeout(resolve, ms));
+
+function startRelay(port: number, mode: 'plain' | 'primary' | 'standby'): Promise<ChildProcess> {
+  const child = spawn(process.execPath, [...process.execArgv, process.argv[1], 'relay', String(port), mode], { stdio: ['pipe', 'pipe', 'inherit'] });
+  return new Promise(resolve => child.stdout!.once('data', () => resolve(child)));
+}
+
+async function metricsOf(port: number): Promise<any> {
+  return (await fetch(`http://127.0.0.1:${port}/metrics`)).json();
+}
+
+const percentile = (values: number[], q: number) => {
+  const sorted = [...values].sort((a, b) => a - b);
+  return sorted.length ? sorted[Math.min(sorted.length - 1, Math.floor(q * sorted.length))] : NaN;
+};
+
+async function run(setup: 'restart' | 'standby') {
+  resetState();
+  let primary = await startRelay(PRIMARY_PORT, setup === 'standby' ? 'primary' : 'plain');
+  let standby: ChildProcess | undefined;
+  if (setup === 'standby') {
+    standby = await startRelay(STANDBY_PORT, 'standby');
+    while ((await metricsOf(PRIMARY_PORT)).gauges['relay.replication.standbys']?.value !== 1) await sleep(50);
+  }
+
+  const endpoints = [{ host: '127.0.0.1', port: PRIMARY_PORT }, { host: '127.0.0.1', port: STANDBY_PORT }];
+  const clients: SessionClient[] = [];
+  const controllers: SessionClient[] = [];
+  const handled: number[] = [];            // per follower, commands run in the measured window
+  const firstAfterKill: number[] = [];     // per follower, ms from the kill to its first command
+  const followerSession: number[] = [];
+  let measuring = false;
+  let killedAt = 0;
+  let rejoinedAt = 0;
+  const rejoined: Set<SessionClient> = new Set();
+
+  const connect = async (client: SessionClient, token?: string) => {
+    client.setJoinedCallback(() => {
+      if (!killedAt) return;
+      rejoined.add(client);
+      if (rejoined.size === clients.length && !rejoinedAt) rejoinedAt = performance.now();
+    });
+    clients.push(client);
+    await client.connect(token);
+  };
+
+  for (let s = 0; s < SESSIONS; s++) {
+    // One selector per session: its controller and followers share a machine's view of the relays
+    const selector = setup === 'standby' ? new RelaySelector(endpoints, { probeIntervalMs: 0, samples: 1 }) : undefined;
+    // Every bench client shares one IP, so sessions come from POST /create-session rather than auto-join
+    const { token } = await (await fetch(`http://127.0.0.1:${PRIMARY_PORT}/create-session`, { method: 'POST' })).json() as { token: string };
+    const controller = new SessionClient('127.0.0.1', PRIMARY_PORT, 'controller');
+    if (selector) controller.useRelaySelector(selector, () => ({}));
+    await connect(controller, token);
+    while (!controller.connected()) await sleep(10);
+    controllers.push(controller);
+
+    for (let f = 0; f < FOLLOWERS; f++) {
+      const index = handled.length;
+      handled.push(0);
+      followerSession.push(s);
+      const follower = new SessionClient('127.0.0.1', PRIMARY_PORT, 'follower');
+      if (selector) follower.useRelaySelector(selector, () => ({}));
+      follower.setClientRestartedCallback(() => {
+        if (!measuring) return;
+        handled[index]++;
+        if (killedAt && firstAfterKill[index] === undefined) firstAfterKill[index] = performance.now() - killedAt;
+      });
+      await connect(follower, token);
+    }
+  }
+  await sleep(1000);
+
+  const issued = new Array(SESSIONS).fill(0);
+  measuring = true;
+  const sender = setInterval(() => controllers.forEach((controller, s) => {
+    controller.broadcastRestart();
+    issued[s]++;
+  }), INTERVAL_MS);
+
+  await sleep(KILL_AFTER_MS);
+  const lag = setup === 'standby' ? (await metricsOf(STANDBY_PORT)).histograms['relay.replication.lag_ms'] : undefined;
+  killedAt = performance.now();
+  primary.kill('SIGKILL');
+  if (setup === 'restart') primary = await startRelay(PRIMARY_PORT, 'plain');
+  await sleep(RUN_AFTER_KILL_MS);
+  clearInterval(sender);
+  await sleep(DRAIN_MS);
+  measuring = false;
+
+  const replayed = setup === 'standby' ? (await metricsOf(STANDBY_PORT)).counters['relay.replication.replayed'] : 0;
+  const expected = issued.reduce((sum, n) => sum + n * FOLLOWERS, 0);
+  const run = handled.reduce((sum, n) => sum + n, 0);
+  const recovered = firstAfterKill.filter(ms => ms !== undefined);
+
+  clients.forEach(client => client.disconnect());
+  primary.kill('SIGKILL');
+  standby?.kill('SIGKILL');
+  await sleep(200);
+
+  return {
+    lag,
+    followersRecovered: `${recovered.length}/${handled.length}`,
+    firstCommandP50: percentile(recovered, 0.5),
+    firstCommandMax: recovered.length ? Math.max(...recovered) : NaN,
+    allRejoinedMs: rejoinedAt ? rejoinedAt - killedAt : NaN,
+    expected,
+    lost: expected - run,
+    replayed
+  };
+}
+
+async function healthOf(port: number): Promise<string> {
+  try {
+    return ((await (await fetch(`http://127.0.0.1:${port}/health`)).json()) as { status: string }).status;
+  } catch {
+    return 'down';
+  }
+}
+
+async function waitForHealth(port: number, status: string, timeoutMs: number): Promise<number> {
+  const started = performance.now();
+  while (performance.now() - started < timeoutMs) {
+    if (await healthOf(port) === status) return performance.now() - started;
+    await sleep(100);
+  }
+  throw new Error(`relay on ${port} did not report '${status}' within ${timeoutMs}ms`);
+}
+
+// Replication state files of the bench relays; each setup starts without any
+const stateDir = process.env.BENCH_STATE_DIR ?? mkdtempSync(join(tmpdir(), 'hot-standby-'));
+process.env.BENCH_STATE_DIR = stateDir;
+const resetState = () => [PRIMARY_PORT, STANDBY_PORT].forEach(port => rmSync(join(stateDir, `replication-${port}.json`), { force: true }));
+
+async function pauseCheck() {
+  resetState();
+  const primary = await startRelay(PRIMARY_PORT, 'primary');
+  const standby = await startRelay(STANDBY_PORT, 'standby');
+  while ((await metricsOf(PRIMARY_PORT)).gauges['relay.replication.standbys']?.value !== 1) await sleep(50);
+
+  // Shorter than timeoutMs: the standby keeps following
+  primary.kill('SIGSTOP');
+  await sleep(TIMEOUT_MS / 2);
+  primary.kill('SIGCONT');
+  await sleep(500);
+  const shortPause = await healthOf(STANDBY_PORT);
+  if (shortPause !== 'standby') throw new Error(`standby reported '${shortPause}' after a ${TIMEOUT_MS / 2}ms pause`);
+
+  // Longer: silence, one failed reconnect, then the takeover
+  primary.kill('SIGSTOP');
+  const tookOverMs = await waitForHealth(STANDBY_PORT, 'ok', 4 * TIMEOUT_MS);
+  primary.kill('SIGCONT');
+  const steppedDownMs = await waitForHealth(PRIMARY_PORT, 'standby', 2 * TIMEOUT_MS);
+  while ((await metricsOf(STANDBY_PORT)).gauges['relay.replication.standbys']?.value !== 1) await sleep(50);
+
+  // The relay that took over restarts with its original standbyOf config
+  standby.kill('SIGKILL');
+  const restarted = await startRelay(STANDBY_PORT, 'standby');
+  const restartStarted = performance.now();
+  let roles = '';
+  while (performance.now() - restartStarted < 4 * TIMEOUT_MS) {
+    roles = [await healthOf(PRIMARY_PORT), await healthOf(STANDBY_PORT)].sort().join('/');
+    if (roles === 'ok/standby') break;
+    await sleep(100);
+  }
+  if (roles !== 'ok/standby') throw new Error(`after the restart the relays report ${roles}`);
+  const settledMs = performance.now() - restartStarted;
+
+  primary.kill('SIGKILL');
+  restarted.kill('SIGKILL');
+  await sleep(200);
+  return { tookOverMs, steppedDownMs, settledMs };
+}
+
+async function main(): Promise<void> {
+  print(`${SESSIONS} sessions x ${FOLLOWERS} followers, a RESTART per session every ${INTERVAL_MS}ms; primary killed after ${KILL_AFTER_MS / 1000}s, measured for ${RUN_AFTER_KILL_MS / 1000}s more`);
+  print('');
+  const ms = (value: number) => Number.isNaN(value) ? '-' : `${Math.round(value)}ms`;
+  print('setup      followers back   first command p50   max       all rejoined   deliveries lost');
+  for (const setup of ['restart', 'standby'] as const) {
+    const result = await run(setup);
+    print(`${setup.padEnd(10)} ${result.followersRecovered.padEnd(16)} ${ms(result.firstCommandP50).padEnd(19)} ${ms(result.firstCommandMax).padEnd(9)} ${ms(result.allRejoinedMs).padEnd(14)} ${result.lost}/${result.expected}`);
+    if (result.lag) {
+      print(`           replication lag p50 ${result.lag.p50}ms p99 ${result.lag.p99}ms; ${result.replayed} command deliveries replayed after the takeover`);
+    }
+  }
+  print('');
+  const pause = await pauseCheck();
+  print(`primary paused: still followed after ${TIMEOUT_MS / 2}ms; taken over ${Math.round(pause.tookOverMs)}ms into a longer pause; the resumed primary stepped down and followed ${Math.round(pause.steppedDownMs)}ms later`);
+  print(`relay that took over restarted with its old config: one serving, one following after ${Math.round(pause.settledMs)}ms`);
+  rmSync(stateDir, { recursive: true, force: true });
+  process.exit(0);
+}
+
+// Child mode: one relay
+if (process.argv[2] === 'relay') {
+  const port = Number(process.argv[3]);
+  const mode = process.argv[4];
+  const relay = new RelayServer(port, {
+    host: '127.0.0.1',
+    sessions: { maxSessionsPerIp: SESSIONS }, // every bench client shares one IP
+    replication: mode === 'plain' ? undefined : {
+      secret: SECRET,
+      stateFile: join(stateDir, `replication-${port}.json`),
+      standbyOf: mode === 'standby' ? `ws://127.0.0.1:${PRIMARY_PORT}` : undefined
+    }
+  });
+  await relay.start();
+  process.stdout.write('ready\n');
+  process.stdin.on('end', () => process.exit(0)).resume();
+} else {
+  await main();
+}
@@ -0,0 +1,182 @@
+/**
+ * HTTP routing: the radix-tree router against the if/else chain it
+ * replaced (copied below), on the same SessionManager. Two measurements
+ * for GET /health, /sessions and /sessions/:token:
+ *
+ *  - dispatch: handler calls on a ServerResponse without a socket (it
+ *    buffers the head and body), ops/sec and bytes allocated per request
+ *    including the response (V8 sampling heap profiler)
+ *  - loopback: requests/sec over keep-alive HTTP with N in flight
+ *
+ *   npm run bench:router -- [sessions] [seconds] [concurrency]
+ */
+import { createServer, Agent, request, ServerResponse } from 'http';
+import type { IncomingMessage } from 'http';
+import { Session } from 'inspector';
+import { SessionManager } from '../src/relay-server/session-manager.js';
+import { OutboundQueue } from '../src/relay-server/outbound-queue.js';
+import { HttpRouter, ERROR_BODIES, sendJson } from '../src/relay-server/http-router.js';
+import { writeJson, DEFAULT_COMPRESSION_OPTIONS } from '../src/relay-server/compression.js';
+
+const SESSIONS = Number(process.argv[2] ?? 20);
+const SECONDS = Number(process.argv[3] ?? 3);
+const CONCURRENCY = Number(process.argv[4] ?? 32);
+const DISPATCH_OPS = 200_000;
+const ALLOC_OPS = 2000;
+
+const print = (line: string) => process.stdout.write(line + '\n');
+console.log = () => {};
+
+const manager = new SessionManager({ maxSessionsPerIp: Infinity, maxOwnerlessSessions: Infinity });
+const queue = () => new OutboundQueue({ readyState: 1, bufferedAmount: 0, send: (_data, cb) => cb?.(), close: () => {}, terminate: () => {} });
+const tokens: string[] = [];
+for (let s = 0; s < SESSIONS; s++) {
+  tokens.push(manager.findOrCreateSessionByIp(`10.0.${s >> 8}.${s & 255}`, queue(), `c${s}`, 'controller')!.token);
+}
+const http = DEFAULT_COMPRESSION_OPTIONS.http;
+
+// The chain as it was before the router, trimmed to the benchmarked routes
+function legacy(req: IncomingMessage, res: ServerResponse): void {
+  res.setHeader('Access-Control-Allow-Origin', '*');
+  res.setHeader('Content-Type', 'application/json');
+
+  if (req.url && req.url.startsWith('/dashboard')) {
+    // (file lookup elided: falls through to API routing when not built)
+  }
+  if (req.url && req.url.startsWith('/debug/')) {
+    res.writeHead(404);
+    res.end(JSON.stringify({ error: 'Not found' }));
+  } else if (req.url === '/health') {
+    res.writeHead(200);
+    res.end(JSON.stringify({ status: 'ok', timestamp: Date.now() }));
+  } else if (req.url === '/metrics' && req.method === 'GET') {
+    res.writeHead(200);
+    res.end('{}');
+  } else if (req.url === '/create-session' && req.method === 'POST') {
+    res.writeHead(200);
+    res.end('{}');
+  } else if (req.url === '/sessions' && req.method === 'GET') {
+    writeJson(req, res, 200, { sessions: manager.getAllSessions() }, http);
+  } else if (req.url && req.url.startsWith('/sessions/') && req.method === 'GET') {
+    const token = req.url.split('/')[2];
+    if (!token) {
+      res.writeHead(400);
+      res.end(JSON.stringify({ error: 'Missing token' }));
+      return;
+    }
+    const info = manager.getSessionInfo(token);
+    if (!info) {
+      res.writeHead(404);
+      res.end(JSON.stringify({ error: 'Session not found' }));
+      return;
+    }
+    res.writeHead(200);
+    res.end(JSON.stringify({ session: info }));
+  } else {
+    res.writeHead(404);
+    res.end(JSON.stringify({ error: 'Not found' }));
+  }
+}
+
+// Same routes as RelayServer.createRouter
+const respond = (res: ServerResponse, status: number, body: object) => sendJson(res, status, JSON.stringify(body));
+const router = new HttpRouter()
+  .on('GET', '/dashboard', (_req, res) => sendJson(res, 404, ERROR_BODIES.notFound))
+  .on('GET', '/dashboard/*', (_req, res) => sendJson(res, 404, ERROR_BODIES.notFound))
+  .on('ANY', '/debug/*', (_req, res) => sendJson(res, 404, ERROR_BODIES.notFound))
+  .on('ANY', '/health', (_req, res) => respond(res, 200, { status: 'ok', timestamp: Date.now() }))
+  .on('GET', '/metrics', (_req, res) => sendJson(res, 200, '{}'))
+  .on('POST', '/create-session', (_req, res) => sendJson(res, 200, '{}'))
+  .on('GET', '/sessions', (req, res) => writeJson(req, res, 200, { sessions: manager.getAllSessions() }, http))
+  .on('GET', '/sessions/:token', (_req, res, [token]) => {
+    const info = manager.getSessionInfo(token);
+    if (!info) {
+      sendJson(res, 404, ERROR_BODIES.sessionNotFound);
+      return;
+    }
+    respond(res, 200, { session: info });
+  })
+  .on('POST', '/sessions/:token/:action', (_req, res) => sendJson(res, 200, '{}'));
+
+const handlers: Record<string, (req: IncomingMessage, res: ServerResponse) => void> = {
+  chain: legacy,
+  router: (req, res) => router.dispatch(req, res)
+};
+const paths = () => ({ '/health': '/health', '/sessions': '/sessions', '/sessions/:token': `/sessions/${tokens[0]}` });
+
+async function dispatch() {
+  const inspector = new Session();
+  inspector.connect();
+  const post = (method: string, params: object = {}) => new Promise<any>((resolve, reject) => {
+    inspector.post(method, params, (error, result) => error ? reject(error) : resolve(result));
+  });
+  await post('HeapProfiler.enable');
+  const totalSize = (node: any): number => node.selfSize + node.children.reduce((sum: number, child: any) => sum + totalSize(child), 0);
+
+  const results: Record<string, Record<string, object>> = {};
+  for (const [route, url] of Object.entries(paths())) {
+    results[route] = {};
+    const req = { url, method: 'GET', httpVersionMajor: 1, httpVersionMinor: 1, headers: {}, socket: { remoteAddress: '127.0.0.1' } } as unknown as IncomingMessage;
+    // /sessions is bounded by getAllSessions and JSON; fewer calls keep it under a few seconds
+    const ops = route === '/sessions' ? DISPATCH_OPS / 20 : DISPATCH_OPS;
+    for (const [name, handle] of Object.entries(handlers)) {
+      for (let i = 0; i < ops / 10; i++) handle(req, new ServerResponse(req)); // warm up
+      const start = performance.now();
+      for (let i = 0; i < ops; i++) handle(req, new ServerResponse(req));
+      const elapsed = performance.now() - start;
+
+      await post('HeapProfiler.startSampling', { samplingInterval: 64, includeObjectsCollectedByMajorGC: true, includeObjectsCollectedByMinorGC: true });
+      for (let i = 0; i < ALLOC_OPS; i++) handle(req, new ServerResponse(req));
+      const { profile } = await post('HeapProfiler.stopSampling');
+
+      results[route][name] = {
+        opsPerSec: Math.round(ops / (elapsed / 1000)),
+        nsPerOp: Math.round(elapsed * 1e6 / ops),
+        bytesPerOp: Math.round(totalSize(profile.head) / ALLOC_OPS)
+      };
+    }
+  }
+  inspector.disconnect();
+  return results;
+}
+
+async function loopback() {
+  const results: Record<string, Record<string, object>> = {};
+  for (const [name, handle] of Object.entries(handlers)) {
+    const server = createServer(handle);
+    await new Promise<void>(resolve => server.listen(0, '127.0.0.1', resolve));
+    const port = (server.address() as { port: number }).port;
+    const agent = new Agent({ keepAlive: true, maxSockets: CONCURRENCY });
+
+    for (const [route, path] of Object.entries(paths())) {
+      const get = () => new Promise<void>((resolve, reject) => {
+        request({ host: '127.0.0.1', port, path, agent }, response => {
+          response.resume();
+          response.on('end', resolve);
+        }).on('error', reject).end();
+      });
+      let completed = 0;
+      const run = async (ms: number) => {
+        const deadline = performance.now() + ms;
+        await Promise.all(Array.from({ length: CONCURRENCY }, async () => {
+          while (performance.now() < deadline) {
+            await get();
+            completed++;
+          }
+        }));
+      };
+      await run(500); // warm up sockets and JIT
+      completed = 0;
+      const start = performance.now();
+      await run(SECONDS * 1000);
+      (results[route] ??= {})[name] = { requestsPerSec: Math.round(completed / ((performance.now() - start) / 1000)) };
+    }
+    agent.destroy();
+    await new Promise(resolve => server.close(resolve));
+  }
+  return results;
+}
+
+print(JSON.stringify({ sessions: SESSIONS, seconds: SECONDS, concurrency: CONCURRENCY, dispatch: await dispatch(), loopback: await loopback() }, null, 2));
+manager.dispose();
+process.exit(0);
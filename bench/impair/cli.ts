@@ -0,0 +1,79 @@
+/**
+ * Standalone network-impairment proxy. Point clients at the listen port
+ * instead of the relay.
+ *
+ *   npx tsx bench/impair/cli.ts --target 127.0.0.1:8080 --listen 9080 \
+ *     --latency 80 --jitter 20 --bandwidth 32k --stall-every 30000 --stall-for 5000 \
+ *     --reset-every 60000 --reset-probability 0
+ *
+ * While running, type a command on stdin to impair by hand:
+ *   stall <ms>    hold all traffic
+ *   reset         reset every open connection
+ *   outage <ms>   reset and refuse connections
+ *   set <flag> <value>   change one option, e.g. "set latency 200"
+ */
+import readline from 'readline';
+import { ImpairmentProxy } from './proxy.js';
+import type { ImpairmentOptions } from './proxy.js';
+
+const FLAGS: Record<string, keyof ImpairmentOptions> = {
+  'latency': 'latencyMs',
+  'jitter': 'jitterMs',
+  'bandwidth': 'bandwidthBps',
+  'stall-every': 'stallEveryMs',
+  'stall-for': 'stallForMs',
+  'reset-every': 'resetEveryMs',
+  'reset-probability': 'resetProbability'
+};
+
+// 64k / 1m (bytes per second) or plain numbers
+const parseValue = (value: string) => {
+  const match = /^([\d.]+)([km]?)$/i.exec(value);
+  if (!match) throw new Error(`Invalid value: ${value}`);
+  return Number(match[1]) * ({ '': 1, k: 1024, m: 1024 * 1024 } as Record<string, number>)[match[2].toLowerCase()];
+};
+
+const args = process.argv.slice(2);
+const options: ImpairmentOptions = {};
+let target = '127.0.0.1:8080';
+let listen = 9080;
+
+for (let i = 0; i < args.length; i += 2) {
+  const flag = args[i].replace(/^--/, '');
+  const value = args[i + 1];
+  if (flag === 'target') target = value;
+  else if (flag === 'listen') listen = Number(value);
+  else if (FLAGS[flag]) options[FLAGS[flag]] = parseValue(value);
+  else {
+    console.error(`Unknown flag --${flag}. Known: --target --listen ${Object.keys(FLAGS).map(f => `--${f}`).join(' ')}`);
+    process.exit(1);
+  }
+}
+
+const [targetHost, targetPort] = target.split(':');
+const proxy = new ImpairmentProxy(targetHost, Number(targetPort), options);
+proxy.on('connection', id => console.log(`[${id}] connected (${proxy.connectionCount()} open)`));
+proxy.on('close', id => console.log(`[${id}] closed (${proxy.connectionCount()} open)`));
+proxy.on('reset', count => console.log(`Reset ${count} connection(s)`));
+
+const port = await proxy.listen(listen, '0.0.0.0');
+console.log(`Impairment proxy on :${port} -> ${target} ${JSON.stringify(options)}`);
+
+readline.createInterface({ input: process.stdin }).on('line', line => {
+  const [command, a, b] = line.trim().split(/\s+/);
+  try {
+    if (command === 'stall') proxy.stall(Number(a));
+    else if (command === 'reset') proxy.reset();
+    else if (command === 'outage') proxy.outage(Number(a));
+    else if (command === 'set' && FLAGS[a]) proxy.configure({ ...proxy.options, [FLAGS[a]]: parseValue(b) });
+    else if (command) console.log('Commands: stall <ms> | reset | outage <ms> | set <flag> <value>');
+    console.log(JSON.stringify(proxy.options));
+  } catch (error) {
+    console.error(error instanceof Error ? error.message : String(error));
+  }
+});
+
+process.on('SIGINT', async () => {
+  await proxy.close();
+  process.exit(0);
+});
@@ -0,0 +1,39 @@
+using LeagueMonitor.Configuration;
+using LeagueMonitor.Network;
+
+namespace LeagueMonitor.ImpairProbe;
+
+/// <summary>
+/// Follower probe for the impairment scenarios, using the C# RelayClient.
+/// Reports client events on stdout as "@probe &lt;event&gt;" lines.
+/// </summary>
+public static class Program
+{
+    private static readonly object _outputLock = new();
+
+    private static void Report(string ev)
+    {
+        lock (_outputLock)
+        {
+            Console.Out.WriteLine($"@probe {ev}");
+            Console.Out.Flush();
+        }
+    }
+
+    public static async Task Main()
+    {
+        var relay = AppConfig.Instance.Relay;
+        relay.Host = Environment.GetEnvironmentVariable("RELAY_HOST") ?? "127.0.0.1";
+        relay.Port = int.Parse(Environment.GetEnvironmentVariable("RELAY_PORT") ?? "8080");
+        relay.UseTls = false;
+
+        using var client = new RelayClient(ClientRole.follower);
+        client.OnConnected += () => Report("connected");
+        client.OnDisconnected += () => Report("disconnected");
+        client.OnJoined += (_, _) => Report("joined");
+        client.OnClientRestarted += () => Report("restart");
+
+        Report("started");
+        await client.ConnectAsync(Environment.GetEnvironmentVariable("SESSION_TOKEN"));
+    }
+}
@@ -0,0 +1,41 @@
+"""Follower probe for the impairment scenarios, using the Python RelayClient.
+
+Reports client events on stdout as "@probe <event>" lines.
+
+    RELAY_HOST=127.0.0.1 RELAY_PORT=9080 SESSION_TOKEN=... python bench/impair/probes/python_probe.py
+"""
+
+import asyncio
+import os
+import sys
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parents[3] / "python"))
+
+from league_monitor.config import get_config  # noqa: E402
+from league_monitor.relay_client import ClientRole, RelayClient  # noqa: E402
+
+
+def report(event: str) -> None:
+    # Client logs also go to stdout; the scenario runner only reads @probe lines
+    print(f"@probe {event}", flush=True)
+
+
+async def main() -> None:
+    config = get_config()
+    config.relay.host = os.environ.get("RELAY_HOST", "127.0.0.1")
+    config.relay.port = int(os.environ.get("RELAY_PORT", "8080"))
+    config.relay.tls = False
+
+    client = RelayClient(ClientRole.FOLLOWER)
+    client.on_connected(lambda: report("connected"))
+    client.on_disconnected(lambda: report("disconnected"))
+    client.on_joined(lambda token, info: report("joined"))
+    client.on_client_restarted(lambda: report("restart"))
+
+    report("started")
+    await client.connect(os.environ.get("SESSION_TOKEN"))
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
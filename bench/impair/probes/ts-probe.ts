@@ -0,0 +1,25 @@
+/**
+ * Follower probe for the impairment scenarios, using the TS SessionClient.
+ * Reports client events on stdout as "@probe <event>" lines.
+ *
+ *   RELAY_HOST=127.0.0.1 RELAY_PORT=9080 SESSION_TOKEN=... npx tsx bench/impair/probes/ts-probe.ts
+ */
+import { SessionClient } from '../../../src/controller/session-client.js';
+
+const report = (event: string) => process.stdout.write(`@probe ${event}\n`);
+console.log = () => {};
+
+const client = new SessionClient(process.env.RELAY_HOST ?? '127.0.0.1', Number(process.env.RELAY_PORT ?? 8080), 'follower');
+client.setJoinedCallback(() => report('joined'));
+client.setClientRestartedCallback(() => report('restart'));
+
+// SessionClient has no disconnect callback; poll its state instead
+let wasConnected = false;
+setInterval(() => {
+  const connected = client.connected();
+  if (connected !== wasConnected) report(connected ? 'connected' : 'disconnected');
+  wasConnected = connected;
+}, 5);
+
+await client.connect(process.env.SESSION_TOKEN);
+report('started');
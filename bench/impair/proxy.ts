@@ -0,0 +1,233 @@
+import net from 'net';
+import EventEmitter from 'events';
+
+export interface ImpairmentOptions {
+  latencyMs?: number;        // added one way, per direction (default 0)
+  jitterMs?: number;         // ± around latencyMs, order is preserved (default 0)
+  bandwidthBps?: number;     // bytes/s per direction, 0 = unlimited (default 0)
+  stallEveryMs?: number;     // start a stall this often, 0 = never (default 0)
+  stallForMs?: number;       // how long each stall holds traffic (default 0)
+  resetEveryMs?: number;     // reset every connection this often, 0 = never (default 0)
+  resetProbability?: number; // chance per chunk of resetting its connection (default 0)
+}
+
+const HIGH_WATER_BYTES = 1024 * 1024;
+
+/**
+ * One direction of a proxied connection. Chunks are released in order at
+ * arrival + latency ± jitter, spaced by the bandwidth cap, and held while
+ * the proxy is stalled (nothing is dropped, like a TCP stall).
+ */
+class Lane {
+  private queue: { chunk: Buffer; releaseAt: number }[] = [];
+  private queuedBytes: number = 0;
+  private lastRelease: number = 0;
+  private timer?: NodeJS.Timeout;
+
+  constructor(private proxy: ImpairmentProxy, private from: net.Socket, private to: net.Socket) {
+    from.on('data', chunk => this.push(chunk));
+  }
+
+  private push(chunk: Buffer): void {
+    const { latencyMs = 0, jitterMs = 0, bandwidthBps = 0 } = this.proxy.options;
+    const now = Date.now();
+    const delay = Math.max(0, latencyMs + (Math.random() * 2 - 1) * jitterMs);
+    const transmit = bandwidthBps > 0 ? chunk.length / bandwidthBps * 1000 : 0;
+    this.lastRelease = Math.max(this.lastRelease, now + delay) + transmit;
+
+    this.queue.push({ chunk, releaseAt: this.lastRelease });
+    this.queuedBytes += chunk.length;
+    if (this.queuedBytes > HIGH_WATER_BYTES) this.from.pause();
+    this.pump();
+  }
+
+  pump(): void {
+    if (this.timer) {
+      clearTimeout(this.timer);
+      this.timer = undefined;
+    }
+    if (this.to.destroyed) return;
+
+    const now = Date.now();
+    const stalledUntil = this.proxy.stalledUntil();
+    if (stalledUntil > now) {
+      this.timer = setTimeout(() => this.pump(), stalledUntil - now);
+      return;
+    }
+
+    while (this.queue.length > 0 && this.queue[0].releaseAt <= now) {
+      const { chunk } = this.queue.shift()!;
+      this.queuedBytes -= chunk.length;
+      this.to.write(chunk);
+    }
+    if (this.queuedBytes <= HIGH_WATER_BYTES && this.from.isPaused()) this.from.resume();
+    if (this.queue.length > 0) {
+      this.timer = setTimeout(() => this.pump(), this.queue[0].releaseAt - now);
+    }
+  }
+
+  /**
+   * Forward the peer's FIN once everything queued before it has gone out
+   */
+  drainThen(done: () => void): void {
+    if (this.queue.length === 0 || this.to.destroyed) return done();
+    setTimeout(() => this.drainThen(done), Math.max(1, this.queue[this.queue.length - 1].releaseAt - Date.now()));
+  }
+
+  clear(): void {
+    if (this.timer) clearTimeout(this.timer);
+    this.queue = [];
+    this.queuedBytes = 0;
+  }
+}
+
+interface ProxiedConnection {
+  client: net.Socket;
+  upstream: net.Socket;
+  lanes: Lane[];
+}
+
+/**
+ * TCP proxy that sits between clients and the relay and degrades the link:
+ * latency, jitter, bandwidth caps, stalls, connection resets and outages.
+ * WebSocket (and TLS) traffic passes through untouched since it works on
+ * the byte stream. Options can be changed while connections are open.
+ *
+ * Emits 'connection' (id), 'close' (id) and 'reset' (count).
+ */
+export class ImpairmentProxy extends EventEmitter {
+  options: ImpairmentOptions;
+  private server: net.Server;
+  private connections = new Map<number, ProxiedConnection>();
+  private nextId: number = 0;
+  private stallEnd: number = 0;
+  private outageEnd: number = 0;
+  private stallTimer?: NodeJS.Timeout;
+  private resetTimer?: NodeJS.Timeout;
+
+  constructor(private targetHost: string, private targetPort: number, options: ImpairmentOptions = {}) {
+    super();
+    this.options = options;
+    // Half-open so a FIN is only forwarded after the data queued before it
+    this.server = net.createServer({ allowHalfOpen: true }, client => this.accept(client));
+  }
+
+  async listen(port: number = 0, host: string = '127.0.0.1'): Promise<number> {
+    await new Promise<void>(resolve => this.server.listen(port, host, resolve));
+    this.configure(this.options);
+    return this.address();
+  }
+
+  address(): number {
+    return (this.server.address() as net.AddressInfo).port;
+  }
+
+  /**
+   * Replace the impairment profile; applies to traffic queued from now on
+   */
+  configure(options: ImpairmentOptions): void {
+    this.options = options;
+    if (this.stallTimer) clearInterval(this.stallTimer);
+    if (this.resetTimer) clearInterval(this.resetTimer);
+    this.stallTimer = this.resetTimer = undefined;
+
+    if (options.stallEveryMs && options.stallForMs) {
+      this.stallTimer = setInterval(() => this.stall(options.stallForMs!), options.stallEveryMs);
+      this.stallTimer.unref();
+    }
+    if (options.resetEveryMs) {
+      this.resetTimer = setInterval(() => this.reset(), options.resetEveryMs);
+      this.resetTimer.unref();
+    }
+  }
+
+  /**
+   * Hold all traffic in both directions for a while
+   */
+  stall(ms: number): void {
+    this.stallEnd = Math.max(this.stallEnd, Date.now() + ms);
+  }
+
+  stalledUntil(): number {
+    return this.stallEnd;
+  }
+
+  /**
+   * Reset (RST) every open connection; returns how many were reset
+   */
+  reset(): number {
+    const count = this.connections.size;
+    for (const id of [...this.connections.keys()]) this.drop(id);
+    if (count > 0) this.emit('reset', count);
+    return count;
+  }
+
+  /**
+   * Reset everything and refuse new connections for a while, like the
+   * relay's host going away
+   */
+  outage(ms: number): void {
+    this.outageEnd = Date.now() + ms;
+    this.reset();
+  }
+
+  connectionCount(): number {
+    return this.connections.size;
+  }
+
+  async close(): Promise<void> {
+    this.configure({});
+    this.reset();
+    await new Promise<void>(resolve => this.server.close(() => resolve()));
+  }
+
+  private accept(client: net.Socket): void {
+    if (Date.now() < this.outageEnd) {
+      client.resetAndDestroy();
+      return;
+    }
+
+    const id = this.nextId++;
+    const upstream = net.connect({ port: this.targetPort, host: this.targetHost, allowHalfOpen: true });
+    client.setNoDelay(true);
+    upstream.setNoDelay(true);
+
+    const toRelay = new Lane(this, client, upstream);
+    const toClient = new Lane(this, upstream, client);
+    this.connections.set(id, { client, upstream, lanes: [toRelay, toClient] });
+    this.emit('connection', id);
+
+    const maybeReset = () => {
+      const probability = this.options.resetProbability ?? 0;
+      if (probability > 0 && Math.random() < probability) this.drop(id);
+    };
+    client.on('data', maybeReset);
+    upstream.on('data', maybeReset);
+
+    client.on('end', () => toRelay.drainThen(() => upstream.end()));
+    upstream.on('end', () => toClient.drainThen(() => client.end()));
+    client.on('close', () => this.closed(id));
+    upstream.on('close', () => this.closed(id));
+    client.on('error', () => {});
+    upstream.on('error', () => {});
+  }
+
+  private drop(id: number): void {
+    const connection = this.connections.get(id);
+    if (!connection) return;
+    connection.lanes.forEach(lane => lane.clear());
+    if (!connection.client.destroyed) connection.client.resetAndDestroy();
+    if (!connection.upstream.destroyed) connection.upstream.resetAndDestroy();
+    this.closed(id);
+  }
+
+  private closed(id: number): void {
+    const connection = this.connections.get(id);
+    if (!connection) return;
+    this.connections.delete(id);
+    connection.lanes.forEach(lane => lane.clear());
+    connection.client.destroy();
+    connection.upstream.destroy();
+    this.emit('close', id);
+  }
+}
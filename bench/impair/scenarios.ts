@@ -0,0 +1,249 @@
+/**
+ * Client behaviour under a degraded link: command delivery latency,
+ * reconnect time and session recovery for the TS, Python and C# followers.
+ *
+ * A relay and a TS controller run in-process on a clean loopback link; the
+ * follower under test is a probe process (bench/impair/probes) connected
+ * through an ImpairmentProxy. Each scenario starts a fresh proxy and probe.
+ * Delivery latency is the controller's RESTART to the follower's
+ * CLIENT_RESTARTED. Reconnect time is from the reset to the follower
+ * having re-joined its session. "Lost" counts commands sent while the
+ * follower was away that never arrived.
+ *
+ *   npx tsx bench/impair/scenarios.ts [--client ts|python|csharp] [--probe "<command>"] [--only reset,outage]
+ *
+ * --probe overrides the command used to start the follower, which gets
+ * RELAY_HOST, RELAY_PORT and SESSION_TOKEN in its environment and reports
+ * "@probe <event>" lines (started, connected, joined, restart, disconnected).
+ */
+import { spawn } from 'child_process';
+import type { ChildProcess } from 'child_process';
+import EventEmitter from 'events';
+import readline from 'readline';
+import { RelayServer } from '../../src/relay-server/relay-server.js';
+import { SessionClient } from '../../src/controller/session-client.js';
+import { Histogram } from '../../src/shared/metrics.js';
+import { ImpairmentProxy } from './proxy.js';
+import type { ImpairmentOptions } from './proxy.js';
+
+const PROBES: Record<string, string> = {
+  ts: 'npx tsx bench/impair/probes/ts-probe.ts',
+  python: `${process.env.PYTHON ?? 'python3'} bench/impair/probes/python_probe.py`,
+  csharp: 'dotnet run -c Release --project bench/impair/probes/csharp'
+};
+
+const args = process.argv.slice(2);
+const flag = (name: string) => {
+  const index = args.indexOf(`--${name}`);
+  return index >= 0 ? args[index + 1] : undefined;
+};
+const client = flag('client') ?? 'ts';
+const probeCommand = flag('probe') ?? PROBES[client];
+const only = flag('only')?.split(',');
+if (!probeCommand) {
+  console.error(`Unknown client "${client}", expected one of ${Object.keys(PROBES).join(', ')} or --probe "<command>"`);
+  process.exit(1);
+}
+
+const print = (line: string) => process.stdout.write(line + '\n');
+console.log = () => {};
+
+const sleep = (ms: number) => new Promise(resolve => setTimeout(resolve, ms));
+
+/**
+ * Follower process under test, as a stream of timestamped events
+ */
+class Probe extends EventEmitter {
+  private child: ChildProcess;
+  private counts = new Map<string, number>();
+
+  constructor(port: number, token: string) {
+    super();
+    this.child = spawn(probeCommand!, {
+      shell: true,
+      env: { ...process.env, RELAY_HOST: '127.0.0.1', RELAY_PORT: String(port), SESSION_TOKEN: token },
+      stdio: ['ignore', 'pipe', 'inherit'],
+      detached: process.platform !== 'win32' // own process group, so stop() reaches past the shell
+    });
+    readline.createInterface({ input: this.child.stdout! }).on('line', line => {
+      if (!line.startsWith('@probe ')) return;
+      const event = line.slice(7).trim();
+      this.counts.set(event, this.count(event) + 1);
+      this.emit(event, performance.now());
+    });
+  }
+
+  count(event: string): number {
+    return this.counts.get(event) ?? 0;
+  }
+
+  /**
+   * Time of the next occurrence of event, or undefined on timeout
+   */
+  next(event: string, timeoutMs: number): Promise<number | undefined> {
+    return new Promise(resolve => {
+      const timer = setTimeout(() => {
+        this.off(event, done);
+        resolve(undefined);
+      }, timeoutMs);
+      const done = (at: number) => {
+        clearTimeout(timer);
+        resolve(at);
+      };
+      this.once(event, done);
+    });
+  }
+
+  stop(): void {
+    if (process.platform === 'win32') {
+      spawn('taskkill', ['/pid', String(this.child.pid), '/t', '/f']);
+    } else {
+      try {
+        process.kill(-this.child.pid!);
+      } catch {
+        // already gone
+      }
+    }
+  }
+}
+
+interface Context {
+  proxy: ImpairmentProxy;
+  probe: Probe;
+  controller: SessionClient;
+}
+
+const round = (ms: number | undefined) => ms === undefined ? null : +ms.toFixed(1);
+
+async function deliveryLatency(ctx: Context, commands: number, gapMs: number = 50) {
+  const latency = new Histogram(commands);
+  let timeouts = 0;
+  for (let i = 0; i < commands; i++) {
+    const start = performance.now();
+    const received = ctx.probe.next('restart', 10_000);
+    ctx.controller.broadcastRestart();
+    const at = await received;
+    if (at === undefined) timeouts++;
+    else latency.record(at - start);
+    await sleep(gapMs);
+  }
+  const { mean, p50, p99, max } = latency.snapshot();
+  return { commands, timeouts, latencyMs: { mean: round(mean), p50: round(p50), p99: round(p99), max: round(max) } };
+}
+
+/**
+ * Break the link, keep sending a command every 200ms and time how long
+ * the follower takes to come back and start receiving again
+ */
+async function recovery(ctx: Context, breakLink: () => void, timeoutMs: number = 30_000) {
+  const before = ctx.probe.count('restart');
+  let disconnected: number | undefined;
+  let firstDelivery: number | undefined;
+  ctx.probe.once('disconnected', (at: number) => disconnected = at);
+  const rejoined = ctx.probe.next('joined', timeoutMs);
+  const start = performance.now();
+  breakLink();
+
+  let sent = 0;
+  ctx.probe.once('restart', (at: number) => firstDelivery = at);
+  const sender = setInterval(() => {
+    ctx.controller.broadcastRestart();
+    sent++;
+  }, 200);
+
+  const joinedAt = await rejoined;
+  while (firstDelivery === undefined && performance.now() - start < timeoutMs) await sleep(20);
+  clearInterval(sender);
+  await sleep(500); // let in-flight commands land
+
+  const since = (at: number | undefined) => round(at === undefined ? undefined : at - start);
+  return {
+    recovered: joinedAt !== undefined && firstDelivery !== undefined,
+    disconnectDetectedMs: since(disconnected),
+    reconnectMs: since(joinedAt),
+    firstDeliveryMs: since(firstDelivery),
+    sent,
+    lost: Math.max(0, sent - (ctx.probe.count('restart') - before))
+  };
+}
+
+interface Scenario {
+  name: string;
+  impairment: ImpairmentOptions;
+  run: (ctx: Context) => Promise<object>;
+}
+
+const scenarios: Scenario[] = [
+  { name: 'baseline', impairment: {}, run: ctx => deliveryLatency(ctx, 30) },
+  { name: 'wan', impairment: { latencyMs: 80, jitterMs: 30 }, run: ctx => deliveryLatency(ctx, 30) },
+  { name: 'slow-link', impairment: { latencyMs: 30, bandwidthBps: 2048 }, run: ctx => deliveryLatency(ctx, 30) },
+  { name: 'stalls', impairment: { stallEveryMs: 2000, stallForMs: 1000 }, run: ctx => deliveryLatency(ctx, 30, 150) },
+  { name: 'reset', impairment: {}, run: ctx => recovery(ctx, () => ctx.proxy.reset()) },
+  { name: 'outage', impairment: {}, run: ctx => recovery(ctx, () => ctx.proxy.outage(8000)) },
+  {
+    name: 'flaky',
+    impairment: { latencyMs: 20, jitterMs: 10 },
+    run: async ctx => {
+      // Random resets for 20s, then check the follower settles once they stop
+      const joinsBefore = ctx.probe.count('joined');
+      const before = ctx.probe.count('restart');
+      ctx.proxy.configure({ ...ctx.proxy.options, resetProbability: 0.02 });
+      let sent = 0;
+      const sender = setInterval(() => {
+        ctx.controller.broadcastRestart();
+        sent++;
+      }, 250);
+      await sleep(20_000);
+      clearInterval(sender);
+
+      ctx.proxy.configure({ latencyMs: 20, jitterMs: 10 });
+      const delivered = ctx.probe.count('restart') - before;
+      await sleep(6_000); // one reconnect interval
+      const after = await deliveryLatency(ctx, 5);
+      return {
+        sent,
+        delivered,
+        reconnects: ctx.probe.count('joined') - joinsBefore,
+        settledAfter: after.timeouts === 0
+      };
+    }
+  }
+];
+
+// Relay and controller on a clean link
+const relay = new RelayServer(0, { host: '127.0.0.1' });
+await relay.start();
+const controller = new SessionClient('127.0.0.1', relay.address(), 'controller');
+await controller.connect();
+while (!controller.connected() || !controller.getSessionToken()) await sleep(20);
+const token = controller.getSessionToken()!;
+
+const results: object[] = [];
+let failed = false;
+
+for (const scenario of scenarios.filter(s => !only || only.includes(s.name))) {
+  const proxy = new ImpairmentProxy('127.0.0.1', relay.address(), scenario.impairment);
+  const port = await proxy.listen();
+  const probe = new Probe(port, token);
+  try {
+    if (await probe.next('joined', 60_000) === undefined) throw new Error(`${client} probe did not join (${probeCommand})`);
+    await sleep(200);
+    const result: any = await scenario.run({ proxy, probe, controller });
+    if (result.recovered === false || result.timeouts > 0 || result.settledAfter === false) failed = true;
+    results.push({ scenario: scenario.name, impairment: scenario.impairment, ...result });
+    print(`${scenario.name}: ${JSON.stringify(result)}`);
+  } catch (error) {
+    failed = true;
+    results.push({ scenario: scenario.name, error: error instanceof Error ? error.message : String(error) });
+    print(`${scenario.name}: ${error instanceof Error ? error.message : String(error)}`);
+  } finally {
+    probe.stop();
+    await proxy.close();
+  }
+}
+
+print(JSON.stringify({ client, probe: probeCommand, results }, null, 2));
+
+controller.disconnect();
+await relay.stop();
+process.exit(failed ? 1 : 0);
@@ -0,0 +1,66 @@
+/**
+ * Round-trip latency and CPU per message: WebSocket over TCP loopback
+ * versus the relay's local socket (Unix domain socket / named pipe).
+ *
+ * Sends HEARTBEAT and waits for HEARTBEAT_ACK, one at a time. CPU covers
+ * client and relay together since both run in-process.
+ *
+ *   npx tsx bench/ipc-latency.ts
+ */
+import WebSocket from 'ws';
+import { mkdtempSync } from 'fs';
+import { tmpdir } from 'os';
+import { join } from 'path';
+import { RelayServer } from '../src/relay-server/relay-server.js';
+import { IpcSocket, defaultIpcPath } from '../src/shared/ipc-socket.js';
+import { Histogram } from '../src/shared/metrics.js';
+
+const MESSAGES = 5000;
+
+const print = (line: string) => process.stdout.write(line + '\n');
+console.log = () => {};
+
+const ipcPath = process.platform === 'win32'
+  ? defaultIpcPath() + '-bench'
+  : join(mkdtempSync(join(tmpdir(), 'relay-ipc-')), 'relay.sock');
+const relay = new RelayServer(0, { host: '127.0.0.1', ipcPath });
+await relay.start();
+
+async function measure(name: string, socket: WebSocket | IpcSocket) {
+  await new Promise(resolve => socket.once('open', resolve));
+
+  const rtt = new Histogram(MESSAGES);
+  let pending: (() => void) | undefined;
+  socket.on('message', (data: Buffer | string) => {
+    if (JSON.parse(data.toString()).type === 'HEARTBEAT_ACK') pending?.();
+  });
+
+  const heartbeat = JSON.stringify({ type: 'HEARTBEAT' });
+  const cpuStart = process.cpuUsage();
+  for (let i = 0; i < MESSAGES; i++) {
+    const start = process.hrtime.bigint();
+    await new Promise<void>(resolve => {
+      pending = resolve;
+      socket.send(heartbeat);
+    });
+    rtt.record(Number(process.hrtime.bigint() - start) / 1000);
+  }
+  const cpu = process.cpuUsage(cpuStart);
+  socket.close();
+
+  const { p50, p99, mean } = rtt.snapshot();
+  return {
+    transport: name,
+    messages: MESSAGES,
+    rttMicros: { mean: Math.round(mean), p50: Math.round(p50), p99: Math.round(p99) },
+    cpuMicrosPerMessage: +((cpu.user + cpu.system) / MESSAGES).toFixed(1)
+  };
+}
+
+const results = [
+  await measure('tcp-websocket', new WebSocket(`ws://127.0.0.1:${relay.address()}`)),
+  await measure('ipc', IpcSocket.connect(ipcPath))
+];
+print(JSON.stringify(results, null, 2));
+await relay.stop();
+process.exit(0);
@@ -0,0 +1,125 @@
+/**
+ * Command latency: remote relay across an emulated WAN versus the
+ * controller's LAN relay.
+ *
+ * The remote relay sits behind an in-process TCP proxy that delays every
+ * chunk by WAN_DELAY_MS ± WAN_JITTER_MS in each direction (order preserved).
+ * The LAN relay is found through the real UDP discovery path. Measures the
+ * time from the controller's RESTART to the follower's CLIENT_RESTARTED.
+ *
+ * For a kernel-level emulation instead of the proxy, run the relay on
+ * another host or namespace and shape it with e.g.
+ *   tc qdisc add dev <if> root netem delay 40ms 10ms
+ *
+ *   npx tsx bench/lan-direct.ts
+ */
+import net from 'net';
+import { RelayServer } from '../src/relay-server/relay-server.js';
+import { NetworkServer } from '../src/controller/network-server.js';
+import { SessionClient } from '../src/controller/session-client.js';
+import { LanDiscovery } from '../src/shared/lan-discovery.js';
+import { Histogram } from '../src/shared/metrics.js';
+
+const COMMANDS = 50;
+const WAN_DELAY_MS = Number(process.env.WAN_DELAY_MS ?? 40);
+const WAN_JITTER_MS = Number(process.env.WAN_JITTER_MS ?? 10);
+const DISCOVERY_PORT = 18089;
+
+const print = (line: string) => process.stdout.write(line + '\n');
+console.log = () => {};
+
+const sleep = (ms: number) => new Promise(resolve => setTimeout(resolve, ms));
+
+/**
+ * Forward to target, delaying each chunk one way without reordering
+ */
+function wanProxy(targetPort: number): Promise<number> {
+  const delayed = (from: net.Socket, to: net.Socket) => {
+    let releaseAt = 0;
+    from.on('data', chunk => {
+      const jitter = (Math.random() * 2 - 1) * WAN_JITTER_MS;
+      releaseAt = Math.max(releaseAt, Date.now() + WAN_DELAY_MS + jitter);
+      setTimeout(() => to.write(chunk), releaseAt - Date.now());
+    });
+    from.on('close', () => setTimeout(() => to.destroy(), WAN_DELAY_MS));
+    from.on('error', () => {});
+  };
+
+  const server = net.createServer(client => {
+    const upstream = net.connect(targetPort, '127.0.0.1');
+    delayed(client, upstream);
+    delayed(upstream, client);
+  });
+  return new Promise(resolve => server.listen(0, '127.0.0.1', () => resolve((server.address() as net.AddressInfo).port)));
+}
+
+async function measure(path: string, controller: SessionClient, follower: SessionClient) {
+  const latency = new Histogram(COMMANDS);
+  let received: (() => void) | undefined;
+  follower.setClientRestartedCallback(() => received?.());
+
+  for (let i = 0; i < COMMANDS; i++) {
+    const start = performance.now();
+    await new Promise<void>(resolve => {
+      received = resolve;
+      controller.broadcastRestart();
+    });
+    latency.record(performance.now() - start);
+    await sleep(20);
+  }
+
+  const { mean, p50, p99, max } = latency.snapshot();
+  return {
+    path,
+    commands: COMMANDS,
+    latencyMs: { mean: +mean.toFixed(2), p50: +p50.toFixed(2), p99: +p99.toFixed(2), max: +max.toFixed(2) }
+  };
+}
+
+async function waitForSession(client: SessionClient) {
+  while (!client.connected() || !client.getSessionToken()) await sleep(20);
+  await sleep(200);
+}
+
+// Remote relay behind the emulated WAN
+const remote = new RelayServer(0, { host: '127.0.0.1' });
+await remote.start();
+const wanPort = await wanProxy(remote.address());
+
+const remoteController = new SessionClient('127.0.0.1', wanPort, 'controller');
+await remoteController.connect();
+await waitForSession(remoteController);
+const token = remoteController.getSessionToken()!;
+
+const remoteFollower = new SessionClient('127.0.0.1', wanPort, 'follower');
+await remoteFollower.connect(token);
+await waitForSession(remoteFollower);
+
+// LAN relay hosted by the controller, announced on loopback for the bench
+const lan = new NetworkServer(0, token, DISCOVERY_PORT, '127.0.0.1');
+await lan.start();
+const lanController = new SessionClient('127.0.0.1', lan.address(), 'controller');
+await lanController.connect(token);
+await waitForSession(lanController);
+
+const discovery = new LanDiscovery(token, DISCOVERY_PORT);
+discovery.start();
+const discoveryStart = performance.now();
+const found = await discovery.waitForRelay(5000);
+if (!found) throw new Error('LAN relay was not discovered');
+const discoveryMs = performance.now() - discoveryStart;
+
+const lanFollower = new SessionClient('127.0.0.1', wanPort, 'follower');
+lanFollower.switchEndpoint(found.host, found.port, {}, found.sessionToken);
+await waitForSession(lanFollower);
+
+const results = [
+  await measure(`remote (WAN ${WAN_DELAY_MS}±${WAN_JITTER_MS}ms one way)`, remoteController, remoteFollower),
+  await measure('lan-direct', lanController, lanFollower)
+];
+print(JSON.stringify({ discoveryMs: Math.round(discoveryMs), results }, null, 2));
+
+discovery.stop();
+await lan.close();
+await remote.stop();
+process.exit(0);
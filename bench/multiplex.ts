@@ -0,0 +1,73 @@
+/**
+ * Dual-role host: a controller and a follower in one process, first on a
+ * socket each, then multiplexed over one shared socket. Reports relay
+ * sockets, heartbeat frames per keepalive round (both clients send their
+ * heartbeat, as the apps do every 30s) and controller-to-follower command
+ * latency in both modes.
+ *
+ *   npx tsx bench/multiplex.ts
+ */
+import { RelayServer } from '../src/relay-server/relay-server.js';
+import { SessionClient } from '../src/controller/session-client.js';
+import { Histogram, metrics } from '../src/shared/metrics.js';
+
+const COMMANDS = 200;
+
+const print = (line: string) => process.stdout.write(line + '\n');
+console.log = () => {};
+
+const sleep = (ms: number) => new Promise(resolve => setTimeout(resolve, ms));
+
+const relay = new RelayServer(0, { host: '127.0.0.1' });
+await relay.start();
+const port = relay.address();
+
+async function measure(multiplex: boolean) {
+  const controller = new SessionClient('127.0.0.1', port, 'controller', { multiplex });
+  let token: string | undefined;
+  controller.setJoinedCallback(joined => { token = joined; });
+  await controller.connect();
+  while (!token) await sleep(5);
+
+  const follower = new SessionClient('127.0.0.1', port, 'follower', { multiplex });
+  let joined = false;
+  follower.setJoinedCallback(() => { joined = true; });
+  await follower.connect(token);
+  while (!joined) await sleep(5);
+
+  const sockets = metrics.gauge('relay.sockets.open').get();
+  const heartbeatsBefore = metrics.counter('relay.heartbeats').get();
+  controller.sendHeartbeat();
+  follower.sendHeartbeat();
+  await sleep(50);
+  const heartbeats = metrics.counter('relay.heartbeats').get() - heartbeatsBefore;
+
+  const latency = new Histogram(COMMANDS);
+  let received: (() => void) | undefined;
+  follower.setClientRestartedCallback(() => received?.());
+  for (let i = 0; i < COMMANDS; i++) {
+    const start = performance.now();
+    await new Promise<void>(resolve => { received = resolve; controller.broadcastRestart(); });
+    latency.record(performance.now() - start);
+  }
+
+  follower.disconnect();
+  controller.disconnect();
+  await sleep(50);
+
+  const { p50, p99 } = latency.snapshot();
+  return {
+    relaySockets: sockets,
+    heartbeatFramesPerRound: heartbeats,
+    commandP50Ms: +p50.toFixed(3),
+    commandP99Ms: +p99.toFixed(3)
+  };
+}
+
+const separate = await measure(false);
+const multiplexed = await measure(true);
+
+print(JSON.stringify({ separate, multiplexed }, null, 2));
+
+await relay.stop();
+process.exit(multiplexed.relaySockets === 1 && separate.relaySockets === 2 ? 0 : 1);
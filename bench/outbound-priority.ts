@@ -0,0 +1,71 @@
+/**
+ * Command latency under informational saturation.
+ *
+ * A slow reader (socket paused most of the time) receives a flood of
+ * SESSIONS_UPDATE-sized frames while the server sends a command every
+ * 100ms. Compares plain ws.send against the prioritized OutboundQueue.
+ *
+ *   npx tsx bench/outbound-priority.ts
+ */
+import { WebSocketServer, WebSocket } from 'ws';
+import type { AddressInfo } from 'net';
+import { OutboundQueue } from '../src/relay-server/outbound-queue.js';
+import { Histogram } from '../src/shared/metrics.js';
+
+const DURATION_MS = 3000;
+const INFO_PAYLOAD = JSON.stringify({ type: 'SESSIONS_UPDATE', payload: { sessions: 'x'.repeat(16 * 1024) } });
+
+async function run(mode: 'direct' | 'queued') {
+  const wss = new WebSocketServer({ port: 0 });
+  await new Promise(resolve => wss.once('listening', resolve));
+  const port = (wss.address() as AddressInfo).port;
+
+  const serverSide = new Promise<WebSocket>(resolve => wss.once('connection', resolve));
+  const client = new WebSocket(`ws://127.0.0.1:${port}`);
+  await new Promise(resolve => client.once('open', resolve));
+  const ws = await serverSide;
+
+  const latency = new Histogram(4096);
+  let infoReceived = 0;
+  client.on('message', (data: Buffer) => {
+    const message = JSON.parse(data.toString());
+    if (message.type === 'IMMEDIATE_START') latency.record(Date.now() - message.sentAt);
+    else infoReceived++;
+  });
+
+  // Slow reader: read for 2ms out of every 100ms
+  const socket = (client as any)._socket;
+  const reader = setInterval(() => {
+    socket.resume();
+    setTimeout(() => socket.pause(), 2);
+  }, 100);
+
+  const queue = new OutboundQueue(ws);
+  const send = (type: string, data: string) => mode === 'queued' ? queue.enqueue(type, data) : ws.send(data);
+
+  const flood = setInterval(() => {
+    for (let i = 0; i < 50; i++) send('SESSIONS_UPDATE', INFO_PAYLOAD);
+  }, 10);
+  const commands = setInterval(() => {
+    send('IMMEDIATE_START', JSON.stringify({ type: 'IMMEDIATE_START', sentAt: Date.now() }));
+  }, 100);
+
+  await new Promise(resolve => setTimeout(resolve, DURATION_MS));
+  clearInterval(flood);
+  clearInterval(commands);
+  clearInterval(reader);
+
+  // Drain so in-flight commands are counted
+  socket.resume();
+  await new Promise(resolve => setTimeout(resolve, 1000));
+
+  const result = { mode, commands: latency.snapshot(), infoReceived, queued: queue.depth() };
+  queue.dispose();
+  client.terminate();
+  wss.close();
+  return result;
+}
+
+const results = [await run('direct'), await run('queued')];
+console.log(JSON.stringify(results, null, 2));
+process.exit(0);
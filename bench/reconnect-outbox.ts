@@ -0,0 +1,88 @@
+/**
+ * Commands issued while the controller is cut off from the relay.
+ *
+ * The controller reaches the relay through an ImpairmentProxy, the
+ * follower connects directly. Each round takes the proxy down for OUTAGE
+ * ms, has the controller send a few status updates and one RESTART half
+ * way through, and measures when the follower gets the command: from the
+ * issue and from the end of the outage. The status updates should arrive
+ * as a single (the latest) STATUS_UPDATE.
+ *
+ *   npm run bench:outbox -- [rounds] [outageMs]
+ */
+import { RelayServer } from '../src/relay-server/relay-server.js';
+import { SessionClient } from '../src/controller/session-client.js';
+import { Histogram, metrics } from '../src/shared/metrics.js';
+import { ImpairmentProxy } from './impair/proxy.js';
+
+const PORT = 18191;
+const ROUNDS = Number(process.argv[2] ?? 5);
+const OUTAGE_MS = Number(process.argv[3] ?? 2000);
+const STATUS_UPDATES = 5;
+
+const print = (line: string) => process.stdout.write(line + '\n');
+console.log = () => {};
+
+const sleep = (ms: number) => new Promise(resolve => setTimeout(resolve, ms));
+
+const relay = new RelayServer(PORT, { host: '127.0.0.1' });
+await relay.start();
+const proxy = new ImpairmentProxy('127.0.0.1', PORT);
+const proxyPort = await proxy.listen();
+
+const controller = new SessionClient('127.0.0.1', proxyPort, 'controller');
+await controller.connect();
+while (!controller.getSessionToken()) await sleep(20);
+const follower = new SessionClient('127.0.0.1', PORT, 'follower');
+await follower.connect(controller.getSessionToken());
+while (!follower.getSessionToken()) await sleep(20);
+await sleep(200);
+
+let received: (() => void) | undefined;
+follower.setClientRestartedCallback(() => received?.());
+
+const fromIssue = new Histogram(ROUNDS);
+const fromRecovery = new Histogram(ROUNDS);
+let lost = 0;
+for (let round = 0; round < ROUNDS; round++) {
+  const outageEnd = performance.now() + OUTAGE_MS;
+  proxy.outage(OUTAGE_MS);
+  await sleep(OUTAGE_MS / 4);
+  for (let i = 0; i < STATUS_UPDATES; i++) controller.sendStatus(i % 2 === 0, i);
+  await sleep(OUTAGE_MS / 4);
+
+  const issuedAt = performance.now();
+  const delivered = await Promise.race([
+    new Promise<boolean>(resolve => { received = () => resolve(true); controller.broadcastRestart(); }),
+    sleep(OUTAGE_MS + 10_000).then(() => false)
+  ]);
+  if (delivered) {
+    fromIssue.record(performance.now() - issuedAt);
+    fromRecovery.record(performance.now() - outageEnd);
+  } else {
+    lost++;
+  }
+  await sleep(500);
+}
+
+const snapshot = metrics.snapshot();
+const { p50, p99 } = fromRecovery.snapshot();
+print(JSON.stringify({
+  rounds: ROUNDS,
+  outageMs: OUTAGE_MS,
+  lost,
+  issueToDeliveryP50Ms: Math.round(fromIssue.snapshot().p50),
+  recoveryToDeliveryMs: { p50: Math.round(p50), p99: Math.round(p99) },
+  outbox: {
+    queued: snapshot.counters['controller.outbox.queued'],
+    coalesced: snapshot.counters['controller.outbox.coalesced'],
+    expired: snapshot.counters['controller.outbox.expired'],
+    dropped: snapshot.counters['controller.outbox.dropped']
+  }
+}, null, 2));
+
+controller.disconnect();
+follower.disconnect();
+await proxy.close();
+await relay.stop();
+process.exit(lost === 0 ? 0 : 1);
@@ -0,0 +1,121 @@
+/**
+ * Multi-relay selection and failover.
+ *
+ * Two federated relays, each behind an ImpairmentProxy: "near" adds 5ms
+ * one way, "far" 40ms. The controller is given both endpoints and should
+ * pick near by RTT; the follower only knows far, so its commands cross the
+ * federation link. Then near has an outage and the controller must fail
+ * over to far with the same session token. Reports the RTTs measured,
+ * command latency before and after, and the time from the outage to the
+ * first command delivered again.
+ *
+ *   npx tsx bench/relay-failover.ts
+ */
+import { RelayServer } from '../src/relay-server/relay-server.js';
+import { SessionClient } from '../src/controller/session-client.js';
+import { RelaySelector, endpointKey } from '../src/shared/relay-endpoints.js';
+import type { RelayEndpoint } from '../src/shared/relay-endpoints.js';
+import { Histogram, metrics } from '../src/shared/metrics.js';
+import { ImpairmentProxy } from './impair/proxy.js';
+
+const NEAR_PORT = 18181;
+const FAR_PORT = 18182;
+const COMMANDS = 20;
+const SECRET = 'bench-federation';
+
+const print = (line: string) => process.stdout.write(line + '\n');
+console.log = () => {};
+
+const sleep = (ms: number) => new Promise(resolve => setTimeout(resolve, ms));
+
+const near = new RelayServer(NEAR_PORT, { host: '127.0.0.1', federation: { peers: [`ws://127.0.0.1:${FAR_PORT}`], secret: SECRET } });
+const far = new RelayServer(FAR_PORT, { host: '127.0.0.1', federation: { peers: [`ws://127.0.0.1:${NEAR_PORT}`], secret: SECRET } });
+await near.start();
+await far.start();
+// near's first link attempt races far's startup; wait for both links
+while (metrics.gauge('relay.federation.peers_connected').get() < 2) await sleep(50);
+
+const nearProxy = new ImpairmentProxy('127.0.0.1', NEAR_PORT, { latencyMs: 5 });
+const farProxy = new ImpairmentProxy('127.0.0.1', FAR_PORT, { latencyMs: 40 });
+const endpoints: RelayEndpoint[] = [
+  { host: '127.0.0.1', port: await farProxy.listen() },
+  { host: '127.0.0.1', port: await nearProxy.listen() }
+];
+const nearKey = endpointKey(endpoints[1]);
+
+// Controller: lowest RTT of both, failover enabled
+const selector = new RelaySelector(endpoints, { probeIntervalMs: 0 });
+const chosen = await selector.selectBest();
+const controller = new SessionClient(chosen.host, chosen.port, 'controller');
+controller.useRelaySelector(selector, () => ({}));
+await controller.connect();
+while (!controller.connected() || !controller.getSessionToken()) await sleep(20);
+const token = controller.getSessionToken()!;
+
+// Follower: far relay only, same token (adopted there through federation)
+const follower = new SessionClient(endpoints[0].host, endpoints[0].port, 'follower');
+await follower.connect(token);
+while (!follower.connected()) await sleep(20);
+await sleep(500);
+
+let received: (() => void) | undefined;
+follower.setClientRestartedCallback(() => received?.());
+
+async function measure(): Promise<object> {
+  const latency = new Histogram(COMMANDS);
+  let timeouts = 0;
+  for (let i = 0; i < COMMANDS; i++) {
+    const start = performance.now();
+    const delivered = await Promise.race([
+      new Promise<boolean>(resolve => { received = () => resolve(true); controller.broadcastRestart(); }),
+      sleep(5000).then(() => false)
+    ]);
+    if (delivered) latency.record(performance.now() - start);
+    else timeouts++;
+    await sleep(20);
+  }
+  const { p50, p99 } = latency.snapshot();
+  return { commands: COMMANDS, timeouts, p50Ms: +p50.toFixed(1), p99Ms: +p99.toFixed(1) };
+}
+
+const before = await measure();
+
+// Outage on the near relay while commands keep going out every 100ms
+const outageStart = performance.now();
+let recoveredAt: number | undefined;
+received = () => { recoveredAt ??= performance.now(); };
+nearProxy.outage(60_000);
+const sender = setInterval(() => controller.broadcastRestart(), 100);
+while (recoveredAt === undefined && performance.now() - outageStart < 30_000) await sleep(10);
+clearInterval(sender);
+await sleep(500);
+
+const after = await measure();
+const snapshot = metrics.snapshot();
+
+print(JSON.stringify({
+  rttMs: Object.fromEntries(Object.entries(snapshot.gauges)
+    .filter(([name]) => name.startsWith('client.relay.rtt_ms.'))
+    .map(([name, gauge]) => [name.slice('client.relay.rtt_ms.'.length), +gauge.max.toFixed(1)])),
+  initiallySelected: endpointKey(chosen) === nearKey ? 'near' : 'far',
+  federatedCommands: before,
+  failover: {
+    recovered: recoveredAt !== undefined,
+    outageToFirstCommandMs: recoveredAt === undefined ? null : Math.round(recoveredAt - outageStart),
+    selectedAfter: endpointKey(selector.current()) === nearKey ? 'near' : 'far',
+    failovers: snapshot.counters['client.relay.failovers']
+  },
+  afterFailover: after,
+  federation: {
+    forwarded: snapshot.counters['relay.federation.forwarded'],
+    received: snapshot.counters['relay.federation.received']
+  }
+}, null, 2));
+
+controller.disconnect();
+follower.disconnect();
+await nearProxy.close();
+await farProxy.close();
+await near.stop();
+await far.stop();
+process.exit(recoveredAt !== undefined && endpointKey(chosen) === nearKey ? 0 : 1);
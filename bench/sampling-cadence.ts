@@ -0,0 +1,254 @@
+/**
+ * Process monitor sampling cadence against stub processes. Copies of
+ * `sleep` named LeagueClient, LeagueClientUx and LeagueGame stand in for
+ * the real processes; a monitor modelled on ClientMonitor counts them with
+ * pgrep, relaunches a missing client (which ramps up to 8 Ux processes),
+ * kills the game and waits for the Ux count to reach 8. The same scripted
+ * timeline runs with the old fixed 5s interval and with the adaptive
+ * cadence, time-scaled 1/20 (results are reported in real-time units).
+ *
+ * Reports how long each kind of transition takes to be noticed, and probes
+ * and probe CPU (this process plus the pgrep children) while stable.
+ * Then checks that ClientMonitor.waitForProcessCount, called right after
+ * a kill, waits for a fresh count instead of the one cached before it.
+ *
+ *   npx tsx bench/sampling-cadence.ts            (Linux/macOS, needs pgrep)
+ */
+import { spawn, exec } from 'child_process';
+import type { ChildProcess } from 'child_process';
+import { promisify } from 'util';
+import { copyFileSync, existsSync, mkdtempSync, readFileSync, rmSync, chmodSync } from 'fs';
+import { tmpdir } from 'os';
+import { join } from 'path';
+import { SamplingCadence, DEFAULT_SAMPLING_OPTIONS } from '../src/shared/sampling-cadence.js';
+import { ClientMonitor } from '../src/controller/client-monitor.js';
+import { ProcessUtils } from '../src/shared/process-utils.js';
+import type { SamplingOptions } from '../src/shared/sampling-cadence.js';
+
+const SCALE = 20;            // everything below is real time / SCALE
+const RAMP_STEP_MS = 4000;   // a launched client adds a Ux process this often
+const THRESHOLD = 8;
+const STABLE_MS = 200_000;   // stable stretch measured for steady-state cost
+const CYCLES = 2;
+
+const print = (line: string) => process.stdout.write(line + '\n');
+const sleep = (ms: number) => new Promise(resolve => setTimeout(resolve, ms / SCALE));
+const execAsync = promisify(exec);
+
+const POLICIES: Array<[string, Partial<SamplingOptions>]> = [
+  ['fixed 5s', { fastMs: 5000, maxMs: 5000 }],
+  ['adaptive', DEFAULT_SAMPLING_OPTIONS]
+];
+
+const scaled = (options: Partial<SamplingOptions>): Partial<SamplingOptions> => ({
+  ...options,
+  fastMs: options.fastMs! / SCALE,
+  maxMs: options.maxMs! / SCALE,
+  burstMs: (options.burstMs ?? DEFAULT_SAMPLING_OPTIONS.burstMs) / SCALE
+});
+
+// Stub executables: comm (what pgrep -x matches) is the file name
+const stubDir = mkdtempSync(join(tmpdir(), 'sampling-stubs-'));
+const sleepBinary = ['/bin/sleep', '/usr/bin/sleep'].find(path => existsSync(path))!;
+const stubPath = (name: string) => join(stubDir, name);
+for (const name of ['LeagueClient', 'LeagueClientUx', 'LeagueGame']) {
+  copyFileSync(sleepBinary, stubPath(name));
+  chmodSync(stubPath(name), 0o755);
+}
+
+class Stubs {
+  private processes: Map<string, ChildProcess[]> = new Map();
+
+  start(name: string): void {
+    const child = spawn(stubPath(name), ['100000'], { stdio: 'ignore' });
+    const list = this.processes.get(name) ?? [];
+    list.push(child);
+    this.processes.set(name, list);
+  }
+
+  kill(name: string): void {
+    (this.processes.get(name) ?? []).forEach(child => child.kill('SIGKILL'));
+    this.processes.set(name, []);
+  }
+
+  killAll(): void {
+    this.processes.forEach((_, name) => this.kill(name));
+  }
+}
+
+async function count(name: string): Promise<number> {
+  try {
+    const { stdout } = await execAsync(`pgrep -c -x ${name}`);
+    return Number(stdout.trim());
+  } catch {
+    return 0; // pgrep exits 1 when nothing matches
+  }
+}
+
+// utime + stime + cutime + cstime of this process, in ms
+function cpuMs(): number {
+  const fields = readFileSync('/proc/self/stat', 'utf-8').split(') ')[1].split(' ');
+  return (Number(fields[11]) + Number(fields[12]) + Number(fields[13]) + Number(fields[14])) * 10;
+}
+
+type Transition = 'client lost' | 'threshold reached' | 'game (unprompted)' | 'game (after command)';
+
+async function run(options: Partial<SamplingOptions>) {
+  const stubs = new Stubs();
+  const detections: Record<Transition, number[]> = {
+    'client lost': [], 'threshold reached': [], 'game (unprompted)': [], 'game (after command)': []
+  };
+  const pending: Partial<Record<Transition, number>> = {};
+  const happened = (transition: Transition) => { pending[transition] = performance.now(); };
+  const noticed = (transition: Transition) => {
+    const at = pending[transition];
+    if (at === undefined) return;
+    detections[transition].push((performance.now() - at) * SCALE);
+    delete pending[transition];
+  };
+
+  let launching = false;
+  let ready = false;
+  let lastState = '';
+  let ramp: Promise<void> = Promise.resolve();
+  let probes = 0;
+
+  const launch = () => {
+    launching = true;
+    ready = false;
+    cadence.burst();
+    stubs.start('LeagueClient');
+    ramp = (async () => {
+      for (let i = 0; i < THRESHOLD; i++) {
+        await sleep(RAMP_STEP_MS);
+        stubs.start('LeagueClientUx');
+        if (i === THRESHOLD - 1) happened('threshold reached');
+      }
+      launching = false;
+    })();
+  };
+
+  // Modelled on ClientMonitor.sample(): restart a missing client, kill the game, watch the count
+  const sample = async (): Promise<boolean> => {
+    probes++;
+    const clientCount = await count('LeagueClient');
+    if (clientCount === 0 && !launching) {
+      noticed('client lost');
+      launch();
+    }
+    const gameRunning = (await count('LeagueGame')) > 0;
+    if (gameRunning) {
+      noticed('game (unprompted)');
+      noticed('game (after command)');
+      stubs.kill('LeagueGame');
+      cadence.burst();
+    }
+    const uxCount = await count('LeagueClientUx');
+    if (uxCount >= THRESHOLD && !ready) {
+      ready = true;
+      noticed('threshold reached');
+    }
+
+    const state = `${clientCount}/${gameRunning}/${uxCount}`;
+    const changed = state !== lastState;
+    lastState = state;
+    return changed;
+  };
+
+  const cadence = new SamplingCadence('bench.monitor', sample, scaled(options));
+  let steadyProbes = 0;
+  let steadyCpuMs = 0;
+  let steadyMs = 0;
+
+  happened('client lost'); // nothing running at startup
+  cadence.start();
+  for (let cycle = 0; cycle < CYCLES; cycle++) {
+    while (!ready) await sleep(500);
+    await ramp;
+
+    // Stable stretch: what the monitor costs while nothing happens
+    await sleep(STABLE_MS / 4); // settle
+    const probesBefore = probes;
+    const cpuBefore = cpuMs();
+    const started = performance.now();
+    await sleep(STABLE_MS);
+    steadyProbes += probes - probesBefore;
+    steadyCpuMs += cpuMs() - cpuBefore;
+    steadyMs += (performance.now() - started) * SCALE;
+
+    // A game starts on its own
+    stubs.start('LeagueGame');
+    happened('game (unprompted)');
+    while (pending['game (unprompted)'] !== undefined) await sleep(100);
+    await sleep(60_000);
+
+    // A command arrives (burst), and its effect shows up a few seconds later
+    cadence.burst();
+    await sleep(3000);
+    stubs.start('LeagueGame');
+    happened('game (after command)');
+    while (pending['game (after command)'] !== undefined) await sleep(100);
+    await sleep(60_000);
+
+    // The client dies on its own; the monitor relaunches it and waits for the threshold
+    stubs.kill('LeagueClient');
+    stubs.kill('LeagueClientUx');
+    happened('client lost');
+  }
+  while (!ready) await sleep(500);
+
+  cadence.stop();
+  stubs.killAll();
+  // Stable stretches ran 1/SCALE of real time, with the same number of probes
+  return { detections, steadyProbesPerMin: steadyProbes / (steadyMs / 60_000), steadyCpuMsPerMin: steadyCpuMs / (steadyMs / 60_000) };
+}
+
+// The real ClientMonitor with its probes stubbed (and a Windows platform, where it counts processes)
+async function staleCountCheck(): Promise<{ waitedMs: number; count: number }> {
+  let uxCount = THRESHOLD;
+  let rampedAt = 0;
+  ProcessUtils.getProcessPids = async () => [1];
+  ProcessUtils.isAnyProcessRunning = async () => false;
+  ProcessUtils.checkVgcServiceExitCode185 = async () => false;
+  ProcessUtils.getProcessCountByDescription = async () => uxCount;
+  Object.defineProperty(process, 'platform', { value: 'win32' });
+  const log = console.log;
+  console.log = () => {};
+
+  const monitor = new ClientMonitor({ fastMs: 50, maxMs: 50 });
+  await monitor.start();
+  await sleep(200 * SCALE); // a few samples at the threshold
+  uxCount = 0; // killed: the monitor's cached count still says THRESHOLD
+  const started = performance.now();
+  const waited = monitor.waitForProcessCount(THRESHOLD, 2000);
+  setTimeout(() => { uxCount = THRESHOLD; rampedAt = performance.now(); }, 300);
+  const count = await waited;
+  const waitedMs = performance.now() - started;
+  monitor.stop();
+  console.log = log;
+  if (!rampedAt || count < THRESHOLD) throw new Error(`waitForProcessCount resolved with ${count} before the count came back`);
+  return { waitedMs, count };
+}
+
+const mean = (values: number[]) => values.length ? values.reduce((a, b) => a + b, 0) / values.length : NaN;
+const seconds = (ms: number) => `${(ms / 1000).toFixed(1)}s`;
+
+print(`Stub processes in ${stubDir}; timeline time-scaled 1/${SCALE}, ${CYCLES} cycles`);
+print('');
+const results: Array<[string, Awaited<ReturnType<typeof run>>]> = [];
+for (const [label, options] of POLICIES) results.push([label, await run(options)]);
+rmSync(stubDir, { recursive: true, force: true });
+
+const transitions: Transition[] = ['threshold reached', 'game (after command)', 'game (unprompted)', 'client lost'];
+print(`${'mean time to notice'.padEnd(24)} ${results.map(([label]) => label.padEnd(12)).join(' ')}`);
+for (const transition of transitions) {
+  print(`${transition.padEnd(24)} ${results.map(([, result]) => seconds(mean(result.detections[transition])).padEnd(12)).join(' ')}`);
+}
+print('');
+print(`${'while stable'.padEnd(24)} ${results.map(([label]) => label.padEnd(12)).join(' ')}`);
+print(`${'probes per minute'.padEnd(24)} ${results.map(([, result]) => result.steadyProbesPerMin.toFixed(1).padEnd(12)).join(' ')}`);
+print(`${'probe CPU ms per minute'.padEnd(24)} ${results.map(([, result]) => result.steadyCpuMsPerMin.toFixed(0).padEnd(12)).join(' ')}`);
+print('');
+const stale = await staleCountCheck();
+print(`waitForProcessCount after a kill: resolved with ${stale.count} after ${Math.round(stale.waitedMs)}ms (count back at 300ms)`);
+process.exit(0);
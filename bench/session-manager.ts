@@ -0,0 +1,239 @@
+/**
+ * SessionManager microbenchmarks. For each scale (sessions x followers per
+ * session) a fresh process fills a SessionManager with controllers and
+ * followers on mock sockets, then times each operation on random sessions:
+ * ops/sec, p50/p99 and bytes allocated per call (sampled with the V8 heap
+ * profiler, including objects already collected).
+ *
+ *   npm run bench -- [--sessions 1000,10000] [--followers 1,100]
+ *                    [--max-clients 2000000] [--ops 10000] [--quick]
+ *                    [--out results.json] [--compare baseline.json]
+ *
+ * Scales above --max-clients (sessions x (followers + 1)) are skipped;
+ * 1k sessions x 10k followers needs --max-clients 11000000 and ~8GB of heap.
+ * --compare prints the change per operation against an earlier --out file.
+ */
+import { fork, execSync } from 'child_process';
+import { fileURLToPath } from 'url';
+import { readFileSync, writeFileSync } from 'fs';
+import { Session } from 'inspector';
+
+const print = (line: string) => process.stdout.write(line + '\n');
+console.log = () => {};
+console.warn = () => {};
+console.error = () => {};
+
+const TIME_BUDGET_MS = 2000;  // per operation; slow ones (getAllSessions at 1M) run fewer times
+const MIN_OPS = 5;
+const ALLOC_OPS = 200;        // calls sampled for allocations
+
+interface OpResult {
+  ops: number;
+  opsPerSec: number;
+  p50Us: number;
+  p99Us: number;
+  bytesPerOp: number;
+}
+
+interface ScaleResult {
+  sessions: number;
+  followers: number;
+  setupMs: number;
+  heapMB: number;
+  ops: Record<string, OpResult>;
+}
+
+function option(name: string): string | undefined {
+  const index = process.argv.indexOf(`--${name}`);
+  return index === -1 ? undefined : process.argv[index + 1];
+}
+
+const list = (value: string | undefined, fallback: number[]) => value ? value.split(',').map(Number) : fallback;
+
+// Child: one scale
+if (process.argv[2] === 'scale') {
+  const { SessionManager } = await import('../src/relay-server/session-manager.js');
+  const { OutboundQueue } = await import('../src/relay-server/outbound-queue.js');
+  type Queue = InstanceType<typeof OutboundQueue>;
+
+  const SESSIONS = Number(process.argv[3]);
+  const FOLLOWERS = Number(process.argv[4]);
+  const OPS = Number(process.argv[5]);
+
+  const queue = (): Queue => new OutboundQueue({
+    readyState: 1,
+    bufferedAmount: 0,
+    send: (_data, cb) => cb?.(),
+    close: () => {},
+    terminate: () => {}
+  });
+  const ipOf = (s: number) => `10.${(s >> 16) & 255}.${(s >> 8) & 255}.${s & 255}`;
+
+  // No per-IP or ownerless eviction, and no redelivery timers firing mid-run
+  const manager = new SessionManager(
+    { maxSessionsPerIp: Infinity, maxOwnerlessSessions: Infinity },
+    { initialDelayMs: 3_600_000 }
+  );
+
+  const setupStart = performance.now();
+  const tokens: string[] = [];
+  for (let s = 0; s < SESSIONS; s++) {
+    const { token } = manager.findOrCreateSessionByIp(ipOf(s), queue(), `c${s}`, 'controller')!;
+    tokens.push(token);
+    for (let f = 0; f < FOLLOWERS; f++) manager.joinSession(token, queue(), `f${s}_${f}`, 'follower');
+  }
+  const setupMs = performance.now() - setupStart;
+
+  // Random sessions picked up front so the timed loop only calls the manager
+  const picks = new Uint32Array(Math.max(OPS, ALLOC_OPS));
+  for (let i = 0; i < picks.length; i++) picks[i] = Math.floor(Math.random() * SESSIONS);
+
+  interface Operation {
+    run: (i: number, pass: string) => void;
+    cleanup?: (count: number, pass: string) => void;
+  }
+  const status = { clientRunning: true, processCount: 3 };
+  const operations: Record<string, Operation> = {
+    getSessionInfo: { run: i => manager.getSessionInfo(tokens[picks[i]]) },
+    getAllSessions: { run: () => manager.getAllSessions() },
+    getFleetSummary: { run: () => manager.getFleetSummary() },
+    joinSession: {
+      run: (i, pass) => manager.joinSession(tokens[picks[i]], queue(), `${pass}j${i}`, 'follower')
+    },
+    // Removes the followers joinSession just added (sessions keep their controller)
+    removeClient: { run: (i, pass) => manager.removeClient(`${pass}j${i}`) },
+    findOrCreateSessionByIp: {
+      run: (i, pass) => manager.findOrCreateSessionByIp(ipOf(picks[i]), queue(), `${pass}ip${i}`, 'follower'),
+      cleanup: (count, pass) => {
+        for (let i = 0; i < count; i++) manager.removeClient(`${pass}ip${i}`);
+      }
+    },
+    broadcastStatus: { run: i => manager.broadcastStatus(`c${picks[i]}`, status) },
+    broadcastRestart: { run: (i, pass) => manager.broadcastRestart(`c${picks[i]}`, `${pass}r${i}`) },
+    broadcastImmediateStart: { run: (i, pass) => manager.broadcastImmediateStart(`c${picks[i]}`, `${pass}s${i}`) }
+  };
+  if (FOLLOWERS > 0) {
+    operations.forwardGameStatus = { run: i => manager.forwardGameStatus(`f${picks[i]}_0`, true) };
+  }
+
+  const inspector = new Session();
+  inspector.connect();
+  const post = (method: string, params: object = {}) => new Promise<any>((resolve, reject) => {
+    inspector.post(method, params, (error, result) => error ? reject(error) : resolve(result));
+  });
+  await post('HeapProfiler.enable');
+  const totalSize = (node: any): number => node.selfSize + node.children.reduce((sum: number, child: any) => sum + totalSize(child), 0);
+
+  const results: Record<string, OpResult> = {};
+  const durations = new Float64Array(OPS);
+  // removeClient can only run as often as joinSession did
+  let joined = OPS;
+  let allocJoined = ALLOC_OPS;
+
+  for (const [name, operation] of Object.entries(operations)) {
+    const limit = name === 'removeClient' ? joined : OPS;
+    let count = 0;
+    const start = performance.now();
+    while (count < limit && (count < MIN_OPS || performance.now() - start < TIME_BUDGET_MS)) {
+      const t0 = performance.now();
+      operation.run(count, 't');
+      durations[count++] = performance.now() - t0;
+    }
+    const elapsed = performance.now() - start;
+    operation.cleanup?.(count, 't');
+    if (name === 'joinSession') joined = count;
+
+    // Allocation pass under the sampling heap profiler (its overhead stays out of the timings)
+    const allocLimit = Math.min(name === 'removeClient' ? allocJoined : ALLOC_OPS, count);
+    await post('HeapProfiler.startSampling', { samplingInterval: 128, includeObjectsCollectedByMajorGC: true, includeObjectsCollectedByMinorGC: true });
+    for (let i = 0; i < allocLimit; i++) operation.run(i, 'a');
+    const { profile } = await post('HeapProfiler.stopSampling');
+    operation.cleanup?.(allocLimit, 'a');
+    if (name === 'joinSession') allocJoined = allocLimit;
+
+    const sorted = Array.from(durations.subarray(0, count)).sort((a, b) => a - b);
+    const at = (p: number) => sorted[Math.min(count - 1, Math.floor(count * p))];
+    results[name] = {
+      ops: count,
+      opsPerSec: Math.round(count / (elapsed / 1000)),
+      p50Us: +(at(0.5) * 1000).toFixed(2),
+      p99Us: +(at(0.99) * 1000).toFixed(2),
+      bytesPerOp: allocLimit > 0 ? Math.round(totalSize(profile.head) / allocLimit) : 0
+    };
+  }
+
+  const result: ScaleResult = {
+    sessions: SESSIONS,
+    followers: FOLLOWERS,
+    setupMs: Math.round(setupMs),
+    heapMB: Math.round(process.memoryUsage().heapUsed / 1e6),
+    ops: results
+  };
+  manager.dispose();
+  process.send!(result);
+  process.exit(0);
+} else {
+  const quick = process.argv.includes('--quick');
+  const sessions = list(option('sessions'), quick ? [1000, 10000] : [1000, 10000, 100000, 1000000]);
+  const followers = list(option('followers'), quick ? [1, 100] : [1, 10, 100, 1000, 10000]);
+  const maxClients = Number(option('max-clients') ?? 2_000_000);
+  const ops = Number(option('ops') ?? 10000);
+
+  const scales: ScaleResult[] = [];
+  const skipped: string[] = [];
+  for (const s of sessions) {
+    for (const f of followers) {
+      if (s * (f + 1) > maxClients) {
+        skipped.push(`${s}x${f}`);
+        continue;
+      }
+      const child = fork(fileURLToPath(import.meta.url), ['scale', String(s), String(f), String(ops)], {
+        stdio: ['ignore', 'ignore', 'inherit', 'ipc'],
+        execArgv: [...process.execArgv, '--max-old-space-size=8192']
+      });
+      const result = await new Promise<ScaleResult | undefined>(resolve => {
+        child.once('message', message => resolve(message as ScaleResult));
+        child.once('exit', () => resolve(undefined));
+      });
+      if (result) scales.push(result);
+      else skipped.push(`${s}x${f} (crashed)`);
+      process.stderr.write(`${s} sessions x ${f} followers done\n`);
+    }
+  }
+
+  let commit = 'unknown';
+  try {
+    commit = execSync('git rev-parse --short HEAD', { stdio: ['ignore', 'pipe', 'ignore'] }).toString().trim();
+  } catch {}
+  const report = { commit, node: process.version, date: new Date().toISOString(), skipped, scales };
+
+  const out = option('out');
+  if (out) writeFileSync(out, JSON.stringify(report, null, 2) + '\n');
+
+  const compare = option('compare');
+  if (!compare) {
+    print(JSON.stringify(report, null, 2));
+  } else {
+    // Percent change against the baseline: positive opsPerSec is faster, positive p99/bytes is worse
+    const baseline = JSON.parse(readFileSync(compare, 'utf8'));
+    const change = (now: number, before: number) => before ? `${now >= before ? '+' : ''}${((now / before - 1) * 100).toFixed(1)}%` : 'n/a';
+    const diff: Record<string, Record<string, object>> = {};
+    for (const scale of scales) {
+      const before: ScaleResult | undefined = baseline.scales.find((b: ScaleResult) => b.sessions === scale.sessions && b.followers === scale.followers);
+      if (!before) continue;
+      const key = `${scale.sessions}x${scale.followers}`;
+      diff[key] = {};
+      for (const [name, result] of Object.entries(scale.ops)) {
+        const old = before.ops[name];
+        if (!old) continue;
+        diff[key][name] = {
+          opsPerSec: change(result.opsPerSec, old.opsPerSec),
+          p99Us: change(result.p99Us, old.p99Us),
+          bytesPerOp: change(result.bytesPerOp, old.bytesPerOp)
+        };
+      }
+    }
+    print(JSON.stringify({ baseline: baseline.commit, commit, diff }, null, 2));
+  }
+  process.exit(0);
+}
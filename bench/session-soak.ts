@@ -0,0 +1,152 @@
+/**
+ * Session index soak: simulates weeks of relay traffic against a
+ * SessionManager on a fake clock and checks that memory and index sizes
+ * stay flat and that no index entry outlives its session.
+ *
+ * Each simulated hour: controllers connect (auto-join by IP), followers
+ * join by token, some clients re-join another session, scripts spam
+ * POST /create-session, and older connections drop. Expired and evicted
+ * sessions close their sockets, which report back through removeClient
+ * like the relay's close handler does. Finally one IP fills its session
+ * limit: only sessions without clients may be evicted, and once every
+ * session has a client the next one is refused.
+ *
+ *   npx tsx bench/session-soak.ts [days]
+ */
+import v8 from 'v8';
+import vm from 'vm';
+import { SessionManager } from '../src/relay-server/session-manager.js';
+import { OutboundQueue } from '../src/relay-server/outbound-queue.js';
+import type { RelaySocket } from '../src/relay-server/outbound-queue.js';
+
+const DAYS = Number(process.argv[2] ?? 21);
+const CONTROLLERS_PER_HOUR = 60;
+const CREATE_SPAM_PER_HOUR = 40;
+const IP_POOL = 3000;
+
+const print = (line: string) => process.stdout.write(line + '\n');
+console.log = () => {};
+console.warn = () => {};
+console.error = () => {};
+
+v8.setFlagsFromString('--expose-gc');
+const gc: () => void = vm.runInNewContext('gc');
+
+// Simulated clock
+let now = Date.now();
+Date.now = () => now;
+
+const manager = new SessionManager();
+manager.on('activity', () => {});
+
+interface Client { id: string; leaveAt: number; }
+let live: Client[] = [];
+let nextId = 0;
+
+function connect(lifetimeMs: number): { id: string; outbound: OutboundQueue } {
+  const id = `c${nextId++}`;
+  const socket: RelaySocket = {
+    readyState: 1,
+    bufferedAmount: 0,
+    send: (_data, cb) => cb?.(),
+    // Relay close handler: the socket goes away and the client is removed
+    close: () => queueMicrotask(() => manager.removeClient(id)),
+    terminate: () => queueMicrotask(() => manager.removeClient(id))
+  };
+  live.push({ id, leaveAt: now + lifetimeMs });
+  return { id, outbound: new OutboundQueue(socket) };
+}
+
+const randomIp = () => `10.${Math.floor(Math.random() * IP_POOL / 250)}.${Math.floor(Math.random() * 250)}.1`;
+const lifetime = () => Math.random() < 0.9 ? Math.random() * 3 * 3600_000 : Math.random() * 3 * 86400_000;
+
+function simulateHour(): void {
+  const tokens: string[] = [];
+
+  for (let i = 0; i < CONTROLLERS_PER_HOUR; i++) {
+    const controller = connect(lifetime());
+    const created = manager.findOrCreateSessionByIp(randomIp(), controller.outbound, controller.id, 'controller');
+    if (!created) continue; // that IP's sessions all have clients
+    const { token } = created;
+    tokens.push(token);
+
+    const followers = Math.floor(Math.random() * 4);
+    for (let f = 0; f < followers; f++) {
+      const follower = connect(lifetime());
+      manager.joinSession(token, follower.outbound, follower.id, 'follower');
+    }
+  }
+
+  // Followers moving to another session on the same socket
+  for (let i = 0; i < 10 && live.length > 0; i++) {
+    const client = live[Math.floor(Math.random() * live.length)];
+    manager.joinSession(tokens[Math.floor(Math.random() * tokens.length)], connect(0).outbound, client.id, 'follower');
+  }
+
+  // Ownerless sessions from a handful of scripted IPs
+  for (let i = 0; i < CREATE_SPAM_PER_HOUR; i++) {
+    manager.generateToken(`192.168.0.${i % 5}`);
+  }
+}
+
+async function advance(ms: number): Promise<void> {
+  const end = now + ms;
+  while (now < end) {
+    now += 5 * 60_000;
+    const leaving = live.filter(client => client.leaveAt <= now);
+    live = live.filter(client => client.leaveAt > now);
+    leaving.forEach(client => manager.removeClient(client.id));
+    manager.cleanupOldSessions();
+    await new Promise(resolve => setImmediate(resolve));
+  }
+}
+
+const rows: any[] = [];
+let orphansSeen = 0;
+
+for (let day = 1; day <= DAYS; day++) {
+  for (let hour = 0; hour < 24; hour++) {
+    simulateHour();
+    await advance(3600_000);
+  }
+
+  gc();
+  const report = manager.checkIndexes();
+  orphansSeen += report.orphanCount;
+  if (report.orphanCount) print(`day ${day} orphans: ${report.orphans.join(', ')}`);
+  rows.push({
+    day,
+    heapMB: +(process.memoryUsage().heapUsed / 1048576).toFixed(1),
+    liveClients: live.length,
+    ...report.sizes,
+    orphans: report.orphanCount
+  });
+}
+
+print(['day', 'heapMB', 'liveClients', 'sessions', 'ownerless', 'clientToSession', 'clientToIp', 'ipToSession', 'sessionsByIp', 'orphans'].join('\t'));
+rows.forEach(row => print(Object.values(row).join('\t')));
+
+// Steady state is reached after the first day (24h expiry); compare week 1 to the end
+const settled = rows[Math.min(6, rows.length - 1)];
+const last = rows[rows.length - 1];
+const flat = last.heapMB <= settled.heapMB * 1.25 + 2 && last.sessions <= settled.sessions * 1.25 + 50;
+print(`\norphans: ${orphansSeen}, heap ${settled.heapMB}MB (day ${settled.day}) -> ${last.heapMB}MB (day ${last.day}), flat: ${flat}`);
+
+// Per-IP limit: idle sessions go first, live ones are never evicted
+const limited = new SessionManager({ maxSessionsPerIp: 4 });
+const limitIp = '172.16.0.1';
+const idle = limited.generateToken(limitIp)!;
+const busy = [0, 1, 2].map(i => {
+  const token = limited.generateToken(limitIp)!;
+  limited.joinSession(token, connect(0).outbound, `limit${i}`, 'controller');
+  return token;
+});
+const replacement = limited.generateToken(limitIp);
+const idleEvicted = !limited.sessionExists(idle) && busy.every(token => limited.sessionExists(token));
+limited.joinSession(replacement!, connect(0).outbound, 'limit3', 'controller');
+const refused = limited.generateToken(limitIp) === undefined && busy.every(token => limited.sessionExists(token));
+print(`per-IP limit: idle session evicted: ${idleEvicted}, refused when all live: ${refused}`);
+limited.dispose();
+
+manager.dispose();
+process.exit(orphansSeen === 0 && flat && idleEvicted && refused ? 0 : 1);
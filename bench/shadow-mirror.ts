@@ -0,0 +1,159 @@
+/**
+ * Shadow-traffic mirroring. The same controller/follower workload runs
+ * against a primary relay twice, without and then with mirroring to a
+ * canary relay (in a child process, so it does not share the primary's
+ * event loop). Reports the command fan-out latency followers see and
+ * process CPU for both runs, the mirror's own event-loop time, and its
+ * primary/canary comparison report.
+ *
+ *   npx tsx bench/shadow-mirror.ts
+ */
+import { spawn } from 'child_process';
+import WebSocket from 'ws';
+import { RelayServer } from '../src/relay-server/relay-server.js';
+import type { MirrorReport } from '../src/relay-server/shadow-mirror.js';
+
+const SESSIONS = 10;
+const FOLLOWERS = 4;
+const ROUNDS = 200;
+const INTERVAL_MS = 50;
+const SECRET = 'bench-canary';
+const DEBUG_TOKEN = 'bench';
+
+const print = (line: string) => process.stdout.write(line + '\n');
+console.log = () => {};
+
+const sleep = (ms: number) => new Promise(resolve => setTimeout(resolve, ms));
+
+async function startCanary(): Promise<{ port: number; stop: () => void }> {
+  const child = spawn(process.execPath, [...process.execArgv, process.argv[1], 'canary'], { stdio: ['pipe', 'pipe', 'inherit'] });
+  const port = await new Promise<number>(resolve => child.stdout!.once('data', (data: Buffer) => resolve(Number(data.toString().trim()))));
+  return { port, stop: () => child.stdin!.end() };
+}
+
+function open(port: number): Promise<WebSocket> {
+  const ws = new WebSocket(`ws://127.0.0.1:${port}`);
+  return new Promise((resolve, reject) => {
+    ws.once('open', () => resolve(ws));
+    ws.once('error', reject);
+  });
+}
+
+function join(ws: WebSocket, sessionToken: string, role: string): Promise<void> {
+  return new Promise(resolve => {
+    const onMessage = (data: Buffer) => {
+      if (JSON.parse(data.toString()).type !== 'JOINED') return;
+      ws.off('message', onMessage);
+      resolve();
+    };
+    ws.on('message', onMessage);
+    ws.send(JSON.stringify({ type: 'JOIN', sessionToken, role }));
+  });
+}
+
+const percentile = (values: number[], q: number) => {
+  const sorted = [...values].sort((a, b) => a - b);
+  return sorted.length ? sorted[Math.min(sorted.length - 1, Math.floor(q * sorted.length))] : 0;
+};
+
+async function run(mirrorPort?: number): Promise<{ latencies: number[]; cpuMs: number; report?: MirrorReport }> {
+  const relay = new RelayServer(0, {
+    host: '127.0.0.1',
+    sessions: { maxSessionsPerIp: SESSIONS }, // every bench client shares one IP
+    debug: { token: DEBUG_TOKEN },
+    mirror: mirrorPort ? { target: `ws://127.0.0.1:${mirrorPort}`, secret: SECRET } : undefined
+  });
+  await relay.start();
+  const port = relay.address();
+
+  // Sessions come from POST /create-session, which is not mirrored: the canary adopts the tokens on JOIN
+  const sent = new Map<string, number>();
+  const latencies: number[] = [];
+  const controllers: WebSocket[] = [];
+  const sockets: WebSocket[] = [];
+  for (let s = 0; s < SESSIONS; s++) {
+    const { token } = await (await fetch(`http://127.0.0.1:${port}/create-session`, { method: 'POST' })).json() as { token: string };
+    const controller = await open(port);
+    await join(controller, token, 'controller');
+    controllers.push(controller);
+    sockets.push(controller);
+    for (let f = 0; f < FOLLOWERS; f++) {
+      const follower = await open(port);
+      await join(follower, token, 'follower');
+      follower.on('message', (data: Buffer) => {
+        const message = JSON.parse(data.toString());
+        if (message.type !== 'CLIENT_RESTARTED') return;
+        latencies.push(performance.now() - sent.get(message.commandId)!);
+        follower.send(JSON.stringify({ type: 'COMMAND_ACK', commandId: message.commandId, stage: 'completed', ok: true }));
+      });
+      sockets.push(follower);
+    }
+  }
+
+  const cpu = process.cpuUsage();
+  for (let round = 0; round < ROUNDS; round++) {
+    controllers.forEach((controller, s) => {
+      const commandId = `${round}-${s}`;
+      sent.set(commandId, performance.now());
+      controller.send(JSON.stringify({ type: 'RESTART', commandId }));
+    });
+    await sleep(INTERVAL_MS);
+  }
+  const deadline = Date.now() + 5000;
+  while (latencies.length < ROUNDS * SESSIONS * FOLLOWERS && Date.now() < deadline) await sleep(10);
+  const used = process.cpuUsage(cpu);
+
+  let report: MirrorReport | undefined;
+  if (mirrorPort) {
+    await sleep(200); // let the canary's answers arrive
+    const response = await fetch(`http://127.0.0.1:${port}/debug/mirror`, { headers: { Authorization: `Bearer ${DEBUG_TOKEN}` } });
+    report = await response.json() as MirrorReport;
+  }
+
+  sockets.forEach(ws => ws.terminate());
+  await relay.stop();
+  return { latencies, cpuMs: (used.user + used.system) / 1000, report };
+}
+
+async function main(): Promise<void> {
+  const canary = await startCanary();
+  const expected = ROUNDS * SESSIONS * FOLLOWERS;
+  const round = (value: number) => +value.toFixed(2);
+
+  print(`${SESSIONS} sessions x ${FOLLOWERS} followers, a RESTART per session every ${INTERVAL_MS}ms for ${ROUNDS} rounds`);
+  print('');
+  print('mirror   delivered   fan-out p50   p99      max      process CPU');
+  const results: Array<[string, Awaited<ReturnType<typeof run>>]> = [];
+  for (const [label, port] of [['off', undefined], ['on', canary.port]] as const) {
+    const result = await run(port);
+    results.push([label, result]);
+    const { latencies, cpuMs } = result;
+    print(`${label.padEnd(8)} ${`${latencies.length}/${expected}`.padEnd(11)} ${`${round(percentile(latencies, 0.5))}ms`.padEnd(13)} ${`${round(percentile(latencies, 0.99))}ms`.padEnd(8)} ${`${round(Math.max(...latencies))}ms`.padEnd(8)} ${Math.round(cpuMs)}ms`);
+  }
+  canary.stop();
+
+  const report = results[1][1].report!;
+  print('');
+  print(`Mirrored ${report.mirrored} frames from ${report.clients} clients (${report.dropped} dropped, ${report.diverged} diverged, ${report.lost} lost); mirror event-loop time ${round(report.overheadMs)}ms`);
+  print('');
+  print('delivered type                  primary   canary');
+  Object.entries(report.delivered).forEach(([type, counts]) =>
+    print(`${type.padEnd(31)} ${String(counts.primary).padEnd(9)} ${counts.canary}`));
+  print('');
+  print('latency (ms)                    primary p50/p99   canary p50/p99');
+  Object.entries(report.latencyMs).forEach(([type, { primary, canary }]) =>
+    print(`${type.padEnd(31)} ${`${round(primary.p50)}/${round(primary.p99)}`.padEnd(17)} ${round(canary.p50)}/${round(canary.p99)}`));
+  print('');
+  print(report.mismatches.length ? `Mismatches: ${JSON.stringify(report.mismatches)}` : 'No per-client delivery mismatches');
+  process.exit(0);
+}
+
+// Child mode: the canary relay
+if (process.argv[2] === 'canary') {
+  const canary = new RelayServer(0, { host: '127.0.0.1', sessions: { maxSessionsPerIp: SESSIONS }, canary: { secret: SECRET } });
+  await canary.start();
+  process.stdout.write(`${canary.address()}\n`);
+  process.stdin.on('end', () => process.exit(0)).resume();
+} else {
+  await main();
+}
@@ -0,0 +1,116 @@
+/**
+ * TLS handshake cost and reconnect-storm recovery, with and without
+ * session resumption.
+ *
+ * Starts an in-process wss:// relay with a throwaway self-signed
+ * certificate (requires the openssl CLI), then:
+ *   1. opens N sequential connections and reports CPU time per handshake
+ *   2. connects M clients, restarts the relay and measures how long it
+ *      takes until every client is connected again
+ *
+ * CPU figures cover client and relay together since both run in-process.
+ *
+ *   npx tsx bench/tls-resumption.ts
+ */
+import WebSocket from 'ws';
+import { execFileSync } from 'child_process';
+import { mkdtempSync } from 'fs';
+import { tmpdir } from 'os';
+import { join } from 'path';
+import { RelayServer } from '../src/relay-server/relay-server.js';
+import { TlsSessionCache } from '../src/shared/tls-session-cache.js';
+
+const SEQUENTIAL = 200;
+const STORM_CLIENTS = 200;
+
+// Keep relay connect/disconnect logging out of the report
+const print = (line: string) => process.stdout.write(line + '\n');
+console.log = () => {};
+
+const dir = mkdtempSync(join(tmpdir(), 'relay-tls-'));
+const certFile = join(dir, 'cert.pem');
+const keyFile = join(dir, 'key.pem');
+execFileSync('openssl', [
+  'req', '-x509', '-newkey', 'ec', '-pkeyopt', 'ec_paramgen_curve:prime256v1',
+  '-nodes', '-days', '1', '-subj', '/CN=localhost',
+  '-keyout', keyFile, '-out', certFile
+], { stdio: 'ignore' });
+
+const tls = { certFile, keyFile, reloadIntervalMs: 0, ticketKeyFile: join(dir, 'tickets.key') };
+let relay = new RelayServer(0, { host: '127.0.0.1', tls });
+await relay.start();
+const port = relay.address();
+const url = `wss://127.0.0.1:${port}`;
+
+function open(cache: TlsSessionCache): Promise<WebSocket> {
+  return new Promise((resolve, reject) => {
+    const ws = new WebSocket(url, { createConnection: cache.connect as any, rejectUnauthorized: false });
+    ws.once('open', () => resolve(ws));
+    ws.once('error', reject);
+  });
+}
+
+async function sequential(resume: boolean) {
+  const shared = new TlsSessionCache();
+  let reused = 0;
+  const cpuStart = process.cpuUsage();
+  const wallStart = performance.now();
+
+  for (let i = 0; i < SEQUENTIAL; i++) {
+    const ws = await open(resume ? shared : new TlsSessionCache());
+    if ((ws as any)._socket.isSessionReused()) reused++;
+    ws.terminate();
+  }
+
+  const cpu = process.cpuUsage(cpuStart);
+  return {
+    mode: resume ? 'resumed' : 'full',
+    connections: SEQUENTIAL,
+    reused,
+    cpuMicrosPerConnection: Math.round((cpu.user + cpu.system) / SEQUENTIAL),
+    wallMsPerConnection: +((performance.now() - wallStart) / SEQUENTIAL).toFixed(2)
+  };
+}
+
+async function storm(resume: boolean) {
+  const caches = Array.from({ length: STORM_CLIENTS }, () => new TlsSessionCache());
+  const sockets = await Promise.all(caches.map(cache => open(cache)));
+  // Let TLS 1.3 tickets arrive before the restart
+  await new Promise(resolve => setTimeout(resolve, 200));
+  if (!resume) caches.forEach(cache => cache.clear());
+
+  await relay.stop();
+  sockets.forEach(ws => ws.terminate());
+
+  const cpuStart = process.cpuUsage();
+  const wallStart = performance.now();
+  relay = new RelayServer(port, { host: '127.0.0.1', tls });
+  await relay.start();
+
+  let reused = 0;
+  const reconnected = await Promise.all(caches.map(async cache => {
+    const ws = await open(cache);
+    if ((ws as any)._socket.isSessionReused()) reused++;
+    return ws;
+  }));
+
+  const cpu = process.cpuUsage(cpuStart);
+  const recoveryMs = performance.now() - wallStart;
+  reconnected.forEach(ws => ws.terminate());
+
+  return {
+    mode: resume ? 'resumed' : 'full',
+    clients: STORM_CLIENTS,
+    reused,
+    recoveryMs: Math.round(recoveryMs),
+    cpuMs: Math.round((cpu.user + cpu.system) / 1000)
+  };
+}
+
+const report = {
+  handshake: [await sequential(false), await sequential(true)],
+  reconnectStorm: [await storm(false), await storm(true)]
+};
+print(JSON.stringify(report, null, 2));
+await relay.stop();
+process.exit(0);
@@ -0,0 +1,106 @@
+/**
+ * Cost of span tracing on the relay's command path.
+ *
+ * Replays what the relay does for a RESTART (root span, parse, session
+ * lookup, fan-out to 10 followers, event emission, logging) against a
+ * SessionManager with in-memory sockets, with tracing off, sampled at 1%
+ * and at 100%.
+ *
+ * "Off" can't be compared against an uninstrumented build, so the check
+ * bounds it instead: spans per message (counted with sampling at 100%)
+ * times the measured cost of a no-op span, as a share of the message
+ * cost. Exits non-zero if that exceeds 1%.
+ *
+ *   npx tsx bench/tracing-overhead.ts
+ */
+import { mkdtempSync, readFileSync } from 'fs';
+import { tmpdir } from 'os';
+import { join } from 'path';
+import { SessionManager } from '../src/relay-server/session-manager.js';
+import { OutboundQueue } from '../src/relay-server/outbound-queue.js';
+import type { RelaySocket } from '../src/relay-server/outbound-queue.js';
+import { tracer } from '../src/shared/tracing.js';
+
+const FOLLOWERS = 10;
+const MESSAGES = 5_000;
+const ROUNDS = 5;
+
+const print = (line: string) => process.stdout.write(line + '\n');
+console.log = () => {};
+
+const socket: RelaySocket = {
+  readyState: 1,
+  bufferedAmount: 0,
+  send: () => {},
+  close: () => {},
+  terminate: () => {}
+};
+
+const manager = new SessionManager();
+manager.on('activity', () => {});
+const { token } = manager.findOrCreateSessionByIp('10.0.0.1', new OutboundQueue(socket), 'controller', 'controller')!;
+for (let i = 0; i < FOLLOWERS; i++) {
+  manager.joinSession(token, new OutboundQueue(socket), `follower-${i}`, 'follower');
+}
+
+const raw = JSON.stringify({ type: 'RESTART' });
+
+// Mirrors RelayServer's message handler for RESTART
+function handle(): void {
+  const received = tracer.now();
+  const message = JSON.parse(raw);
+  const span = tracer.root('relay.handleMessage', message.trace, received).arg('type', message.type);
+  tracer.span('parse', received).end();
+  manager.broadcastRestart('controller');
+  span.end();
+}
+
+function nsPerMessage(): number {
+  for (let i = 0; i < 1000; i++) handle(); // warm up
+  const samples: number[] = [];
+  for (let round = 0; round < ROUNDS; round++) {
+    const start = process.hrtime.bigint();
+    for (let i = 0; i < MESSAGES; i++) handle();
+    samples.push(Number(process.hrtime.bigint() - start) / MESSAGES);
+  }
+  return samples.sort((a, b) => a - b)[Math.floor(ROUNDS / 2)];
+}
+
+const results: Record<string, number> = {};
+results.off = nsPerMessage();
+
+// Cost of a no-op span (tracing off)
+const NOOP_CALLS = 10_000_000;
+let start = process.hrtime.bigint();
+for (let i = 0; i < NOOP_CALLS; i++) tracer.span('noop').end();
+const noopNs = Number(process.hrtime.bigint() - start) / NOOP_CALLS;
+
+const dir = mkdtempSync(join(tmpdir(), 'relay-trace-'));
+tracer.configure({ enabled: true, sampleRate: 0.01, file: join(dir, 'sampled.json') }, 'bench');
+results.sampled1pct = nsPerMessage();
+tracer.disable();
+
+tracer.configure({ enabled: true, sampleRate: 1, file: join(dir, 'full.json') }, 'bench');
+results.sampled100pct = nsPerMessage();
+tracer.disable();
+
+// Spans per message, counted on a short fully sampled run
+const countFile = join(dir, 'count.json');
+tracer.configure({ enabled: true, sampleRate: 1, file: countFile }, 'bench');
+for (let i = 0; i < 100; i++) handle();
+tracer.disable();
+const events = readFileSync(countFile, 'utf8').split('\n').filter(line => line.includes('"ph":"X"')).length;
+const spansPerMessage = events / 100;
+const offOverheadPct = (spansPerMessage * noopNs) / results.off * 100;
+
+print(JSON.stringify({
+  followers: FOLLOWERS,
+  nsPerMessage: Object.fromEntries(Object.entries(results).map(([k, v]) => [k, Math.round(v)])),
+  noopSpanNs: +noopNs.toFixed(2),
+  spansPerMessage: +spansPerMessage.toFixed(1),
+  offOverheadPct: +offOverheadPct.toFixed(3),
+  traceFile: countFile
+}, null, 2));
+
+manager.dispose();
+process.exit(offOverheadPct < 1 ? 0 : 1);
@@ -0,0 +1,250 @@
+/**
+ * Transport engine comparison. Runs the same protocol checks and load
+ * against a relay on each engine (forked, so CPU and memory are its own):
+ *
+ *  - protocol: HTTP endpoints, JOIN, status fan-out, acknowledged restart,
+ *    /admin subscription, gzip and a multiplexed channel
+ *  - throughput/latency: clients each keep one HEARTBEAT in flight for a
+ *    few seconds; acks per second and round-trip percentiles
+ *  - memory: relay RSS growth per idle connection
+ *
+ * Engines whose module is not installed are reported as skipped.
+ *
+ *   npx tsx bench/transport-engines.ts [clients] [idle] [seconds]
+ */
+import { fork } from 'child_process';
+import { fileURLToPath } from 'url';
+import { get } from 'http';
+import WebSocket from 'ws';
+import type { TransportEngine } from '../src/relay-server/transport.js';
+
+const CLIENTS = Number(process.argv[2] ?? 100);
+const IDLE = Number(process.argv[3] ?? 2000);
+const SECONDS = Number(process.argv[4] ?? 5);
+const ENGINES: TransportEngine[] = ['ws', 'uws'];
+
+const print = (line: string) => process.stdout.write(line + '\n');
+console.log = () => {};
+
+const sleep = (ms: number) => new Promise(resolve => setTimeout(resolve, ms));
+
+// Child: the relay under test
+if (process.argv[2] === 'relay') {
+  const { RelayServer } = await import('../src/relay-server/relay-server.js');
+  const relay = new RelayServer(0, {
+    host: '127.0.0.1',
+    sessions: { maxSessionsPerIp: 100000, maxOwnerlessSessions: 100000 },
+    transport: { engine: process.argv[3] as TransportEngine }
+  });
+  try {
+    await relay.start();
+  } catch (error) {
+    process.send!({ error: error instanceof Error ? error.message : String(error) });
+    process.exit(0);
+  }
+  let mark = process.cpuUsage();
+  process.on('message', (message: string) => {
+    if (message === 'mark') mark = process.cpuUsage();
+    global.gc?.();
+    const { user, system } = process.cpuUsage(mark);
+    process.send!({ cpuMs: (user + system) / 1000, rss: process.memoryUsage().rss });
+  });
+  process.send!({ port: relay.address() });
+} else {
+  /**
+   * Test client that keeps every message so checks can wait for one
+   */
+  class Client {
+    ws: WebSocket;
+    messages: any[] = [];
+    opened: Promise<void>;
+    private waiters: Array<() => void> = [];
+
+    constructor(url: string) {
+      this.ws = new WebSocket(url);
+      this.opened = new Promise((resolve, reject) => {
+        this.ws.once('open', () => resolve());
+        this.ws.once('error', reject);
+      });
+      this.ws.on('message', (data: Buffer) => {
+        this.messages.push(JSON.parse(data.toString()));
+        this.waiters.splice(0).forEach(wake => wake());
+      });
+    }
+
+    send(message: object): void {
+      this.ws.send(JSON.stringify(message));
+    }
+
+    async waitFor(match: (message: any) => boolean, timeoutMs = 2000): Promise<any> {
+      const deadline = Date.now() + timeoutMs;
+      for (;;) {
+        const found = this.messages.find(match);
+        if (found) return found;
+        if (Date.now() > deadline) throw new Error('timed out');
+        await new Promise<void>(resolve => {
+          this.waiters.push(resolve);
+          setTimeout(resolve, 50);
+        });
+      }
+    }
+  }
+
+  const httpGet = (port: number, path: string, headers: Record<string, string> = {}) => new Promise<{ status: number; headers: any; body: Buffer }>(resolve => {
+    get({ host: '127.0.0.1', port, path, headers }, response => {
+      const chunks: Buffer[] = [];
+      response.on('data', (chunk: Buffer) => chunks.push(chunk));
+      response.on('end', () => resolve({ status: response.statusCode!, headers: response.headers, body: Buffer.concat(chunks) }));
+    });
+  });
+
+  async function protocol(port: number): Promise<Record<string, string>> {
+    const base = `ws://127.0.0.1:${port}`;
+    const results: Record<string, string> = {};
+    const check = async (name: string, run: () => Promise<void>) => {
+      try {
+        await run();
+        results[name] = 'pass';
+      } catch (error) {
+        results[name] = `FAIL: ${error instanceof Error ? error.message : String(error)}`;
+      }
+    };
+
+    let token = '';
+    const controller = new Client(base);
+    const follower = new Client(base);
+    const admin = new Client(`${base}/admin`);
+
+    await check('GET /health', async () => {
+      const { status, body } = await httpGet(port, '/health');
+      if (status !== 200 || JSON.parse(body.toString()).status !== 'ok') throw new Error(`status ${status}`);
+    });
+    await check('POST /create-session', async () => {
+      token = (await (await fetch(`http://127.0.0.1:${port}/create-session`, { method: 'POST' })).json()).token;
+      if (!token) throw new Error('no token');
+    });
+    await check('CONNECTED on open', async () => {
+      await Promise.all([controller.opened, follower.opened, admin.opened]);
+      await controller.waitFor(message => message.type === 'CONNECTED');
+    });
+    await check('JOIN controller and follower', async () => {
+      controller.send({ type: 'JOIN', sessionToken: token, role: 'controller' });
+      follower.send({ type: 'JOIN', sessionToken: token, role: 'follower' });
+      await controller.waitFor(message => message.type === 'JOINED' && message.role === 'controller');
+      await follower.waitFor(message => message.type === 'JOINED' && message.role === 'follower');
+    });
+    await check('STATUS_UPDATE reaches follower', async () => {
+      controller.send({ type: 'STATUS_UPDATE', status: { clientRunning: true, processCount: 3 } });
+      await follower.waitFor(message => message.type === 'STATUS_UPDATE');
+    });
+    await check('RESTART acked back to controller', async () => {
+      controller.send({ type: 'RESTART', commandId: 'cmd-1' });
+      await follower.waitFor(message => message.type === 'CLIENT_RESTARTED' && message.commandId === 'cmd-1');
+      follower.send({ type: 'COMMAND_ACK', commandId: 'cmd-1', stage: 'completed', ok: true });
+      await controller.waitFor(message => message.type === 'COMMAND_ACK' && message.completed === 1);
+    });
+    await check('ADMIN_SUBSCRIBE on /admin', async () => {
+      admin.send({ type: 'ADMIN_SUBSCRIBE' });
+      const update = await admin.waitFor(message => message.type === 'SESSIONS_UPDATE');
+      if (!update.payload.sessions.some((session: any) => session.token === token)) throw new Error('session missing');
+    });
+    await check('GET /sessions gzip', async () => {
+      const { status, headers } = await httpGet(port, '/sessions', { 'Accept-Encoding': 'gzip' });
+      if (status !== 200) throw new Error(`status ${status}`);
+      // Small lists stay below the compression threshold
+      if (headers['content-encoding'] && headers['content-encoding'] !== 'gzip') throw new Error(headers['content-encoding']);
+    });
+    await check('multiplexed channel JOIN', async () => {
+      const shared = new Client(base);
+      await shared.opened;
+      shared.ws.send(JSON.stringify({ channel: 'c1', type: 'CHANNEL_OPEN' }));
+      shared.ws.send(JSON.stringify({ channel: 'c1', type: 'JOIN', sessionToken: token, role: 'follower' }));
+      await shared.waitFor(message => message.channel === 'c1' && message.type === 'JOINED');
+      shared.ws.close();
+    });
+
+    [controller, follower, admin].forEach(client => client.ws.close());
+    return results;
+  }
+
+  async function load(port: number, request: (message: string) => Promise<any>) {
+    const base = `ws://127.0.0.1:${port}`;
+    const clients = await Promise.all(Array.from({ length: CLIENTS }, async () => {
+      const client = new WebSocket(base);
+      await new Promise(resolve => client.once('open', resolve));
+      return client;
+    }));
+
+    // Closed loop: each client sends its next heartbeat when the last is acked
+    const rtts: number[] = [];
+    let running = true;
+    await request('mark');
+    await Promise.all(clients.map(client => new Promise<void>(resolve => {
+      let sentAt = 0;
+      const next = () => {
+        if (!running) return resolve();
+        sentAt = performance.now();
+        client.send('{"type":"HEARTBEAT"}');
+      };
+      client.on('message', (data: Buffer) => {
+        if (!data.toString().includes('HEARTBEAT_ACK')) return;
+        rtts.push(performance.now() - sentAt);
+        next();
+      });
+      next();
+      setTimeout(() => { running = false; }, SECONDS * 1000);
+    })));
+    const { cpuMs } = await request('cpu');
+    clients.forEach(client => client.close());
+
+    rtts.sort((a, b) => a - b);
+    const percentile = (p: number) => +rtts[Math.min(rtts.length - 1, Math.floor(rtts.length * p))].toFixed(3);
+    return {
+      acksPerSecond: Math.round(rtts.length / SECONDS),
+      rttP50Ms: percentile(0.5),
+      rttP99Ms: percentile(0.99),
+      relayCpuMicrosPerAck: +(cpuMs * 1000 / rtts.length).toFixed(1)
+    };
+  }
+
+  async function memory(port: number, request: (message: string) => Promise<any>) {
+    await sleep(500);
+    const before = (await request('rss')).rss;
+    const sockets: WebSocket[] = [];
+    for (let i = 0; i < IDLE; i += 100) {
+      sockets.push(...await Promise.all(Array.from({ length: Math.min(100, IDLE - i) }, () => new Promise<WebSocket>(resolve => {
+        const socket = new WebSocket(`ws://127.0.0.1:${port}`);
+        socket.once('message', () => resolve(socket)); // CONNECTED
+      }))));
+    }
+    await sleep(500);
+    const after = (await request('rss')).rss;
+    sockets.forEach(socket => socket.terminate());
+    return { idleConnections: IDLE, relayKBPerConnection: +((after - before) / 1024 / IDLE).toFixed(1) };
+  }
+
+  const results: Record<string, any> = {};
+  for (const engine of ENGINES) {
+    const child = fork(fileURLToPath(import.meta.url), ['relay', engine], {
+      stdio: ['ignore', 'ignore', 'inherit', 'ipc'],
+      execArgv: [...process.execArgv, '--expose-gc']
+    });
+    const request = (message: string) => new Promise<any>(resolve => { child.once('message', resolve); child.send(message); });
+    const started = await new Promise<any>(resolve => child.once('message', resolve));
+    if (started.error) {
+      results[engine] = { skipped: started.error };
+      child.kill();
+      continue;
+    }
+
+    results[engine] = {
+      protocol: await protocol(started.port),
+      ...await load(started.port, request),
+      ...await memory(started.port, request)
+    };
+    child.kill();
+  }
+
+  print(JSON.stringify({ clients: CLIENTS, seconds: SECONDS, results }, null, 2));
+  process.exit(0);
+}
@@ -9,6 +9,10 @@ public class RelayConfig
 {
     public string Host { get; set; } = "localhost";
     public int Port { get; set; } = 8080;
+    public bool UseTls { get; set; } = false;
+    public List<string> Endpoints { get; set; } = new();  // "host:port" relays, lowest RTT is used
+    public int ProbeIntervalMs { get; set; } = 60000;
+    public bool Multiplex { get; set; } = false;  // one socket per relay for all roles in this process
 }
 
 /// <summary>
@@ -90,7 +94,13 @@ public class AppConfig
     }
 
     /// <summary>
-    /// Get WebSocket URL for relay server
+    /// Get WebSocket URL for relay server (wss:// when UseTls is set;
+    /// SChannel caches TLS sessions per process, so reconnects resume)
     /// </summary>
-    public string GetRelayUrl() => $"ws://{Relay.Host}:{Relay.Port}";
+    public string GetRelayUrl() => GetRelayUrl(Relay.Host, Relay.Port);
+
+    /// <summary>
+    /// Get WebSocket URL for one of the configured relay endpoints
+    /// </summary>
+    public string GetRelayUrl(string host, int port) => $"{(Relay.UseTls ? "wss" : "ws")}://{host}:{port}";
 }
@@ -37,6 +37,9 @@ public enum MessageType
     // Heartbeat
     HEARTBEAT,
     HEARTBEAT_ACK,
+
+    // Command acknowledgements (follower -> relay -> controller)
+    COMMAND_ACK,
     
     // Error
     ERROR
@@ -92,8 +95,41 @@ public class RelayMessage
 
     [JsonProperty("gameRunning")]
     public bool? GameRunning { get; set; }
+
+    [JsonProperty("commandId")]
+    public string? CommandId { get; set; }
+
+    // COMMAND_ACK
+    [JsonProperty("commandType")]
+    public string? CommandType { get; set; }
+
+    [JsonProperty("stage")]
+    public string? Stage { get; set; }
+
+    [JsonProperty("ok")]
+    public bool? Ok { get; set; }
+
+    [JsonProperty("detail")]
+    public string? Detail { get; set; }
+
+    [JsonProperty("followerId")]
+    public string? FollowerId { get; set; }
+
+    [JsonProperty("followers")]
+    public int? Followers { get; set; }
+
+    [JsonProperty("completed")]
+    public int? Completed { get; set; }
+
+    [JsonProperty("failed")]
+    public int? Failed { get; set; }
 }
 
+/// <summary>
+/// Result a follower reports when it finished a command
+/// </summary>
+public record CommandOutcome(bool Ok, string? Detail = null);
+
 /// <summary>
 /// Client status information
 /// </summary>
@@ -149,14 +185,26 @@ public static class MessageBuilder
         return JsonConvert.SerializeObject(new { type = "HEARTBEAT" });
     }
 
-    public static string Restart()
+    public static string Restart(string commandId)
     {
-        return JsonConvert.SerializeObject(new { type = "RESTART" });
+        return JsonConvert.SerializeObject(new { type = "RESTART", commandId });
     }
 
-    public static string ImmediateStart()
+    public static string ImmediateStart(string commandId)
     {
-        return JsonConvert.SerializeObject(new { type = "IMMEDIATE_START" });
+        return JsonConvert.SerializeObject(new { type = "IMMEDIATE_START", commandId });
+    }
+
+    public static string CommandAck(string commandId, string stage, CommandOutcome? outcome = null)
+    {
+        return JsonConvert.SerializeObject(new
+        {
+            type = "COMMAND_ACK",
+            commandId,
+            stage,
+            ok = outcome?.Ok,
+            detail = outcome?.Detail
+        });
     }
 
     public static string StatusUpdate(bool clientRunning, int processCount)
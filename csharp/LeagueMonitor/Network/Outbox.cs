@@ -0,0 +1,85 @@
+namespace LeagueMonitor.Network;
+
+/// <summary>
+/// Messages a RelayClient could not send because it was not in a session
+/// (disconnected, reconnecting or waiting for JOINED). Drained right after
+/// the next JOINED, commands first; each message carries its own deadline
+/// and is dropped once it passes.
+/// </summary>
+public class Outbox
+{
+    private const int MaxCommands = 64;
+    private const int MaxState = 16;
+    private static readonly TimeSpan CommandTtl = TimeSpan.FromSeconds(30); // a late command is worse than none
+    private static readonly TimeSpan StateTtl = TimeSpan.FromSeconds(60);
+
+    // Only the latest queued copy of these is kept; anything else is a command
+    private static readonly HashSet<string> StateTypes = new() { "STATUS_UPDATE", "STATUS_REQUEST", "GAME_STATUS" };
+
+    private record Pending(string Type, string Message, DateTime ExpiresAt);
+
+    private readonly LinkedList<Pending> _commands = new();
+    private readonly List<Pending> _state = new(); // oldest first, one per type
+    private readonly object _lock = new();
+
+    public bool HasCommands
+    {
+        get { lock (_lock) return _commands.Count > 0; }
+    }
+
+    public int Count
+    {
+        get { lock (_lock) return _commands.Count + _state.Count; }
+    }
+
+    /// <summary>
+    /// Queue a serialized message; ttl overrides the default for its kind
+    /// </summary>
+    public void Push(string type, string message, TimeSpan? ttl = null)
+    {
+        lock (_lock)
+        {
+            if (StateTypes.Contains(type))
+            {
+                _state.RemoveAll(p => p.Type == type);
+                if (_state.Count >= MaxState) _state.RemoveAt(0);
+                _state.Add(new Pending(type, message, DateTime.UtcNow + (ttl ?? StateTtl)));
+                return;
+            }
+
+            if (_commands.Count >= MaxCommands) _commands.RemoveFirst();
+            _commands.AddLast(new Pending(type, message, DateTime.UtcNow + (ttl ?? CommandTtl)));
+        }
+    }
+
+    /// <summary>
+    /// Empty the outbox: the live messages, commands first, and the types of
+    /// the ones that expired
+    /// </summary>
+    public (List<string> Messages, List<string> Expired) Drain()
+    {
+        var messages = new List<string>();
+        var expired = new List<string>();
+        lock (_lock)
+        {
+            var now = DateTime.UtcNow;
+            foreach (var pending in _commands.Concat(_state))
+            {
+                if (pending.ExpiresAt <= now) expired.Add(pending.Type);
+                else messages.Add(pending.Message);
+            }
+            _commands.Clear();
+            _state.Clear();
+        }
+        return (messages, expired);
+    }
+
+    public void Clear()
+    {
+        lock (_lock)
+        {
+            _commands.Clear();
+            _state.Clear();
+        }
+    }
+}
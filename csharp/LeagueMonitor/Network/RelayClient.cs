@@ -13,23 +13,47 @@ public class RelayClient : IDisposable
 {
     private readonly Logger _logger;
     private readonly ClientRole _role;
-    private readonly string _serverUrl;
+    private string _serverUrl;
+    private readonly RelaySelector? _selector;
+    private RelayEndpoint? _endpoint;
+    private bool _switching;
+    private DateTime _lastFailover = DateTime.MinValue;
     
     private ClientWebSocket? _webSocket;
+    private readonly SemaphoreSlim _sendLock = new(1, 1); // one send at a time on _webSocket
+    private RelayChannel? _channel; // Relay.Multiplex: this client's channel on the shared socket
     private CancellationTokenSource? _cancellationTokenSource;
     private Task? _receiveTask;
     
     private string? _sessionToken;
     private bool _isConnected;
+    private bool _joined; // JOINED received on the current connection
     private readonly int _reconnectInterval = 5000;
+    private const int PendingReconnectInterval = 1000; // while a queued command waits for the relay
+    private CancellationTokenSource? _reconnectWake;
+
+    // Kept for the next JOINED while not in a session; JOIN and heartbeats are per connection
+    private readonly Outbox _outbox = new();
+    private static readonly HashSet<string> ConnectionTypes = new() { "JOIN", "CREATE_SESSION", "HEARTBEAT" };
+    // Answers to a delivery on the current connection: the relay drops the delivery with the
+    // connection, so one replayed after a reconnect (under a new client ID) matches nothing
+    private static readonly HashSet<string> DeliveryTypes = new() { "COMMAND_ACK" };
+
+    // Command IDs remembered for deduplication (follower) and latency (controller)
+    private const int RecentCommands = 256;
+    private readonly Dictionary<string, CommandOutcome?> _handledCommands = new(); // null while running
+    private readonly Queue<string> _handledOrder = new();
+    private readonly Dictionary<string, DateTime> _issuedCommands = new();
+    private readonly Queue<string> _issuedOrder = new();
 
     // Events
     public event Action? OnConnected;
     public event Action? OnDisconnected;
     public event Action<string>? OnSessionCreated;
     public event Action<string, SessionInfo?>? OnJoined;
-    public event Action? OnImmediateStart;
-    public event Action? OnClientRestarted;
+    // Follower command handlers; the outcome is acknowledged to the controller
+    public event Func<Task<CommandOutcome>>? OnImmediateStart;
+    public event Func<Task<CommandOutcome>>? OnClientRestarted;
     public event Action<ClientStatus>? OnStatusUpdate;
     public event Func<Task<ClientStatus>>? OnStatusRequest;
     public event Action<bool>? OnFollowerGameStatusChanged; // Controller receives this
@@ -43,6 +67,18 @@ public class RelayClient : IDisposable
         _role = role;
         _logger = new Logger($"RelayClient-{role}");
         _serverUrl = AppConfig.Instance.GetRelayUrl();
+
+        var relay = AppConfig.Instance.Relay;
+        if (relay.Endpoints.Count > 0)
+        {
+            _selector = new RelaySelector(relay.Endpoints.Select(e => RelayEndpoint.Parse(e, relay.Port)), relay.UseTls);
+        }
+    }
+
+    private void UseEndpoint(RelayEndpoint endpoint)
+    {
+        _endpoint = endpoint;
+        _serverUrl = AppConfig.Instance.GetRelayUrl(endpoint.Host, endpoint.Port);
     }
 
     /// <summary>
@@ -53,28 +89,76 @@ public class RelayClient : IDisposable
         _sessionToken = sessionToken;
         _cancellationTokenSource = CancellationTokenSource.CreateLinkedTokenSource(ct);
 
+        if (_selector != null)
+        {
+            UseEndpoint(await _selector.SelectBestAsync());
+            if (AppConfig.Instance.Relay.ProbeIntervalMs > 0)
+            {
+                _ = ProbeLoopAsync(_cancellationTokenSource.Token);
+            }
+        }
+
         await ConnectInternalAsync();
     }
 
+    /// <summary>
+    /// Move to a clearly faster relay when periodic probing finds one
+    /// </summary>
+    private async Task ProbeLoopAsync(CancellationToken ct)
+    {
+        try
+        {
+            while (!ct.IsCancellationRequested)
+            {
+                await Task.Delay(AppConfig.Instance.Relay.ProbeIntervalMs, ct);
+                if (!_isConnected) continue; // reconnecting; failover picks the relay
+
+                var better = await _selector!.FindBetterAsync();
+                if (better != null && _isConnected)
+                {
+                    UseEndpoint(better);
+                    _switching = true;
+                    await CloseConnectionAsync("Switching relay");
+                }
+            }
+        }
+        catch (OperationCanceledException) { }
+        catch (Exception ex)
+        {
+            _logger.Error("Relay probe failed", ex);
+        }
+    }
+
     private async Task ConnectInternalAsync()
     {
         while (!_cancellationTokenSource!.Token.IsCancellationRequested)
         {
             try
             {
-                _logger.Info($"Connecting to relay server at {_serverUrl}...");
-                
                 _webSocket?.Dispose();
-                _webSocket = new ClientWebSocket();
+                _webSocket = null;
+                _channel = null;
+                _joined = false;
 
-                await _webSocket.ConnectAsync(new Uri(_serverUrl), _cancellationTokenSource.Token);
+                if (AppConfig.Instance.Relay.Multiplex)
+                {
+                    // One socket per relay for every RelayClient in this process
+                    _logger.Info($"Connecting to relay server at {_serverUrl} (shared connection)...");
+                    _channel = await SharedConnection.OpenChannelAsync(_serverUrl, _cancellationTokenSource.Token);
+                }
+                else
+                {
+                    _logger.Info($"Connecting to relay server at {_serverUrl}...");
+                    _webSocket = new ClientWebSocket();
+                    await _webSocket.ConnectAsync(new Uri(_serverUrl), _cancellationTokenSource.Token);
+                }
 
                 _isConnected = true;
                 _logger.Success("Connected to relay server");
                 OnConnected?.Invoke();
 
                 // Start receive loop
-                _receiveTask = ReceiveLoopAsync();
+                _receiveTask = _channel != null ? ChannelReceiveLoopAsync(_channel) : ReceiveLoopAsync();
 
                 // If token provided, join session; otherwise create/auto-join
                 if (!string.IsNullOrEmpty(_sessionToken))
@@ -105,16 +189,70 @@ public class RelayClient : IDisposable
             }
 
             _isConnected = false;
+            _joined = false;
             OnDisconnected?.Invoke();
 
+            if (_switching)
+            {
+                // Deliberate move to a faster relay: reconnect right away
+                _switching = false;
+                continue;
+            }
+
+            // At most one failover per reconnect interval, so two bad relays don't ping-pong
+            if (_selector != null && _endpoint != null && !_cancellationTokenSource.Token.IsCancellationRequested &&
+                DateTime.UtcNow - _lastFailover >= TimeSpan.FromMilliseconds(_reconnectInterval))
+            {
+                _lastFailover = DateTime.UtcNow;
+                var next = await _selector.FailoverAsync(_endpoint);
+                if (next != null)
+                {
+                    UseEndpoint(next);
+                    continue;
+                }
+            }
+
             if (!_cancellationTokenSource.Token.IsCancellationRequested)
             {
-                _logger.Info($"Reconnecting in {_reconnectInterval / 1000} seconds...");
-                await Task.Delay(_reconnectInterval, _cancellationTokenSource.Token);
+                await WaitToReconnectAsync();
             }
         }
     }
 
+    /// <summary>
+    /// Wait out the reconnect interval, shorter while a command is queued;
+    /// a newly queued command ends the wait early (ReconnectNow)
+    /// </summary>
+    private async Task WaitToReconnectAsync()
+    {
+        var interval = _outbox.HasCommands ? PendingReconnectInterval : _reconnectInterval;
+        _logger.Info($"Reconnecting in {interval / 1000.0:0.#} seconds...");
+
+        using var wake = CancellationTokenSource.CreateLinkedTokenSource(_cancellationTokenSource!.Token);
+        _reconnectWake = wake;
+        try
+        {
+            await Task.Delay(interval, wake.Token);
+        }
+        catch (OperationCanceledException) when (!_cancellationTokenSource.Token.IsCancellationRequested)
+        {
+            _logger.Info("Reconnecting now to deliver queued messages...");
+        }
+        finally
+        {
+            _reconnectWake = null;
+        }
+    }
+
+    private void ReconnectNow()
+    {
+        try
+        {
+            _reconnectWake?.Cancel();
+        }
+        catch (ObjectDisposedException) { } // the wait just ended
+    }
+
     private async Task ReceiveLoopAsync()
     {
         var buffer = new byte[8192];
@@ -151,6 +289,25 @@ public class RelayClient : IDisposable
         _isConnected = false;
     }
 
+    private async Task ChannelReceiveLoopAsync(RelayChannel channel)
+    {
+        try
+        {
+            await foreach (var message in channel.ReadAllAsync(_cancellationTokenSource!.Token))
+            {
+                await HandleMessageAsync(message);
+            }
+            _logger.Warn("Server closed connection");
+        }
+        catch (OperationCanceledException) { }
+        catch (Exception ex)
+        {
+            _logger.Error("Receive error", ex);
+        }
+
+        _isConnected = false;
+    }
+
     private async Task HandleMessageAsync(string messageJson)
     {
         try
@@ -189,13 +346,15 @@ public class RelayClient : IDisposable
                         _logger.Info($"Controller: {(message.SessionInfo.HasController ? "Yes" : "No")}");
                         _logger.Info($"Followers: {message.SessionInfo.FollowerCount}");
                     }
-                    
+
+                    _joined = true;
+                    await FlushOutboxAsync();
                     OnJoined?.Invoke(message.SessionToken!, message.SessionInfo);
                     break;
 
                 case "IMMEDIATE_START":
                     _logger.Info("Received immediate start command from controller!");
-                    OnImmediateStart?.Invoke();
+                    await RunCommandAsync(message.CommandId, OnImmediateStart);
                     break;
 
                 case "IMMEDIATE_START_BROADCASTED":
@@ -204,7 +363,11 @@ public class RelayClient : IDisposable
 
                 case "CLIENT_RESTARTED":
                     _logger.Info("Received CLIENT_RESTARTED message from controller!");
-                    OnClientRestarted?.Invoke();
+                    await RunCommandAsync(message.CommandId, OnClientRestarted);
+                    break;
+
+                case "COMMAND_ACK":
+                    RecordAck(message);
                     break;
 
                 case "RESTART_BROADCASTED":
@@ -274,29 +437,177 @@ public class RelayClient : IDisposable
         }
     }
 
-    private async Task SendAsync(string message)
+    /// <summary>
+    /// Ack receipt, run the handler once per command ID and ack its outcome.
+    /// A redelivered command is only re-acknowledged.
+    /// </summary>
+    private async Task RunCommandAsync(string? commandId, Func<Task<CommandOutcome>>? handler)
+    {
+        if (commandId == null)
+        {
+            if (handler != null) _ = handler();
+            return;
+        }
+
+        await SendAsync("COMMAND_ACK", MessageBuilder.CommandAck(commandId, "received"));
+
+        CommandOutcome? previous;
+        lock (_handledCommands)
+        {
+            if (!_handledCommands.TryGetValue(commandId, out previous))
+            {
+                if (_handledOrder.Count >= RecentCommands) _handledCommands.Remove(_handledOrder.Dequeue());
+                _handledCommands[commandId] = null;
+                _handledOrder.Enqueue(commandId);
+                _ = CompleteCommandAsync(commandId, handler);
+                return;
+            }
+        }
+
+        _logger.Info($"Command {commandId} already handled, not running it again");
+        if (previous != null) await SendAsync("COMMAND_ACK", MessageBuilder.CommandAck(commandId, "completed", previous));
+    }
+
+    private async Task CompleteCommandAsync(string commandId, Func<Task<CommandOutcome>>? handler)
+    {
+        CommandOutcome outcome;
+        try
+        {
+            outcome = handler != null ? await handler() : new CommandOutcome(true);
+        }
+        catch (Exception ex)
+        {
+            _logger.Error($"Command {commandId} failed", ex);
+            outcome = new CommandOutcome(false, ex.Message);
+        }
+
+        lock (_handledCommands)
+        {
+            if (_handledCommands.ContainsKey(commandId)) _handledCommands[commandId] = outcome;
+        }
+        await SendAsync("COMMAND_ACK", MessageBuilder.CommandAck(commandId, "completed", outcome));
+    }
+
+    /// <summary>
+    /// Log a follower's completion of a command this controller issued
+    /// </summary>
+    private void RecordAck(RelayMessage message)
+    {
+        if (message.Stage != "completed" || message.CommandId == null) return;
+        if (!_issuedCommands.TryGetValue(message.CommandId, out var issuedAt)) return;
+
+        var latencyMs = (int)(DateTime.UtcNow - issuedAt).TotalMilliseconds;
+        var detail = message.Detail != null ? $" ({message.Detail})" : "";
+        if (message.Ok == true)
+            _logger.Info($"Follower {message.FollowerId} completed {message.CommandType} in {latencyMs}ms{detail}");
+        else
+            _logger.Warn($"Follower {message.FollowerId} failed {message.CommandType} after {latencyMs}ms{detail}");
+
+        if ((message.Completed ?? 0) + (message.Failed ?? 0) >= (message.Followers ?? 0))
+        {
+            _logger.Success($"{message.CommandType} done: {message.Completed ?? 0}/{message.Followers ?? 0} follower(s) succeeded");
+        }
+    }
+
+    private void TrackIssued(string commandId)
     {
+        if (_issuedCommands.ContainsKey(commandId)) return;
+        if (_issuedOrder.Count >= RecentCommands) _issuedCommands.Remove(_issuedOrder.Dequeue());
+        _issuedCommands[commandId] = DateTime.UtcNow;
+        _issuedOrder.Enqueue(commandId);
+    }
+
+    /// <summary>
+    /// Send now when in a session; otherwise keep the message in the outbox
+    /// until the next JOINED
+    /// </summary>
+    private async Task SendAsync(string type, string message)
+    {
+        if (ConnectionTypes.Contains(type) || (_joined && _isConnected))
+        {
+            await WriteAsync(message);
+            return;
+        }
+        if (DeliveryTypes.Contains(type))
+        {
+            _logger.Info($"Not in a session, dropping {type} (its delivery went with the connection)");
+            return;
+        }
+
+        _outbox.Push(type, message);
+        if (type is "STATUS_UPDATE" or "STATUS_REQUEST") return; // routine, coalesced
+        _logger.Warn($"Not in a session, {type} queued until the relay is back ({_outbox.Count} pending)");
+        ReconnectNow();
+    }
+
+    private async Task FlushOutboxAsync()
+    {
+        if (_outbox.Count == 0) return;
+        var (messages, expired) = _outbox.Drain();
+        if (expired.Count > 0)
+        {
+            _logger.Warn($"Dropped {expired.Count} queued message(s) past their deadline: {string.Join(", ", expired)}");
+        }
+        if (messages.Count > 0)
+        {
+            _logger.Info($"Sending {messages.Count} message(s) queued while disconnected");
+        }
+        foreach (var message in messages)
+        {
+            await WriteAsync(message);
+        }
+    }
+
+    private async Task WriteAsync(string message)
+    {
+        if (_channel != null)
+        {
+            try
+            {
+                await _channel.SendAsync(message, _cancellationTokenSource?.Token ?? CancellationToken.None);
+            }
+            catch (Exception ex)
+            {
+                _logger.Error("Failed to send message", ex);
+            }
+            return;
+        }
+
         if (_webSocket?.State != WebSocketState.Open)
         {
             _logger.Warn("Cannot send: not connected");
             return;
         }
 
+        var ct = _cancellationTokenSource?.Token ?? CancellationToken.None;
+        var bytes = Encoding.UTF8.GetBytes(message);
+        try
+        {
+            // ClientWebSocket allows only one send at a time; command handlers ack from their own tasks
+            await _sendLock.WaitAsync(ct);
+        }
+        catch (OperationCanceledException)
+        {
+            return;
+        }
+
         try
         {
-            var bytes = Encoding.UTF8.GetBytes(message);
-            await _webSocket.SendAsync(new ArraySegment<byte>(bytes), WebSocketMessageType.Text, true, 
-                _cancellationTokenSource?.Token ?? CancellationToken.None);
+            await _webSocket.SendAsync(new ArraySegment<byte>(bytes), WebSocketMessageType.Text, true, ct);
         }
         catch (Exception ex)
         {
             _logger.Error("Failed to send message", ex);
         }
+        finally
+        {
+            _sendLock.Release();
+        }
     }
 
     private async Task JoinSessionAsync(string? token)
     {
-        await SendAsync(MessageBuilder.Join(token, _role));
+        await SendAsync("JOIN", MessageBuilder.Join(token, _role));
     }
 
     /// <summary>
@@ -304,33 +615,36 @@ public class RelayClient : IDisposable
     /// </summary>
     public async Task SendHeartbeatAsync()
     {
-        await SendAsync(MessageBuilder.Heartbeat());
+        if (_channel != null)
+        {
+            await _channel.Connection.HeartbeatAsync();
+            return;
+        }
+        await SendAsync("HEARTBEAT", MessageBuilder.Heartbeat());
     }
 
     /// <summary>
-    /// Broadcast immediate start command (controller only)
+    /// Broadcast immediate start command (controller only); returns the command ID.
+    /// Issued while not in a session, it goes out right after the next JOINED.
     /// </summary>
-    public async Task BroadcastImmediateStartAsync()
+    public async Task<string> BroadcastImmediateStartAsync(string? commandId = null)
     {
-        if (!_isConnected)
-        {
-            _logger.Warn("Not connected, cannot broadcast immediate start");
-            return;
-        }
-        await SendAsync(MessageBuilder.ImmediateStart());
+        commandId ??= Guid.NewGuid().ToString();
+        TrackIssued(commandId);
+        await SendAsync("IMMEDIATE_START", MessageBuilder.ImmediateStart(commandId));
+        return commandId;
     }
 
     /// <summary>
-    /// Broadcast restart command (controller only)
+    /// Broadcast restart command (controller only); returns the command ID.
+    /// Reusing an ID never makes a follower run the command twice.
     /// </summary>
-    public async Task BroadcastRestartAsync()
+    public async Task<string> BroadcastRestartAsync(string? commandId = null)
     {
-        if (!_isConnected)
-        {
-            _logger.Warn("Not connected, cannot broadcast restart");
-            return;
-        }
-        await SendAsync(MessageBuilder.Restart());
+        commandId ??= Guid.NewGuid().ToString();
+        TrackIssued(commandId);
+        await SendAsync("RESTART", MessageBuilder.Restart(commandId));
+        return commandId;
     }
 
     /// <summary>
@@ -338,12 +652,7 @@ public class RelayClient : IDisposable
     /// </summary>
     public async Task SendStatusAsync(bool clientRunning, int processCount)
     {
-        if (!_isConnected)
-        {
-            _logger.Warn("Not connected, cannot send status");
-            return;
-        }
-        await SendAsync(MessageBuilder.StatusUpdate(clientRunning, processCount));
+        await SendAsync("STATUS_UPDATE", MessageBuilder.StatusUpdate(clientRunning, processCount));
     }
 
     /// <summary>
@@ -351,12 +660,7 @@ public class RelayClient : IDisposable
     /// </summary>
     public async Task RequestStatusAsync()
     {
-        if (!_isConnected)
-        {
-            _logger.Warn("Not connected, cannot request status");
-            return;
-        }
-        await SendAsync(MessageBuilder.StatusRequest());
+        await SendAsync("STATUS_REQUEST", MessageBuilder.StatusRequest());
     }
 
     /// <summary>
@@ -364,12 +668,6 @@ public class RelayClient : IDisposable
     /// </summary>
     public async Task SendGameStatusAsync(bool gameRunning)
     {
-        if (!_isConnected)
-        {
-            _logger.Warn("Not connected, cannot send game status");
-            return;
-        }
-
         if (_role != ClientRole.follower)
         {
             _logger.Warn("Only followers can send game status");
@@ -377,7 +675,7 @@ public class RelayClient : IDisposable
         }
 
         _logger.Info($"Sending game status: {(gameRunning ? "RUNNING" : "STOPPED")}");
-        await SendAsync(MessageBuilder.GameStatus(gameRunning));
+        await SendAsync("GAME_STATUS", MessageBuilder.GameStatus(gameRunning));
     }
 
     /// <summary>
@@ -386,17 +684,29 @@ public class RelayClient : IDisposable
     public async Task DisconnectAsync()
     {
         _cancellationTokenSource?.Cancel();
+        await CloseConnectionAsync("Disconnecting");
+        _isConnected = false;
+        if (_outbox.Count > 0)
+        {
+            _logger.Warn($"Discarding {_outbox.Count} queued message(s)");
+            _outbox.Clear();
+        }
+    }
 
-        if (_webSocket?.State == WebSocketState.Open)
+    private async Task CloseConnectionAsync(string reason)
+    {
+        try
         {
-            try
+            if (_channel != null)
+            {
+                await _channel.CloseAsync();
+            }
+            else if (_webSocket?.State == WebSocketState.Open)
             {
-                await _webSocket.CloseAsync(WebSocketCloseStatus.NormalClosure, "Disconnecting", CancellationToken.None);
+                await _webSocket.CloseAsync(WebSocketCloseStatus.NormalClosure, reason, CancellationToken.None);
             }
-            catch { }
         }
-
-        _isConnected = false;
+        catch { }
     }
 
     public void Dispose()
@@ -404,5 +714,7 @@ public class RelayClient : IDisposable
         _cancellationTokenSource?.Cancel();
         _cancellationTokenSource?.Dispose();
         _webSocket?.Dispose();
+        _selector?.Dispose();
+        _sendLock.Dispose();
     }
 }
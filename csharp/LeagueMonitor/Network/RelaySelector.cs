@@ -0,0 +1,189 @@
+using System.Diagnostics;
+using LeagueMonitor.Core;
+
+namespace LeagueMonitor.Network;
+
+/// <summary>
+/// One relay server ("host:port")
+/// </summary>
+public record RelayEndpoint(string Host, int Port)
+{
+    public string Key => $"{Host}:{Port}";
+
+    public static RelayEndpoint Parse(string value, int defaultPort)
+    {
+        var trimmed = value.Trim();
+        var colon = trimmed.LastIndexOf(':');
+        if (colon < 0 || trimmed.EndsWith("]"))
+        {
+            return new RelayEndpoint(trimmed.Trim('[', ']'), defaultPort);
+        }
+        return new RelayEndpoint(trimmed[..colon].Trim('[', ']'), int.Parse(trimmed[(colon + 1)..]));
+    }
+}
+
+/// <summary>
+/// Picks the lowest-RTT relay from a list and hands out the next best on failover
+/// </summary>
+public class RelaySelector : IDisposable
+{
+    private readonly Logger _logger = new("RelaySelector");
+    private readonly List<RelayEndpoint> _endpoints;
+    private readonly bool _useTls;
+    private readonly Dictionary<string, double?> _rtts = new();
+    private readonly object _lock = new();
+    private readonly HttpClient _http;
+
+    public RelayEndpoint Current { get; private set; }
+
+    /// <summary>
+    /// Number of failovers so far
+    /// </summary>
+    public int Failovers { get; private set; }
+
+    public RelaySelector(IEnumerable<RelayEndpoint> endpoints, bool useTls)
+    {
+        _endpoints = endpoints.ToList();
+        if (_endpoints.Count == 0) throw new ArgumentException("No relay endpoints configured");
+        _useTls = useTls;
+        Current = _endpoints[0];
+        // Kept-alive connections, so probes after the first skip the handshake
+        _http = new HttpClient(new SocketsHttpHandler { PooledConnectionLifetime = TimeSpan.FromMinutes(5) })
+        {
+            Timeout = TimeSpan.FromSeconds(2)
+        };
+    }
+
+    /// <summary>
+    /// Last measured RTT per endpoint in ms (null = unreachable)
+    /// </summary>
+    public IReadOnlyDictionary<string, double?> Rtts
+    {
+        get { lock (_lock) return new Dictionary<string, double?>(_rtts); }
+    }
+
+    /// <summary>
+    /// Median round trip of GET /health; the first request sets up the
+    /// connection and isn't counted. Null if the relay didn't answer.
+    /// </summary>
+    public async Task<double?> ProbeRttAsync(RelayEndpoint endpoint, int samples = 3)
+    {
+        var url = $"{(_useTls ? "https" : "http")}://{endpoint.Host}:{endpoint.Port}/health";
+        try
+        {
+            (await _http.GetAsync(url)).EnsureSuccessStatusCode();
+            var rtts = new List<double>();
+            for (var i = 0; i < samples; i++)
+            {
+                var stopwatch = Stopwatch.StartNew();
+                (await _http.GetAsync(url)).EnsureSuccessStatusCode();
+                rtts.Add(stopwatch.Elapsed.TotalMilliseconds);
+            }
+            rtts.Sort();
+            return rtts[rtts.Count / 2];
+        }
+        catch (Exception)
+        {
+            return null;
+        }
+    }
+
+    /// <summary>
+    /// Probe every endpoint in parallel and record the results
+    /// </summary>
+    public async Task ProbeAsync()
+    {
+        var results = await Task.WhenAll(_endpoints.Select(e => ProbeRttAsync(e)));
+        lock (_lock)
+        {
+            for (var i = 0; i < _endpoints.Count; i++)
+            {
+                _rtts[_endpoints[i].Key] = results[i];
+            }
+        }
+        _logger.Info($"Relay RTTs: {string.Join(", ", _endpoints.Select(e => $"{e.Key}={Describe(e)}"))}");
+    }
+
+    /// <summary>
+    /// Probe and select the best relay (the first one if none answered)
+    /// </summary>
+    public async Task<RelayEndpoint> SelectBestAsync()
+    {
+        await ProbeAsync();
+        Select(Best() ?? _endpoints[0]);
+        return Current;
+    }
+
+    /// <summary>
+    /// The relay in use failed: move to the best other reachable one, or null if none answered
+    /// </summary>
+    public async Task<RelayEndpoint?> FailoverAsync(RelayEndpoint failed)
+    {
+        await ProbeAsync();
+        lock (_lock) _rtts[failed.Key] = null;
+
+        var next = Best();
+        if (next == null)
+        {
+            _logger.Warn($"No other relay reachable, staying on {failed.Key}");
+            return null;
+        }
+        Failovers++;
+        _logger.Warn($"Failing over from {failed.Key} to {next.Key} ({Describe(next)})");
+        Select(next);
+        return next;
+    }
+
+    /// <summary>
+    /// Re-probe; select and return another relay if it is at least 30% and 20ms faster
+    /// </summary>
+    public async Task<RelayEndpoint?> FindBetterAsync()
+    {
+        await ProbeAsync();
+        var best = Best();
+        if (best == null || best == Current) return null;
+
+        double? currentRtt, bestRtt;
+        lock (_lock)
+        {
+            currentRtt = _rtts.GetValueOrDefault(Current.Key);
+            bestRtt = _rtts[best.Key];
+        }
+        if (currentRtt == null || (bestRtt < currentRtt * 0.7 && currentRtt - bestRtt > 20))
+        {
+            _logger.Info($"Relay {best.Key} ({Describe(best)}) is faster than {Current.Key} ({Describe(Current)}), switching");
+            Select(best);
+            return best;
+        }
+        return null;
+    }
+
+    private RelayEndpoint? Best()
+    {
+        lock (_lock)
+        {
+            return _endpoints
+                .Where(e => _rtts.GetValueOrDefault(e.Key) != null)
+                .OrderBy(e => _rtts[e.Key])
+                .FirstOrDefault();
+        }
+    }
+
+    private void Select(RelayEndpoint endpoint)
+    {
+        Current = endpoint;
+        _logger.Success($"Using relay {endpoint.Key} ({Describe(endpoint)})");
+    }
+
+    private string Describe(RelayEndpoint endpoint)
+    {
+        double? rtt;
+        lock (_lock) rtt = _rtts.GetValueOrDefault(endpoint.Key);
+        return rtt == null ? "unreachable" : $"{rtt:F1}ms";
+    }
+
+    public void Dispose()
+    {
+        _http.Dispose();
+    }
+}
@@ -0,0 +1,219 @@
+using System.Collections.Concurrent;
+using System.Net.WebSockets;
+using System.Text;
+using System.Text.RegularExpressions;
+using System.Threading.Channels;
+using LeagueMonitor.Core;
+using Newtonsoft.Json;
+
+namespace LeagueMonitor.Network;
+
+/// <summary>
+/// One logical relay connection inside a SharedConnection. Frames arrive
+/// without the channel ID; closing it leaves the socket up for the others.
+/// </summary>
+public class RelayChannel
+{
+    private readonly Channel<string> _inbox = Channel.CreateUnbounded<string>();
+
+    public string Id { get; }
+    public SharedConnection Connection { get; }
+    public bool IsOpen { get; private set; } = true;
+
+    internal RelayChannel(SharedConnection connection, string id)
+    {
+        Connection = connection;
+        Id = id;
+    }
+
+    public Task SendAsync(string message, CancellationToken ct = default)
+    {
+        if (!IsOpen) throw new WebSocketException(WebSocketError.InvalidState, $"Channel {Id} is closed");
+        return Connection.SendFrameAsync($"{{\"channel\":\"{Id}\",{message[1..]}", ct);
+    }
+
+    /// <summary>
+    /// Messages for this channel until it or the socket closes
+    /// </summary>
+    public IAsyncEnumerable<string> ReadAllAsync(CancellationToken ct = default) => _inbox.Reader.ReadAllAsync(ct);
+
+    public Task CloseAsync() => Connection.CloseChannelAsync(this);
+
+    internal void Deliver(string message) => _inbox.Writer.TryWrite(message);
+
+    internal void MarkClosed()
+    {
+        IsOpen = false;
+        _inbox.Writer.TryComplete();
+    }
+}
+
+/// <summary>
+/// The process's socket to one relay, carrying a channel per RelayClient
+/// (Relay.Multiplex). The relay treats every channel as a client of its own;
+/// the socket closes when its last channel does.
+/// </summary>
+public class SharedConnection
+{
+    // Channel frames are relay messages with the channel ID spliced in front:
+    // {"channel":"c1","type":"JOIN",...}. Routing only looks at that prefix.
+    private static readonly Regex ChannelPrefix = new("^\\{\"channel\":\"([A-Za-z0-9_-]{1,32})\",", RegexOptions.Compiled);
+    private static readonly TimeSpan HeartbeatInterval = TimeSpan.FromSeconds(10);
+    private static readonly Dictionary<string, SharedConnection> Connections = new();
+    private static readonly object ConnectionsLock = new();
+
+    private readonly Logger _logger = new("SharedConnection");
+    private readonly string _url;
+    private readonly ClientWebSocket _webSocket = new();
+    private readonly ConcurrentDictionary<string, RelayChannel> _channels = new();
+    private readonly SemaphoreSlim _sendLock = new(1, 1);
+    private readonly Task _connectTask;
+    private int _nextId;
+    private bool _closed;
+    private DateTime _lastHeartbeat = DateTime.MinValue;
+
+    private SharedConnection(string url)
+    {
+        _url = url;
+        _connectTask = ConnectAsync();
+    }
+
+    /// <summary>
+    /// Open a channel on the live connection to url, connecting first if needed
+    /// </summary>
+    public static async Task<RelayChannel> OpenChannelAsync(string url, CancellationToken ct)
+    {
+        SharedConnection connection;
+        lock (ConnectionsLock)
+        {
+            if (!Connections.TryGetValue(url, out connection!) || connection._closed)
+            {
+                connection = new SharedConnection(url);
+                Connections[url] = connection;
+            }
+        }
+
+        await connection._connectTask.WaitAsync(ct);
+        var channel = new RelayChannel(connection, $"c{Interlocked.Increment(ref connection._nextId)}");
+        connection._channels[channel.Id] = channel;
+        await connection.SendFrameAsync(Control(channel.Id, "CHANNEL_OPEN"), ct);
+        return channel;
+    }
+
+    private async Task ConnectAsync()
+    {
+        try
+        {
+            await _webSocket.ConnectAsync(new Uri(_url), CancellationToken.None);
+        }
+        catch
+        {
+            Shutdown();
+            throw;
+        }
+        _ = ReceiveLoopAsync();
+    }
+
+    private async Task ReceiveLoopAsync()
+    {
+        var buffer = new byte[8192];
+        var frame = new StringBuilder();
+
+        try
+        {
+            while (_webSocket.State == WebSocketState.Open)
+            {
+                var result = await _webSocket.ReceiveAsync(new ArraySegment<byte>(buffer), CancellationToken.None);
+                if (result.MessageType == WebSocketMessageType.Close) break;
+
+                frame.Append(Encoding.UTF8.GetString(buffer, 0, result.Count));
+                if (!result.EndOfMessage) continue;
+                Route(frame.ToString());
+                frame.Clear();
+            }
+        }
+        catch (WebSocketException ex)
+        {
+            _logger.Error("WebSocket error", ex);
+        }
+
+        Shutdown();
+    }
+
+    private void Route(string frame)
+    {
+        var match = ChannelPrefix.Match(frame);
+        if (!match.Success) return; // CONNECTED / HEARTBEAT_ACK for the socket itself
+        if (!_channels.TryGetValue(match.Groups[1].Value, out var channel)) return;
+
+        var body = "{" + frame[match.Length..];
+        if (body.StartsWith("{\"type\":\"CHANNEL_CLOSE\""))
+        {
+            _channels.TryRemove(channel.Id, out _);
+            channel.MarkClosed();
+            return;
+        }
+        channel.Deliver(body);
+    }
+
+    internal async Task SendFrameAsync(string frame, CancellationToken ct = default)
+    {
+        var bytes = Encoding.UTF8.GetBytes(frame);
+        // ClientWebSocket allows only one send at a time; channels share it
+        await _sendLock.WaitAsync(ct);
+        try
+        {
+            await _webSocket.SendAsync(new ArraySegment<byte>(bytes), WebSocketMessageType.Text, true, ct);
+        }
+        finally
+        {
+            _sendLock.Release();
+        }
+    }
+
+    /// <summary>
+    /// Keepalive for every channel; repeats from other channels within 10s are skipped
+    /// </summary>
+    public async Task HeartbeatAsync()
+    {
+        if (_webSocket.State != WebSocketState.Open || DateTime.UtcNow - _lastHeartbeat < HeartbeatInterval) return;
+        _lastHeartbeat = DateTime.UtcNow;
+        await SendFrameAsync(MessageBuilder.Heartbeat());
+    }
+
+    internal async Task CloseChannelAsync(RelayChannel channel)
+    {
+        if (!_channels.TryRemove(channel.Id, out _)) return;
+        channel.MarkClosed();
+
+        try
+        {
+            await SendFrameAsync(Control(channel.Id, "CHANNEL_CLOSE"));
+            if (_channels.IsEmpty)
+            {
+                Shutdown();
+                await _webSocket.CloseAsync(WebSocketCloseStatus.NormalClosure, "Last channel closed", CancellationToken.None);
+            }
+        }
+        catch { }
+    }
+
+    /// <summary>
+    /// Stop handing out this connection and end every channel
+    /// </summary>
+    private void Shutdown()
+    {
+        lock (ConnectionsLock)
+        {
+            _closed = true;
+            if (Connections.TryGetValue(_url, out var current) && current == this) Connections.Remove(_url);
+        }
+        foreach (var id in _channels.Keys)
+        {
+            if (_channels.TryRemove(id, out var channel)) channel.MarkClosed();
+        }
+    }
+
+    private static string Control(string channelId, string type) =>
+        JsonConvert.SerializeObject(new { channel = channelId, type });
+}
@@ -47,15 +47,8 @@ public class FollowerService : IDisposable
             OnSessionJoined?.Invoke(token);
         };
 
-        _relayClient.OnImmediateStart += async () =>
-        {
-            await HandleImmediateStartAsync();
-        };
-
-        _relayClient.OnClientRestarted += async () =>
-        {
-            await HandleClientRestartedAsync();
-        };
+        _relayClient.OnImmediateStart += HandleImmediateStartAsync;
+        _relayClient.OnClientRestarted += HandleClientRestartedAsync;
 
         _relayClient.OnStatusUpdate += async (status) =>
         {
@@ -290,9 +283,9 @@ public class FollowerService : IDisposable
         }
     }
 
-    private async Task LaunchClientAsync()
+    private async Task<CommandOutcome> LaunchClientAsync()
     {
-        if (_isStartingClient) return; // Already starting
+        if (_isStartingClient) return new CommandOutcome(true, "already starting");
         
         _isStartingClient = true;
         var clientProcessName = LeagueUtils.GetLeagueClientProcessName();
@@ -317,11 +310,11 @@ public class FollowerService : IDisposable
                 {
                     _logger.Warn("LeagueClient process not detected after 15 seconds");
                 }
+                return new CommandOutcome(true, "client launched");
             }
-            else
-            {
-                _logger.Error("Failed to launch LeagueClient");
-            }
+
+            _logger.Error("Failed to launch LeagueClient");
+            return new CommandOutcome(false, "launch failed");
         }
         finally
         {
@@ -329,7 +322,7 @@ public class FollowerService : IDisposable
         }
     }
 
-    private async Task HandleImmediateStartAsync()
+    private async Task<CommandOutcome> HandleImmediateStartAsync()
     {
         _logger.Info("IMMEDIATE START command received from controller!");
 
@@ -337,14 +330,14 @@ public class FollowerService : IDisposable
         if (_isStartingClient)
         {
             _logger.Info("Already starting client, skipping.");
-            return;
+            return new CommandOutcome(true, "already starting");
         }
 
         // Check if game is running
         if (LeagueUtils.IsLeagueGameRunning())
         {
             _logger.Info("League game is running, skipping LeagueClient launch");
-            return;
+            return new CommandOutcome(true, "game running");
         }
 
         // Kill existing client if running (restart scenario)
@@ -355,10 +348,10 @@ public class FollowerService : IDisposable
             await Task.Delay(1000); // Brief wait for process to terminate
         }
 
-        await LaunchClientAsync();
+        return await LaunchClientAsync();
     }
 
-    private async Task HandleClientRestartedAsync()
+    private async Task<CommandOutcome> HandleClientRestartedAsync()
     {
         _logger.Info("CLIENT_RESTARTED command received from controller (VGC exit code 185)!");
 
@@ -366,14 +359,14 @@ public class FollowerService : IDisposable
         if (_isStartingClient)
         {
             _logger.Info("Already starting client, skipping.");
-            return;
+            return new CommandOutcome(true, "already starting");
         }
 
         // Check if game is running
         if (LeagueUtils.IsLeagueGameRunning())
         {
             _logger.Info("League game is running, skipping LeagueClient launch");
-            return;
+            return new CommandOutcome(true, "game running");
         }
 
         // Kill existing client if running
@@ -384,7 +377,7 @@ public class FollowerService : IDisposable
             await Task.Delay(1000); // Brief wait for process to terminate
         }
 
-        await LaunchClientAsync();
+        return await LaunchClientAsync();
     }
 
     public void Dispose()
@@ -0,0 +1,75 @@
+"""Adaptive probe cadence for process monitors without process events."""
+
+import asyncio
+import time
+from typing import Set
+
+
+class SamplingCadence:
+    """When a monitor loop should take its next sample.
+
+    Samples every ``fast`` seconds after a sample that saw a change, for
+    ``burst`` seconds after burst() (a launch, kill or command) and while any
+    hold() is set (waiting on a process-count threshold). Otherwise each
+    unchanged sample multiplies the interval by ``backoff``, up to
+    ``maximum``. burst() and hold() also cut a longer pending wait short.
+    """
+
+    def __init__(self, fast: float = 1.0, maximum: float = 15.0, backoff: float = 2.0, burst: float = 30.0):
+        self._fast = fast
+        self._maximum = maximum
+        self._backoff = backoff
+        self._burst = burst
+        self._interval = fast
+        self._burst_until = 0.0
+        self._holds: Set[str] = set()
+        self._hurry = asyncio.Event()
+        self.probes = 0
+        self.probe_seconds = 0.0  # total wall time spent sampling
+
+    @property
+    def interval(self) -> float:
+        """Seconds the next wait() sleeps."""
+        return self._interval
+
+    async def wait(self) -> None:
+        """Sleep until the next sample is due."""
+        self._hurry.clear()
+        try:
+            await asyncio.wait_for(self._hurry.wait(), self._interval)
+        except asyncio.TimeoutError:
+            pass
+
+    def observe(self, changed: bool, probe_seconds: float) -> None:
+        """Record a sample: whether it saw a change and how long probing took."""
+        self.probes += 1
+        self.probe_seconds += probe_seconds
+        fast = changed or bool(self._holds) or time.monotonic() < self._burst_until
+        self._interval = self._fast if fast else min(self._maximum, self._interval * self._backoff)
+
+    def burst(self) -> None:
+        """Something was just launched, killed or commanded: sample fast for a while."""
+        self._burst_until = time.monotonic() + self._burst
+        self._speed_up()
+
+    def hold(self, reason: str, on: bool = True) -> None:
+        """Keep sampling fast until released (e.g. while waiting on a threshold)."""
+        if not on:
+            self._holds.discard(reason)
+            return
+        if reason not in self._holds:
+            self._holds.add(reason)
+            self._speed_up()
+
+    def snapshot(self) -> dict:
+        """Current cadence and probe cost."""
+        return {
+            "cadence_s": self._interval,
+            "probes": self.probes,
+            "probe_ms_avg": self.probe_seconds * 1000 / self.probes if self.probes else 0.0,
+        }
+
+    def _speed_up(self) -> None:
+        if self._interval > self._fast:
+            self._interval = self._fast
+            self._hurry.set()
@@ -12,17 +12,34 @@ class RelayConfig:
     """Relay server configuration."""
     host: str = "37.59.96.187"
     port: int = 8080
+    tls: bool = False
+    ca_file: str | None = None
+    # "host:port" list; the lowest-RTT relay is used, the others are failovers
+    endpoints: list[str] = field(default_factory=list)
+    probe_interval: float = 60.0
+    # share one socket per relay between the controller and follower of this process
+    multiplex: bool = False
 
     @property
     def url(self) -> str:
-        return f"ws://{self.host}:{self.port}"
+        return self.url_for(self.host, self.port)
+
+    def url_for(self, host: str, port: int) -> str:
+        scheme = "wss" if self.tls else "ws"
+        return f"{scheme}://{host}:{port}"
 
 
 @dataclass
 class ControllerConfig:
     """Controller mode configuration."""
     process_count_threshold: int = 2
-    check_interval: float = 2.0
+    # Probe cadence: sampling_fast seconds around launches, commands and changes,
+    # backing off by sampling_backoff per unchanged sample up to sampling_max
+    sampling_fast: float = 1.0
+    sampling_max: float = 15.0
+    sampling_backoff: float = 2.0
+    sampling_burst: float = 30.0  # how long a launch or command keeps sampling fast
+    check_interval: float | None = None  # older fixed probe interval; overrides sampling_* when set
     restart_cooldown: float = 5.0
 
 
@@ -2,8 +2,10 @@
 
 import asyncio
 import sys
-from typing import Optional
+import time
+from typing import Optional, Tuple
 
+from .cadence import SamplingCadence
 from .config import get_config
 from .league_utils import (
     get_league_process_count,
@@ -17,6 +19,10 @@ from .league_utils import (
 from .logger import Logger
 from .relay_client import ClientRole, RelayClient
 
+# How long a client that started coming up keeps the monitor sampling fast
+# while its process count is below the threshold
+_THRESHOLD_WAIT = 120.0
+
 
 class ControllerService:
     """Controller service - monitors League Client and notifies followers."""
@@ -32,6 +38,9 @@ class ControllerService:
         self._client_was_restarted = False  # Track if client was restarted (not first start)
         self._last_process_count = 0
         self._session_token: Optional[str] = None
+        self._cadence = self._make_cadence()
+        self._last_sample: Optional[Tuple[bool, int]] = None  # (client running, process count)
+        self._ramp_started = 0.0  # when the process count last rose from 0
         
         self._setup_event_handlers()
 
@@ -75,6 +84,7 @@ class ControllerService:
                 # If client is ready and a new follower is asking, send IMMEDIATE_START
                 if client_ready and is_running:
                     self._logger.info("Client is ready, sending IMMEDIATE_START to new follower...")
+                    self._cadence.burst()
                     asyncio.create_task(self._relay_client.broadcast_immediate_start())
                 
                 return {"clientRunning": is_running, "processCount": ux_count, "clientReady": client_ready}
@@ -89,10 +99,28 @@ class ControllerService:
                 
                 if client_ready and is_running:
                     self._logger.info("Client is ready, sending IMMEDIATE_START to new follower...")
+                    self._cadence.burst()
                     asyncio.create_task(self._relay_client.broadcast_immediate_start())
                 
                 return {"clientRunning": is_running, "processCount": process_count, "clientReady": client_ready}
 
+    def _make_cadence(self) -> SamplingCadence:
+        """Adaptive cadence, or the fixed check_interval an older config asks for."""
+        if self._config.check_interval is not None:
+            interval = self._config.check_interval
+            return SamplingCadence(fast=interval, maximum=interval)
+        return SamplingCadence(
+            fast=self._config.sampling_fast,
+            maximum=self._config.sampling_max,
+            backoff=self._config.sampling_backoff,
+            burst=self._config.sampling_burst,
+        )
+
+    @property
+    def cadence(self) -> dict:
+        """Current probe cadence and cost."""
+        return self._cadence.snapshot()
+
     async def start(self) -> None:
         """Start controller service."""
         if self._running:
@@ -146,14 +174,32 @@ class ControllerService:
 
         while self._running:
             try:
-                await asyncio.sleep(self._config.check_interval)
+                # Fast around launches, commands and a rising process count; backs off while nothing changes
+                await self._cadence.wait()
+                probe_started = time.perf_counter()
 
                 # Check process count (macOS uses LeagueClientUx, Windows uses all processes)
                 if is_macos:
                     process_count = get_macos_leagueclientux_count()
                 else:
                     process_count = get_league_process_count()
-                
+
+                # Check if client is running
+                client_running = is_league_client_running()
+
+                sample = (client_running, process_count)
+                self._cadence.observe(sample != self._last_sample, time.perf_counter() - probe_started)
+                self._last_sample = sample
+                if process_count > 0 and self._last_process_count == 0:
+                    self._ramp_started = time.monotonic()
+                waiting = (
+                    client_running
+                    and 0 < process_count < threshold
+                    and not self._immediate_start_sent
+                    and time.monotonic() - self._ramp_started < _THRESHOLD_WAIT
+                )
+                self._cadence.hold("threshold", waiting)
+
                 if process_count != self._last_process_count:
                     self._last_process_count = process_count
                     if is_macos:
@@ -161,9 +207,6 @@ class ControllerService:
                     else:
                         self._logger.info(f"Process count: {process_count}")
 
-                # Check if client is running
-                client_running = is_league_client_running()
-
                 if not client_running and not self._is_restarting_client:
                     # Client stopped - restart it
                     self._logger.warn("LeagueClient is not running!")
@@ -179,11 +222,13 @@ class ControllerService:
                         if self._client_was_restarted:
                             # Client was restarted - tell followers to restart their clients too
                             self._logger.success("Client was RESTARTED - sending CLIENT_RESTARTED to followers...")
+                            self._cadence.burst()
                             await self._relay_client.broadcast_restart()
                             self._client_was_restarted = False
                         else:
                             # First start or new follower - just tell them to start
                             self._logger.success("Sending IMMEDIATE_START to followers...")
+                            self._cadence.burst()
                             await self._relay_client.broadcast_immediate_start()
                         
                         self._immediate_start_sent = True
@@ -214,6 +259,7 @@ class ControllerService:
             
             if success:
                 self._logger.success("LeagueClient launched successfully")
+                self._cadence.burst()
                 
                 # Wait for client to appear
                 self._logger.info("Waiting for LeagueClient process to appear...")
@@ -250,6 +296,8 @@ class ControllerService:
         This ensures that:
         - New followers get IMMEDIATE_START when they connect
         - Followers whose client was killed get IMMEDIATE_START to restart
+
+        Uses the monitor loop's latest sample rather than probing again.
         """
         is_macos = sys.platform == "darwin"
         threshold = MACOS_LEAGUECLIENTUX_THRESHOLD if is_macos else self._config.process_count_threshold
@@ -261,20 +309,14 @@ class ControllerService:
             try:
                 await asyncio.sleep(check_interval)
                 
-                if not self._relay_client.is_connected:
+                if not self._relay_client.is_connected or self._last_sample is None:
                     continue
                 
                 # Check if our client is ready
-                client_running = is_league_client_running()
+                client_running, process_count = self._last_sample
                 if not client_running:
                     continue
                 
-                # Get process count
-                if is_macos:
-                    process_count = get_macos_leagueclientux_count()
-                else:
-                    process_count = get_league_process_count()
-                
                 # If ready, broadcast IMMEDIATE_START to all followers
                 # Followers will only start if their client is not running
                 if process_count >= threshold:
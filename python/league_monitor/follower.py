@@ -11,7 +11,7 @@ from .league_utils import (
     launch_league_client,
 )
 from .logger import Logger
-from .relay_client import ClientRole, RelayClient
+from .relay_client import ClientRole, CommandOutcome, RelayClient
 
 
 class FollowerService:
@@ -44,13 +44,14 @@ class FollowerService:
             self._session_token = token
             self._logger.success(f"Joined session: {token}")
 
+        # Outcomes are acknowledged to the controller
         @self._relay_client.on_immediate_start
-        def on_immediate_start():
-            asyncio.create_task(self._handle_immediate_start())
+        async def on_immediate_start():
+            return await self._handle_immediate_start()
 
         @self._relay_client.on_client_restarted
-        def on_client_restarted():
-            asyncio.create_task(self._handle_client_restarted())
+        async def on_client_restarted():
+            return await self._handle_client_restarted()
 
         @self._relay_client.on_status_update
         def on_status_update(status: dict):
@@ -123,36 +124,36 @@ class FollowerService:
             except Exception as e:
                 self._logger.error("Heartbeat error", e)
 
-    async def _handle_immediate_start(self) -> None:
+    async def _handle_immediate_start(self) -> CommandOutcome:
         """Handle immediate start command from controller."""
         self._logger.info("IMMEDIATE START command received from controller!")
 
         if self._is_starting_client:
             self._logger.info("Already starting client, skipping.")
-            return
+            return CommandOutcome(ok=True, detail="already starting")
 
         if is_league_game_running():
             self._logger.info("League game is running, skipping LeagueClient launch")
-            return
+            return CommandOutcome(ok=True, detail="game running")
 
         # Only start if client is NOT running
         if is_league_client_running():
             self._logger.info("LeagueClient is already running, no action needed.")
-            return
+            return CommandOutcome(ok=True, detail="client already running")
 
-        await self._launch_client()
+        return await self._launch_client()
 
-    async def _handle_client_restarted(self) -> None:
+    async def _handle_client_restarted(self) -> CommandOutcome:
         """Handle client restarted command from controller - restart follower's client too."""
         self._logger.info("CLIENT_RESTARTED command received from controller!")
 
         if self._is_starting_client:
             self._logger.info("Already starting client, skipping.")
-            return
+            return CommandOutcome(ok=True, detail="already starting")
 
         if is_league_game_running():
             self._logger.info("League game is running, skipping LeagueClient restart")
-            return
+            return CommandOutcome(ok=True, detail="game running")
 
         # Kill existing client if running, then restart
         if is_league_client_running():
@@ -160,7 +161,7 @@ class FollowerService:
             kill_league_client()
             await asyncio.sleep(2)
 
-        await self._launch_client()
+        return await self._launch_client()
 
     def _handle_status_update(self, status: dict) -> None:
         """Handle status update from controller."""
@@ -179,10 +180,10 @@ class FollowerService:
                 self._logger.info("Controller is ready, starting our LeagueClient...")
                 asyncio.create_task(self._launch_client())
 
-    async def _launch_client(self) -> None:
+    async def _launch_client(self) -> CommandOutcome:
         """Launch League Client."""
         if self._is_starting_client:
-            return
+            return CommandOutcome(ok=True, detail="already starting")
 
         self._is_starting_client = True
 
@@ -202,8 +203,10 @@ class FollowerService:
                         break
                 else:
                     self._logger.warn("LeagueClient process not detected after 15 seconds")
-            else:
-                self._logger.error("Failed to launch LeagueClient")
+                return CommandOutcome(ok=True, detail="client launched")
+
+            self._logger.error("Failed to launch LeagueClient")
+            return CommandOutcome(ok=False, detail="launch failed")
 
         finally:
             self._is_starting_client = False
@@ -0,0 +1,67 @@
+"""Messages kept for delivery while a RelayClient is not in a session."""
+
+import time
+from collections import OrderedDict, deque
+from dataclasses import dataclass
+from typing import Deque, List, Optional, Tuple
+
+_MAX_COMMANDS = 64
+_MAX_STATE = 16
+_COMMAND_TTL = 30.0  # seconds; a late command is worse than none
+_STATE_TTL = 60.0
+
+# Only the latest queued copy of these is kept; anything else is a command
+_STATE_TYPES = frozenset({"STATUS_UPDATE", "STATUS_REQUEST", "GAME_STATUS"})
+
+
+@dataclass
+class _Pending:
+    msg_type: str
+    message: str
+    expires_at: float
+
+
+class Outbox:
+    """Messages a RelayClient could not send because it was not in a session.
+
+    Drained right after the next JOINED, commands first; each message
+    carries its own deadline and is dropped once it passes.
+    """
+
+    def __init__(self):
+        self._commands: Deque[_Pending] = deque(maxlen=_MAX_COMMANDS)  # full: oldest dropped
+        self._state: "OrderedDict[str, _Pending]" = OrderedDict()  # type -> latest, oldest first
+
+    @property
+    def has_commands(self) -> bool:
+        return bool(self._commands)
+
+    def __len__(self) -> int:
+        return len(self._commands) + len(self._state)
+
+    def push(self, msg_type: str, message: str, ttl: Optional[float] = None) -> None:
+        """Queue a serialized message; ttl (seconds) overrides the default for its kind."""
+        if msg_type in _STATE_TYPES:
+            self._state.pop(msg_type, None)
+            if len(self._state) >= _MAX_STATE:
+                self._state.popitem(last=False)
+            self._state[msg_type] = _Pending(msg_type, message, time.monotonic() + (_STATE_TTL if ttl is None else ttl))
+            return
+        self._commands.append(_Pending(msg_type, message, time.monotonic() + (_COMMAND_TTL if ttl is None else ttl)))
+
+    def drain(self) -> Tuple[List[str], List[str]]:
+        """Empty the outbox: the live messages, commands first, and the types of the expired ones."""
+        now = time.monotonic()
+        messages: List[str] = []
+        expired: List[str] = []
+        for pending in [*self._commands, *self._state.values()]:
+            if pending.expires_at <= now:
+                expired.append(pending.msg_type)
+            else:
+                messages.append(pending.message)
+        self.clear()
+        return messages, expired
+
+    def clear(self) -> None:
+        self._commands.clear()
+        self._state.clear()
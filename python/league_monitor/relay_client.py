@@ -1,15 +1,24 @@
 """WebSocket client for relay server communication."""
 
 import asyncio
+import inspect
 import json
+import ssl
+import time
+import uuid
+from collections import OrderedDict
+from dataclasses import dataclass
 from enum import Enum
-from typing import Any, Callable, Dict, Optional
+from typing import Any, Awaitable, Callable, Dict, Optional, Union
 
 import websockets
 from websockets.client import WebSocketClientProtocol
 
 from .config import get_config
 from .logger import Logger
+from .outbox import Outbox
+from .relay_selector import RelayEndpoint, RelaySelector
+from .shared_connection import Channel, SharedConnection
 
 
 class MessageType(Enum):
@@ -31,6 +40,7 @@ class MessageType(Enum):
     GAME_STATUS_RECEIVED = "GAME_STATUS_RECEIVED"
     HEARTBEAT = "HEARTBEAT"
     HEARTBEAT_ACK = "HEARTBEAT_ACK"
+    COMMAND_ACK = "COMMAND_ACK"
     ERROR = "ERROR"
 
 
@@ -40,6 +50,30 @@ class ClientRole(Enum):
     FOLLOWER = "follower"
 
 
+@dataclass
+class CommandOutcome:
+    """Result a follower reports when it finished a command."""
+    ok: bool
+    detail: Optional[str] = None  # e.g. "client launched", "cooldown"
+
+
+# A command handler may be sync or async; returning None counts as success
+CommandHandler = Callable[[], Union[Optional[CommandOutcome], Awaitable[Optional[CommandOutcome]]]]
+
+# Command IDs remembered for deduplication (follower) and latency (controller)
+_RECENT_COMMANDS = 256
+
+# Tied to one connection: sent again on connect, never worth queueing
+_CONNECTION_TYPES = frozenset({"JOIN", "CREATE_SESSION", "HEARTBEAT"})
+
+# Answers to a delivery on the current connection: the relay drops the delivery with the
+# connection, so one replayed after a reconnect (under a new client ID) matches nothing
+_DELIVERY_TYPES = frozenset({"COMMAND_ACK"})
+
+# Reconnect interval (seconds) while a queued command is waiting for the relay
+_PENDING_RECONNECT_INTERVAL = 1.0
+
+
 class RelayClient:
     """WebSocket client for relay server."""
 
@@ -48,24 +82,74 @@ class RelayClient:
         self._logger = Logger(f"RelayClient-{role.value}")
         self._config = get_config()
         self._server_url = self._config.relay.url
+        self._ssl_context = self._create_ssl_context()
+        self._selector = self._create_selector()
+        self._endpoint: Optional[RelayEndpoint] = None
+        self._switching = False
+        self._last_failover = 0.0
         
-        self._websocket: Optional[WebSocketClientProtocol] = None
+        self._websocket: Optional[Union[WebSocketClientProtocol, Channel]] = None
         self._session_token: Optional[str] = None
         self._is_connected = False
+        self._joined = False  # JOINED received on the current connection
         self._reconnect_interval = 5.0
+        self._reconnect_wake = asyncio.Event()
         self._running = False
+        self._outbox = Outbox()
         
         # Event handlers
         self._on_connected: Optional[Callable[[], None]] = None
         self._on_disconnected: Optional[Callable[[], None]] = None
         self._on_session_created: Optional[Callable[[str], None]] = None
         self._on_joined: Optional[Callable[[str, Dict[str, Any]], None]] = None
-        self._on_immediate_start: Optional[Callable[[], None]] = None
-        self._on_client_restarted: Optional[Callable[[], None]] = None
+        self._on_immediate_start: Optional[CommandHandler] = None
+        self._on_client_restarted: Optional[CommandHandler] = None
         self._on_status_update: Optional[Callable[[Dict[str, Any]], None]] = None
         self._on_status_request: Optional[Callable[[], Dict[str, Any]]] = None
         self._on_error: Optional[Callable[[str], None]] = None
 
+        # Follower: command ID -> outcome once handled (None while running)
+        self._handled_commands: "OrderedDict[str, Optional[CommandOutcome]]" = OrderedDict()
+        # Controller: command ID -> time it was issued
+        self._issued_commands: "OrderedDict[str, float]" = OrderedDict()
+
+    def _create_ssl_context(self) -> Optional[ssl.SSLContext]:
+        """Build one TLS context for all reconnects (wss:// only).
+
+        asyncio cannot offer a previous TLS session on a new connection, so
+        reconnects do a full handshake; sharing the context at least avoids
+        reloading the trust store every time.
+        """
+        if not self._config.relay.tls:
+            return None
+        context = ssl.create_default_context(cafile=self._config.relay.ca_file)
+        context.minimum_version = ssl.TLSVersion.TLSv1_2
+        return context
+
+    def _create_selector(self) -> Optional[RelaySelector]:
+        """Relay list from relay.endpoints, or None for the single relay.host."""
+        relay = self._config.relay
+        if not relay.endpoints:
+            return None
+        endpoints = [RelayEndpoint.parse(value, relay.port) for value in relay.endpoints]
+        return RelaySelector(endpoints, self._ssl_context)
+
+    def _use_endpoint(self, endpoint: RelayEndpoint) -> None:
+        self._endpoint = endpoint
+        self._server_url = self._config.relay.url_for(endpoint.host, endpoint.port)
+
+    async def _probe_loop(self) -> None:
+        """Move to a clearly faster relay when periodic probing finds one."""
+        while self._running:
+            await asyncio.sleep(self._config.relay.probe_interval)
+            if not self._is_connected:
+                continue  # reconnecting; failover picks the relay
+            better = await self._selector.find_better()
+            if better and self._websocket and self._is_connected:
+                self._use_endpoint(better)
+                self._switching = True
+                await self._websocket.close()
+
     @property
     def is_connected(self) -> bool:
         return self._is_connected
@@ -86,10 +170,10 @@ class RelayClient:
     def on_joined(self, handler: Callable[[str, Dict[str, Any]], None]) -> None:
         self._on_joined = handler
 
-    def on_immediate_start(self, handler: Callable[[], None]) -> None:
+    def on_immediate_start(self, handler: CommandHandler) -> None:
         self._on_immediate_start = handler
 
-    def on_client_restarted(self, handler: Callable[[], None]) -> None:
+    def on_client_restarted(self, handler: CommandHandler) -> None:
         self._on_client_restarted = handler
 
     def on_status_update(self, handler: Callable[[Dict[str, Any]], None]) -> None:
@@ -105,14 +189,34 @@ class RelayClient:
         """Connect to relay server."""
         self._session_token = session_token
         self._running = True
-        
+
+        probe_task: Optional[asyncio.Task] = None
+        if self._selector:
+            self._use_endpoint(await self._selector.select_best())
+            if self._config.relay.probe_interval > 0:
+                probe_task = asyncio.create_task(self._probe_loop())
+
+        try:
+            await self._connect_loop()
+        finally:
+            if probe_task:
+                probe_task.cancel()
+
+    async def _connect_loop(self) -> None:
         while self._running:
             try:
-                self._logger.info(f"Connecting to relay server at {self._server_url}...")
-                
-                async with websockets.connect(self._server_url) as ws:
+                if self._config.relay.multiplex:
+                    # One socket per relay for every RelayClient in this process
+                    self._logger.info(f"Connecting to relay server at {self._server_url} (shared connection)...")
+                    connection = SharedConnection.channel(self._server_url, self._ssl_context)
+                else:
+                    self._logger.info(f"Connecting to relay server at {self._server_url}...")
+                    connection = websockets.connect(self._server_url, ssl=self._ssl_context)
+
+                async with connection as ws:
                     self._websocket = ws
                     self._is_connected = True
+                    self._joined = False
                     self._logger.success("Connected to relay server")
                     
                     if self._on_connected:
@@ -130,19 +234,50 @@ class RelayClient:
                 self._logger.error("Connection error", e)
             
             self._is_connected = False
+            self._joined = False
             if self._on_disconnected:
                 self._on_disconnected()
-            
+
+            if self._switching:
+                # Deliberate move to a faster relay: reconnect right away
+                self._switching = False
+                continue
+
+            # At most one failover per reconnect interval, so two bad relays don't ping-pong
+            if self._running and self._selector and time.monotonic() - self._last_failover >= self._reconnect_interval:
+                self._last_failover = time.monotonic()
+                failover = await self._selector.failover(self._endpoint)
+                if failover:
+                    self._use_endpoint(failover)
+                    continue
+
             if self._running:
-                self._logger.info(f"Reconnecting in {self._reconnect_interval} seconds...")
-                await asyncio.sleep(self._reconnect_interval)
+                await self._wait_to_reconnect()
+
+    async def _wait_to_reconnect(self) -> None:
+        """Wait out the reconnect interval, shorter while a command is queued.
+
+        A newly queued command ends the wait early.
+        """
+        interval = _PENDING_RECONNECT_INTERVAL if self._outbox.has_commands else self._reconnect_interval
+        self._logger.info(f"Reconnecting in {interval} seconds...")
+        self._reconnect_wake.clear()
+        try:
+            await asyncio.wait_for(self._reconnect_wake.wait(), interval)
+            self._logger.info("Reconnecting now to deliver queued messages...")
+        except asyncio.TimeoutError:
+            pass
 
     async def disconnect(self) -> None:
         """Disconnect from relay server."""
         self._running = False
+        self._reconnect_wake.set()
         if self._websocket:
             await self._websocket.close()
         self._is_connected = False
+        if len(self._outbox):
+            self._logger.warn(f"Discarding {len(self._outbox)} queued message(s)")
+            self._outbox.clear()
 
     async def _receive_loop(self) -> None:
         """Receive messages from server."""
@@ -183,22 +318,22 @@ class RelayClient:
                 self._logger.info(f"Session: {self._session_token}")
                 self._logger.info(f"Controller: {'Yes' if session_info.get('hasController') else 'No'}")
                 self._logger.info(f"Followers: {session_info.get('followerCount', 0)}")
-                
+
+                self._joined = True
+                await self._flush_outbox()
                 if self._on_joined:
                     self._on_joined(self._session_token, session_info)
             
             elif msg_type == "IMMEDIATE_START":
                 self._logger.info("Received immediate start command from controller!")
-                if self._on_immediate_start:
-                    self._on_immediate_start()
+                await self._run_command(data.get("commandId"), self._on_immediate_start)
             
             elif msg_type == "IMMEDIATE_START_BROADCASTED":
                 self._logger.success(f"Immediate start command sent to {data.get('sentTo')} follower(s)")
             
             elif msg_type == "CLIENT_RESTARTED":
                 self._logger.info("Received CLIENT_RESTARTED message from controller!")
-                if self._on_client_restarted:
-                    self._on_client_restarted()
+                await self._run_command(data.get("commandId"), self._on_client_restarted)
             
             elif msg_type == "RESTART_BROADCASTED":
                 self._logger.success(f"Restart command sent to {data.get('sentTo')} follower(s)")
@@ -215,6 +350,9 @@ class RelayClient:
                     status = self._on_status_request()
                     await self.send_status(status.get("clientRunning", False), status.get("processCount", 0))
             
+            elif msg_type == "COMMAND_ACK":
+                self._record_ack(data)
+
             elif msg_type == "HEARTBEAT_ACK":
                 pass  # Silent
             
@@ -238,13 +376,41 @@ class RelayClient:
             self._logger.error("Failed to handle message", e)
 
     async def _send(self, data: Dict[str, Any]) -> None:
-        """Send message to server."""
+        """Send now when in a session; otherwise keep the message for the next JOINED."""
+        msg_type = data["type"]
+        if msg_type in _CONNECTION_TYPES or (self._joined and self._is_connected):
+            await self._write(json.dumps(data))
+            return
+        if msg_type in _DELIVERY_TYPES:
+            self._logger.info(
+                f"Not in a session, dropping {msg_type} for {data.get('commandId')} (its delivery went with the connection)"
+            )
+            return
+
+        self._outbox.push(msg_type, json.dumps(data))
+        if msg_type in ("STATUS_UPDATE", "STATUS_REQUEST"):
+            return  # routine, coalesced
+        self._logger.warn(f"Not in a session, {msg_type} queued until the relay is back ({len(self._outbox)} pending)")
+        self._reconnect_wake.set()
+
+    async def _flush_outbox(self) -> None:
+        if not len(self._outbox):
+            return
+        messages, expired = self._outbox.drain()
+        if expired:
+            self._logger.warn(f"Dropped {len(expired)} queued message(s) past their deadline: {', '.join(expired)}")
+        if messages:
+            self._logger.info(f"Sending {len(messages)} message(s) queued while disconnected")
+        for message in messages:
+            await self._write(message)
+
+    async def _write(self, message: str) -> None:
         if not self._websocket or not self._is_connected:
             self._logger.warn("Cannot send: not connected")
             return
-        
+
         try:
-            await self._websocket.send(json.dumps(data))
+            await self._websocket.send(message)
         except Exception as e:
             self._logger.error("Failed to send message", e)
 
@@ -258,27 +424,100 @@ class RelayClient:
 
     async def send_heartbeat(self) -> None:
         """Send heartbeat to keep connection alive."""
+        if isinstance(self._websocket, Channel) and self._is_connected:
+            await self._websocket.heartbeat()
+            return
         await self._send({"type": "HEARTBEAT"})
 
-    async def broadcast_immediate_start(self) -> None:
-        """Broadcast immediate start command (controller only)."""
-        if not self._is_connected:
-            self._logger.warn("Not connected, cannot broadcast immediate start")
+    async def broadcast_immediate_start(self, command_id: Optional[str] = None) -> str:
+        """Broadcast immediate start command (controller only); returns the command ID.
+
+        Issued while not in a session, it goes out right after the next JOINED.
+        """
+        return await self._issue("IMMEDIATE_START", command_id)
+
+    async def broadcast_restart(self, command_id: Optional[str] = None) -> str:
+        """Broadcast restart command (controller only); returns the command ID.
+
+        Reusing an ID never makes a follower run the command twice.
+        """
+        return await self._issue("RESTART", command_id)
+
+    async def _issue(self, msg_type: str, command_id: Optional[str]) -> str:
+        command_id = command_id or str(uuid.uuid4())
+        if command_id not in self._issued_commands:
+            if len(self._issued_commands) >= _RECENT_COMMANDS:
+                self._issued_commands.popitem(last=False)
+            self._issued_commands[command_id] = time.monotonic()
+        await self._send({"type": msg_type, "commandId": command_id})
+        return command_id
+
+    def _record_ack(self, data: Dict[str, Any]) -> None:
+        """Log a follower's completion of a command this controller issued."""
+        issued_at = self._issued_commands.get(data.get("commandId", ""))
+        if issued_at is None or data.get("stage") != "completed":
+            return
+        latency_ms = round((time.monotonic() - issued_at) * 1000)
+        detail = f" ({data['detail']})" if data.get("detail") else ""
+        outcome = "completed" if data.get("ok") else "failed"
+        self._logger.info(
+            f"Follower {data.get('followerId')} {outcome} {data.get('commandType')} in {latency_ms}ms{detail}"
+        )
+        followers = data.get("followers", 0)
+        if data.get("completed", 0) + data.get("failed", 0) >= followers:
+            self._logger.success(
+                f"{data.get('commandType')} done: {data.get('completed', 0)}/{followers} follower(s) succeeded"
+            )
+
+    async def _run_command(self, command_id: Optional[str], handler: Optional[CommandHandler]) -> None:
+        """Ack receipt, run the handler once per command ID and ack its outcome.
+
+        A redelivered command is only re-acknowledged.
+        """
+        if not command_id:
+            if handler:
+                result = handler()
+                if inspect.isawaitable(result):
+                    asyncio.create_task(result)
             return
-        await self._send({"type": "IMMEDIATE_START"})
 
-    async def broadcast_restart(self) -> None:
-        """Broadcast restart command (controller only)."""
-        if not self._is_connected:
-            self._logger.warn("Not connected, cannot broadcast restart")
+        await self._ack_command(command_id, "received")
+        if command_id in self._handled_commands:
+            self._logger.info(f"Command {command_id} already handled, not running it again")
+            outcome = self._handled_commands[command_id]
+            if outcome is not None:
+                await self._ack_command(command_id, "completed", outcome)
             return
-        await self._send({"type": "RESTART"})
+
+        if len(self._handled_commands) >= _RECENT_COMMANDS:
+            self._handled_commands.popitem(last=False)
+        self._handled_commands[command_id] = None
+        asyncio.create_task(self._complete_command(command_id, handler))
+
+    async def _complete_command(self, command_id: str, handler: Optional[CommandHandler]) -> None:
+        try:
+            result = handler() if handler else None
+            if inspect.isawaitable(result):
+                result = await result
+            outcome = result or CommandOutcome(ok=True)
+        except Exception as e:
+            self._logger.error(f"Command {command_id} failed", e)
+            outcome = CommandOutcome(ok=False, detail=str(e))
+        if command_id in self._handled_commands:
+            self._handled_commands[command_id] = outcome
+        await self._ack_command(command_id, "completed", outcome)
+
+    async def _ack_command(self, command_id: str, stage: str, outcome: Optional[CommandOutcome] = None) -> None:
+        await self._send({
+            "type": "COMMAND_ACK",
+            "commandId": command_id,
+            "stage": stage,
+            "ok": outcome.ok if outcome else None,
+            "detail": outcome.detail if outcome else None,
+        })
 
     async def send_status(self, client_running: bool, process_count: int) -> None:
         """Send status update (controller only)."""
-        if not self._is_connected:
-            self._logger.warn("Not connected, cannot send status")
-            return
         await self._send({
             "type": "STATUS_UPDATE",
             "status": {
@@ -289,7 +528,4 @@ class RelayClient:
 
     async def request_status(self) -> None:
         """Request status from controller (follower only)."""
-        if not self._is_connected:
-            self._logger.warn("Not connected, cannot request status")
-            return
         await self._send({"type": "STATUS_REQUEST"})
@@ -0,0 +1,158 @@
+"""Relay endpoint selection by measured RTT, with failover."""
+
+import asyncio
+import ssl
+import statistics
+import time
+from dataclasses import dataclass
+from typing import Dict, List, Optional
+
+from .logger import Logger
+
+
+@dataclass(frozen=True)
+class RelayEndpoint:
+    """One relay server."""
+    host: str
+    port: int
+
+    @property
+    def key(self) -> str:
+        return f"{self.host}:{self.port}"
+
+    @classmethod
+    def parse(cls, value: str, default_port: int) -> "RelayEndpoint":
+        """Parse "host:port" (or "host", with default_port)."""
+        host, sep, port = value.strip().rpartition(":")
+        if not sep or "]" in port:
+            return cls(value.strip().strip("[]"), default_port)
+        return cls(host.strip("[]"), int(port))
+
+
+async def probe_rtt(
+    endpoint: RelayEndpoint,
+    ssl_context: Optional[ssl.SSLContext] = None,
+    samples: int = 3,
+    timeout: float = 2.0,
+) -> Optional[float]:
+    """Median round trip in ms of GET /health over one kept-alive connection.
+
+    The first request pays for the TCP/TLS handshake and isn't counted.
+    Returns None when the relay doesn't answer.
+    """
+    request = (
+        f"GET /health HTTP/1.1\r\nHost: {endpoint.host}:{endpoint.port}\r\n"
+        "Connection: keep-alive\r\n\r\n"
+    ).encode()
+
+    async def round_trip(reader: asyncio.StreamReader, writer: asyncio.StreamWriter) -> float:
+        start = time.perf_counter()
+        writer.write(request)
+        await writer.drain()
+        headers = await reader.readuntil(b"\r\n\r\n")
+        status = int(headers.split(b" ", 2)[1])
+        fields = dict(
+            (name.strip().lower(), value.strip().lower())
+            for name, _, value in (line.partition(b":") for line in headers.split(b"\r\n")[1:] if line)
+        )
+        if fields.get(b"transfer-encoding") == b"chunked":
+            while True:
+                size = int((await reader.readuntil(b"\r\n")).strip(), 16)
+                await reader.readexactly(size + 2)
+                if size == 0:
+                    break
+        else:
+            await reader.readexactly(int(fields.get(b"content-length", b"0")))
+        if status != 200:
+            raise ConnectionError(f"HTTP {status}")
+        return (time.perf_counter() - start) * 1000
+
+    writer: Optional[asyncio.StreamWriter] = None
+    try:
+        reader, writer = await asyncio.wait_for(
+            asyncio.open_connection(endpoint.host, endpoint.port, ssl=ssl_context), timeout
+        )
+        await asyncio.wait_for(round_trip(reader, writer), timeout)
+        rtts = [await asyncio.wait_for(round_trip(reader, writer), timeout) for _ in range(samples)]
+        return statistics.median(rtts)
+    except (OSError, asyncio.TimeoutError, asyncio.IncompleteReadError, ValueError, IndexError):
+        return None
+    finally:
+        if writer:
+            writer.close()
+
+
+class RelaySelector:
+    """Picks the lowest-RTT relay from a list and hands out the next best on failover."""
+
+    def __init__(self, endpoints: List[RelayEndpoint], ssl_context: Optional[ssl.SSLContext] = None):
+        if not endpoints:
+            raise ValueError("No relay endpoints configured")
+        self._endpoints = endpoints
+        self._ssl_context = ssl_context
+        self._rtts: Dict[str, Optional[float]] = {}
+        self._selected = endpoints[0]
+        self._logger = Logger("RelaySelector")
+
+    @property
+    def current(self) -> RelayEndpoint:
+        return self._selected
+
+    @property
+    def rtts(self) -> Dict[str, Optional[float]]:
+        """Last measured RTT per endpoint in ms (None = unreachable)."""
+        return dict(self._rtts)
+
+    async def probe(self) -> None:
+        """Probe every endpoint in parallel and record the results."""
+        results = await asyncio.gather(*(probe_rtt(e, self._ssl_context) for e in self._endpoints))
+        for endpoint, rtt in zip(self._endpoints, results):
+            self._rtts[endpoint.key] = rtt
+        self._logger.info("Relay RTTs: " + ", ".join(f"{e.key}={self._describe(e)}" for e in self._endpoints))
+
+    async def select_best(self) -> RelayEndpoint:
+        """Probe and select the best relay (the first one if none answered)."""
+        await self.probe()
+        self._select(self._best() or self._endpoints[0])
+        return self._selected
+
+    async def failover(self, failed: RelayEndpoint) -> Optional[RelayEndpoint]:
+        """The relay in use failed: move to the best other reachable one, if any."""
+        await self.probe()
+        self._rtts[failed.key] = None
+        best = self._best()
+        if best is None:
+            self._logger.warn(f"No other relay reachable, staying on {failed.key}")
+            return None
+        self._logger.warn(f"Failing over from {failed.key} to {best.key} ({self._describe(best)})")
+        self._select(best)
+        return best
+
+    async def find_better(self) -> Optional[RelayEndpoint]:
+        """Re-probe; select and return another relay if it is at least 30% and 20ms faster."""
+        await self.probe()
+        best = self._best()
+        if best is None or best == self._selected:
+            return None
+        current_rtt = self._rtts.get(self._selected.key)
+        best_rtt = self._rtts[best.key]
+        if current_rtt is None or (best_rtt < current_rtt * 0.7 and current_rtt - best_rtt > 20):
+            self._logger.info(
+                f"Relay {best.key} ({self._describe(best)}) is faster than "
+                f"{self._selected.key} ({self._describe(self._selected)}), switching"
+            )
+            self._select(best)
+            return best
+        return None
+
+    def _best(self) -> Optional[RelayEndpoint]:
+        reachable = [e for e in self._endpoints if self._rtts.get(e.key) is not None]
+        return min(reachable, key=lambda e: self._rtts[e.key], default=None)
+
+    def _select(self, endpoint: RelayEndpoint) -> None:
+        self._selected = endpoint
+        self._logger.success(f"Using relay {endpoint.key} ({self._describe(endpoint)})")
+
+    def _describe(self, endpoint: RelayEndpoint) -> str:
+        rtt = self._rtts.get(endpoint.key)
+        return "unreachable" if rtt is None else f"{rtt:.1f}ms"
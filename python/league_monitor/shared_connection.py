@@ -0,0 +1,174 @@
+"""One relay socket per process, multiplexed into a channel per RelayClient."""
+
+import asyncio
+import json
+import re
+import ssl
+import time
+from typing import Dict, Optional
+
+import websockets
+from websockets.client import WebSocketClientProtocol
+
+from .logger import Logger
+
+# Channel frames are relay messages with the channel ID spliced in front:
+# {"channel":"c1","type":"JOIN",...}. Routing only looks at that prefix.
+_CHANNEL_PREFIX = re.compile(r'^\{"channel":"([A-Za-z0-9_-]{1,32})",')
+
+_HEARTBEAT_INTERVAL = 10.0
+
+
+def _control(channel_id: str, msg_type: str) -> str:
+    return json.dumps({"channel": channel_id, "type": msg_type}, separators=(",", ":"))
+
+
+class Channel:
+    """One logical relay connection inside a SharedConnection.
+
+    Used like the websocket it replaces: ``async with`` opens it, ``send``
+    writes, ``async for`` reads (frames arrive without the channel ID) and
+    ``close`` closes only this channel.
+    """
+
+    def __init__(self, connection: "SharedConnection", channel_id: str):
+        self._connection = connection
+        self.id = channel_id
+        self._inbox: asyncio.Queue = asyncio.Queue()
+        self._open = False
+
+    async def __aenter__(self) -> "Channel":
+        await self._connection._ensure_connected()
+        await self._connection._send(_control(self.id, "CHANNEL_OPEN"))
+        self._open = True
+        return self
+
+    async def __aexit__(self, *exc) -> None:
+        await self.close()
+
+    def __aiter__(self) -> "Channel":
+        return self
+
+    async def __anext__(self) -> str:
+        frame = await self._inbox.get()
+        if frame is None:
+            raise websockets.ConnectionClosed(None, None)
+        return frame
+
+    async def send(self, message: str) -> None:
+        if not self._open:
+            raise websockets.ConnectionClosed(None, None)
+        await self._connection._send(f'{{"channel":"{self.id}",{message[1:]}')
+
+    async def heartbeat(self) -> None:
+        await self._connection.heartbeat()
+
+    async def close(self) -> None:
+        if not self._open:
+            return
+        self._open = False
+        self._inbox.put_nowait(None)
+        await self._connection._close_channel(self)
+
+    def _closed_by_peer(self) -> None:
+        self._open = False
+        self._inbox.put_nowait(None)
+
+
+class SharedConnection:
+    """The process's socket to one relay; closes when its last channel does."""
+
+    _connections: Dict[str, "SharedConnection"] = {}
+
+    @classmethod
+    def channel(cls, url: str, ssl_context: Optional[ssl.SSLContext] = None) -> Channel:
+        """A new channel on the live connection to url (or a new connection)."""
+        connection = cls._connections.get(url)
+        if connection is None or connection._closed:
+            connection = cls(url, ssl_context)
+            cls._connections[url] = connection
+        return connection._new_channel()
+
+    def __init__(self, url: str, ssl_context: Optional[ssl.SSLContext]):
+        self._url = url
+        self._ssl_context = ssl_context
+        self._websocket: Optional[WebSocketClientProtocol] = None
+        self._channels: Dict[str, Channel] = {}
+        self._next_id = 1
+        self._lock = asyncio.Lock()
+        self._closed = False
+        self._last_heartbeat = 0.0
+        self._logger = Logger("SharedConnection")
+
+    def _new_channel(self) -> Channel:
+        channel = Channel(self, f"c{self._next_id}")
+        self._next_id += 1
+        self._channels[channel.id] = channel
+        return channel
+
+    async def _ensure_connected(self) -> None:
+        async with self._lock:
+            if self._websocket is not None:
+                return
+            if self._closed:
+                raise ConnectionError("Shared connection already closed")
+            try:
+                self._websocket = await websockets.connect(self._url, ssl=self._ssl_context)
+            except Exception:
+                self._shutdown()
+                raise
+            asyncio.create_task(self._receive_loop())
+
+    async def _receive_loop(self) -> None:
+        try:
+            async for frame in self._websocket:
+                match = _CHANNEL_PREFIX.match(frame)
+                if not match:
+                    continue  # CONNECTED / HEARTBEAT_ACK for the socket itself
+                channel = self._channels.get(match.group(1))
+                if channel is None:
+                    continue
+                body = "{" + frame[match.end():]
+                if body.startswith('{"type":"CHANNEL_CLOSE"'):
+                    self._channels.pop(channel.id, None)
+                    channel._closed_by_peer()
+                else:
+                    channel._inbox.put_nowait(body)
+        except websockets.ConnectionClosed:
+            pass
+        except Exception as e:
+            self._logger.error("Receive error", e)
+        self._shutdown()
+
+    async def _send(self, frame: str) -> None:
+        if self._websocket is None:
+            raise websockets.ConnectionClosed(None, None)
+        await self._websocket.send(frame)
+
+    async def heartbeat(self) -> None:
+        """Keepalive for every channel; repeats from other channels within 10s are skipped."""
+        if self._websocket is None or time.monotonic() - self._last_heartbeat < _HEARTBEAT_INTERVAL:
+            return
+        self._last_heartbeat = time.monotonic()
+        await self._websocket.send(json.dumps({"type": "HEARTBEAT"}))
+
+    async def _close_channel(self, channel: Channel) -> None:
+        if self._channels.pop(channel.id, None) is None:
+            return
+        try:
+            await self._send(_control(channel.id, "CHANNEL_CLOSE"))
+        except Exception:
+            pass
+        if not self._channels and self._websocket is not None:
+            self._shutdown()
+            await self._websocket.close()
+
+    def _shutdown(self) -> None:
+        """Stop handing out this connection and end every channel."""
+        self._closed = True
+        if SharedConnection._connections.get(self._url) is self:
+            del SharedConnection._connections[self._url]
+        channels = list(self._channels.values())
+        self._channels.clear()
+        for channel in channels:
+            channel._closed_by_peer()
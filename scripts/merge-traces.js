@@ -0,0 +1,22 @@
+#!/usr/bin/env node
+// Merge trace files from the relay, controller and followers into one timeline
+// Usage: node scripts/merge-traces.js trace-relay.json trace-controller.json ... > merged.json
+import { readFileSync } from 'fs';
+
+const files = process.argv.slice(2);
+if (files.length === 0) {
+  console.error('Usage: node scripts/merge-traces.js <trace.json>... > merged.json');
+  process.exit(1);
+}
+
+const traceEvents = [];
+for (const file of files) {
+  // Trace files are unterminated JSON arrays with a trailing comma
+  const text = readFileSync(file, 'utf8').trim().replace(/,$/, '').replace(/\]$/, '');
+  const events = JSON.parse(text + ']');
+  traceEvents.push(...events);
+  console.error(`${file}: ${events.length} events`);
+}
+
+traceEvents.sort((a, b) => (a.ts ?? 0) - (b.ts ?? 0));
+process.stdout.write(JSON.stringify({ traceEvents, displayTimeUnit: 'ms' }));
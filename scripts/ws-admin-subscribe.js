@@ -1,13 +1,22 @@
 #!/usr/bin/env node
 // Simple admin WS client for relay server, prints events
+// Optional filter: ADMIN_SESSIONS=tok1,tok2 ADMIN_EVENTS=sessions,activity,commands,traffic,fleet,hotspots ADMIN_MIN_LEVEL=info
 import WebSocket from 'ws';
 const base = process.env.RELAY_BASE || 'ws://localhost:8080';
+const list = (value) => value ? value.split(',').map(s => s.trim()).filter(Boolean) : undefined;
 
-const ws = new WebSocket(base);
+const filter = {
+  sessions: list(process.env.ADMIN_SESSIONS),
+  events: list(process.env.ADMIN_EVENTS),
+  minLevel: process.env.ADMIN_MIN_LEVEL
+};
+
+// /admin gets permessage-deflate; the default path works too, uncompressed
+const ws = new WebSocket(`${base}/admin`);
 
 ws.onopen = () => {
   console.log('connected, subscribing...');
-  ws.send(JSON.stringify({ type: 'ADMIN_SUBSCRIBE' }));
+  ws.send(JSON.stringify({ type: 'ADMIN_SUBSCRIBE', filter }));
 };
 
 ws.onmessage = (ev) => {
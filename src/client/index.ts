@@ -1,12 +1,19 @@
 import { SessionClient } from '../controller/session-client.js';
 import { LeagueUtils } from '../shared/league-utils.js';
 import { Logger } from '../shared/logger.js';
+import { resolveClientIpcPath } from '../shared/ipc-socket.js';
+import { tracer } from '../shared/tracing.js';
+import { LanDiscovery } from '../shared/lan-discovery.js';
 import { getFollowerConfig } from '../shared/config.js';
+import { selectRelay } from '../shared/relay-endpoints.js';
+import { SamplingCadence } from '../shared/sampling-cadence.js';
+import type { RelayEndpoint } from '../shared/relay-endpoints.js';
 
 const logger = new Logger('Follower');
 
 // Load configuration from config.json
 const config = getFollowerConfig();
+tracer.configure(config.tracing, 'follower');
 
 async function main() {
   // Get token from command line argument (optional - will auto-join by IP if not provided)
@@ -22,12 +29,21 @@ async function main() {
     logger.info('(Make sure controller is running on the same machine/IP)');
   }
 
-  // Initialize session client
-  const sessionClient = new SessionClient(
-    config.relayServerHost,
-    config.relayServerPort,
-    'follower'
-  );
+  // Initialize session client on the nearest configured relay
+  const remoteOptions = (endpoint: RelayEndpoint) => ({
+    tls: { enabled: config.relayServerTls ?? false, caFile: config.relayServerCaFile },
+    ipcPath: resolveClientIpcPath(endpoint.host, config.relayIpc, config.relayIpcPath, config.relayServerTls),
+    multiplex: config.relayMultiplex
+  });
+  const { endpoint: relay, selector } = await selectRelay(config);
+  const sessionClient = new SessionClient(relay.host, relay.port, 'follower', remoteOptions(relay));
+  if (selector) {
+    sessionClient.useRelaySelector(selector, remoteOptions);
+    selector.start();
+  }
+
+  // Game process checks: fast around commands and kills, backing off while nothing changes
+  const gameCheck = new SamplingCadence('follower.game_check', () => checkGameProcess(), config.sampling);
 
   // Spam protection: track last start time
   let lastStartTime: number = 0;
@@ -40,7 +56,7 @@ async function main() {
     if (timeSinceLastStart < startCooldown) {
       const remainingSeconds = Math.ceil((startCooldown - timeSinceLastStart) / 1000);
       logger.info(`CLIENT_RESTARTED command received, but in cooldown period (${remainingSeconds}s remaining). Skipping.`);
-      return;
+      return { ok: true, detail: 'cooldown' };
     }
 
     const { ProcessUtils } = await import('../shared/process-utils.js');
@@ -49,12 +65,13 @@ async function main() {
     const gameProcessNames = LeagueUtils.getLeagueGameProcessNames();
     
     logger.info('CLIENT_RESTARTED command received from controller (VGC exit code 185)!');
+    gameCheck.burst();
     
     // Check if game is running - if yes, skip launch (30-second check will handle it when game closes)
     const isGameRunning = await ProcessUtils.isAnyProcessRunning(gameProcessNames);
     if (isGameRunning) {
       logger.info('League of Legends game is running, skipping LeagueClient launch (will be handled by 30-second game check when game closes)');
-      return;
+      return { ok: true, detail: 'game running' };
     }
     
     const isClientRunning = await ProcessUtils.isProcessRunning(clientProcessName);
@@ -91,8 +108,10 @@ async function main() {
       } else {
         logger.warn('LeagueClient process not detected after 15 seconds, but launch was successful');
       }
+      return { ok: true, detail: 'client launched' };
     } else {
       logger.error('Failed to launch client');
+      return { ok: false, detail: 'launch failed' };
     }
   });
 
@@ -103,7 +122,7 @@ async function main() {
     if (timeSinceLastStart < startCooldown) {
       const remainingSeconds = Math.ceil((startCooldown - timeSinceLastStart) / 1000);
       logger.info(`IMMEDIATE START command received, but in cooldown period (${remainingSeconds}s remaining). Skipping.`);
-      return;
+      return { ok: true, detail: 'cooldown' };
     }
 
     const { ProcessUtils } = await import('../shared/process-utils.js');
@@ -112,12 +131,13 @@ async function main() {
     const gameProcessNames = LeagueUtils.getLeagueGameProcessNames();
     
     logger.info('IMMEDIATE START command received from controller!');
+    gameCheck.burst();
     
     // Check if game is running - if yes, skip launch (30-second check will handle it when game closes)
     const isGameRunning = await ProcessUtils.isAnyProcessRunning(gameProcessNames);
     if (isGameRunning) {
       logger.info('League of Legends game is running, skipping LeagueClient launch (will be handled by 30-second game check when game closes)');
-      return;
+      return { ok: true, detail: 'game running' };
     }
     
     const isClientRunning = await ProcessUtils.isProcessRunning(clientProcessName);
@@ -154,13 +174,41 @@ async function main() {
       } else {
         logger.warn('LeagueClient process not detected after 15 seconds, but launch was successful');
       }
+      return { ok: true, detail: 'client launched' };
     } else {
       logger.error('Failed to launch client');
+      return { ok: false, detail: 'launch failed' };
     }
   });
 
-  // Connect with token (or auto-join by IP)
-  await sessionClient.connect(sessionToken);
+  // LAN direct: prefer a controller's LAN relay, keep the remote relay as fallback
+  if (config.lanDirect) {
+    const discovery = new LanDiscovery(sessionToken, config.lanDiscoveryPort, undefined, config.lanSecret);
+    discovery.start();
+
+    const lanRelay = await discovery.waitForRelay(3000);
+    if (lanRelay) {
+      logger.success(`Using LAN relay at ${lanRelay.host}:${lanRelay.port}`);
+      sessionClient.switchEndpoint(lanRelay.host, lanRelay.port, {}, lanRelay.sessionToken);
+    } else {
+      logger.info('No LAN relay found, using remote relay');
+      await sessionClient.connect(sessionToken);
+    }
+
+    discovery.on('found', relay => {
+      logger.success(`LAN relay available at ${relay.host}:${relay.port}, switching`);
+      sessionClient.switchEndpoint(relay.host, relay.port, {}, relay.sessionToken);
+    });
+    discovery.on('lost', () => {
+      logger.warn('LAN relay lost, falling back to remote relay');
+      const remote = selector?.current() ?? relay;
+      // The LAN relay's token may be one the remote relay never saw: rejoin with our own (or by IP)
+      sessionClient.switchEndpoint(remote.host, remote.port, remoteOptions(remote), sessionToken ?? null);
+    });
+  } else {
+    // Connect with token (or auto-join by IP)
+    await sessionClient.connect(sessionToken);
+  }
 
   // Request initial status from controller (only if we have a session token)
   // If auto-joining, wait for successful join first
@@ -187,15 +235,18 @@ async function main() {
   let lastGameRunningCheckTime: number = 0;
   const gameRunningRestartCooldown: number = 10 * 60 * 1000; // 5 minutes cooldown between restart requests when game is running
 
-  // Check game process every 5 seconds
-  // If game was running 5 seconds ago but is now closed, restart both clients
-  const gameCheckInterval = 5 * 1000; // 5 seconds in milliseconds
-  
-  // Every 5 seconds: Check if game process status changed (running -> closed)
-  // Also check if game is running and LeagueClient should be closed
-  setInterval(async () => {
+  let lastClientStatus: boolean | null = null;
+
+  // Every 2 minutes (on the first sample after): request restart if the game keeps running
+  const gameRunningCheckInterval = 2 * 60 * 1000; // 2 minutes in milliseconds
+  let nextGameRunningCheck: number = Date.now() + gameRunningCheckInterval;
+
+  // Each sample: check if game is running and LeagueClient should be closed, and
+  // (every 2 minutes) request a restart if the game keeps running.
+  // Resolves true when the game or client status changed.
+  const checkGameProcess = async (): Promise<boolean> => {
     if (!sessionClient.connected() || !sessionClient.getSessionToken()) {
-      return; // Not connected yet, skip check
+      return false; // Not connected yet, skip check
     }
 
     try {
@@ -205,12 +256,20 @@ async function main() {
       const clientProcessName = LeagueUtils.getLeagueClientProcessName();
       const isGameRunning = await ProcessUtils.isAnyProcessRunning(gameProcessNames);
       const isClientRunning = await ProcessUtils.isProcessRunning(clientProcessName);
+      const changed = isGameRunning !== lastGameStatus || isClientRunning !== lastClientStatus;
+      lastClientStatus = isClientRunning;
+
+      if (Date.now() >= nextGameRunningCheck) {
+        while (nextGameRunningCheck <= Date.now()) nextGameRunningCheck += gameRunningCheckInterval;
+        if (isGameRunning) checkGameStillRunning();
+      }
 
       // If game is running and LeagueClient is also running, close LeagueClient
       if (isGameRunning && isClientRunning) {
         logger.warn('League of Legends game is running and LeagueClient is also running! Closing LeagueClient until game closes...');
         const killedCount = await ProcessUtils.killProcessByName(clientProcessName);
         if (killedCount > 0) {
+          gameCheck.burst();
           logger.success('Closed LeagueClient because game is running');
           // Also kill RiotClientServices
           const riotClientServicesName = LeagueUtils.getRiotClientServicesProcessName();
@@ -221,7 +280,7 @@ async function main() {
           }
         }
         lastGameStatus = isGameRunning;
-        return;
+        return changed;
       }
       
       // // Check if game was running before but is now closed
@@ -254,45 +313,32 @@ async function main() {
       //     }
       //   }
       // }
+      lastGameStatus = isGameRunning;
+      return changed;
     } catch (error) {
       logger.error('Failed to check game process status', error as Error);
+      return false;
     }
-  }, gameCheckInterval);
-
-  // Also check game process every 2 minutes for restart request when game is running
-  const gameRunningCheckInterval = 2 * 60 * 1000; // 2 minutes in milliseconds
+  };
 
-  // Every 2 minutes: Check if game is running and request restart (if game keeps running)
-  setInterval(async () => {
-    if (!sessionClient.connected() || !sessionClient.getSessionToken()) {
-      return; // Not connected yet, skip check
-    }
+  // Game is running (2 minute check): request restart from controller unless in cooldown
+  const checkGameStillRunning = () => {
+    const now = Date.now();
 
-    try {
-      const { ProcessUtils } = await import('../shared/process-utils.js');
-      const { LeagueUtils } = await import('../shared/league-utils.js');
-      const gameProcessNames = LeagueUtils.getLeagueGameProcessNames();
-      const isGameRunning = await ProcessUtils.isAnyProcessRunning(gameProcessNames);
+    // Game is running, check if we should request restart
+    const timeSinceLastRequest = now - lastGameRunningCheckTime;
 
-      const now = Date.now();
-      
-      if (isGameRunning) {
-        // Game is running, check if we should request restart
-        const timeSinceLastRequest = now - lastGameRunningCheckTime;
-        
-        if (timeSinceLastRequest >= gameRunningRestartCooldown) {
-          logger.info('League of Legends game is running (2 minute check), requesting restart from controller...');
-          sessionClient.requestRestartFromController();
-          lastGameRunningCheckTime = now;
-        } else {
-          const remainingMinutes = Math.ceil((gameRunningRestartCooldown - timeSinceLastRequest) / 60000);
-          logger.info(`Game is running, but restart request is in cooldown (${remainingMinutes} minutes remaining)`);
-        }
-      }
-    } catch (error) {
-      logger.error('Failed to check game process for restart request', error as Error);
+    if (timeSinceLastRequest >= gameRunningRestartCooldown) {
+      logger.info('League of Legends game is running (2 minute check), requesting restart from controller...');
+      sessionClient.requestRestartFromController();
+      lastGameRunningCheckTime = now;
+    } else {
+      const remainingMinutes = Math.ceil((gameRunningRestartCooldown - timeSinceLastRequest) / 60000);
+      logger.info(`Game is running, but restart request is in cooldown (${remainingMinutes} minutes remaining)`);
     }
-  }, gameRunningCheckInterval);
+  };
+
+  gameCheck.start();
 
   // Send heartbeat every 30 seconds
   setInterval(() => {
@@ -303,13 +349,14 @@ async function main() {
 
   process.on('SIGINT', () => {
     logger.info('Shutting down...');
+    gameCheck.stop();
     sessionClient.disconnect();
     process.exit(0);
   });
 
   logger.success('Follower is running!');
   logger.info('Waiting for 8+ process detection from controller...');
-  logger.info('Game process check: Every 30 seconds (if game closes, will request restart)');
+  logger.info('Game process check: every 1-15s (faster after commands, slower while nothing changes)');
   logger.info('Game process check: Every 2 minutes (if game is running, will request restart)');
   logger.info('Press Ctrl+C to stop');
 }
@@ -1,26 +1,39 @@
 import { ProcessUtils } from '../shared/process-utils.js';
 import { LeagueUtils } from '../shared/league-utils.js';
 import { Logger } from '../shared/logger.js';
+import { SamplingCadence } from '../shared/sampling-cadence.js';
+import type { SamplingOptions } from '../shared/sampling-cadence.js';
+
+interface ProcessCountWaiter {
+  threshold: number;
+  since: number; // only samples started at or after this count
+  resolve: (count: number) => void;
+  timer: NodeJS.Timeout;
+}
 
 export class ClientMonitor {
   private logger: Logger;
-  private monitorInterval: number;
+  private cadence: SamplingCadence;
   private isMonitoring: boolean = false;
-  private monitorTimer?: NodeJS.Timeout;
   private onImmediateStart?: () => void;
   private onClientStarted?: () => void;
   private onRestart?: () => void; // Callback for VGC exit code 185 restart
   private lastProcessCount: number = 0;
+  private sampleSeq: number = 0; // bumped as each process count sample starts
   private immediateStartTriggered: boolean = false;
   private lastRestartTime: number = 0;
   private lastLogTime: number = 0;
   private lastVgcCheckTime: number = 0;
   private vgcRestartTriggered: boolean = false;
   private readonly restartCooldown: number = 30000; // 30 seconds cooldown
+  private clientCount: number = 0;
+  private gameRunning: boolean = false;
+  private lastState: string = '';
+  private waiters: ProcessCountWaiter[] = [];
 
-  constructor(monitorInterval: number = 5000) {
+  constructor(sampling: Partial<SamplingOptions> = {}) {
     this.logger = new Logger('ClientMonitor');
-    this.monitorInterval = monitorInterval;
+    this.cadence = new SamplingCadence('controller.monitor', () => this.sample(), sampling);
   }
 
   /**
@@ -59,13 +72,8 @@ export class ClientMonitor {
     // Initial check and launch if needed
     await this.checkAndRestartClient();
 
-    // Set up periodic monitoring
-    this.monitorTimer = setInterval(async () => {
-      await this.checkAndRestartClient();
-      await this.checkAndKillGame();
-      await this.checkLeagueProcessCount();
-      await this.checkVgcService(); // Check VGC service exit code
-    }, this.monitorInterval);
+    // Periodic monitoring: fast around launches, kills and commands, backing off while nothing changes
+    this.cadence.start();
 
     this.logger.success('Monitor started successfully');
   }
@@ -74,14 +82,59 @@ export class ClientMonitor {
    * Stop monitoring
    */
   stop(): void {
-    if (this.monitorTimer) {
-      clearInterval(this.monitorTimer);
-      this.monitorTimer = undefined;
-    }
+    this.cadence.stop();
     this.isMonitoring = false;
     this.logger.info('Monitor stopped');
   }
 
+  /**
+   * A command was received or issued: sample fast while its effects show up
+   */
+  burst(): void {
+    this.cadence.burst();
+  }
+
+  /**
+   * Resolve with the League of Legends process count once a sample taken
+   * after this call reaches threshold, or with the last count after
+   * timeoutMs. A count cached from before a kill or relaunch never counts.
+   * Samples fast meanwhile (Windows only; the count is always 0 elsewhere).
+   */
+  waitForProcessCount(threshold: number, timeoutMs: number): Promise<number> {
+    return new Promise(resolve => {
+      const waiter: ProcessCountWaiter = {
+        threshold,
+        since: this.sampleSeq + 1,
+        resolve,
+        timer: setTimeout(() => this.release(waiter, this.lastProcessCount), timeoutMs)
+      };
+      this.waiters.push(waiter);
+      this.cadence.hold('process-count');
+    });
+  }
+
+  private release(waiter: ProcessCountWaiter, count: number): void {
+    clearTimeout(waiter.timer);
+    this.waiters = this.waiters.filter(other => other !== waiter);
+    if (this.waiters.length === 0) this.cadence.hold('process-count', false);
+    waiter.resolve(count);
+  }
+
+  /**
+   * One sample of everything monitored; true when any of it changed
+   */
+  private async sample(): Promise<boolean> {
+    await this.checkAndRestartClient();
+    await this.checkAndKillGame();
+    await this.checkLeagueProcessCount();
+    await this.checkVgcService(); // Check VGC service exit code
+
+    const state = `${this.clientCount}/${this.gameRunning}/${this.lastProcessCount}/${this.vgcRestartTriggered}`;
+    const changed = state !== this.lastState;
+    this.lastState = state;
+    return changed;
+  }
+
   /**
    * Check if client is running, restart if not
    */
@@ -91,6 +144,7 @@ export class ClientMonitor {
     // Check process count first - if already 1 or more, don't start new one
     const processPids = await ProcessUtils.getProcessPids(processName);
     const processCount = processPids.length;
+    this.clientCount = processCount;
     
     if (processCount >= 1) {
       // Already have LeagueClient running, don't start another one
@@ -118,9 +172,11 @@ export class ClientMonitor {
       }
       
       const success = await LeagueUtils.launchLeagueClient();
+      this.lastProcessCount = 0; // whatever was counted before the launch is gone
       
       if (success) {
         this.lastRestartTime = Date.now();
+        this.cadence.burst();
         this.logger.success('LeagueClient restarted successfully');
         
         // Wait for process to actually appear (up to 15 seconds)
@@ -147,6 +203,7 @@ export class ClientMonitor {
   private async checkAndKillGame(): Promise<void> {
     const gameProcessNames = LeagueUtils.getLeagueGameProcessNames();
     const isRunning = await ProcessUtils.isAnyProcessRunning(gameProcessNames);
+    this.gameRunning = isRunning;
 
     if (isRunning) {
       this.logger.warn('League of Legends game detected, killing immediately...');
@@ -154,6 +211,7 @@ export class ClientMonitor {
       const killedCount = await ProcessUtils.killProcessByMultipleNames(gameProcessNames);
       
       if (killedCount > 0) {
+        this.cadence.burst();
         this.logger.success(`Killed ${killedCount} game process(es)`);
       } else {
         this.logger.error('Failed to kill game process');
@@ -164,7 +222,6 @@ export class ClientMonitor {
   /**
    * Check League of Legends process count by description
    * If 8 or more processes found, trigger immediate start callback
-   * This runs every monitorInterval (default 5 seconds)
    */
   private async checkLeagueProcessCount(): Promise<void> {
     // Only check on Windows
@@ -173,9 +230,13 @@ export class ClientMonitor {
     }
 
     try {
+      const seq = ++this.sampleSeq;
       const processCount = await ProcessUtils.getProcessCountByDescription('League of Legends');
       
       // Always log process count for debugging (especially when >= 8)
+      this.waiters
+        .filter(waiter => seq >= waiter.since && processCount >= waiter.threshold)
+        .forEach(waiter => this.release(waiter, processCount));
       if (processCount !== this.lastProcessCount) {
         this.lastProcessCount = processCount;
       } else {
@@ -210,7 +271,6 @@ export class ClientMonitor {
   /**
    * Check VGC service exit code
    * If exit code is 185, wait for VGC process to close, then restart League Client and notify followers
-   * This runs every monitorInterval (default 5 seconds)
    */
   private async checkVgcService(): Promise<void> {
     // Only check on Windows
@@ -264,9 +324,11 @@ export class ClientMonitor {
           // Restart League Client
           this.logger.info('Restarting League Client due to VGC exit code 185...');
           const success = await LeagueUtils.launchLeagueClient();
+          this.lastProcessCount = 0; // the count before the kill and relaunch is stale
 
           if (success) {
             this.lastRestartTime = Date.now();
+            this.cadence.burst();
             this.logger.success('League Client restarted successfully due to VGC exit code 185');
 
             // Wait for process to appear
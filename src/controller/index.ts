@@ -1,12 +1,19 @@
 import { ClientMonitor } from './client-monitor.js';
 import { SessionClient } from './session-client.js';
+import { NetworkServer, DEFAULT_LAN_PORT } from './network-server.js';
 import { Logger } from '../shared/logger.js';
+import { resolveClientIpcPath } from '../shared/ipc-socket.js';
+import { tracer } from '../shared/tracing.js';
+import { selectRelay } from '../shared/relay-endpoints.js';
+import type { RelayEndpoint } from '../shared/relay-endpoints.js';
 import { getControllerConfig } from '../shared/config.js';
+import crypto from 'crypto';
 
 const logger = new Logger('Controller');
 
 // Load configuration from config.json
 const config = getControllerConfig();
+tracer.configure(config.tracing, 'controller');
 
 async function main() {
   logger.info('Starting League Client Controller (Mac) with Session Token...');
@@ -16,20 +23,43 @@ async function main() {
     logger.warn('This controller is designed for macOS. Functionality may be limited.');
   }
 
-  // Initialize session client (creates new session)
-  const sessionClient = new SessionClient(
-    config.relayServerHost,
-    config.relayServerPort,
-    'controller'
-  );
+  // Initialize session client (creates new session) on the nearest configured relay
+  const remoteOptions = (endpoint: RelayEndpoint) => ({
+    tls: { enabled: config.relayServerTls ?? false, caFile: config.relayServerCaFile },
+    ipcPath: resolveClientIpcPath(endpoint.host, config.relayIpc, config.relayIpcPath, config.relayServerTls),
+    multiplex: config.relayMultiplex
+  });
+  const { endpoint: relay, selector } = await selectRelay(config);
+  const sessionClient = new SessionClient(relay.host, relay.port, 'controller', remoteOptions(relay));
+  if (selector) {
+    sessionClient.useRelaySelector(selector, remoteOptions);
+    selector.start();
+  }
 
-  // Initialize client monitor
-  const monitor = new ClientMonitor(config.monitorInterval);
+  // LAN relay client, joined once the LAN relay is up (lanDirect only)
+  let lanClient: SessionClient | undefined;
+  let lanServer: NetworkServer | undefined;
+
+  // Commands go out on both paths under one ID; each follower is attached to
+  // exactly one of them, and one switching paths mid-command runs it only once
+  const broadcastImmediateStart = () => {
+    const commandId = sessionClient.broadcastImmediateStart();
+    lanClient?.broadcastImmediateStart(commandId);
+  };
+  const broadcastRestart = () => {
+    const commandId = sessionClient.broadcastRestart();
+    lanClient?.broadcastRestart(commandId);
+  };
+
+  // Initialize client monitor; a fixed monitorInterval from an older config keeps the fixed cadence
+  const monitor = new ClientMonitor(
+    config.sampling ?? (config.monitorInterval ? { fastMs: config.monitorInterval, maxMs: config.monitorInterval } : {})
+  );
 
   // Set callback to broadcast immediate start when 8+ processes detected
   monitor.setImmediateStartCallback(() => {
     logger.info('8+ League of Legends processes detected, sending immediate start command...');
-    sessionClient.broadcastImmediateStart();
+    broadcastImmediateStart();
   });
 
   // Set callback to broadcast restart when VGC exit code 185 detected
@@ -38,44 +68,28 @@ async function main() {
 
     // Wait for process count to reach 8 before notifying followers (Windows only)
     if (process.platform === 'win32') {
-      const { ProcessUtils } = await import('../shared/process-utils.js');
-
       const maxWaitTime = 120000; // 2 minutes max wait
-      const checkInterval = 5000; // Check every 5 seconds
-      const startTime = Date.now();
-      let processCount = 0;
-
-      while (Date.now() - startTime < maxWaitTime) {
-        try {
-          processCount = await ProcessUtils.getProcessCountByDescription('League of Legends');
-          logger.info(`VGC restart: Current process count: ${processCount} (waiting for >= 8)`);
-
-          if (processCount >= 8) {
-            logger.success(`VGC restart: Process count reached ${processCount} (>=8)! Notifying followers...`);
-            sessionClient.broadcastRestart();
-            return;
-          }
-        } catch (error) {
-          logger.warn(`VGC restart: Failed to check process count: ${error instanceof Error ? error.message : 'Unknown error'}`);
-        }
+      // The monitor samples fast while this waits
+      const processCount = await monitor.waitForProcessCount(8, maxWaitTime);
 
-        // Wait before next check
-        await new Promise(resolve => setTimeout(resolve, checkInterval));
+      if (processCount >= 8) {
+        logger.success(`VGC restart: Process count reached ${processCount} (>=8)! Notifying followers...`);
+      } else {
+        // Timeout reached, notify anyway
+        logger.warn(`VGC restart: Process count did not reach 8 within ${maxWaitTime / 1000} seconds. Current count: ${processCount}. Notifying followers anyway...`);
       }
-
-      // Timeout reached, notify anyway
-      logger.warn(`VGC restart: Process count did not reach 8 within ${maxWaitTime / 1000} seconds. Current count: ${processCount}. Notifying followers anyway...`);
-      sessionClient.broadcastRestart();
+      broadcastRestart();
     } else {
       // Non-Windows: notify immediately (can't check process count)
       logger.info('VGC exit code 185 detected, sending restart command to followers...');
-      sessionClient.broadcastRestart();
+      broadcastRestart();
     }
   });
 
-  // Set callback for game running restart request from follower
-  sessionClient.setGameRunningRestartRequestCallback(async () => {
+  // Game running restart request from a follower (via either relay)
+  const handleGameRunningRestartRequest = async () => {
     logger.info('Game running restart request received from follower! Restarting League Client...');
+    monitor.burst();
 
     const { ProcessUtils } = await import('../shared/process-utils.js');
     const { LeagueUtils } = await import('../shared/league-utils.js');
@@ -122,42 +136,27 @@ async function main() {
         logger.info('Waiting for process count to reach 8 before notifying followers...');
 
         const maxWaitTime = 120000; // 2 minutes max wait
-        const checkInterval = 5000; // Check every 5 seconds
-        const startTime = Date.now();
-        let processCount = 0;
-
-        while (Date.now() - startTime < maxWaitTime) {
-          try {
-            processCount = await ProcessUtils.getProcessCountByDescription('League of Legends');
-            logger.info(`Current process count: ${processCount} (waiting for >= 8)`);
-
-            if (processCount >= 8) {
-              logger.success(`Process count reached ${processCount} (>=8)! Notifying followers...`);
-              sessionClient.broadcastRestart();
-              return;
-            }
-          } catch (error) {
-            logger.warn(`Failed to check process count: ${error instanceof Error ? error.message : 'Unknown error'}`);
-          }
-
-          // Wait before next check
-          await new Promise(resolve => setTimeout(resolve, checkInterval));
-        }
+        const processCount = await monitor.waitForProcessCount(8, maxWaitTime);
 
-        // Timeout reached, notify anyway
-        logger.warn(`Process count did not reach 8 within ${maxWaitTime / 1000} seconds. Current count: ${processCount}. Notifying followers anyway...`);
-        sessionClient.broadcastRestart();
+        if (processCount >= 8) {
+          logger.success(`Process count reached ${processCount} (>=8)! Notifying followers...`);
+        } else {
+          // Timeout reached, notify anyway
+          logger.warn(`Process count did not reach 8 within ${maxWaitTime / 1000} seconds. Current count: ${processCount}. Notifying followers anyway...`);
+        }
+        broadcastRestart();
       } else {
         // Non-Windows: notify immediately (can't check process count)
         logger.info('Non-Windows platform, notifying followers immediately...');
-        sessionClient.broadcastRestart();
+        broadcastRestart();
       }
     } else {
       logger.error('Failed to restart League Client due to game running restart request');
     }
-  });
-  // Set callback for status requests
-  sessionClient.setStatusRequestCallback(async () => {
+  };
+
+  // Status requests from followers (via either relay)
+  const handleStatusRequest = async () => {
     const { ProcessUtils } = await import('../shared/process-utils.js');
     const { LeagueUtils } = await import('../shared/league-utils.js');
     const processName = LeagueUtils.getLeagueClientProcessName();
@@ -175,20 +174,50 @@ async function main() {
 
     logger.info(`Status check: LeagueClient is ${isRunning ? 'RUNNING' : 'NOT RUNNING'}, Process count: ${processCount}`);
     return { clientRunning: isRunning, processCount };
-  });
-
-  // Connect to relay server
-  await sessionClient.connect();
-
-  // Wait for session creation
-  await new Promise(resolve => setTimeout(resolve, 2000));
-
-  const token = sessionClient.getSessionToken();
-  if (token) {
+  };
+
+  sessionClient.setGameRunningRestartRequestCallback(handleGameRunningRestartRequest);
+  sessionClient.setStatusRequestCallback(handleStatusRequest);
+
+  // Every new remote session: show its token and move the LAN relay onto it,
+  // so a follower falling back from LAN to remote presents a token the remote knows
+  let remoteToken: string | undefined;
+  let firstJoin!: () => void;
+  const joined = new Promise<void>(resolve => { firstJoin = resolve; });
+  sessionClient.setJoinedCallback(token => {
+    firstJoin();
+    if (token === remoteToken) return;
+    remoteToken = token;
     logger.success('='.repeat(60));
     logger.success(`SESSION TOKEN: ${token}`);
     logger.success('Share this token with follower clients to connect');
     logger.success('='.repeat(60));
+
+    if (lanServer && lanClient) {
+      lanServer.setSessionToken(token);
+      lanClient.switchEndpoint('127.0.0.1', lanServer.address(), {}, token);
+    }
+  });
+
+  // Connect to relay server and give the session a moment to be created
+  await sessionClient.connect();
+  await Promise.race([joined, new Promise(resolve => setTimeout(resolve, 2000))]);
+
+  if (config.lanDirect) {
+    // Same token on both relays, so followers can use either. LAN-only while the
+    // remote relay is down: a local token until the remote session exists
+    const lanToken = remoteToken ?? crypto.randomBytes(16).toString('hex');
+    const lanPort = config.lanPort ?? DEFAULT_LAN_PORT;
+    lanServer = new NetworkServer(lanPort, lanToken, config.lanDiscoveryPort, undefined, config.lanSecret);
+    await lanServer.start();
+
+    lanClient = new SessionClient('127.0.0.1', lanServer.address(), 'controller');
+    lanClient.setGameRunningRestartRequestCallback(handleGameRunningRestartRequest);
+    lanClient.setStatusRequestCallback(handleStatusRequest);
+    // The remote session may have started while the LAN relay was coming up
+    const current = remoteToken ?? lanToken;
+    if (current !== lanToken) lanServer.setSessionToken(current);
+    await lanClient.connect(current);
   }
 
   // Start monitoring
@@ -199,6 +228,9 @@ async function main() {
     if (sessionClient.connected()) {
       sessionClient.sendHeartbeat();
     }
+    if (lanClient?.connected()) {
+      lanClient.sendHeartbeat();
+    }
   }, 30000);
 
   // Handle graceful shutdown
@@ -206,6 +238,8 @@ async function main() {
     logger.info('Received SIGINT, shutting down...');
     monitor.stop();
     sessionClient.disconnect();
+    lanClient?.disconnect();
+    lanServer?.close();
     process.exit(0);
   });
 
@@ -0,0 +1,118 @@
+import { metrics } from '../shared/metrics.js';
+
+export interface OutboxOptions {
+  maxCommands: number;  // queued commands before the oldest is dropped
+  maxInfo: number;      // queued status messages before the oldest is dropped
+  commandTtlMs: number; // a command older than this is not worth delivering late
+  infoTtlMs: number;
+}
+
+export const DEFAULT_OUTBOX_OPTIONS: OutboxOptions = {
+  maxCommands: 64,
+  maxInfo: 16,
+  commandTtlMs: 30_000,
+  infoTtlMs: 60_000
+};
+
+/**
+ * State messages: only the latest queued copy of each type is kept, the
+ * relay (and its followers) only care about the current status. Anything
+ * not listed is a command and is delivered in order.
+ */
+const STATE_TYPES: ReadonlySet<string> = new Set(['STATUS_UPDATE', 'STATUS_REQUEST', 'GAME_STATUS']);
+
+interface Pending {
+  type: string;
+  data: string;
+  queuedAt: number;
+  expiresAt: number;
+}
+
+const queuedCounter = metrics.counter('controller.outbox.queued');
+const coalescedCounter = metrics.counter('controller.outbox.coalesced');
+const expiredCounter = metrics.counter('controller.outbox.expired');
+const droppedCounter = metrics.counter('controller.outbox.dropped');
+const waitHistogram = metrics.histogram('controller.outbox.wait_ms');
+
+/**
+ * Messages a SessionClient could not send because it was not in a session
+ * (disconnected, reconnecting or waiting for JOINED). Drained right after
+ * the next JOINED, commands first; each message carries its own deadline
+ * and is dropped once it passes.
+ */
+export class Outbox {
+  private commands: Pending[] = [];
+  private state: Map<string, Pending> = new Map(); // type -> latest
+  private options: OutboxOptions;
+
+  constructor(options: Partial<OutboxOptions> = {}) {
+    this.options = { ...DEFAULT_OUTBOX_OPTIONS, ...options };
+  }
+
+  /**
+   * Queue a serialized message; ttlMs overrides the default for its kind
+   */
+  push(type: string, data: string, ttlMs?: number): void {
+    const now = Date.now();
+    queuedCounter.inc();
+
+    if (STATE_TYPES.has(type)) {
+      const previous = this.state.get(type);
+      if (previous) {
+        coalescedCounter.inc();
+        this.state.delete(type); // re-inserted below so map order stays oldest-first
+      } else if (this.state.size >= this.options.maxInfo) {
+        this.state.delete(this.state.keys().next().value!);
+        droppedCounter.inc();
+      }
+      this.state.set(type, { type, data, queuedAt: previous?.queuedAt ?? now, expiresAt: now + (ttlMs ?? this.options.infoTtlMs) });
+      return;
+    }
+
+    if (this.commands.length >= this.options.maxCommands) {
+      this.commands.shift();
+      droppedCounter.inc();
+    }
+    this.commands.push({ type, data, queuedAt: now, expiresAt: now + (ttlMs ?? this.options.commandTtlMs) });
+  }
+
+  /**
+   * Empty the outbox: the live messages, commands first, and the types of
+   * the ones that expired
+   */
+  drain(): { messages: string[]; expired: string[] } {
+    const now = Date.now();
+    const messages: string[] = [];
+    const expired: string[] = [];
+    const take = (pending: Pending) => {
+      if (pending.expiresAt <= now) {
+        expired.push(pending.type);
+        expiredCounter.inc();
+        return;
+      }
+      waitHistogram.record(now - pending.queuedAt);
+      messages.push(pending.data);
+    };
+    this.commands.forEach(take);
+    this.state.forEach(take);
+    this.clear();
+    return { messages, expired };
+  }
+
+  clear(): void {
+    this.commands = [];
+    this.state.clear();
+  }
+
+  get commandTtlMs(): number {
+    return this.options.commandTtlMs;
+  }
+
+  get hasCommands(): boolean {
+    return this.commands.length > 0;
+  }
+
+  get size(): number {
+    return this.commands.length + this.state.size;
+  }
+}
@@ -1,37 +1,204 @@
 import WebSocket from 'ws';
+import EventEmitter from 'events';
+import crypto from 'crypto';
+import { existsSync, readFileSync } from 'fs';
+import { dirname } from 'path';
 import { Logger } from '../shared/logger.js';
+import { tlsSessionCache } from '../shared/tls-session-cache.js';
+import { IpcSocket, isPrivateIpcPath } from '../shared/ipc-socket.js';
+import { ChannelSocket } from '../shared/channel-mux.js';
+import { SharedConnection } from './shared-connection.js';
+import { tracer } from '../shared/tracing.js';
+import { metrics } from '../shared/metrics.js';
+import { endpointKey } from '../shared/relay-endpoints.js';
+import { Outbox } from './outbox.js';
+import type { OutboxOptions } from './outbox.js';
+import type { RelayEndpoint, RelaySelector } from '../shared/relay-endpoints.js';
+
+export interface RelayTlsClientOptions {
+  enabled: boolean;
+  caFile?: string; // extra trusted CA, e.g. for a self-signed relay certificate
+}
+
+export interface SessionClientOptions {
+  tls?: RelayTlsClientOptions;
+  ipcPath?: string; // same-host relay socket, preferred over TCP when reachable
+  multiplex?: boolean; // share one socket per relay with the process's other SessionClients
+  outbox?: Partial<OutboxOptions>; // what is kept for delivery while not in a session
+}
+
+/**
+ * Result a follower reports when it finished a command
+ */
+export interface CommandOutcome {
+  ok: boolean;
+  detail?: string; // e.g. 'client launched', 'cooldown'
+}
+
+type CommandCallback = () => CommandOutcome | void | Promise<CommandOutcome | void>;
+
+/**
+ * Follower progress of a command this controller issued
+ */
+export interface CommandSummary {
+  type: string;
+  issuedAt: number;
+  followers: number;
+  received: number;
+  completed: number;
+  failed: number;
+}
+
+// Command IDs remembered for deduplication (follower) and progress (controller)
+const RECENT_COMMANDS = 256;
+
+const ackHistogram = metrics.histogram('controller.commands.ack_ms');
+const completeHistogram = metrics.histogram('controller.commands.complete_ms');
+
+// Tied to one connection: sent again by connect(), never worth queueing
+const CONNECTION_TYPES: ReadonlySet<string> = new Set(['JOIN', 'CREATE_SESSION', 'HEARTBEAT']);
+// Answers to a delivery on the current connection: the relay drops the delivery with the
+// connection, so one replayed after a reconnect (under a new client ID) matches nothing
+const DELIVERY_TYPES: ReadonlySet<string> = new Set(['COMMAND_ACK']);
+// Reconnect interval while a queued command is waiting for the relay
+const PENDING_RECONNECT_MS = 1000;
+
+// Common surface of a ws WebSocket and an IpcSocket
+interface RelayTransport extends EventEmitter {
+  readonly readyState: number;
+  send(data: string): void;
+  close(): void;
+}
 
 export class SessionClient {
-  private ws?: WebSocket;
+  private ws?: RelayTransport;
   private logger: Logger;
-  private serverUrl: string;
+  private serverUrl!: string;
   private sessionToken?: string;
   private role: 'controller' | 'follower';
   private reconnectInterval: number = 5000;
   private reconnectTimer?: NodeJS.Timeout;
   private onStatusRequest?: () => Promise<{ clientRunning: boolean; processCount: number }>;
-  private onImmediateStart?: () => void;
-  private onClientRestarted?: () => void; // Callback for CLIENT_RESTARTED message
+  private onImmediateStart?: CommandCallback;
+  private onClientRestarted?: CommandCallback; // Callback for CLIENT_RESTARTED message
   private onGameRunningRestartRequest?: () => void; // Callback for GAME_RUNNING_RESTART_REQUEST from follower
+  private onJoined?: (sessionToken: string) => void;
   private isConnected: boolean = false;
+  private joined: boolean = false; // JOINED received on the current connection
+  private stopped: boolean = false; // disconnect() was called: don't reconnect
+  private outbox: Outbox;
   private autoJoinRetryTimer?: NodeJS.Timeout;
   private autoJoinRetryInterval: number = 5000; // 5 seconds
-
-  constructor(serverHost: string, serverPort: number, role: 'controller' | 'follower') {
+  private wsOptions: WebSocket.ClientOptions = {};
+  private ipcPath?: string;
+  private skipIpcOnce: boolean = false;
+  private multiplex: boolean = false;
+  private shared?: SharedConnection;
+  private endpoint!: RelayEndpoint;
+  private selector?: RelaySelector;
+  private endpointOptions: (endpoint: RelayEndpoint) => SessionClientOptions = () => ({});
+  private lastFailover: number = 0;
+  private handledCommands: Map<string, CommandOutcome | undefined> = new Map(); // follower: commandId -> outcome once done
+  private issuedCommands: Map<string, CommandSummary> = new Map(); // controller: commandId -> progress
+  private unconfirmed: Map<string, { message: any; issuedAt: number; written: boolean }> = new Map(); // controller: commands the relay hasn't answered
+
+  constructor(serverHost: string, serverPort: number, role: 'controller' | 'follower', options: SessionClientOptions = {}) {
     this.logger = new Logger(`SessionClient-${role}`);
-    this.serverUrl = `ws://${serverHost}:${serverPort}`;
     this.role = role;
+    this.serverUrl = this.configureEndpoint(serverHost, serverPort, options);
+    this.outbox = new Outbox(options.outbox);
+  }
+
+  private configureEndpoint(serverHost: string, serverPort: number, options: SessionClientOptions): string {
+    const tls = options.tls;
+    this.endpoint = { host: serverHost, port: serverPort };
+    this.ipcPath = options.ipcPath;
+    this.multiplex = options.multiplex ?? false;
+    this.wsOptions = {};
+
+    if (tls?.enabled) {
+      // Reuse TLS sessions across reconnects (see TlsSessionCache)
+      this.wsOptions = {
+        createConnection: tlsSessionCache.connect as any,
+        ca: tls.caFile ? readFileSync(tls.caFile) : undefined
+      };
+    }
+
+    return `${tls?.enabled ? 'wss' : 'ws'}://${serverHost}:${serverPort}`;
+  }
+
+  /**
+   * Move to another relay (e.g. between the LAN relay and the remote one)
+   * and reconnect right away instead of waiting for the reconnect timer.
+   * sessionToken: the session to join there; undefined keeps the current
+   * one, null drops it (a follower then auto-joins by IP)
+   */
+  switchEndpoint(serverHost: string, serverPort: number, options: SessionClientOptions = {}, sessionToken?: string | null): void {
+    const url = this.configureEndpoint(serverHost, serverPort, options);
+    this.logger.info(`Switching relay: ${this.serverUrl} -> ${url}`);
+    this.serverUrl = url;
+    if (sessionToken !== undefined) this.sessionToken = sessionToken ?? undefined;
+
+    if (this.reconnectTimer) {
+      clearTimeout(this.reconnectTimer);
+      this.reconnectTimer = undefined;
+    }
+    if (this.ws) {
+      // Detach first so the old socket's close doesn't schedule a reconnect
+      const previous = this.ws;
+      previous.removeAllListeners();
+      previous.on('error', () => {});
+      previous.close();
+    }
+    this.isConnected = false;
+    this.joined = false;
+    this.connect(this.sessionToken);
+  }
+
+  /**
+   * Fail over between the selector's relays: after a disconnect move to the
+   * next best one instead of retrying the same relay, and follow the
+   * selector's switches to a faster relay. Only applies while connected to
+   * one of its relays (not e.g. a LAN relay).
+   */
+  useRelaySelector(selector: RelaySelector, optionsFor: (endpoint: RelayEndpoint) => SessionClientOptions): void {
+    this.selector = selector;
+    this.endpointOptions = optionsFor;
+    selector.on('switch', (endpoint: RelayEndpoint) => {
+      if (!selector.includes(this.endpoint)) return;
+      this.switchEndpoint(endpoint.host, endpoint.port, optionsFor(endpoint));
+    });
+  }
+
+  private failover(): void {
+    const selector = this.selector;
+    if (!selector || !selector.includes(this.endpoint)) return;
+    // At most one failover per reconnect interval, so two bad relays don't ping-pong
+    if (Date.now() - this.lastFailover < this.reconnectInterval) return;
+
+    this.lastFailover = Date.now();
+    const failed = endpointKey(this.endpoint);
+    selector.failover(this.endpoint).then(next => {
+      // Still waiting to reconnect to the failed relay? Go elsewhere now
+      if (next && !this.isConnected && endpointKey(this.endpoint) === failed) {
+        this.switchEndpoint(next.host, next.port, this.endpointOptions(next));
+      }
+    });
+  }
+
+  getServerUrl(): string {
+    return this.serverUrl;
   }
 
   setStatusRequestCallback(callback: () => Promise<{ clientRunning: boolean; processCount: number }>): void {
     this.onStatusRequest = callback;
   }
 
-  setImmediateStartCallback(callback: () => void): void {
+  setImmediateStartCallback(callback: CommandCallback): void {
     this.onImmediateStart = callback;
   }
 
-  setClientRestartedCallback(callback: () => void): void {
+  setClientRestartedCallback(callback: CommandCallback): void {
     this.onClientRestarted = callback;
   }
 
@@ -39,17 +206,48 @@ export class SessionClient {
     this.onGameRunningRestartRequest = callback;
   }
 
-  async connect(sessionToken?: string): Promise<void> {
-    this.logger.info(`Connecting to relay server at ${this.serverUrl}...`);
+  setJoinedCallback(callback: (sessionToken: string) => void): void {
+    this.onJoined = callback;
+  }
 
-    this.ws = new WebSocket(this.serverUrl);
+  /**
+   * The local socket sits where only this user (or root) could have created it
+   */
+  private ipcPathTrusted(): boolean {
+    if (isPrivateIpcPath(this.ipcPath!)) return true;
+    if (existsSync(dirname(this.ipcPath!))) this.logger.warn(`Not using ${this.ipcPath}: its directory is not private to this user`);
+    return false;
+  }
+
+  async connect(sessionToken?: string): Promise<void> {
+    this.stopped = false;
+    // Same-host relay: try the local socket first, TCP if it isn't there
+    const useIpc = !!this.ipcPath && !this.skipIpcOnce && this.ipcPathTrusted();
+    this.skipIpcOnce = false;
+    let opened = false;
+
+    if (this.multiplex) {
+      const target = useIpc ? this.ipcPath! : this.serverUrl;
+      this.logger.info(`Connecting to relay server at ${target} (shared connection)...`);
+      this.shared = SharedConnection.get(target, () => useIpc ? IpcSocket.connect(target) : new WebSocket(target, this.wsOptions));
+      this.ws = this.shared.open();
+    } else if (useIpc) {
+      this.logger.info(`Connecting to relay server at ${this.ipcPath} (local socket)...`);
+      this.ws = IpcSocket.connect(this.ipcPath!);
+    } else {
+      this.logger.info(`Connecting to relay server at ${this.serverUrl}...`);
+      this.ws = new WebSocket(this.serverUrl, this.wsOptions);
+    }
 
     this.ws.on('open', () => {
       this.logger.success('Connected to relay server');
       this.isConnected = true;
+      this.joined = false;
+      opened = true;
 
       if (this.reconnectTimer) {
         clearTimeout(this.reconnectTimer);
+        this.reconnectTimer = undefined;
       }
 
       // If token provided, join session
@@ -66,22 +264,44 @@ export class SessionClient {
       }
     });
 
-    this.ws.on('message', (data: Buffer) => {
+    this.ws.on('message', (data: Buffer | string) => {
+      let message: any;
       try {
-        const message = JSON.parse(data.toString());
-        this.handleMessage(message);
+        message = JSON.parse(data.toString());
       } catch (error) {
         this.logger.error('Failed to parse message', error as Error);
+        return;
+      }
+
+      // Continue the sender's trace when the message carries one
+      const span = message.trace ? tracer.root(`${this.role}.${message.type}`, message.trace) : undefined;
+      try {
+        this.handleMessage(message);
+      } catch (error) {
+        this.logger.error('Failed to handle message', error as Error);
+      } finally {
+        span?.end();
       }
     });
 
     this.ws.on('close', () => {
+      if (useIpc && !opened && !this.stopped) {
+        this.logger.info('Local relay socket unavailable, falling back to TCP');
+        this.skipIpcOnce = true;
+        this.connect(sessionToken);
+        return;
+      }
+
       this.logger.warn('Disconnected from relay server');
       this.isConnected = false;
+      this.joined = false;
+      if (this.stopped) return;
       this.scheduleReconnect();
+      this.failover();
     });
 
-    this.ws.on('error', (error) => {
+    this.ws.on('error', (error: Error) => {
+      if (useIpc && !opened) return; // handled by the fallback in 'close'
       this.logger.error('WebSocket error', error);
     });
   }
@@ -136,27 +356,35 @@ export class SessionClient {
           this.logger.info(`Controller: ${message.sessionInfo.hasController ? 'Yes' : 'No'}`);
           this.logger.info(`Followers: ${message.sessionInfo.followerCount}`);
         }
+        this.joined = true;
+        this.flushOutbox();
+        this.resendUnconfirmed();
+        if (this.onJoined) {
+          this.onJoined(message.sessionToken);
+        }
         break;
 
       case 'IMMEDIATE_START':
         this.logger.info('Received immediate start command from controller!');
-        if (this.onImmediateStart) {
-          this.onImmediateStart();
-        }
+        this.runCommand(message.commandId, this.onImmediateStart);
         break;
 
       case 'IMMEDIATE_START_BROADCASTED':
+        this.unconfirmed.delete(message.commandId);
         this.logger.success(`Immediate start command sent to ${message.sentTo} follower(s)`);
         break;
 
       case 'CLIENT_RESTARTED':
         this.logger.info('Received CLIENT_RESTARTED message from controller!');
-        if (this.onClientRestarted) {
-          this.onClientRestarted();
-        }
+        this.runCommand(message.commandId, this.onClientRestarted);
+        break;
+
+      case 'COMMAND_ACK':
+        this.recordAck(message);
         break;
 
       case 'RESTART_BROADCASTED':
+        this.unconfirmed.delete(message.commandId);
         this.logger.success(`Restart command sent to ${message.sentTo} follower(s)`);
         break;
 
@@ -227,60 +455,141 @@ export class SessionClient {
     }
   }
 
-  broadcastImmediateStart(): void {
-    if (!this.isConnected) {
-      this.logger.warn('Not connected, cannot broadcast immediate start');
-      return;
-    }
+  /**
+   * Returns the command ID; reusing one (e.g. for the same command on
+   * another relay) never makes a follower run it twice. Issued while not
+   * in a session, the command goes out right after the next JOINED.
+   */
+  broadcastImmediateStart(commandId: string = crypto.randomUUID()): string {
+    this.issue('IMMEDIATE_START', commandId);
+    return commandId;
+  }
 
-    this.send({
-      type: 'IMMEDIATE_START'
-    });
+  broadcastRestart(commandId: string = crypto.randomUUID()): string {
+    this.issue('RESTART', commandId);
+    return commandId;
   }
 
-  broadcastRestart(): void {
-    if (!this.isConnected) {
-      this.logger.warn('Not connected, cannot broadcast restart');
-      return;
+  /**
+   * Follower progress of an issued command, as acknowledged so far
+   */
+  commandSummary(commandId: string): CommandSummary | undefined {
+    return this.issuedCommands.get(commandId);
+  }
+
+  private issue(type: string, commandId: string): void {
+    if (!this.issuedCommands.has(commandId)) {
+      if (this.issuedCommands.size >= RECENT_COMMANDS) {
+        this.issuedCommands.delete(this.issuedCommands.keys().next().value!);
+      }
+      this.issuedCommands.set(commandId, { type, issuedAt: Date.now(), followers: 0, received: 0, completed: 0, failed: 0 });
     }
+    const span = tracer.root(`${this.role}.${type}`);
+    const message = { type, commandId, trace: tracer.context() };
+    if (this.unconfirmed.size >= RECENT_COMMANDS) {
+      this.unconfirmed.delete(this.unconfirmed.keys().next().value!);
+    }
+    this.unconfirmed.set(commandId, { message, issuedAt: Date.now(), written: this.send(message) });
+    span.end();
+  }
 
-    this.send({
-      type: 'RESTART'
+  /**
+   * After a rejoin (e.g. on the standby that took over from a relay that
+   * died), send again the commands written to the previous connection
+   * that the relay never confirmed. The relay knows the ones it did
+   * receive by ID and does not issue them twice.
+   */
+  private resendUnconfirmed(): void {
+    const cutoff = Date.now() - this.outbox.commandTtlMs;
+    const resend: any[] = [];
+    this.unconfirmed.forEach((entry, commandId) => {
+      if (entry.issuedAt < cutoff) {
+        this.unconfirmed.delete(commandId);
+        return;
+      }
+      if (entry.written) resend.push(entry.message);
+      entry.written = true; // the queued ones just went out with the outbox
     });
+    if (resend.length === 0) return;
+    this.logger.info(`Re-sending ${resend.length} command(s) the relay did not confirm`);
+    resend.forEach(message => this.ws!.send(JSON.stringify(message)));
   }
 
-  sendStatus(clientRunning: boolean, processCount: number = 0): void {
-    if (!this.isConnected) {
-      this.logger.warn('Not connected, cannot send status');
+  private recordAck(message: any): void {
+    const summary = this.issuedCommands.get(message.commandId);
+    if (!summary) return;
+
+    const latencyMs = Date.now() - summary.issuedAt;
+    summary.followers = message.followers;
+    summary.received = message.received;
+    summary.completed = message.completed;
+    summary.failed = message.failed;
+
+    if (message.stage === 'received') {
+      ackHistogram.record(latencyMs);
       return;
     }
 
-    this.send({
-      type: 'STATUS_UPDATE',
-      status: { clientRunning, processCount }
-    });
+    completeHistogram.record(latencyMs);
+    const detail = message.detail ? ` (${message.detail})` : '';
+    if (message.ok) this.logger.info(`Follower ${message.followerId} completed ${summary.type} in ${latencyMs}ms${detail}`);
+    else this.logger.warn(`Follower ${message.followerId} failed ${summary.type} after ${latencyMs}ms${detail}`);
+    if (summary.completed + summary.failed >= summary.followers) {
+      this.logger.success(`${summary.type} done: ${summary.completed}/${summary.followers} follower(s) succeeded in ${latencyMs}ms`);
+    }
   }
 
-  requestStatus(): void {
-    if (!this.isConnected) {
-      this.logger.warn('Not connected, cannot request status');
+  /**
+   * Ack receipt, run the handler once per command ID and ack its outcome.
+   * A redelivered command is only re-acknowledged.
+   */
+  private runCommand(commandId: string | undefined, callback?: CommandCallback): void {
+    if (!commandId) {
+      callback?.();
       return;
     }
 
-    this.send({
-      type: 'STATUS_REQUEST'
-    });
+    this.ackCommand(commandId, 'received');
+    if (this.handledCommands.has(commandId)) {
+      this.logger.info(`Command ${commandId} already handled, not running it again`);
+      const outcome = this.handledCommands.get(commandId);
+      if (outcome) this.ackCommand(commandId, 'completed', outcome);
+      return;
+    }
+
+    if (this.handledCommands.size >= RECENT_COMMANDS) {
+      this.handledCommands.delete(this.handledCommands.keys().next().value!);
+    }
+    this.handledCommands.set(commandId, undefined);
+
+    Promise.resolve()
+      .then(() => callback?.())
+      .then(
+        outcome => outcome ?? { ok: true },
+        error => ({ ok: false, detail: (error as Error).message })
+      )
+      .then(outcome => {
+        if (this.handledCommands.has(commandId)) this.handledCommands.set(commandId, outcome);
+        this.ackCommand(commandId, 'completed', outcome);
+      });
+  }
+
+  private ackCommand(commandId: string, stage: 'received' | 'completed', outcome?: CommandOutcome): void {
+    this.send({ type: 'COMMAND_ACK', commandId, stage, ok: outcome?.ok, detail: outcome?.detail });
+  }
+
+  sendStatus(clientRunning: boolean, processCount: number = 0): void {
+    this.sendTraced('STATUS_UPDATE', { status: { clientRunning, processCount } });
+  }
+
+  requestStatus(): void {
+    this.sendTraced('STATUS_REQUEST');
   }
 
   /**
    * Request restart from controller (follower sends this when game is running)
    */
   requestRestartFromController(): void {
-    if (!this.isConnected) {
-      this.logger.warn('Not connected, cannot request restart');
-      return;
-    }
-
     if (this.role !== 'follower') {
       this.logger.warn('Only followers can request restart from controller');
       return;
@@ -291,13 +600,64 @@ export class SessionClient {
     });
   }
 
-  private send(data: any): void {
-    if (this.ws && this.ws.readyState === WebSocket.OPEN) {
-      this.ws.send(JSON.stringify(data));
+  /**
+   * Send a command as the root of a trace (when sampled), so relay and
+   * receiver spans join the same timeline
+   */
+  private sendTraced(type: string, fields: Record<string, any> = {}): void {
+    const span = tracer.root(`${this.role}.${type}`);
+    this.send({ type, ...fields, trace: tracer.context() });
+    span.end();
+  }
+
+  /**
+   * Send now when in a session; otherwise keep the message in the outbox
+   * until the next JOINED (see Outbox). True when it was written now.
+   */
+  private send(data: any): boolean {
+    const open = !!this.ws && this.ws.readyState === WebSocket.OPEN;
+    if (CONNECTION_TYPES.has(data.type)) {
+      if (open) this.ws!.send(JSON.stringify(data));
+      return open;
     }
+    if (open && this.joined) {
+      this.ws!.send(JSON.stringify(data));
+      return true;
+    }
+    if (DELIVERY_TYPES.has(data.type)) {
+      this.logger.info(`Not in a session, dropping ${data.type} for ${data.commandId} (its delivery went with the connection)`);
+      return false;
+    }
+
+    this.outbox.push(data.type, JSON.stringify(data));
+    if (data.type === 'STATUS_UPDATE' || data.type === 'STATUS_REQUEST') return false; // routine, coalesced
+    this.logger.warn(`Not in a session, ${data.type} queued until the relay is back (${this.outbox.size} pending)`);
+    this.reconnectNow();
+    return false;
+  }
+
+  private flushOutbox(): void {
+    if (this.outbox.size === 0) return;
+    const { messages, expired } = this.outbox.drain();
+    if (expired.length > 0) this.logger.warn(`Dropped ${expired.length} queued message(s) past their deadline: ${expired.join(', ')}`);
+    if (messages.length > 0) this.logger.info(`Sending ${messages.length} message(s) queued while disconnected`);
+    for (const data of messages) this.ws!.send(data);
+  }
+
+  // A command is waiting to be delivered: retry now instead of at the end of the reconnect interval
+  private reconnectNow(): void {
+    if (!this.reconnectTimer) return;
+    clearTimeout(this.reconnectTimer);
+    this.reconnectTimer = undefined;
+    this.logger.info('Reconnecting now to deliver queued messages...');
+    this.connect(this.sessionToken);
   }
 
   sendHeartbeat(): void {
+    if (this.ws instanceof ChannelSocket) {
+      this.shared!.heartbeat();
+      return;
+    }
     this.send({ type: 'HEARTBEAT' });
   }
 
@@ -307,9 +667,10 @@ export class SessionClient {
     }
 
     this.reconnectTimer = setTimeout(() => {
+      this.reconnectTimer = undefined;
       this.logger.info('Attempting to reconnect...');
       this.connect(this.sessionToken);
-    }, this.reconnectInterval);
+    }, this.outbox.hasCommands ? PENDING_RECONNECT_MS : this.reconnectInterval);
   }
 
   private scheduleAutoJoinRetry(): void {
@@ -334,8 +695,14 @@ export class SessionClient {
   }
 
   disconnect(): void {
+    this.stopped = true;
     if (this.reconnectTimer) {
       clearTimeout(this.reconnectTimer);
+      this.reconnectTimer = undefined;
+    }
+    if (this.outbox.size > 0) {
+      this.logger.warn(`Discarding ${this.outbox.size} queued message(s)`);
+      this.outbox.clear();
     }
     if (this.autoJoinRetryTimer) {
       clearInterval(this.autoJoinRetryTimer);
@@ -0,0 +1,60 @@
+import { ChannelMux } from '../shared/channel-mux.js';
+import type { ChannelSocket, MuxParent } from '../shared/channel-mux.js';
+
+const OPEN = 1;
+const HEARTBEAT_INTERVAL = 10000;
+
+/**
+ * One relay socket per process and relay, carrying a channel for each
+ * SessionClient that has multiplexing enabled (e.g. a controller and a
+ * follower in the same process). The relay treats every channel as a
+ * client of its own; the socket closes when its last channel does.
+ */
+export class SharedConnection {
+  private static connections: Map<string, SharedConnection> = new Map();
+  private mux: ChannelMux;
+  private lastHeartbeat: number = 0;
+
+  /**
+   * The live connection for key (relay URL or local socket path), or a new
+   * one from connect()
+   */
+  static get(key: string, connect: () => MuxParent): SharedConnection {
+    let connection = SharedConnection.connections.get(key);
+    if (!connection || connection.socket.readyState > OPEN) {
+      connection = new SharedConnection(key, connect());
+      SharedConnection.connections.set(key, connection);
+    }
+    return connection;
+  }
+
+  private constructor(private key: string, private socket: MuxParent) {
+    this.mux = new ChannelMux(socket, false);
+    // Frames without a channel (CONNECTED, HEARTBEAT_ACK) are for the socket itself
+    socket.on('message', (data: Buffer | string) => this.mux.route(data.toString()));
+    socket.on('close', () => this.forget());
+    this.mux.on('removed', () => {
+      if (this.mux.size > 0) return;
+      this.forget();
+      socket.close();
+    });
+  }
+
+  open(): ChannelSocket {
+    return this.mux.open();
+  }
+
+  /**
+   * Keepalive for every channel: the relay refreshes all of them on one
+   * HEARTBEAT, so repeats from other channels within 10s are skipped
+   */
+  heartbeat(): void {
+    if (this.socket.readyState !== OPEN || Date.now() - this.lastHeartbeat < HEARTBEAT_INTERVAL) return;
+    this.lastHeartbeat = Date.now();
+    this.socket.send(JSON.stringify({ type: 'HEARTBEAT' }));
+  }
+
+  private forget(): void {
+    if (SharedConnection.connections.get(this.key) === this) SharedConnection.connections.delete(this.key);
+  }
+}
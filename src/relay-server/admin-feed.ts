@@ -0,0 +1,261 @@
+import { tracer } from '../shared/tracing.js';
+import type { OutboundQueue } from './outbound-queue.js';
+import type { TopDimension, TopReport } from './traffic-stats.js';
+import type { FleetSummary } from './fleet-stats.js';
+
+/**
+ * Event classes an admin can subscribe to:
+ *  - sessions: SESSIONS_UPDATE on create/join/leave/remove
+ *  - activity: ACTIVITY log lines
+ *  - commands: COMMAND_UPDATE acks of follower commands
+ *  - traffic:  TRAFFIC_COUNTS, per-interval counts of heartbeats, status
+ *              pushes/requests and game-status forwards
+ *  - fleet:    FLEET_SUMMARY, fleet-wide totals, once per interval when
+ *              they changed
+ *  - hotspots: TRAFFIC_TOP, per-interval busiest clients and sessions by
+ *              bytes, messages and handling time (only when asked for)
+ */
+export type AdminEventClass = 'sessions' | 'activity' | 'commands' | 'traffic' | 'fleet' | 'hotspots';
+export type ActivityLevel = 'debug' | 'info' | 'warn' | 'error';
+export type TrafficKind = 'heartbeat' | 'status' | 'status_request' | 'game_status';
+
+const EVENT_CLASSES: ReadonlySet<string> = new Set(['sessions', 'activity', 'commands', 'traffic', 'fleet', 'hotspots']);
+// What a filter without events gets; hotspots walk every client, so they are opt-in
+const DEFAULT_EVENTS: AdminEventClass[] = ['sessions', 'activity', 'commands', 'traffic', 'fleet'];
+const LEVELS: Record<ActivityLevel, number> = { debug: 0, info: 1, warn: 2, error: 3 };
+
+/**
+ * ADMIN_SUBSCRIBE filter; omitted fields match everything
+ */
+export interface AdminFilter {
+  sessions?: string[];
+  events?: AdminEventClass[];
+  minLevel?: ActivityLevel;
+}
+
+interface Subscriber {
+  outbound: OutboundQueue;
+  sessions?: Set<string>;
+  events: Set<string>;
+  minLevel: number;
+}
+
+type SessionSummary = { token: string } & Record<string, any>;
+
+/**
+ * Source of session snapshots for SESSIONS_UPDATE (the SessionManager)
+ */
+export interface SessionDirectory {
+  getAllSessions(): SessionSummary[];
+  getSessionSummary(token: string): SessionSummary | null;
+  getFleetSummary(): FleetSummary;
+  readonly fleetVersion: number;
+}
+
+/**
+ * Source of TRAFFIC_TOP reports (the relay's TrafficStats)
+ */
+export interface HotspotSource {
+  hotspots(n: number, sessions?: ReadonlySet<string>): Record<TopDimension, TopReport>;
+}
+
+export const DEFAULT_TRAFFIC_INTERVAL_MS = 5000;
+const HOTSPOT_COUNT = 10;
+
+/**
+ * Admin subscriptions scoped by session, event class and activity level.
+ * Subscribers are indexed by session, so an event for one session only
+ * touches the admins watching it (plus unscoped ones), and messages are
+ * only built when someone will receive them. High-frequency traffic is
+ * counted and flushed once per interval instead of sent per event.
+ */
+export class AdminFeed {
+  private subscribers: Map<object, Subscriber> = new Map();   // socket -> subscriber
+  private unscoped: Set<Subscriber> = new Set();              // no session filter
+  private bySession: Map<string, Set<Subscriber>> = new Map(); // token -> scoped subscribers
+  private traffic: Map<string, Record<string, number>> = new Map(); // token -> counts this interval
+  private timer: NodeJS.Timeout;
+  private fleetSent: number = -1; // fleetVersion of the last FLEET_SUMMARY
+
+  constructor(private directory: SessionDirectory, intervalMs: number = DEFAULT_TRAFFIC_INTERVAL_MS, private hotspotSource?: HotspotSource) {
+    this.timer = setInterval(() => {
+      this.flushTraffic(intervalMs);
+      this.flushFleet();
+      this.flushHotspots();
+    }, intervalMs);
+    this.timer.unref();
+  }
+
+  get size(): number {
+    return this.subscribers.size;
+  }
+
+  /**
+   * Add or re-scope a subscriber and send it the sessions it can see
+   */
+  subscribe(socket: object, outbound: OutboundQueue, filter: AdminFilter = {}): void {
+    this.unsubscribe(socket);
+
+    const subscriber: Subscriber = {
+      outbound,
+      sessions: filter.sessions ? new Set(filter.sessions) : undefined,
+      events: new Set((filter.events ?? DEFAULT_EVENTS).filter(event => EVENT_CLASSES.has(event))),
+      minLevel: LEVELS[filter.minLevel ?? 'debug'] ?? 0
+    };
+    this.subscribers.set(socket, subscriber);
+    if (!subscriber.sessions) {
+      this.unscoped.add(subscriber);
+    } else {
+      subscriber.sessions.forEach(token => {
+        if (!this.bySession.has(token)) this.bySession.set(token, new Set());
+        this.bySession.get(token)!.add(subscriber);
+      });
+    }
+
+    if (subscriber.events.has('sessions')) {
+      const sessions = subscriber.sessions
+        ? [...subscriber.sessions].map(token => this.directory.getSessionSummary(token)).filter(Boolean)
+        : this.directory.getAllSessions();
+      outbound.send({ type: 'SESSIONS_UPDATE', timestamp: Date.now(), payload: { sessions } });
+    }
+    if (subscriber.events.has('fleet')) {
+      outbound.send({ type: 'FLEET_SUMMARY', timestamp: Date.now(), payload: this.directory.getFleetSummary() });
+    }
+  }
+
+  unsubscribe(socket: object): void {
+    const subscriber = this.subscribers.get(socket);
+    if (!subscriber) return;
+    this.subscribers.delete(socket);
+    this.unscoped.delete(subscriber);
+    subscriber.sessions?.forEach(token => {
+      const scoped = this.bySession.get(token);
+      scoped?.delete(subscriber);
+      if (scoped?.size === 0) this.bySession.delete(token);
+    });
+  }
+
+  /**
+   * A session was created, changed or removed. Unscoped admins get the full
+   * list (built once); scoped admins only the session they watch.
+   */
+  sessionChanged(token: string, event: string, data: any): void {
+    const unscoped = this.matching(this.unscoped, 'sessions');
+    const scoped = this.matching(this.bySession.get(token), 'sessions');
+
+    if (unscoped.length > 0) {
+      this.send(unscoped, 'SESSIONS_UPDATE', { sessions: this.directory.getAllSessions(), event, data });
+    }
+    if (scoped.length > 0) {
+      // A delta per session: coalesced per token, so a backlog keeps the latest of each session
+      const summary = this.directory.getSessionSummary(token);
+      this.send(scoped, 'SESSIONS_UPDATE', { sessions: summary ? [summary] : [], event, data }, token);
+    }
+  }
+
+  /**
+   * An ACTIVITY line; token-less lines only reach unscoped admins
+   */
+  activity(token: string | undefined, level: ActivityLevel, payload: any): void {
+    const rank = LEVELS[level] ?? LEVELS.info;
+    const recipients = this.recipients(token, 'activity').filter(subscriber => subscriber.minLevel <= rank);
+    if (recipients.length > 0) this.send(recipients, 'ACTIVITY', payload);
+  }
+
+  /**
+   * A COMMAND_UPDATE for a session
+   */
+  command(token: string, payload: any): void {
+    const recipients = this.recipients(token, 'commands');
+    if (recipients.length > 0) this.send(recipients, 'COMMAND_UPDATE', payload);
+  }
+
+  /**
+   * Count one high-frequency event; free unless someone watches its session
+   */
+  count(token: string, kind: TrafficKind): void {
+    if (!this.watched(token, 'traffic')) return;
+    let counts = this.traffic.get(token);
+    if (!counts) {
+      counts = {};
+      this.traffic.set(token, counts);
+    }
+    counts[kind] = (counts[kind] ?? 0) + 1;
+  }
+
+  dispose(): void {
+    clearInterval(this.timer);
+  }
+
+  private flushTraffic(intervalMs: number): void {
+    if (this.traffic.size === 0) return;
+    const traffic = this.traffic;
+    this.traffic = new Map();
+
+    const unscoped = this.matching(this.unscoped, 'traffic');
+    if (unscoped.length > 0) {
+      this.send(unscoped, 'TRAFFIC_COUNTS', { intervalMs, sessions: Object.fromEntries(traffic) });
+    }
+    this.subscribers.forEach(subscriber => {
+      if (!subscriber.sessions || !subscriber.events.has('traffic')) return;
+      const sessions: Record<string, Record<string, number>> = {};
+      subscriber.sessions.forEach(token => {
+        const counts = traffic.get(token);
+        if (counts) sessions[token] = counts;
+      });
+      if (Object.keys(sessions).length > 0) this.send([subscriber], 'TRAFFIC_COUNTS', { intervalMs, sessions });
+    });
+  }
+
+  // Fleet totals are global, so scoped admins get the same summary
+  private flushFleet(): void {
+    if (this.directory.fleetVersion === this.fleetSent) return;
+    const recipients: Subscriber[] = [];
+    this.subscribers.forEach(subscriber => {
+      if (subscriber.events.has('fleet')) recipients.push(subscriber);
+    });
+    if (recipients.length === 0) return;
+    this.fleetSent = this.directory.fleetVersion;
+    this.send(recipients, 'FLEET_SUMMARY', this.directory.getFleetSummary());
+  }
+
+  // One report for all unscoped admins; scoped admins only see their sessions' clients
+  private flushHotspots(): void {
+    if (!this.hotspotSource) return;
+    const unscoped = this.matching(this.unscoped, 'hotspots');
+    if (unscoped.length > 0) this.send(unscoped, 'TRAFFIC_TOP', this.hotspotSource.hotspots(HOTSPOT_COUNT));
+    this.subscribers.forEach(subscriber => {
+      if (!subscriber.sessions || !subscriber.events.has('hotspots')) return;
+      this.send([subscriber], 'TRAFFIC_TOP', this.hotspotSource!.hotspots(HOTSPOT_COUNT, subscriber.sessions));
+    });
+  }
+
+  private watched(token: string, event: AdminEventClass): boolean {
+    for (const subscriber of this.unscoped) if (subscriber.events.has(event)) return true;
+    const scoped = this.bySession.get(token);
+    if (scoped) for (const subscriber of scoped) if (subscriber.events.has(event)) return true;
+    return false;
+  }
+
+  private recipients(token: string | undefined, event: AdminEventClass): Subscriber[] {
+    const recipients = this.matching(this.unscoped, event);
+    if (token) recipients.push(...this.matching(this.bySession.get(token), event));
+    return recipients;
+  }
+
+  private matching(subscribers: Set<Subscriber> | undefined, event: AdminEventClass): Subscriber[] {
+    const matching: Subscriber[] = [];
+    subscribers?.forEach(subscriber => {
+      if (subscriber.events.has(event)) matching.push(subscriber);
+    });
+    return matching;
+  }
+
+  // Serialize once for all recipients; admin queues coalesce SESSIONS_UPDATE (per coalesceKey) if they fall behind
+  private send(recipients: Subscriber[], type: string, payload: any, coalesceKey?: string): void {
+    const span = tracer.span('admin.broadcast').arg('admins', recipients.length);
+    const data = JSON.stringify({ type, timestamp: Date.now(), payload });
+    recipients.forEach(subscriber => subscriber.outbound.enqueue(type, data, coalesceKey));
+    span.end();
+  }
+}
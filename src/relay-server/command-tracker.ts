@@ -0,0 +1,269 @@
+import { Logger } from '../shared/logger.js';
+import { metrics } from '../shared/metrics.js';
+import type { OutboundQueue } from './outbound-queue.js';
+
+const logger = new Logger('CommandTracker');
+
+export type AckStage = 'received' | 'completed';
+
+export interface CommandRetryOptions {
+  initialDelayMs: number;  // first redelivery when no 'received' ack arrived (doubles each time)
+  maxAttempts: number;     // deliveries per follower, including the first
+  maxCommands: number;     // command IDs remembered for deduplication (relay-wide; finished ones are evicted first)
+}
+
+export const DEFAULT_RETRY_OPTIONS: CommandRetryOptions = {
+  initialDelayMs: 1000,
+  maxAttempts: 5,
+  maxCommands: 65536
+};
+
+/**
+ * Commands whose deliveries are tracked (sent to followers)
+ */
+export const TRACKED_COMMANDS: ReadonlySet<string> = new Set(['CLIENT_RESTARTED', 'IMMEDIATE_START']);
+
+interface Delivery {
+  followerId: string;
+  outbound: OutboundQueue;
+  data: string;
+  attempts: number;
+  timer?: NodeJS.Timeout;
+  receivedAt?: number;
+}
+
+interface CommandRecord {
+  commandId: string;
+  sessionToken: string;
+  type: string;
+  issuedAt: number;
+  deliveries: Map<string, Delivery>; // followerId ->
+  pending: number;                   // followers that have not completed it (nor left)
+  received: number;
+  completed: number;
+  failed: number;
+}
+
+export interface AckResult {
+  commandId: string;
+  commandType: string;
+  followerId: string;
+  stage: AckStage;
+  latencyMs: number;   // since the relay issued the command
+  received: number;
+  completed: number;
+  failed: number;
+  followers: number;
+}
+
+function commandKey(sessionToken: string, commandId: string): string {
+  return `${sessionToken}:${commandId}`;
+}
+
+const issuedCounter = metrics.counter('relay.commands.issued');
+const duplicateCounter = metrics.counter('relay.commands.duplicates');
+const retryCounter = metrics.counter('relay.commands.retries');
+const expiredCounter = metrics.counter('relay.commands.expired');
+const evictedPendingCounter = metrics.counter('relay.commands.evicted_pending');
+const ackHistogram = metrics.histogram('relay.commands.ack_ms');
+const completeHistogram = metrics.histogram('relay.commands.complete_ms');
+
+/**
+ * Per-follower delivery state of recent commands. A delivery is resent
+ * with exponential backoff until the follower acks receipt; completion
+ * acks are counted separately. Command IDs are remembered so a repeated
+ * command is never delivered twice; at maxCommands the oldest finished
+ * command is forgotten, and only if none is finished the oldest pending
+ * one (its redeliveries stop).
+ */
+export class CommandTracker {
+  private commands: Map<string, CommandRecord> = new Map(); // "token:commandId" -> record, oldest first
+  private finished: Set<string> = new Set();                // keys of commands no follower is pending on, oldest first
+  private byFollower: Map<string, Set<string>> = new Map(); // followerId -> keys of pending commands
+  private options: CommandRetryOptions;
+
+  constructor(options: Partial<CommandRetryOptions> = {}) {
+    this.options = { ...DEFAULT_RETRY_OPTIONS, ...options };
+  }
+
+  /**
+   * Start tracking a command; false if this session already issued it
+   */
+  begin(sessionToken: string, commandId: string, type: string): boolean {
+    const key = commandKey(sessionToken, commandId);
+    if (this.commands.has(key)) {
+      duplicateCounter.inc();
+      return false;
+    }
+
+    if (this.commands.size >= this.options.maxCommands) {
+      const evicted = this.finished.values().next().value ?? this.commands.keys().next().value!;
+      if (!this.finished.has(evicted)) {
+        evictedPendingCounter.inc();
+        logger.warn(`${this.options.maxCommands} commands still pending: forgetting ${evicted} and its redeliveries`);
+      }
+      this.forget(evicted);
+    }
+    this.commands.set(key, {
+      commandId,
+      sessionToken,
+      type,
+      issuedAt: Date.now(),
+      deliveries: new Map(),
+      pending: 0,
+      received: 0,
+      completed: 0,
+      failed: 0
+    });
+    this.finished.add(key); // until delivered to someone
+    issuedCounter.inc();
+    return true;
+  }
+
+  has(sessionToken: string, commandId: string): boolean {
+    return this.commands.has(commandKey(sessionToken, commandId));
+  }
+
+  /**
+   * Commands some follower has not finished yet, with what was delivered
+   */
+  pending(): Array<{ token: string; commandId: string; type: string; data: string; followers: number }> {
+    const pending: Array<{ token: string; commandId: string; type: string; data: string; followers: number }> = [];
+    this.commands.forEach((command, key) => {
+      const delivery = [...command.deliveries.values()].find(d => this.byFollower.get(d.followerId)?.has(key));
+      if (delivery) pending.push({ token: command.sessionToken, commandId: command.commandId, type: command.type, data: delivery.data, followers: command.deliveries.size });
+    });
+    return pending;
+  }
+
+  /**
+   * Followers the command went to (for a repeated command)
+   */
+  followerCount(sessionToken: string, commandId: string): number {
+    return this.commands.get(commandKey(sessionToken, commandId))?.deliveries.size ?? 0;
+  }
+
+  /**
+   * Send a command to one follower and redeliver until it acks receipt
+   */
+  deliver(sessionToken: string, commandId: string, followerId: string, outbound: OutboundQueue, data: string): void {
+    const key = commandKey(sessionToken, commandId);
+    const command = this.commands.get(key);
+    if (!command) return;
+
+    const delivery: Delivery = { followerId, outbound, data, attempts: 0 };
+    command.deliveries.set(followerId, delivery);
+    if (!this.byFollower.has(followerId)) this.byFollower.set(followerId, new Set());
+    const pending = this.byFollower.get(followerId)!;
+    if (!pending.has(key)) {
+      pending.add(key);
+      command.pending++;
+      this.finished.delete(key);
+    }
+    this.send(command, delivery);
+  }
+
+  private send(command: CommandRecord, delivery: Delivery): void {
+    delivery.attempts++;
+    if (delivery.attempts > 1) retryCounter.inc();
+    delivery.outbound.enqueue(command.type, delivery.data);
+
+    if (delivery.attempts >= this.options.maxAttempts) {
+      delivery.timer = setTimeout(() => {
+        delivery.timer = undefined;
+        if (delivery.receivedAt) return;
+        expiredCounter.inc();
+        logger.warn(`${command.type} ${command.commandId} not acknowledged by follower ${delivery.followerId} after ${delivery.attempts} attempts`);
+      }, this.backoff(delivery.attempts));
+    } else {
+      delivery.timer = setTimeout(() => {
+        delivery.timer = undefined;
+        if (!delivery.receivedAt) this.send(command, delivery);
+      }, this.backoff(delivery.attempts));
+    }
+    delivery.timer.unref();
+  }
+
+  private backoff(attempt: number): number {
+    return this.options.initialDelayMs * 2 ** (attempt - 1);
+  }
+
+  /**
+   * Record a follower's ack; undefined if the command or delivery is
+   * unknown or the stage was already acknowledged (e.g. a re-ack of a
+   * duplicate)
+   */
+  ack(sessionToken: string, followerId: string, commandId: string, stage: AckStage, ok: boolean = true): AckResult | undefined {
+    const key = commandKey(sessionToken, commandId);
+    const command = this.commands.get(key);
+    const delivery = command?.deliveries.get(followerId);
+    if (!command || !delivery) return undefined;
+
+    const latencyMs = Date.now() - command.issuedAt;
+    if (stage === 'received') {
+      if (delivery.receivedAt) return undefined;
+      delivery.receivedAt = Date.now();
+      command.received++;
+      ackHistogram.record(latencyMs);
+    } else {
+      if (!this.byFollower.get(followerId)?.has(key)) return undefined;
+      // Completion implies receipt
+      if (!delivery.receivedAt) {
+        delivery.receivedAt = Date.now();
+        command.received++;
+      }
+      if (ok) command.completed++;
+      else command.failed++;
+      completeHistogram.record(latencyMs);
+      this.release(followerId, key);
+    }
+    if (delivery.timer) clearTimeout(delivery.timer);
+    delivery.timer = undefined;
+
+    return {
+      commandId,
+      commandType: command.type,
+      followerId,
+      stage,
+      latencyMs,
+      received: command.received,
+      completed: command.completed,
+      failed: command.failed,
+      followers: command.deliveries.size
+    };
+  }
+
+  /**
+   * Stop redelivering to a follower that left
+   */
+  dropFollower(followerId: string): void {
+    [...this.byFollower.get(followerId) ?? []].forEach(key => {
+      const delivery = this.commands.get(key)?.deliveries.get(followerId);
+      if (delivery?.timer) clearTimeout(delivery.timer);
+      this.release(followerId, key);
+    });
+  }
+
+  dispose(): void {
+    [...this.commands.keys()].forEach(key => this.forget(key));
+  }
+
+  private release(followerId: string, key: string): void {
+    const pending = this.byFollower.get(followerId);
+    if (!pending?.delete(key)) return;
+    if (pending.size === 0) this.byFollower.delete(followerId);
+    const command = this.commands.get(key);
+    if (command && --command.pending === 0) this.finished.add(key);
+  }
+
+  private forget(key: string): void {
+    const command = this.commands.get(key);
+    if (!command) return;
+    command.deliveries.forEach(delivery => {
+      if (delivery.timer) clearTimeout(delivery.timer);
+      this.release(delivery.followerId, key);
+    });
+    this.commands.delete(key);
+    this.finished.delete(key);
+  }
+}
@@ -0,0 +1,82 @@
+import { gzip } from 'zlib';
+import type { IncomingMessage, ServerResponse } from 'http';
+import type { PerMessageDeflateOptions } from 'ws';
+import { GZIP_JSON_HEADERS, sendJson } from './http-router.js';
+
+/**
+ * WebSocket path for admin/dashboard sockets. They get permessage-deflate;
+ * controller and follower sockets (the default path) never do, since their
+ * frames are tiny and compressing them only costs CPU.
+ */
+export const ADMIN_PATH = '/admin';
+
+export interface AdminCompressionOptions {
+  enabled: boolean;
+  level: number;       // zlib level 1-9
+  windowBits: number;  // 9-15; LZ77 window of the relay's deflate
+  memLevel: number;    // 1-9; deflate state size
+  threshold: number;   // frames smaller than this are sent uncompressed (bytes)
+}
+
+export interface HttpCompressionOptions {
+  enabled: boolean;
+  level: number;
+  threshold: number;   // responses smaller than this are sent uncompressed (bytes)
+}
+
+export interface CompressionOptions {
+  admin: AdminCompressionOptions;
+  http: HttpCompressionOptions;
+}
+
+// Each SESSIONS_UPDATE repeats most of the previous one, so the window must
+// hold a whole list (~11KB at 100 sessions) for context takeover to pay off:
+// 4KB windows only reach ~4x, 32KB ~20x at level 1 and ~70x at level 6
+// (bench/admin-compression.ts). Level 9 adds little on top of 6.
+// Per admin socket: deflate ~ 2^(windowBits+2) + 2^(memLevel+9) = 192KB
+// (vs 256KB with zlib defaults); inflate is capped by CLIENT_WINDOW_BITS.
+export const DEFAULT_COMPRESSION_OPTIONS: CompressionOptions = {
+  admin: { enabled: true, level: 6, windowBits: 15, memLevel: 7, threshold: 1024 },
+  http: { enabled: true, level: 6, threshold: 1024 }
+};
+
+// Dashboards only send small control messages; a 1KB window keeps the
+// relay's inflate state per socket small
+const CLIENT_WINDOW_BITS = 10;
+
+/**
+ * ws options for the admin WebSocketServer
+ */
+export function adminDeflateOptions(options: AdminCompressionOptions): PerMessageDeflateOptions | false {
+  if (!options.enabled) return false;
+  return {
+    zlibDeflateOptions: { level: options.level, memLevel: options.memLevel },
+    serverMaxWindowBits: options.windowBits,
+    clientMaxWindowBits: CLIENT_WINDOW_BITS,
+    threshold: options.threshold,
+    // Bound concurrent zlib work so a burst to many admins can't pile up buffers
+    concurrencyLimit: 4
+  };
+}
+
+/**
+ * End a JSON response, gzipped when the client accepts it and the body is
+ * large enough to be worth it
+ */
+export function writeJson(req: IncomingMessage, res: ServerResponse, status: number, body: unknown, options: HttpCompressionOptions): void {
+  const json = JSON.stringify(body);
+  const accepts = /\bgzip\b/.test(String(req.headers['accept-encoding'] ?? ''));
+  if (!options.enabled || !accepts || json.length < options.threshold) {
+    sendJson(res, status, json);
+    return;
+  }
+
+  gzip(json, { level: options.level }, (error, compressed) => {
+    if (error) {
+      sendJson(res, status, json);
+      return;
+    }
+    res.writeHead(status, GZIP_JSON_HEADERS as string[]);
+    res.end(compressed);
+  });
+}
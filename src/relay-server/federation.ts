@@ -0,0 +1,180 @@
+import WebSocket from 'ws';
+import { readFileSync } from 'fs';
+import crypto from 'crypto';
+import { Logger } from '../shared/logger.js';
+import { secretMatches } from '../shared/secrets.js';
+import { metrics } from '../shared/metrics.js';
+
+const logger = new Logger('Federation');
+
+export interface FederationOptions {
+  peers: string[];   // ws:// or wss:// URLs of every other relay (full mesh)
+  secret: string;    // shared by all relays in the federation
+  caFile?: string;   // extra CA for peers with self-signed certificates
+}
+
+export type ForwardTarget = 'followers' | 'controller';
+
+const forwardedCounter = metrics.counter('relay.federation.forwarded');
+const droppedCounter = metrics.counter('relay.federation.dropped');
+const receivedCounter = metrics.counter('relay.federation.received');
+const lookupsCounter = metrics.counter('relay.federation.lookups');
+const unownedCounter = metrics.counter('relay.federation.lookups_unowned');
+const peersGauge = metrics.gauge('relay.federation.peers_connected');
+
+const LOOKUP_TIMEOUT_MS = 2000;
+
+/**
+ * Outbound link to one peer relay. Reconnects every 5 seconds while down;
+ * forwards made while it's down are dropped (commands are not replayed).
+ */
+class PeerLink {
+  private ws?: WebSocket;
+  private open: boolean = false;
+  private reconnectTimer?: NodeJS.Timeout;
+  private closed: boolean = false;
+
+  constructor(
+    private url: string,
+    private relayId: string,
+    private options: FederationOptions,
+    private onOwns: (lookupId: string, owned: boolean) => void
+  ) {}
+
+  connect(): void {
+    this.ws = new WebSocket(this.url, { ca: this.options.caFile ? readFileSync(this.options.caFile) : undefined });
+
+    this.ws.on('open', () => {
+      this.open = true;
+      peersGauge.add(1);
+      this.ws!.send(JSON.stringify({ type: 'PEER_HELLO', secret: this.options.secret, relayId: this.relayId }));
+      logger.success(`Linked to peer relay ${this.url}`);
+    });
+
+    // The peer answers lookups with PEER_OWNS; CONNECTED / ERROR need no handling
+    this.ws.on('message', (data: Buffer) => {
+      let message: any;
+      try {
+        message = JSON.parse(data.toString());
+      } catch {
+        return;
+      }
+      if (message.type === 'PEER_OWNS' && typeof message.lookupId === 'string') {
+        this.onOwns(message.lookupId, message.owned === true);
+      }
+    });
+
+    this.ws.on('close', () => {
+      if (this.open) {
+        peersGauge.add(-1);
+        logger.warn(`Lost link to peer relay ${this.url}`);
+      }
+      this.open = false;
+      if (!this.closed) this.reconnectTimer = setTimeout(() => this.connect(), 5000);
+    });
+
+    this.ws.on('error', (error: Error) => {
+      logger.warn(`Peer relay ${this.url}: ${error.message}`);
+    });
+  }
+
+  send(data: string): boolean {
+    if (!this.open) return false;
+    this.ws!.send(data);
+    return true;
+  }
+
+  close(): void {
+    this.closed = true;
+    if (this.reconnectTimer) clearTimeout(this.reconnectTimer);
+    this.ws?.close();
+  }
+}
+
+/**
+ * Lets a follower on one relay receive its controller's commands sent to
+ * another. Every relay links to every peer; session messages delivered
+ * locally are also forwarded over those links and delivered by each peer
+ * to its own clients of that session. Forwarded messages are never
+ * forwarded again, so the mesh needs no loop detection.
+ *
+ * A relay only takes on a session it has never seen once a peer confirms
+ * that it serves it (lookup); an unknown token is not a new session.
+ */
+export class RelayFederation {
+  readonly relayId: string = crypto.randomBytes(4).toString('hex');
+  private links: PeerLink[];
+  private lookups: Map<string, { pending: number; resolve: (owned: boolean) => void; timer: NodeJS.Timeout }> = new Map();
+
+  constructor(private options: FederationOptions) {
+    this.links = options.peers.map(url => new PeerLink(url, this.relayId, options, (lookupId, owned) => this.answered(lookupId, owned)));
+  }
+
+  start(): void {
+    logger.info(`Relay ${this.relayId} federating with ${this.links.length} peer(s)`);
+    this.links.forEach(link => link.connect());
+  }
+
+  /**
+   * Forward an already serialized session message to every peer
+   */
+  forward(sessionToken: string, target: ForwardTarget, type: string, data: string): void {
+    const envelope = JSON.stringify({ type: 'PEER_FORWARD', sessionToken, target, messageType: type, data });
+    this.links.forEach(link => {
+      if (link.send(envelope)) forwardedCounter.inc();
+      else droppedCounter.inc();
+    });
+  }
+
+  received(): void {
+    receivedCounter.inc();
+  }
+
+  /**
+   * Ask every linked peer whether it serves a session. Resolves true on the
+   * first peer that does, false once all said no, none is linked, or
+   * LOOKUP_TIMEOUT_MS passed.
+   */
+  lookup(sessionToken: string): Promise<boolean> {
+    lookupsCounter.inc();
+    const lookupId = crypto.randomBytes(8).toString('hex');
+    const envelope = JSON.stringify({ type: 'PEER_LOOKUP', sessionToken, lookupId });
+    const pending = this.links.filter(link => link.send(envelope)).length;
+    if (pending === 0) {
+      unownedCounter.inc();
+      return Promise.resolve(false);
+    }
+
+    return new Promise(resolve => {
+      const timer = setTimeout(() => this.settle(lookupId, false), LOOKUP_TIMEOUT_MS);
+      this.lookups.set(lookupId, { pending, resolve, timer });
+    });
+  }
+
+  private answered(lookupId: string, owned: boolean): void {
+    const lookup = this.lookups.get(lookupId);
+    if (!lookup) return;
+    if (owned || --lookup.pending === 0) this.settle(lookupId, owned);
+  }
+
+  private settle(lookupId: string, owned: boolean): void {
+    const lookup = this.lookups.get(lookupId);
+    if (!lookup) return;
+    this.lookups.delete(lookupId);
+    clearTimeout(lookup.timer);
+    if (!owned) unownedCounter.inc();
+    lookup.resolve(owned);
+  }
+
+  /**
+   * Check of a peer's PEER_HELLO secret
+   */
+  isPeerSecret(presented: unknown): boolean {
+    return secretMatches(presented, this.options.secret);
+  }
+
+  stop(): void {
+    this.links.forEach(link => link.close());
+    [...this.lookups.keys()].forEach(lookupId => this.settle(lookupId, false));
+  }
+}
@@ -0,0 +1,142 @@
+/**
+ * Last STATUS_UPDATE a session's controller sent
+ */
+export interface ControllerStatus {
+  clientRunning: boolean;
+  processCount?: number;
+}
+
+// processCount histogram: one bucket per count below this, then "N+"
+const PROCESS_BUCKETS = 10;
+
+export interface FleetSummary {
+  sessions: number;
+  withController: number;
+  withoutController: number;
+  followers: number;
+  // Controller status of each session; unknown until its controller sends one
+  clientRunning: { running: number; stopped: number; unknown: number };
+  processCount: Record<string, number>;
+  // Each follower's last GAME_STATUS
+  gameRunning: { running: number; stopped: number; unknown: number };
+  version: number; // bumped on every change
+}
+
+/**
+ * Fleet-wide aggregates kept up to date by the SessionManager: each join,
+ * leave, status update and game-status forward adjusts a few counters, so
+ * a summary never walks the sessions. Every transition is reported as
+ * (previous, next), which keeps the counters symmetric and checkable
+ * against a recount (SessionManager.checkIndexes).
+ */
+export class FleetStats {
+  private sessions = 0;
+  private withController = 0;
+  private followers = 0;
+  private running = 0;
+  private stopped = 0;
+  private processCounts: number[] = new Array(PROCESS_BUCKETS + 1).fill(0);
+  private gameRunning = 0;
+  private gameStopped = 0;
+  private version = 0;
+
+  sessionAdded(): void {
+    this.sessions++;
+    this.version++;
+  }
+
+  sessionRemoved(): void {
+    this.sessions--;
+    this.version++;
+  }
+
+  controllerChanged(had: boolean, has: boolean): void {
+    if (had === has) return;
+    this.withController += has ? 1 : -1;
+    this.version++;
+  }
+
+  followerAdded(): void {
+    this.followers++;
+    this.version++;
+  }
+
+  /**
+   * A follower left; its last game status leaves with it
+   */
+  followerRemoved(gameRunning?: boolean): void {
+    this.followers--;
+    this.gameStatusChanged(gameRunning, undefined);
+    this.version++;
+  }
+
+  statusChanged(previous: ControllerStatus | undefined, next: ControllerStatus | undefined): void {
+    if (previous) this.countStatus(previous, -1);
+    if (next) this.countStatus(next, 1);
+    this.version++;
+  }
+
+  gameStatusChanged(previous: boolean | undefined, next: boolean | undefined): void {
+    if (previous === next) return;
+    if (previous !== undefined) {
+      if (previous) this.gameRunning--;
+      else this.gameStopped--;
+    }
+    if (next !== undefined) {
+      if (next) this.gameRunning++;
+      else this.gameStopped++;
+    }
+    this.version++;
+  }
+
+  get changes(): number {
+    return this.version;
+  }
+
+  snapshot(): FleetSummary {
+    const processCount: Record<string, number> = {};
+    this.processCounts.forEach((count, bucket) => {
+      if (count > 0) processCount[bucket === PROCESS_BUCKETS ? `${PROCESS_BUCKETS}+` : String(bucket)] = count;
+    });
+    return {
+      sessions: this.sessions,
+      withController: this.withController,
+      withoutController: this.sessions - this.withController,
+      followers: this.followers,
+      clientRunning: { running: this.running, stopped: this.stopped, unknown: this.sessions - this.running - this.stopped },
+      processCount,
+      gameRunning: { running: this.gameRunning, stopped: this.gameStopped, unknown: this.followers - this.gameRunning - this.gameStopped },
+      version: this.version
+    };
+  }
+
+  private countStatus(status: ControllerStatus, delta: number): void {
+    if (status.clientRunning) this.running += delta;
+    else this.stopped += delta;
+    const bucket = processBucket(status.processCount);
+    if (bucket !== undefined) this.processCounts[bucket] += delta;
+  }
+}
+
+// undefined for a missing or malformed count (left out of the histogram)
+function processBucket(processCount: number | undefined): number | undefined {
+  if (typeof processCount !== 'number' || !Number.isFinite(processCount) || processCount < 0) return undefined;
+  return Math.min(Math.floor(processCount), PROCESS_BUCKETS);
+}
+
+/**
+ * Recount a summary from scratch, for checking the incremental one
+ */
+export function recountFleet(sessions: Iterable<{ controller: boolean; status?: ControllerStatus; followers: Iterable<boolean | undefined> }>): FleetStats {
+  const fleet = new FleetStats();
+  for (const session of sessions) {
+    fleet.sessionAdded();
+    fleet.controllerChanged(false, session.controller);
+    fleet.statusChanged(undefined, session.status);
+    for (const gameRunning of session.followers) {
+      fleet.followerAdded();
+      fleet.gameStatusChanged(undefined, gameRunning);
+    }
+  }
+  return fleet;
+}
@@ -0,0 +1,178 @@
+import type { IncomingMessage, ServerResponse } from 'http';
+
+/**
+ * Route handler; params holds the :param and * values in pattern order.
+ * The array is reused by the next request, so copy anything kept past
+ * the synchronous part of the handler.
+ */
+export type RouteHandler = (req: IncomingMessage, res: ServerResponse, params: string[]) => void;
+
+export type RouteMethod = 'GET' | 'POST' | 'ANY';
+
+// Header lists in the flat [name, value, ...] form writeHead takes as-is
+export const JSON_HEADERS: readonly string[] = ['Content-Type', 'application/json', 'Access-Control-Allow-Origin', '*'];
+export const GZIP_JSON_HEADERS: readonly string[] = [...JSON_HEADERS, 'Content-Encoding', 'gzip', 'Vary', 'Accept-Encoding'];
+
+// Error bodies every request shares instead of re-serializing
+export const ERROR_BODIES = {
+  notFound: Buffer.from(JSON.stringify({ error: 'Not found' })),
+  methodNotAllowed: Buffer.from(JSON.stringify({ error: 'Method not allowed' })),
+  sessionNotFound: Buffer.from(JSON.stringify({ error: 'Session not found' })),
+  unauthorized: Buffer.from(JSON.stringify({ error: 'Unauthorized' }))
+};
+
+/**
+ * End a JSON response with the shared API headers
+ */
+export function sendJson(res: ServerResponse, status: number, body: string | Buffer): void {
+  res.writeHead(status, JSON_HEADERS as string[]);
+  res.end(body);
+}
+
+/**
+ * Split a pattern into static text, ':name' and '*' parts:
+ * '/sessions/:token/restart' -> ['/sessions/', ':token', '/restart']
+ */
+function parsePattern(pattern: string): string[] {
+  const parts: string[] = [];
+  let start = 0;
+  for (let i = 0; i < pattern.length; i++) {
+    const char = pattern[i];
+    if (char !== ':' && char !== '*') continue;
+    if (i > start) parts.push(pattern.slice(start, i));
+    if (char === '*') {
+      parts.push('*');
+      start = i + 1;
+      continue;
+    }
+    let end = pattern.indexOf('/', i);
+    if (end === -1) end = pattern.length;
+    parts.push(pattern.slice(i, end));
+    start = end;
+    i = end - 1;
+  }
+  if (start < pattern.length) parts.push(pattern.slice(start));
+  return parts;
+}
+
+class RouteNode {
+  prefix: string;
+  statics: Map<number, RouteNode> = new Map(); // first char code of the child's prefix ->
+  param?: RouteNode;     // :name, up to the next '/'
+  wildcard?: RouteNode;  // *, the rest of the path
+  handlers?: Map<string, RouteHandler>;
+
+  constructor(prefix: string = '') {
+    this.prefix = prefix;
+  }
+}
+
+/**
+ * Radix-tree router. Patterns are compiled once into nodes keyed by their
+ * first character. A lookup walks the URL in place: static segments are
+ * compared with startsWith at an offset and the query string is skipped,
+ * so a match only allocates the strings of its parameters. Patterns
+ * without parameters are also kept in a map for URLs without a query.
+ * Static children win over :params, and :params win over *.
+ */
+export class HttpRouter {
+  private root = new RouteNode();
+  private exact: Map<string, RouteNode> = new Map(); // patterns without params, for one hash lookup
+  private params: string[] = [];
+
+  on(method: RouteMethod, pattern: string, handler: RouteHandler): this {
+    let node = this.root;
+    for (const part of parsePattern(pattern)) {
+      if (part === '*') {
+        node = node.wildcard ??= new RouteNode();
+      } else if (part.startsWith(':')) {
+        node = node.param ??= new RouteNode();
+      } else {
+        node = this.insertStatic(node, part);
+      }
+    }
+    node.handlers ??= new Map();
+    node.handlers.set(method, handler);
+    if (!pattern.includes(':') && !pattern.includes('*')) this.exact.set(pattern, node);
+    return this;
+  }
+
+  /**
+   * Route a request: 404 for an unknown path, 405 for a known path
+   * without a handler for the method
+   */
+  dispatch(req: IncomingMessage, res: ServerResponse): void {
+    const url = req.url ?? '/';
+    const query = url.indexOf('?');
+    const params = this.params;
+    params.length = 0;
+
+    const node = (query === -1 ? this.exact.get(url) : undefined)
+      ?? this.match(this.root, url, 0, query === -1 ? url.length : query, params);
+    if (!node) {
+      sendJson(res, 404, ERROR_BODIES.notFound);
+      return;
+    }
+    const handler = node.handlers!.get(req.method ?? 'GET') ?? node.handlers!.get('ANY');
+    if (!handler) {
+      res.setHeader('Allow', [...node.handlers!.keys()].join(', '));
+      sendJson(res, 405, ERROR_BODIES.methodNotAllowed);
+      return;
+    }
+    handler(req, res, params);
+  }
+
+  private insertStatic(node: RouteNode, path: string): RouteNode {
+    const child = node.statics.get(path.charCodeAt(0));
+    if (!child) {
+      const created = new RouteNode(path);
+      node.statics.set(path.charCodeAt(0), created);
+      return created;
+    }
+
+    let common = 0;
+    while (common < path.length && common < child.prefix.length && path[common] === child.prefix[common]) common++;
+
+    if (common < child.prefix.length) {
+      // Split: the shared part becomes a node holding the old child's remainder
+      const split = new RouteNode(child.prefix.slice(0, common));
+      child.prefix = child.prefix.slice(common);
+      split.statics.set(child.prefix.charCodeAt(0), child);
+      node.statics.set(split.prefix.charCodeAt(0), split);
+      return common === path.length ? split : this.insertStatic(split, path.slice(common));
+    }
+    return common === path.length ? child : this.insertStatic(child, path.slice(common));
+  }
+
+  private match(node: RouteNode, url: string, position: number, end: number, params: string[]): RouteNode | undefined {
+    if (position === end) {
+      if (node.handlers) return node;
+      if (!node.wildcard?.handlers) return undefined;
+      params.push('');
+      return node.wildcard;
+    }
+
+    const child = node.statics.get(url.charCodeAt(position));
+    if (child && position + child.prefix.length <= end && url.startsWith(child.prefix, position)) {
+      const found = this.match(child, url, position + child.prefix.length, end, params);
+      if (found) return found;
+    }
+
+    if (node.param) {
+      let segmentEnd = url.indexOf('/', position);
+      if (segmentEnd === -1 || segmentEnd > end) segmentEnd = end;
+      if (segmentEnd > position) {
+        params.push(url.slice(position, segmentEnd));
+        const found = this.match(node.param, url, segmentEnd, end, params);
+        if (found) return found;
+        params.pop();
+      }
+    }
+
+    if (node.wildcard?.handlers) {
+      params.push(url.slice(position, end));
+      return node.wildcard;
+    }
+    return undefined;
+  }
+}
@@ -0,0 +1,206 @@
+import { WebSocket } from 'ws';
+import { Logger } from '../shared/logger.js';
+import { metrics } from '../shared/metrics.js';
+
+const logger = new Logger('OutboundQueue');
+
+export type Priority = 'command' | 'info';
+
+/**
+ * What the queue needs from a connection; satisfied by ws WebSocket and IpcSocket
+ */
+export interface RelaySocket {
+  readonly readyState: number;
+  readonly bufferedAmount: number;
+  send(data: string, cb?: (error?: Error) => void): void;
+  close(): void;
+  terminate(): void;
+}
+
+/**
+ * Told about every frame actually written (after coalescing and drops)
+ */
+export interface OutboundMeter {
+  sent(type: string, bytes: number, data?: string): void; // data: the frame itself
+}
+
+export interface OutboundQueueOptions {
+  highWaterMark: number;   // bytes allowed in the socket buffer before we hold messages back
+  maxInfoDepth: number;    // informational messages queued before the oldest is dropped
+  maxCommandDepth: number; // commands queued before the connection is considered stuck
+}
+
+export const DEFAULT_OUTBOUND_OPTIONS: OutboundQueueOptions = {
+  highWaterMark: 64 * 1024,
+  maxInfoDepth: 256,
+  maxCommandDepth: 1024
+};
+
+/**
+ * Informational message types. Anything not listed here is treated as a
+ * command so a newly added message type can never be silently dropped.
+ * Types mapped to true are coalesced: only the latest queued copy is kept
+ * (per coalesce key, when the sender gives one).
+ */
+const INFO_TYPES: Map<string, boolean> = new Map([
+  ['HEARTBEAT_ACK', true],
+  ['STATUS_BROADCASTED', true],
+  ['STATUS_UPDATE', true],
+  ['SESSIONS_UPDATE', true],
+  ['GAME_STATUS_RECEIVED', true],
+  ['RESTART_BROADCASTED', false],
+  ['IMMEDIATE_START_BROADCASTED', false],
+  ['ACTIVITY', false],
+  ['COMMAND_UPDATE', false],
+  ['TRAFFIC_COUNTS', false],
+  ['TRAFFIC_TOP', true],
+  ['FLEET_SUMMARY', true]
+]);
+
+export function priorityOf(type: string): Priority {
+  return INFO_TYPES.has(type) ? 'info' : 'command';
+}
+
+interface QueuedMessage {
+  type: string;
+  data: string;
+  enqueuedAt: number;
+  key?: string; // coalescing slot, for coalesced types
+}
+
+const depthGauges = {
+  command: metrics.gauge('relay.outbound.depth.command'),
+  info: metrics.gauge('relay.outbound.depth.info')
+};
+const waitHistograms = {
+  command: metrics.histogram('relay.outbound.wait_ms.command'),
+  info: metrics.histogram('relay.outbound.wait_ms.info')
+};
+const coalescedCounter = metrics.counter('relay.outbound.coalesced');
+const droppedCounter = metrics.counter('relay.outbound.dropped');
+
+/**
+ * Per-connection outbound scheduler with two priority lanes.
+ * Commands are written ahead of informational traffic; informational
+ * messages are coalesced by type and dropped oldest-first when the lane
+ * is full. Only highWaterMark bytes are handed to the socket at a time,
+ * so a queued command never sits behind a large backlog in the kernel.
+ */
+export class OutboundQueue {
+  private commands: QueuedMessage[] = [];
+  private info: QueuedMessage[] = [];
+  private pendingByKey: Map<string, QueuedMessage> = new Map(); // coalescing slot -> its queued message
+  private closed: boolean = false;
+
+  constructor(
+    private ws: RelaySocket,
+    private options: OutboundQueueOptions = DEFAULT_OUTBOUND_OPTIONS,
+    private meter?: OutboundMeter
+  ) {}
+
+  /**
+   * Serialize and queue a message
+   */
+  send(message: { type: string; [key: string]: any }): void {
+    this.enqueue(message.type, JSON.stringify(message));
+  }
+
+  /**
+   * Queue an already serialized message (lets broadcasts serialize once).
+   * coalesceKey splits a coalesced type into independent slots, e.g. one
+   * per session for single-session deltas, so one doesn't replace another.
+   */
+  enqueue(type: string, data: string, coalesceKey?: string): void {
+    if (this.closed || this.ws.readyState !== WebSocket.OPEN) return;
+
+    // Fast path: nothing queued and the socket is keeping up
+    if (this.commands.length === 0 && this.info.length === 0 && this.ws.bufferedAmount < this.options.highWaterMark) {
+      waitHistograms[priorityOf(type)].record(0);
+      this.write(type, data);
+      return;
+    }
+
+    if (priorityOf(type) === 'command') {
+      if (this.commands.length >= this.options.maxCommandDepth) {
+        logger.warn(`Command queue full (${this.commands.length}), terminating stuck connection`);
+        this.ws.terminate();
+        return;
+      }
+      this.commands.push({ type, data, enqueuedAt: Date.now() });
+      depthGauges.command.add(1);
+    } else {
+      const key = INFO_TYPES.get(type) ? (coalesceKey === undefined ? type : `${type}:${coalesceKey}`) : undefined;
+      if (key) {
+        const pending = this.pendingByKey.get(key);
+        if (pending) {
+          pending.data = data;
+          coalescedCounter.inc();
+          return;
+        }
+      }
+
+      if (this.info.length >= this.options.maxInfoDepth) {
+        const dropped = this.info.shift()!;
+        if (dropped.key && this.pendingByKey.get(dropped.key) === dropped) this.pendingByKey.delete(dropped.key);
+        depthGauges.info.add(-1);
+        droppedCounter.inc();
+      }
+
+      const entry: QueuedMessage = { type, data, enqueuedAt: Date.now(), key };
+      this.info.push(entry);
+      if (key) this.pendingByKey.set(key, entry);
+      depthGauges.info.add(1);
+    }
+
+    this.pump();
+  }
+
+  /**
+   * Number of queued (not yet written) messages
+   */
+  depth(): { command: number; info: number } {
+    return { command: this.commands.length, info: this.info.length };
+  }
+
+  close(): void {
+    this.ws.close();
+  }
+
+  /**
+   * Release queued messages once the socket is gone
+   */
+  dispose(): void {
+    this.closed = true;
+    depthGauges.command.add(-this.commands.length);
+    depthGauges.info.add(-this.info.length);
+    this.commands = [];
+    this.info = [];
+    this.pendingByKey.clear();
+  }
+
+  private pump = (): void => {
+    while (!this.closed && this.ws.readyState === WebSocket.OPEN && this.ws.bufferedAmount < this.options.highWaterMark) {
+      let entry = this.commands.shift();
+      let lane: Priority = 'command';
+      if (!entry) {
+        entry = this.info.shift();
+        lane = 'info';
+        if (!entry) return;
+        if (entry.key && this.pendingByKey.get(entry.key) === entry) this.pendingByKey.delete(entry.key);
+      }
+
+      depthGauges[lane].add(-1);
+      waitHistograms[lane].record(Date.now() - entry.enqueuedAt);
+      this.write(entry.type, entry.data);
+    }
+    // Socket buffer is full; the write callback of an in-flight frame resumes pumping
+  };
+
+  private write(type: string, data: string): void {
+    this.meter?.sent(type, data.length, data);
+    this.ws.send(data, (error) => {
+      if (error) return;
+      if (this.commands.length > 0 || this.info.length > 0) this.pump();
+    });
+  }
+}
@@ -0,0 +1,146 @@
+import { Session } from 'inspector';
+import { writeHeapSnapshot } from 'v8';
+import { mkdirSync, readdirSync, statSync, unlinkSync, writeFileSync } from 'fs';
+import { join } from 'path';
+import type { IncomingMessage } from 'http';
+import { Logger } from '../shared/logger.js';
+import { secretMatches } from '../shared/secrets.js';
+
+const logger = new Logger('Profiler');
+
+export interface RelayDebugOptions {
+  token: string;          // required as "Authorization: Bearer <token>" on /debug/*
+  dir?: string;           // where profiles are kept (default ./profiles)
+  maxFiles?: number;      // newest profiles kept in dir (default 10)
+  maxSeconds?: number;    // longest capture window accepted (default 60)
+}
+
+/**
+ * Constant-time bearer token check for the /debug endpoints
+ */
+export function isAuthorized(req: IncomingMessage, token: string): boolean {
+  const header = req.headers.authorization ?? '';
+  return secretMatches(header.startsWith('Bearer ') ? header.slice(7) : '', token);
+}
+
+/**
+ * On-demand CPU, heap and allocation profiling through the in-process
+ * inspector. Every capture is written to dir (oldest files rotated out)
+ * so it can still be collected after an incident. One capture at a time.
+ */
+export class Profiler {
+  private dir: string;
+  private maxFiles: number;
+  readonly maxSeconds: number;
+  private busy: boolean = false;
+
+  constructor(options: RelayDebugOptions) {
+    this.dir = options.dir ?? join(process.cwd(), 'profiles');
+    this.maxFiles = options.maxFiles ?? 10;
+    this.maxSeconds = options.maxSeconds ?? 60;
+  }
+
+  isBusy(): boolean {
+    return this.busy;
+  }
+
+  /**
+   * Sample the CPU for a window; returns the .cpuprofile path
+   */
+  async cpu(seconds: number): Promise<string> {
+    return this.capture('cpu', 'cpuprofile', async session => {
+      await post(session, 'Profiler.enable');
+      await post(session, 'Profiler.start');
+      await sleep(seconds * 1000);
+      const { profile } = await post(session, 'Profiler.stop');
+      await post(session, 'Profiler.disable');
+      return JSON.stringify(profile);
+    });
+  }
+
+  /**
+   * Sample allocations for a window; returns the .heapprofile path
+   */
+  async alloc(seconds: number): Promise<string> {
+    return this.capture('alloc', 'heapprofile', async session => {
+      await post(session, 'HeapProfiler.enable');
+      await post(session, 'HeapProfiler.startSampling', { samplingInterval: 32 * 1024 });
+      await sleep(seconds * 1000);
+      const { profile } = await post(session, 'HeapProfiler.stopSampling');
+      await post(session, 'HeapProfiler.disable');
+      return JSON.stringify(profile);
+    });
+  }
+
+  /**
+   * Write a heap snapshot straight to disk; returns its path.
+   * The event loop only stalls for the snapshot itself, the caller streams
+   * the file afterwards instead of buffering it in memory.
+   */
+  heap(): string {
+    if (this.busy) throw new Error('Profiler busy');
+    this.busy = true;
+    try {
+      const file = this.prepare('heap', 'heapsnapshot');
+      const start = Date.now();
+      writeHeapSnapshot(file);
+      logger.info(`Heap snapshot written to ${file} in ${Date.now() - start}ms`);
+      this.rotate();
+      return file;
+    } finally {
+      this.busy = false;
+    }
+  }
+
+  private async capture(kind: string, extension: string, run: (session: Session) => Promise<string>): Promise<string> {
+    if (this.busy) throw new Error('Profiler busy');
+    this.busy = true;
+
+    const session = new Session();
+    session.connect();
+    try {
+      const file = this.prepare(kind, extension);
+      writeFileSync(file, await run(session));
+      logger.info(`${kind} profile written to ${file}`);
+      this.rotate();
+      return file;
+    } finally {
+      session.disconnect();
+      this.busy = false;
+    }
+  }
+
+  private prepare(kind: string, extension: string): string {
+    mkdirSync(this.dir, { recursive: true });
+    const stamp = new Date().toISOString().replace(/[:.]/g, '-');
+    return join(this.dir, `${kind}-${stamp}-${process.pid}.${extension}`);
+  }
+
+  /**
+   * Keep only the newest maxFiles profiles
+   */
+  private rotate(): void {
+    const files = readdirSync(this.dir)
+      .filter(name => /\.(cpuprofile|heapprofile|heapsnapshot)$/.test(name))
+      .map(name => ({ path: join(this.dir, name), mtime: statSync(join(this.dir, name)).mtimeMs }))
+      .sort((a, b) => b.mtime - a.mtime);
+
+    for (const file of files.slice(this.maxFiles)) {
+      try {
+        unlinkSync(file.path);
+      } catch (error) {
+        logger.warn(`Failed to rotate ${file.path}: ${error instanceof Error ? error.message : String(error)}`);
+      }
+    }
+  }
+}
+
+function post(session: Session, method: string, params?: object): Promise<any> {
+  return new Promise((resolve, reject) => {
+    session.post(method, params ?? {}, (error, result) => error ? reject(error) : resolve(result));
+  });
+}
+
+function sleep(ms: number): Promise<void> {
+  return new Promise(resolve => setTimeout(resolve, ms));
+}
@@ -0,0 +1,902 @@
+import type { IncomingMessage, ServerResponse } from 'http';
+import { createServer as createNetServer } from 'net';
+import type { Server as NetServer } from 'net';
+import { SessionManager } from './session-manager.js';
+import type { SessionLimits } from './session-manager.js';
+import { OutboundQueue, DEFAULT_OUTBOUND_OPTIONS } from './outbound-queue.js';
+import type { OutboundQueueOptions } from './outbound-queue.js';
+import type { RelayTlsOptions } from './tls.js';
+import { Profiler, isAuthorized } from './profiler.js';
+import type { RelayDebugOptions } from './profiler.js';
+import { RelayFederation } from './federation.js';
+import type { FederationOptions, ForwardTarget } from './federation.js';
+import type { AckStage, CommandRetryOptions } from './command-tracker.js';
+import { ShadowMirror } from './shadow-mirror.js';
+import type { MirrorOptions, CanaryOptions } from './shadow-mirror.js';
+import { Fencer, ReplicationSource, StandbyLink, loadReplicationState, saveReplicationState } from './replication.js';
+import type { ReplicationOptions } from './replication.js';
+import { AdminFeed } from './admin-feed.js';
+import type { AdminFilter } from './admin-feed.js';
+import { TrafficStats, TOP_DIMENSIONS } from './traffic-stats.js';
+import type { TopDimension } from './traffic-stats.js';
+import { DEFAULT_COMPRESSION_OPTIONS, writeJson } from './compression.js';
+import { HttpRouter, ERROR_BODIES, sendJson } from './http-router.js';
+import type { CompressionOptions } from './compression.js';
+import { DEFAULT_TRANSPORT_SETTINGS, createTransport, normalizeIp } from './transport.js';
+import type { RelayTransport, TransportSettings, TransportSocket } from './transport.js';
+import { readFileSync, existsSync, lstatSync, unlinkSync, createReadStream } from 'fs';
+import { join, basename } from 'path';
+import { Logger } from '../shared/logger.js';
+import { metrics } from '../shared/metrics.js';
+import { secretMatches } from '../shared/secrets.js';
+import { IpcSocket, preparePrivateIpcDir } from '../shared/ipc-socket.js';
+import { ChannelMux, ChannelSocket } from '../shared/channel-mux.js';
+import { tracer } from '../shared/tracing.js';
+import type { TraceContext } from '../shared/tracing.js';
+import crypto from 'crypto';
+
+const logger = new Logger('RelayServer');
+const SESSION_LIMIT_MESSAGE = 'Session limit reached for your IP and every session has clients connected';
+const socketsGauge = metrics.gauge('relay.sockets.open');
+const channelsGauge = metrics.gauge('relay.channels.open');
+const heartbeatCounter = metrics.counter('relay.heartbeats');
+
+interface ClientMessage {
+  type: 'JOIN' | 'HEARTBEAT' | 'RESTART' | 'CREATE_SESSION' | 'STATUS_UPDATE' | 'STATUS_REQUEST' | 'IMMEDIATE_START' | 'GAME_STATUS' | 'ADMIN_SUBSCRIBE' | 'ADMIN_UNSUBSCRIBE' | 'PEER_HELLO' | 'PEER_FORWARD' | 'PEER_LOOKUP' | 'SHADOW_HELLO' | 'REPL_HELLO' | 'REPL_FENCE' | 'COMMAND_ACK';
+  sessionToken?: string;
+  role?: 'controller' | 'follower';
+  status?: { clientRunning: boolean; processCount?: number };
+  gameRunning?: boolean;
+  trace?: TraceContext;
+  secret?: string;           // PEER_HELLO, SHADOW_HELLO, REPL_HELLO, REPL_FENCE
+  term?: number;             // REPL_HELLO, REPL_FENCE
+  url?: string;              // REPL_FENCE, where the sender is reached (advertiseUrl)
+  port?: number;             // REPL_FENCE, the sender's port
+  relayId?: string;          // PEER_HELLO
+  ip?: string;               // SHADOW_HELLO, the mirrored client's address
+  target?: ForwardTarget;    // PEER_FORWARD
+  messageType?: string;      // PEER_FORWARD
+  data?: string;             // PEER_FORWARD, the serialized message
+  lookupId?: string;         // PEER_LOOKUP
+  commandId?: string;        // RESTART, IMMEDIATE_START, COMMAND_ACK
+  stage?: AckStage;          // COMMAND_ACK
+  ok?: boolean;              // COMMAND_ACK
+  detail?: string;           // COMMAND_ACK, e.g. 'client launched'
+  filter?: AdminFilter;      // ADMIN_SUBSCRIBE
+}
+
+export interface RelayServerOptions {
+  host?: string;
+  outbound?: OutboundQueueOptions;
+  tls?: RelayTlsOptions;
+  ipcPath?: string; // also accept same-host clients on this Unix socket / named pipe
+  adoptUnknownSessions?: boolean; // JOIN with an unknown token creates that session (controller's LAN relay)
+  debug?: RelayDebugOptions;      // enables the authenticated /debug/* endpoints
+  sessions?: Partial<SessionLimits>;
+  commands?: Partial<CommandRetryOptions>; // redelivery of unacknowledged follower commands
+  federation?: FederationOptions; // share sessions with peer relays; unknown tokens are adopted once a peer confirms them
+  mirror?: MirrorOptions;         // copy client traffic to a canary relay and compare what it delivers
+  canary?: CanaryOptions;         // accept mirrored clients from a primary; their unknown tokens are adopted
+  replication?: ReplicationOptions; // stream session state to a standby, or (standbyOf) be one
+  adminTrafficIntervalMs?: number; // how often admins get TRAFFIC_COUNTS and TRAFFIC_TOP
+  trafficWindowMs?: number;        // sliding window of per-client traffic accounting (/debug/top, hotspots)
+  compression?: CompressionOptions; // admin sockets and HTTP list responses only
+  transport?: Partial<TransportSettings>; // WebSocket engine ('ws' or native 'uws') and idle timeout
+}
+
+// A transport socket, IpcSocket or ChannelSocket; all emit 'message', 'close' and 'error'
+type ClientSocket = TransportSocket;
+
+export class RelayServer {
+  private sessionManager: SessionManager;
+  private transport?: RelayTransport; // created on start (the uws engine loads asynchronously)
+  private router: HttpRouter;
+  private handleRequest: (req: IncomingMessage, res: ServerResponse) => void;
+  private compression: CompressionOptions;
+  private ipcServer?: NetServer;
+  private profiler?: Profiler;
+  private outboundOptions: OutboundQueueOptions;
+  private clientIds: Map<ClientSocket, string> = new Map();
+  private clientIps: Map<ClientSocket, string> = new Map(); // Store IP for each socket
+  private queues: Map<ClientSocket, OutboundQueue> = new Map(); // Prioritized outbound lane per socket
+  private adminFeed: AdminFeed;
+  private traffic: TrafficStats; // per-client messages, bytes and handling time
+  private federation?: RelayFederation;
+  private peerSockets: Set<ClientSocket> = new Set(); // inbound links from peer relays
+  private mirror?: ShadowMirror;
+  private shadowSockets: Set<ClientSocket> = new Set(); // mirrored clients of a primary (canary only)
+  private replication?: ReplicationSource;
+  private standbyLink?: StandbyLink; // set while this relay follows a primary (standbyOf)
+  private fencer?: Fencer;           // set while serving after a takeover
+  private fenceUrl?: string;         // the replaced primary, fenced from start()
+  private standbySockets: Set<ClientSocket> = new Set(); // standbys streamed from this relay
+  private steppedDown: boolean = false; // a relay with a higher replication term took over, with nowhere to follow
+  private muxes: Map<ClientSocket, ChannelMux> = new Map(); // sockets carrying multiplexed channels
+
+  constructor(private port: number, private options: RelayServerOptions = {}) {
+    this.sessionManager = new SessionManager(options.sessions, options.commands);
+    this.traffic = new TrafficStats({ windowMs: options.trafficWindowMs });
+    this.adminFeed = new AdminFeed(this.sessionManager, options.adminTrafficIntervalMs, this.traffic);
+    this.outboundOptions = options.outbound ?? DEFAULT_OUTBOUND_OPTIONS;
+    this.compression = options.compression ?? DEFAULT_COMPRESSION_OPTIONS;
+    if (options.debug?.token) this.profiler = new Profiler(options.debug);
+    if (options.federation) {
+      const federation = new RelayFederation(options.federation);
+      this.sessionManager.setForwarder((token, target, type, data) => federation.forward(token, target, type, data));
+      this.federation = federation;
+    }
+    if (options.mirror) this.mirror = new ShadowMirror(options.mirror);
+    if (options.replication) {
+      this.replication = new ReplicationSource(this.sessionManager, options.replication);
+      // A takeover or step-down before a restart wins over the configured standbyOf
+      const state = loadReplicationState(this.stateFile());
+      this.replication.term = state?.term ?? 0;
+      const standbyOf = state ? state.standbyOf : options.replication.standbyOf;
+      if (standbyOf) this.standbyLink = this.createStandbyLink(standbyOf);
+      else this.fenceUrl = state?.fence;
+    }
+    
+    this.router = this.createRouter();
+    this.handleRequest = (req, res) => this.router.dispatch(req, res);
+
+    // Subscribe to session manager events and forward them to the admins whose filter matches
+    this.sessionManager.on('session_created', (payload: any) => this.adminFeed.sessionChanged(payload.token, 'session_created', payload));
+    this.sessionManager.on('session_updated', (payload: any) => this.adminFeed.sessionChanged(payload.token, 'session_updated', payload));
+    this.sessionManager.on('session_removed', (token: string) => this.adminFeed.sessionChanged(token, 'session_removed', token));
+    this.sessionManager.on('activity', (payload: any) => this.adminFeed.activity(payload.sessionToken, payload.level, payload));
+    this.sessionManager.on('command_progress', (payload: any) => this.adminFeed.command(payload.sessionToken, payload));
+    this.sessionManager.on('traffic', (payload: any) => this.adminFeed.count(payload.sessionToken, payload.kind));
+    this.setupIpc();
+  }
+
+  /**
+   * HTTP API. JSON routes get the shared CORS/JSON headers; dashboard
+   * files only their content type.
+   */
+  private createRouter(): HttpRouter {
+    const respond = (res: ServerResponse, status: number, body: object) => sendJson(res, status, JSON.stringify(body));
+
+    return new HttpRouter()
+      .on('GET', '/dashboard', (_req, res) => this.serveDashboard(res, '/index.html'))
+      .on('GET', '/dashboard/*', (_req, res, [path]) => this.serveDashboard(res, path ? `/${path}` : '/index.html'))
+      .on('ANY', '/debug/*', (req, res) => this.handleDebug(req, res))
+      // A standby answers 503 so clients' relay selection passes it over until it takes over
+      .on('ANY', '/health', (_req, res) => {
+        const health = () => this.isStandby()
+          ? respond(res, 503, { status: this.steppedDown ? 'stepped down' : 'standby', timestamp: Date.now() })
+          : respond(res, 200, { status: 'ok', timestamp: Date.now() });
+        if (this.standbyLink) this.standbyLink.settled().then(health);
+        else health();
+      })
+      .on('GET', '/metrics', (req, res) => writeJson(req, res, 200, metrics.snapshot(), this.compression.http))
+      .on('POST', '/create-session', (req, res) => {
+        if (this.isStandby()) {
+          respond(res, 503, { error: 'This relay is a standby' });
+          return;
+        }
+        const token = this.sessionManager.generateToken(normalizeIp(req.socket.remoteAddress));
+        if (!token) {
+          respond(res, 429, { error: SESSION_LIMIT_MESSAGE });
+          return;
+        }
+        respond(res, 200, { token, message: 'Session created' });
+      })
+      .on('GET', '/fleet', (_req, res) => respond(res, 200, this.sessionManager.getFleetSummary()))
+      .on('GET', '/sessions', (req, res) => writeJson(req, res, 200, { sessions: this.sessionManager.getAllSessions() }, this.compression.http))
+      .on('GET', '/sessions/:token', (_req, res, [token]) => {
+        const info = this.sessionManager.getSessionInfo(token);
+        if (!info) {
+          sendJson(res, 404, ERROR_BODIES.sessionNotFound);
+          return;
+        }
+        respond(res, 200, { session: info });
+      })
+      // POST /sessions/:token/restart or /sessions/:token/immediate
+      .on('POST', '/sessions/:token/:action', (req, res, [token, action]) => {
+        if (!this.sessionManager.sessionExists(token)) {
+          sendJson(res, 404, ERROR_BODIES.sessionNotFound);
+          return;
+        }
+
+        // A retried request with the same Idempotency-Key is not delivered again
+        const commandId = (req.headers['idempotency-key'] as string | undefined) || crypto.randomUUID();
+
+        if (action === 'restart') {
+          const count = this.sessionManager.broadcastRestartByToken(token, commandId);
+          respond(res, 200, { result: 'broadcasted', sentTo: count, commandId });
+          return;
+        }
+        if (action === 'immediate') {
+          const count = this.sessionManager.broadcastImmediateStartByToken(token, commandId);
+          respond(res, 200, { result: 'broadcasted', sentTo: count, commandId });
+          return;
+        }
+        respond(res, 400, { error: 'Unknown action' });
+      });
+  }
+
+  /**
+   * Serve a built dashboard file: .output/public (Nuxt build), then dashboard/dist
+   */
+  private serveDashboard(res: ServerResponse, relPath: string): void {
+    let filePath = join(process.cwd(), 'dashboard', '.output', 'public', relPath);
+    if (!existsSync(filePath)) {
+      filePath = join(process.cwd(), 'dashboard', 'dist', relPath);
+    }
+
+    if (existsSync(filePath)) {
+      try {
+        const contents = readFileSync(filePath);
+        // crude content-type detection
+        const ct = filePath.endsWith('.html') ? 'text/html' : filePath.endsWith('.js') ? 'application/javascript' : filePath.endsWith('.css') ? 'text/css' : 'application/octet-stream';
+        res.writeHead(200, { 'Content-Type': ct });
+        res.end(contents);
+        return;
+      } catch (err) {
+        logger.warn(`Failed serving dashboard file ${filePath}: ${err instanceof Error ? err.message : String(err)}`);
+      }
+    }
+    sendJson(res, 404, ERROR_BODIES.notFound);
+  }
+
+  /**
+   * /debug/cpu?seconds=N, /debug/alloc?seconds=N, /debug/heap, /debug/indexes
+   * /debug/top?by=bytes|messages|cpu&n=20 and /debug/mirror.
+   * Disabled (404) unless a debug token is configured.
+   */
+  private handleDebug(req: IncomingMessage, res: ServerResponse): void {
+    const profiler = this.profiler;
+    if (!profiler) {
+      sendJson(res, 404, ERROR_BODIES.notFound);
+      return;
+    }
+    if (!isAuthorized(req, this.options.debug!.token)) {
+      sendJson(res, 401, ERROR_BODIES.unauthorized);
+      return;
+    }
+
+    const url = new URL(req.url!, 'http://relay');
+    if (url.pathname === '/debug/indexes') {
+      sendJson(res, 200, JSON.stringify(this.sessionManager.checkIndexes()));
+      return;
+    }
+
+    if (url.pathname === '/debug/top') {
+      const by = url.searchParams.get('by') ?? 'bytes';
+      const n = Number(url.searchParams.get('n') ?? 20);
+      if (!TOP_DIMENSIONS.has(by) || !Number.isInteger(n) || n < 1) {
+        sendJson(res, 400, JSON.stringify({ error: 'by must be bytes, messages or cpu, and n a positive integer' }));
+        return;
+      }
+      sendJson(res, 200, JSON.stringify(this.traffic.top(by as TopDimension, n)));
+      return;
+    }
+
+    if (url.pathname === '/debug/mirror') {
+      if (this.mirror) sendJson(res, 200, JSON.stringify(this.mirror.report()));
+      else sendJson(res, 404, ERROR_BODIES.notFound);
+      return;
+    }
+
+    if (profiler.isBusy()) {
+      sendJson(res, 409, JSON.stringify({ error: 'A capture is already running' }));
+      return;
+    }
+
+    const seconds = Number(url.searchParams.get('seconds') ?? 10);
+    if (!Number.isFinite(seconds) || seconds <= 0 || seconds > profiler.maxSeconds) {
+      sendJson(res, 400, JSON.stringify({ error: `seconds must be between 0 and ${profiler.maxSeconds}` }));
+      return;
+    }
+
+    const sendFile = (file: string) => {
+      res.writeHead(200, {
+        'Content-Type': 'application/octet-stream',
+        'Content-Disposition': `attachment; filename="${basename(file)}"`
+      });
+      createReadStream(file).pipe(res);
+    };
+    const fail = (error: unknown) => {
+      logger.error('Profiling failed', error as Error);
+      sendJson(res, 500, JSON.stringify({ error: error instanceof Error ? error.message : String(error) }));
+    };
+
+    logger.info(`Debug capture requested: ${url.pathname}`);
+    switch (url.pathname) {
+      case '/debug/cpu':
+        profiler.cpu(seconds).then(sendFile, fail);
+        return;
+      case '/debug/alloc':
+        profiler.alloc(seconds).then(sendFile, fail);
+        return;
+      case '/debug/heap':
+        try {
+          sendFile(profiler.heap());
+        } catch (error) {
+          fail(error);
+        }
+        return;
+      default:
+        sendJson(res, 404, ERROR_BODIES.notFound);
+    }
+  }
+
+  private setupIpc(): void {
+    if (this.options.ipcPath) {
+      // Same-host clients: loopback address keeps IP auto-join pairing intact
+      this.ipcServer = createNetServer(socket => this.attachClient(new IpcSocket(socket, true), '127.0.0.1'));
+      this.ipcServer.on('error', (error) => logger.error('IPC server error', error));
+    }
+  }
+
+  private attachClient(ws: ClientSocket, normalizedIp: string): void {
+    const clientId = crypto.randomBytes(8).toString('hex');
+    this.clientIds.set(ws, clientId);
+    this.clientIps.set(ws, normalizedIp);
+    const traffic = this.traffic.client(clientId, normalizedIp);
+    this.mirror?.opened(clientId, normalizedIp);
+    this.queues.set(ws, new OutboundQueue(ws, this.outboundOptions, this.mirror?.meter(clientId, traffic) ?? traffic));
+
+    if (!(ws instanceof ChannelSocket)) socketsGauge.add(1);
+    const via = ws instanceof IpcSocket ? ' (ipc)' : ws instanceof ChannelSocket ? ` (channel ${ws.id})` : '';
+    logger.info(`Client connected: ${clientId} from ${normalizedIp}${via}`);
+
+    ws.on('message', (data: Buffer | string) => {
+      // The trace context is inside the message, so the span starts retroactively
+      const received = tracer.now();
+      const frame = data.toString();
+      // Channel frames are handled by that channel's own attachClient
+      if (!(ws instanceof ChannelSocket) && frame.startsWith('{"channel":') && this.muxFor(ws, normalizedIp).route(frame)) return;
+      this.mirror?.inbound(clientId, frame);
+
+      const start = performance.now();
+      let message: ClientMessage;
+      try {
+        message = JSON.parse(frame);
+      } catch (error) {
+        logger.error('Failed to parse message', error as Error);
+        traffic.received('INVALID', frame.length, (performance.now() - start) * 1000);
+        return;
+      }
+
+      const span = tracer.root('relay.handleMessage', message.trace, received).arg('type', message.type);
+      tracer.span('parse', received).end();
+      try {
+        this.handleMessage(ws, clientId, message);
+      } catch (error) {
+        logger.error('Failed to handle message', error as Error);
+      } finally {
+        span.end();
+        traffic.session = this.sessionManager.sessionTokenOf(clientId) ?? traffic.session;
+        traffic.received(typeof message?.type === 'string' ? message.type : 'INVALID', frame.length, (performance.now() - start) * 1000);
+      }
+    });
+
+    ws.on('close', () => {
+      logger.info(`Client disconnected: ${clientId}`);
+      if (!(ws instanceof ChannelSocket)) socketsGauge.add(-1);
+      this.sessionManager.removeClient(clientId);
+      this.traffic.disconnected(clientId);
+      this.mirror?.closed(clientId);
+      if (this.standbySockets.delete(ws)) this.replication!.remove(this.queues.get(ws)!);
+      this.clientIds.delete(ws);
+      this.clientIps.delete(ws);
+      this.queues.get(ws)?.dispose();
+      this.queues.delete(ws);
+      this.adminFeed.unsubscribe(ws);
+      this.peerSockets.delete(ws);
+      this.shadowSockets.delete(ws);
+      this.muxes.delete(ws);
+    });
+
+    ws.on('error', (error: Error) => {
+      logger.error(`Socket error for ${clientId}`, error);
+    });
+
+    // If admin connects via WS and sends ADMIN_SUBSCRIBE, they will be added in handleMessage
+
+    // Send welcome
+    this.send(ws, {
+      type: 'CONNECTED',
+      clientId,
+      message: 'Connected to relay server'
+    });
+  }
+
+  /**
+   * Start multiplexing a socket: each channel the client opens becomes a
+   * client of its own (own clientId, role, session and outbound queue)
+   */
+  private muxFor(ws: ClientSocket, normalizedIp: string): ChannelMux {
+    let mux = this.muxes.get(ws);
+    if (!mux) {
+      mux = new ChannelMux(ws, true);
+      mux.on('channel', (channel: ChannelSocket) => {
+        channelsGauge.add(1);
+        this.attachClient(channel, normalizedIp);
+      });
+      mux.on('removed', () => channelsGauge.add(-1));
+      this.muxes.set(ws, mux);
+    }
+    return mux;
+  }
+
+  private handleMessage(ws: ClientSocket, clientId: string, message: ClientMessage): void {
+    // Peer traffic is per command; keep it out of the log
+    if (message.type === 'PEER_FORWARD') {
+      if (!this.peerSockets.has(ws) || !message.sessionToken || !message.target || !message.messageType || !message.data) return;
+      this.federation!.received();
+      this.sessionManager.deliverFromPeer(message.sessionToken, message.target, message.messageType, message.data);
+      return;
+    }
+    if (message.type === 'PEER_LOOKUP') {
+      if (!this.peerSockets.has(ws) || !message.sessionToken || !message.lookupId) return;
+      const owned = this.sessionManager.sessionExists(message.sessionToken);
+      // The asking relay takes the session on: from now on a controller missing here may be there
+      if (owned) this.sessionManager.markFederated(message.sessionToken);
+      this.send(ws, { type: 'PEER_OWNS', lookupId: message.lookupId, owned });
+      return;
+    }
+
+    logger.info(`Message from ${clientId}: ${message.type}`);
+
+    // A standby only serves other standbys until it takes over
+    if (this.isStandby() && message.type !== 'REPL_HELLO' && message.type !== 'REPL_FENCE') {
+      this.send(ws, { type: 'ERROR', message: 'This relay is a standby' });
+      ws.close();
+      return;
+    }
+
+    switch (message.type) {
+      case 'PEER_HELLO':
+        if (!this.federation?.isPeerSecret(message.secret)) {
+          logger.warn(`Rejected peer relay link from ${clientId}`);
+          this.send(ws, { type: 'ERROR', message: 'Federation is not enabled or the secret is wrong' });
+          ws.close();
+          return;
+        }
+        this.peerSockets.add(ws);
+        logger.success(`Peer relay ${message.relayId ?? 'unknown'} linked as ${clientId}`);
+        return;
+
+      case 'SHADOW_HELLO':
+        if (!this.options.canary || !secretMatches(message.secret, this.options.canary.secret)) {
+          logger.warn(`Rejected mirrored client ${clientId}`);
+          this.send(ws, { type: 'ERROR', message: 'This relay is not a canary or the secret is wrong' });
+          ws.close();
+          return;
+        }
+        // IP auto-join pairs by the client's address, not the primary's
+        if (typeof message.ip === 'string') this.clientIps.set(ws, message.ip);
+        this.shadowSockets.add(ws);
+        return;
+
+      case 'REPL_HELLO':
+        if (!this.replication || !secretMatches(message.secret, this.options.replication!.secret)) {
+          logger.warn(`Rejected standby link from ${clientId}`);
+          this.send(ws, { type: 'ERROR', message: 'Replication is not enabled or the secret is wrong' });
+          ws.close();
+          return;
+        }
+        if (typeof message.term === 'number' && message.term > this.term()) {
+          this.stepDown(message.term, `standby ${clientId} follows term ${message.term}`, ws);
+        }
+        if (this.steppedDown) {
+          this.send(ws, { type: 'REPL_FENCED', term: this.term(), primary: this.standbyLink?.primaryUrl });
+          ws.close();
+          return;
+        }
+        this.standbySockets.add(ws);
+        this.replication.add(this.queues.get(ws)!);
+        return;
+
+      case 'REPL_FENCE':
+        // A standby that took over, at the address it knows as its primary's
+        if (!this.replication || !secretMatches(message.secret, this.options.replication!.secret)) {
+          logger.warn(`Rejected replication fence from ${clientId}`);
+          this.send(ws, { type: 'ERROR', message: 'Replication is not enabled or the secret is wrong' });
+          ws.close();
+          return;
+        }
+        if (typeof message.term === 'number' && message.term > this.term()) {
+          this.stepDown(message.term, `${clientId} took over with term ${message.term}`, ws, this.fencerUrl(ws, message));
+        }
+        this.send(ws, { type: 'REPL_FENCED', term: this.term(), primary: this.standbyLink?.primaryUrl });
+        ws.close();
+        return;
+
+      case 'ADMIN_SUBSCRIBE':
+        // Sends the initial sessions list; subscribing again replaces the filter
+        this.adminFeed.subscribe(ws, this.queues.get(ws)!, message.filter);
+        logger.info(`Admin subscribed: ${clientId}${message.filter ? ` ${JSON.stringify(message.filter)}` : ''}`);
+        return;
+
+      case 'ADMIN_UNSUBSCRIBE':
+        this.adminFeed.unsubscribe(ws);
+        logger.info(`Admin unsubscribed: ${clientId}`);
+        return;
+      case 'CREATE_SESSION':
+        const createSessionIp = this.clientIps.get(ws) || 'unknown';
+        const created = this.sessionManager.findOrCreateSessionByIp(
+          createSessionIp,
+          this.queues.get(ws)!,
+          clientId,
+          'controller'
+        );
+        if (!created) {
+          this.send(ws, { type: 'ERROR', message: SESSION_LIMIT_MESSAGE });
+          return;
+        }
+        const { token, isNew } = created;
+        
+        this.send(ws, {
+          type: 'SESSION_CREATED',
+          token,
+          message: isNew 
+            ? 'New session created (same IP clients will auto-connect)' 
+            : 'Joined existing session for your IP'
+        });
+        
+        // Auto-join the session
+        const sessionInfo = this.sessionManager.getSessionInfo(token);
+        this.send(ws, {
+          type: 'JOINED',
+          role: 'controller',
+          sessionToken: token,
+          sessionInfo
+        });
+        break;
+
+      case 'JOIN':
+        const clientIp = this.clientIps.get(ws) || 'unknown';
+        
+        // If no token provided, try to auto-join by IP
+        if (!message.sessionToken) {
+          logger.info(`No token provided, attempting auto-join by IP: ${clientIp}`);
+          const role = message.role || 'follower';
+          const autoJoined = this.sessionManager.findOrCreateSessionByIp(
+            clientIp,
+            this.queues.get(ws)!,
+            clientId,
+            role
+          );
+          if (!autoJoined) {
+            this.send(ws, { type: 'ERROR', message: SESSION_LIMIT_MESSAGE });
+            return;
+          }
+          const { token: autoToken, isNew } = autoJoined;
+          
+          if (!isNew) {
+            // Found existing session, auto-joined
+            const sessionInfo = this.sessionManager.getSessionInfo(autoToken);
+            this.send(ws, {
+              type: 'JOINED',
+              role: role,
+              sessionToken: autoToken,
+              sessionInfo,
+              autoJoined: true
+            });
+            break;
+          } else {
+            // New session created (for controller) or no existing session (for follower)
+            if (role === 'controller') {
+              // Controller created new session via auto-join
+              const sessionInfo = this.sessionManager.getSessionInfo(autoToken);
+              this.send(ws, {
+                type: 'JOINED',
+                role: 'controller',
+                sessionToken: autoToken,
+                sessionInfo,
+                autoJoined: true
+              });
+              break;
+            } else {
+              // Follower: No existing session found, need token
+              this.send(ws, { 
+                type: 'ERROR', 
+                message: 'No session found for your IP. Please provide a session token or start controller first.' 
+              });
+              return;
+            }
+          }
+        }
+
+        // Token provided, use normal join flow
+        if (!message.role) {
+          this.send(ws, { type: 'ERROR', message: 'Missing role' });
+          return;
+        }
+
+        // A mirrored client's session was created on the primary
+        const adopt = this.options.adoptUnknownSessions || this.shadowSockets.has(ws);
+        if (!this.sessionManager.sessionExists(message.sessionToken) && adopt &&
+            !this.sessionManager.createSession(message.sessionToken, clientIp)) {
+          this.send(ws, { type: 'ERROR', message: SESSION_LIMIT_MESSAGE });
+          return;
+        }
+
+        // Tokens stay valid across federated relays, but only for sessions a peer actually serves
+        if (!this.sessionManager.sessionExists(message.sessionToken) && this.federation) {
+          const token = message.sessionToken;
+          this.federation.lookup(token).then(owned => {
+            if (!this.queues.has(ws)) return; // gone while the peers answered
+            if (owned && !this.sessionManager.createSession(token, clientIp)) {
+              this.send(ws, { type: 'ERROR', message: SESSION_LIMIT_MESSAGE });
+              return;
+            }
+            if (owned) this.sessionManager.markFederated(token);
+            this.completeJoin(ws, clientId, token, message.role!);
+          });
+          break;
+        }
+
+        this.completeJoin(ws, clientId, message.sessionToken, message.role);
+        break;
+
+      case 'HEARTBEAT':
+        heartbeatCounter.inc();
+        this.sessionManager.updateHeartbeat(clientId);
+        // One heartbeat keeps every channel of a multiplexed socket alive
+        this.muxes.get(ws)?.forEach(channel => this.sessionManager.updateHeartbeat(this.clientIds.get(channel)!));
+        this.send(ws, { type: 'HEARTBEAT_ACK' });
+        break;
+
+      case 'RESTART':
+        const restartId = message.commandId ?? crypto.randomUUID();
+        const sentCount = this.sessionManager.broadcastRestart(clientId, restartId);
+        this.send(ws, {
+          type: 'RESTART_BROADCASTED',
+          sentTo: sentCount,
+          commandId: restartId
+        });
+        break;
+
+      case 'STATUS_UPDATE':
+        if (!message.status) {
+          this.send(ws, { type: 'ERROR', message: 'Missing status' });
+          return;
+        }
+        // Ensure processCount is included (default to 0 if not provided)
+        const statusWithCount = {
+          clientRunning: message.status.clientRunning || false,
+          processCount: message.status.processCount || 0
+        };
+        const statusSent = this.sessionManager.broadcastStatus(clientId, statusWithCount);
+        this.send(ws, {
+          type: 'STATUS_BROADCASTED',
+          sentTo: statusSent
+        });
+        break;
+
+      case 'STATUS_REQUEST':
+        const statusRequested = this.sessionManager.requestStatus(clientId);
+        if (!statusRequested) {
+          this.send(ws, { type: 'ERROR', message: 'Failed to request status' });
+        }
+        break;
+
+      case 'IMMEDIATE_START':
+        const immediateId = message.commandId ?? crypto.randomUUID();
+        const sentImmediate = this.sessionManager.broadcastImmediateStart(clientId, immediateId);
+        this.send(ws, {
+          type: 'IMMEDIATE_START_BROADCASTED',
+          sentTo: sentImmediate,
+          commandId: immediateId
+        });
+        break;
+
+      case 'COMMAND_ACK':
+        if (!message.commandId || (message.stage !== 'received' && message.stage !== 'completed')) {
+          this.send(ws, { type: 'ERROR', message: 'Missing commandId or stage' });
+          return;
+        }
+        this.sessionManager.acknowledgeCommand(clientId, message.commandId, message.stage, message.ok ?? true, message.detail);
+        break;
+
+      case 'GAME_STATUS':
+        // Follower sends game status to controller
+        const gameStatusSent = this.sessionManager.forwardGameStatus(clientId, message.gameRunning ?? false);
+        if (gameStatusSent) {
+          this.send(ws, {
+            type: 'GAME_STATUS_RECEIVED',
+            message: 'Game status forwarded to controller'
+          });
+        } else {
+          this.send(ws, {
+            type: 'ERROR',
+            message: 'Failed to forward game status to controller'
+          });
+        }
+        break;
+
+        // other non-handled messages fall through to default below
+
+      default:
+        logger.warn(`Unknown message type: ${message.type}`);
+    }
+  }
+
+  private isStandby(): boolean {
+    return this.steppedDown || !!this.standbyLink?.standby;
+  }
+
+  /**
+   * Highest replication term this relay knows of
+   */
+  private term(): number {
+    return Math.max(this.replication?.term ?? 0, this.standbyLink?.term ?? 0);
+  }
+
+  private stateFile(): string {
+    return this.options.replication!.stateFile ?? `replication-${this.port}.json`;
+  }
+
+  private saveReplicationState(): void {
+    saveReplicationState(this.stateFile(), {
+      term: this.term(),
+      standbyOf: this.standbyLink?.primaryUrl ?? null,
+      fence: this.standbyLink ? undefined : this.fencer?.url
+    });
+  }
+
+  /**
+   * Follow primaryUrl: refuse clients until the link takes over from it
+   */
+  private createStandbyLink(primaryUrl: string): StandbyLink {
+    return new StandbyLink(this.sessionManager, this.options.replication!, primaryUrl, this.term(), term => {
+      this.replication!.term = term;
+      this.standbyLink = undefined;
+      this.startFencer(primaryUrl);
+      this.saveReplicationState();
+      logger.success('Now serving clients');
+    }, (term, primary) => {
+      this.standbyLink = undefined; // stopped itself
+      this.stepDown(term, 'the primary stepped down', undefined, primary);
+    });
+  }
+
+  private startFencer(url: string): void {
+    this.fencer = new Fencer(url, this.options.replication!, { term: () => this.term(), port: this.address() }, term => {
+      this.stepDown(term, `${url} took over later`, undefined, url);
+    });
+    this.fencer.start();
+  }
+
+  /**
+   * Where the relay sending REPL_FENCE is reached: its advertised URL, or
+   * its address as seen here with the port it reports
+   */
+  private fencerUrl(ws: ClientSocket, message: ClientMessage): string | undefined {
+    if (typeof message.url === 'string') return message.url;
+    const ip = this.clientIps.get(ws);
+    if (!ip || typeof message.port !== 'number') return undefined;
+    return `${this.options.tls ? 'wss' : 'ws'}://${ip.includes(':') ? `[${ip}]` : ip}:${message.port}`;
+  }
+
+  /**
+   * Another relay serves a higher term: drop the connected clients (except
+   * the socket reporting it), so they move to that relay, and follow it as
+   * its standby when its URL is known. Without one, clients are refused
+   * until a restart.
+   */
+  private stepDown(term: number, reason: string, reporter?: ClientSocket, follow?: string): void {
+    this.standbyLink?.observe(term);
+    this.replication!.term = Math.max(this.replication!.term, term);
+    if (this.steppedDown || (this.standbyLink && (!follow || this.standbyLink.primaryUrl === follow))) return;
+    logger.error(`Stepping down, ${reason}${follow ? `: following ${follow}` : ': refusing clients until restarted'}`);
+    this.fencer?.stop();
+    this.fencer = undefined;
+    this.standbyLink?.stop();
+    this.standbyLink = undefined;
+    this.replication!.stepDown(term, follow); // tells the standbys, whose sockets close from their side
+    this.clientIds.forEach((_, ws) => {
+      if (ws !== reporter && !this.standbySockets.has(ws)) ws.terminate();
+    });
+    if (follow) {
+      this.standbyLink = this.createStandbyLink(follow);
+      this.standbyLink.connect();
+    } else {
+      this.steppedDown = true;
+    }
+    this.saveReplicationState();
+  }
+
+  /**
+   * Join a session this relay has, answering JOINED or ERROR
+   */
+  private completeJoin(ws: ClientSocket, clientId: string, token: string, role: 'controller' | 'follower'): void {
+    if (!this.sessionManager.sessionExists(token)) {
+      this.send(ws, { type: 'ERROR', message: 'Session not found' });
+      return;
+    }
+
+    const joined = this.sessionManager.joinSession(token, this.queues.get(ws)!, clientId, role);
+    if (joined) {
+      const sessionInfo = this.sessionManager.getSessionInfo(token);
+      this.send(ws, {
+        type: 'JOINED',
+        role,
+        sessionToken: token,
+        sessionInfo
+      });
+    } else {
+      this.send(ws, { type: 'ERROR', message: 'Failed to join session' });
+    }
+  }
+
+  private send(ws: ClientSocket, data: any): void {
+    this.queues.get(ws)?.send(data);
+  }
+
+  async start(): Promise<void> {
+    const host = this.options.host ?? '0.0.0.0';
+    const http = this.options.tls ? 'https' : 'http';
+    const ws = this.options.tls ? 'wss' : 'ws';
+    const settings = { ...DEFAULT_TRANSPORT_SETTINGS, ...this.options.transport };
+
+    const transport = await createTransport(settings.engine, {
+      port: this.port,
+      host,
+      tls: this.options.tls,
+      compression: this.compression,
+      idleTimeoutSec: settings.idleTimeoutSec,
+      onRequest: this.handleRequest
+    });
+    transport.on('connection', (socket: ClientSocket, ip: string) => this.attachClient(socket, ip));
+    await transport.listen();
+    this.transport = transport;
+
+    logger.success(`Relay server started on port ${this.address()}${this.options.tls ? ' (TLS)' : ''} (${transport.engine} engine)`);
+    logger.info('Endpoints:');
+    logger.info(`  HTTP: ${http}://${host}:${this.address()}/health`);
+    logger.info(`  HTTP: ${http}://${host}:${this.address()}/create-session (POST)`);
+    logger.info(`  HTTP: ${http}://${host}:${this.address()}/metrics`);
+    if (this.profiler) logger.info(`  HTTP: ${http}://${host}:${this.address()}/debug/{cpu,heap,alloc} (token)`);
+    logger.info(`  WS:   ${ws}://${host}:${this.address()}`);
+    this.federation?.start();
+    if (this.standbyLink) {
+      logger.info(`Standby of ${this.standbyLink.primaryUrl}: clients are refused until it takes over`);
+      this.standbyLink.connect();
+    }
+    if (this.fenceUrl) {
+      logger.info(`Took over from ${this.fenceUrl} before the restart (term ${this.term()}): serving, and fencing it`);
+      this.startFencer(this.fenceUrl);
+    }
+
+    if (this.ipcServer) {
+      const ipcPath = this.options.ipcPath!;
+      preparePrivateIpcDir(ipcPath);
+      // A crashed relay leaves its socket file behind; anything else there is not ours to remove
+      if (process.platform !== 'win32' && existsSync(ipcPath)) {
+        if (!lstatSync(ipcPath).isSocket()) throw new Error(`${ipcPath} exists and is not a socket`);
+        unlinkSync(ipcPath);
+      }
+      await new Promise<void>(resolve => this.ipcServer!.listen(ipcPath, resolve));
+      logger.info(`  IPC:  ${ipcPath}`);
+    }
+  }
+
+  /**
+   * Close all client sockets and stop listening
+   */
+  stop(): Promise<void> {
+    this.federation?.stop();
+    this.mirror?.stop();
+    this.replication?.stop();
+    this.standbyLink?.stop();
+    this.fencer?.stop();
+    this.sessionManager.dispose();
+    this.adminFeed.dispose();
+    this.traffic.dispose();
+    this.clientIds.forEach((_, ws) => ws.terminate());
+    this.ipcServer?.close();
+    return this.transport?.close() ?? Promise.resolve();
+  }
+
+  /**
+   * Bound port (useful when started with port 0)
+   */
+  address(): number {
+    return this.transport?.address() ?? this.port;
+  }
+}
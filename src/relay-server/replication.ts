@@ -0,0 +1,417 @@
+import WebSocket from 'ws';
+import { existsSync, readFileSync, renameSync, writeFileSync } from 'fs';
+import { Logger } from '../shared/logger.js';
+import { metrics } from '../shared/metrics.js';
+import type { OutboundQueue } from './outbound-queue.js';
+import type { ReplicationOp, SessionManager } from './session-manager.js';
+
+const logger = new Logger('Replication');
+
+export interface ReplicationOptions {
+  secret: string;          // shared by the primary and its standby
+  standbyOf?: string;      // ws(s):// URL of the primary; set on the standby only
+  caFile?: string;         // extra CA for a primary with a self-signed certificate
+  heartbeatMs?: number;    // primary pings its standbys this often (default 250)
+  timeoutMs?: number;      // standby reconnects after this long without a frame, and takes over if that fails too (default 5000)
+  resumeGraceMs?: number;  // after taking over: how long sessions wait to be rejoined (default 60000)
+  stateFile?: string;      // term and role, kept across restarts (default ./replication-<port>.json)
+  advertiseUrl?: string;   // ws(s):// URL other relays reach this one at (default: its address as they see it)
+}
+
+/**
+ * What a relay has become, kept on disk so a restart (pm2) neither forgets
+ * a takeover nor goes back to following a primary that has stepped down.
+ * Once written it wins over standbyOf.
+ */
+export interface ReplicationState {
+  term: number;
+  standbyOf: string | null; // primary followed; null while serving
+  fence?: string;           // while serving: the replaced primary's address, still told of the term
+}
+
+export function loadReplicationState(file: string): ReplicationState | undefined {
+  if (!existsSync(file)) return undefined;
+  try {
+    const state = JSON.parse(readFileSync(file, 'utf-8'));
+    if (typeof state.term === 'number' && (state.standbyOf === null || typeof state.standbyOf === 'string')) return state;
+  } catch {
+    // fall through
+  }
+  logger.warn(`Ignoring replication state file ${file}`);
+  return undefined;
+}
+
+export function saveReplicationState(file: string, state: ReplicationState): void {
+  try {
+    // Written aside and renamed, so a crash mid-write can't leave half a file
+    writeFileSync(`${file}.tmp`, JSON.stringify(state));
+    renameSync(`${file}.tmp`, file);
+  } catch (error) {
+    logger.error(`Failed to persist replication state to ${file}`, error as Error);
+  }
+}
+
+const opsCounter = metrics.counter('relay.replication.ops');
+const framesCounter = metrics.counter('relay.replication.frames');
+const standbysGauge = metrics.gauge('relay.replication.standbys');
+const appliedCounter = metrics.counter('relay.replication.applied');
+const promotedCounter = metrics.counter('relay.replication.promoted');
+const lagHistogram = metrics.histogram('relay.replication.lag_ms');
+const termGauge = metrics.gauge('relay.replication.term');
+const steppedDownCounter = metrics.counter('relay.replication.stepped_down');
+
+/**
+ * Primary side: streams every SessionManager mutation to the standbys
+ * linked to it. A new standby first gets a snapshot. Ops are batched per
+ * event-loop turn (one REPL_OPS frame), except commands, which go out
+ * before the relay answers the controller: a command the controller saw
+ * confirmed is on its way to the standby.
+ *
+ * term counts takeovers: a standby that takes over serves term + 1, and a
+ * relay that hears of a term above its own steps down (see StandbyLink).
+ */
+export class ReplicationSource {
+  term: number = 0;
+  private standbys: Set<OutboundQueue> = new Set();
+  private batch: ReplicationOp[] = [];
+  private flushScheduled: boolean = false;
+  private heartbeat: NodeJS.Timeout;
+
+  constructor(private sessionManager: SessionManager, options: ReplicationOptions) {
+    sessionManager.setReplicator(op => this.publish(op));
+    this.heartbeat = setInterval(() => {
+      if (this.standbys.size === 0) return;
+      const data = JSON.stringify({ type: 'REPL_PING', sentAt: Date.now() });
+      this.standbys.forEach(outbound => outbound.enqueue('REPL_PING', data));
+    }, options.heartbeatMs ?? 250);
+    this.heartbeat.unref();
+  }
+
+  add(outbound: OutboundQueue): void {
+    this.flush(); // ops so far belong before the snapshot, not after it
+    const ops = this.sessionManager.replicationSnapshot();
+    outbound.enqueue('REPL_SNAPSHOT', JSON.stringify({ type: 'REPL_SNAPSHOT', sentAt: Date.now(), term: this.term, ops }));
+    this.standbys.add(outbound);
+    standbysGauge.set(this.standbys.size);
+    logger.success(`Standby linked, sent a snapshot of ${ops.length} op(s)`);
+  }
+
+  /**
+   * A relay with a higher term took over: stop streaming, and tell the
+   * standbys so they neither follow this relay nor take over from it
+   */
+  stepDown(term: number, primary?: string): void {
+    this.term = Math.max(this.term, term);
+    termGauge.set(this.term);
+    steppedDownCounter.inc();
+    const data = JSON.stringify({ type: 'REPL_FENCED', term: this.term, primary });
+    this.standbys.forEach(outbound => outbound.enqueue('REPL_FENCED', data));
+    this.standbys.clear();
+    standbysGauge.set(0);
+  }
+
+  remove(outbound: OutboundQueue): void {
+    if (!this.standbys.delete(outbound)) return;
+    standbysGauge.set(this.standbys.size);
+    logger.warn('Standby link closed');
+  }
+
+  private publish(op: ReplicationOp): void {
+    if (this.standbys.size === 0) return;
+    this.batch.push(op);
+    opsCounter.inc();
+    if (op.op === 'command') {
+      this.flush();
+    } else if (!this.flushScheduled) {
+      this.flushScheduled = true;
+      setImmediate(() => this.flush());
+    }
+  }
+
+  private flush(): void {
+    this.flushScheduled = false;
+    if (this.batch.length === 0) return;
+    const data = JSON.stringify({ type: 'REPL_OPS', sentAt: Date.now(), ops: this.batch });
+    this.batch = [];
+    framesCounter.inc();
+    this.standbys.forEach(outbound => outbound.enqueue('REPL_OPS', data));
+  }
+
+  stop(): void {
+    clearInterval(this.heartbeat);
+  }
+}
+
+/**
+ * Standby side: the link to the primary. Applies the snapshot and ops to
+ * the local SessionManager. Takes over (onPromote) only when the link is
+ * lost and one immediate reconnect fails too; a link silent for timeoutMs
+ * (not even a ping) counts as lost. Until it has had a snapshot it only
+ * keeps retrying: a standby started before its primary never takes over
+ * on its own.
+ *
+ * After taking over it serves the primary's term + 1 (see Fencer). A
+ * primary that has stepped down answers REPL_FENCED, naming the relay it
+ * follows now if any: the link stops and never takes over (onStepDown).
+ */
+export class StandbyLink {
+  private ws?: WebSocket;
+  private synced: boolean = false;   // a snapshot arrived on some link
+  private retrying: boolean = false; // the link dropped, this is the one reconnect attempt
+  private promoted: boolean = false;
+  private stopped: boolean = false;
+  private currentTerm: number = 0;
+  private watchdog?: NodeJS.Timeout;
+  private reconnectTimer?: NodeJS.Timeout;
+  private timeoutMs: number;
+  private waiters: Array<() => void> = []; // settled() callers
+
+  constructor(
+    private sessionManager: SessionManager,
+    private options: ReplicationOptions,
+    readonly primaryUrl: string,
+    term: number,
+    private onPromote: (term: number) => void,
+    private onStepDown: (term: number, primary?: string) => void
+  ) {
+    this.timeoutMs = options.timeoutMs ?? 5000;
+    this.currentTerm = term;
+  }
+
+  /**
+   * Highest term seen: the primary's while following, its own after taking over
+   */
+  get term(): number {
+    return this.currentTerm;
+  }
+
+  /**
+   * Another relay reported a higher term
+   */
+  observe(term: number): void {
+    this.currentTerm = Math.max(this.currentTerm, term);
+  }
+
+  /**
+   * Still following a primary (not taken over)
+   */
+  get standby(): boolean {
+    return !this.promoted;
+  }
+
+  /**
+   * Resolves once the link is not in doubt: clients that just lost the
+   * primary ask the standby whether it took over (GET /health), and the
+   * answer should not be "standby" just because it has not decided yet
+   */
+  settled(): Promise<void> {
+    if (!this.retrying || this.promoted || this.stopped) return Promise.resolve();
+    return new Promise(resolve => this.waiters.push(resolve));
+  }
+
+  connect(): void {
+    const ws = new WebSocket(this.primaryUrl, {
+      ca: this.options.caFile ? readFileSync(this.options.caFile) : undefined,
+      handshakeTimeout: this.timeoutMs
+    });
+    this.ws = ws;
+
+    ws.on('open', () => {
+      ws.send(JSON.stringify({ type: 'REPL_HELLO', secret: this.options.secret, term: this.currentTerm }));
+      this.arm();
+    });
+
+    ws.on('message', (data: Buffer) => {
+      let message: any;
+      try {
+        message = JSON.parse(data.toString());
+      } catch (error) {
+        // Nothing after a bad frame can be trusted to apply in order: drop the link
+        logger.error('Failed to parse a frame from the primary', error as Error);
+        ws.terminate();
+        return;
+      }
+      this.arm();
+      if (typeof message.sentAt === 'number') lagHistogram.record(Date.now() - message.sentAt);
+
+      switch (message.type) {
+        case 'REPL_SNAPSHOT':
+          if (typeof message.term === 'number') this.observe(message.term);
+          this.resync(message.ops);
+          if (this.retrying) logger.success('Primary is back, following it again');
+          this.synced = true;
+          this.retrying = false;
+          this.settle();
+          return;
+        case 'REPL_OPS':
+          message.ops.forEach((op: ReplicationOp) => this.sessionManager.applyReplicated(op));
+          appliedCounter.inc(message.ops.length);
+          return;
+        case 'REPL_FENCED':
+          // The primary stepped down for a newer term: that relay's standby took over, not this one
+          logger.error(`Primary stepped down (term ${message.term}); no longer following it or taking over`);
+          this.stepDown(message.term, typeof message.primary === 'string' ? message.primary : undefined);
+          return;
+        case 'ERROR':
+          logger.error(`Primary refused the standby link: ${message.message}`);
+          return;
+      }
+    });
+
+    ws.on('close', () => {
+      if (this.ws !== ws) return;
+      this.disarm();
+      if (this.stopped || this.promoted) return;
+      if (!this.synced) {
+        this.reconnectTimer = setTimeout(() => this.connect(), 1000);
+        return;
+      }
+      if (this.retrying) {
+        this.promote('primary unreachable');
+        return;
+      }
+      // One immediate attempt tells a dropped link from a primary that is gone
+      logger.warn('Lost the link to the primary, reconnecting once...');
+      this.retrying = true;
+      this.connect();
+    });
+
+    ws.on('error', (error: Error) => {
+      logger.warn(`Primary ${this.primaryUrl}: ${error.message}`);
+    });
+  }
+
+  stop(): void {
+    this.stopped = true;
+    this.settle();
+    this.disarm();
+    if (this.reconnectTimer) clearTimeout(this.reconnectTimer);
+    this.ws?.terminate();
+  }
+
+  /**
+   * A relay with a higher term exists: stop following and never take over
+   */
+  private stepDown(term: number, primary?: string): void {
+    if (this.stopped) return;
+    this.observe(term);
+    this.stop();
+    this.onStepDown(this.currentTerm, primary);
+  }
+
+  /**
+   * A new snapshot replaces everything replicated so far
+   */
+  private resync(ops: ReplicationOp[]): void {
+    const tokens = new Set(ops.filter(op => op.op === 'session').map(op => op.token));
+    this.sessionManager.getAllSessions()
+      .filter(session => !tokens.has(session.token))
+      .forEach(session => this.sessionManager.applyReplicated({ op: 'session_removed', token: session.token }));
+    ops.forEach(op => this.sessionManager.applyReplicated(op));
+    appliedCounter.inc(ops.length);
+    logger.success(`Synced ${tokens.size} session(s) from the primary`);
+  }
+
+  private settle(): void {
+    this.waiters.splice(0).forEach(resolve => resolve());
+  }
+
+  private arm(): void {
+    this.disarm();
+    if (!this.synced && !this.retrying) return;
+    const ws = this.ws;
+    this.watchdog = setTimeout(() => {
+      logger.warn(`Nothing from the primary for ${this.timeoutMs}ms`);
+      ws?.terminate(); // the close handler reconnects, and takes over only if that fails too
+    }, this.timeoutMs);
+  }
+
+  private disarm(): void {
+    if (this.watchdog) clearTimeout(this.watchdog);
+    this.watchdog = undefined;
+  }
+
+  private promote(reason: string): void {
+    if (this.promoted) return;
+    this.promoted = true;
+    this.disarm();
+    const ws = this.ws;
+    this.ws = undefined;
+    ws?.terminate();
+    this.currentTerm++;
+    termGauge.set(this.currentTerm);
+    promotedCounter.inc();
+    logger.warn(`Taking over from the primary (${reason}), term ${this.currentTerm}`);
+    this.sessionManager.resume(this.options.resumeGraceMs ?? 60000);
+    this.onPromote(this.currentTerm);
+    this.settle();
+  }
+}
+
+/**
+ * Serving side of a takeover: tells whatever answers at the replaced
+ * primary's address about this relay's term every timeoutMs (REPL_FENCE),
+ * with the URL to reach this relay at. A primary that was only cut off, or
+ * comes back, steps down and follows this relay instead of serving
+ * alongside it. If the relay there answers with a higher term, this one is
+ * the stale one (onHigherTerm).
+ */
+export class Fencer {
+  private ws?: WebSocket;
+  private timer?: NodeJS.Timeout;
+  private stopped: boolean = false;
+  private timeoutMs: number;
+
+  constructor(
+    readonly url: string,
+    private options: ReplicationOptions,
+    private self: { term: () => number; port: number },
+    private onHigherTerm: (term: number) => void
+  ) {
+    this.timeoutMs = options.timeoutMs ?? 5000;
+  }
+
+  start(): void {
+    if (this.stopped || this.ws) return;
+    const ws = new WebSocket(this.url, {
+      ca: this.options.caFile ? readFileSync(this.options.caFile) : undefined,
+      handshakeTimeout: this.timeoutMs
+    });
+    this.ws = ws;
+
+    ws.on('open', () => ws.send(JSON.stringify({
+      type: 'REPL_FENCE',
+      secret: this.options.secret,
+      term: this.self.term(),
+      url: this.options.advertiseUrl,
+      port: this.self.port
+    })));
+    ws.on('message', (data: Buffer) => {
+      let message: any;
+      try {
+        message = JSON.parse(data.toString());
+      } catch {
+        message = undefined;
+      }
+      ws.close();
+      if (message?.type === 'REPL_FENCED' && typeof message.term === 'number' && message.term > this.self.term()) {
+        // That relay took over later than this one did
+        logger.error(`${this.url} serves term ${message.term}, above this relay's ${this.self.term()}`);
+        this.stop();
+        this.onHigherTerm(message.term);
+      }
+    });
+    ws.on('close', () => {
+      this.ws = undefined;
+      if (this.stopped) return;
+      this.timer = setTimeout(() => this.start(), this.timeoutMs);
+    });
+    ws.on('error', () => {}); // the old primary is usually just gone
+  }
+
+  stop(): void {
+    this.stopped = true;
+    if (this.timer) clearTimeout(this.timer);
+    this.ws?.terminate();
+  }
+}
@@ -1,59 +1,251 @@
 import { Logger } from '../shared/logger.js';
 import EventEmitter from 'events';
 import crypto from 'crypto';
+import { OutboundQueue } from './outbound-queue.js';
+import { CommandTracker, TRACKED_COMMANDS } from './command-tracker.js';
+import type { AckStage, CommandRetryOptions } from './command-tracker.js';
+import { FleetStats, recountFleet } from './fleet-stats.js';
+import type { ControllerStatus, FleetSummary } from './fleet-stats.js';
+import { metrics } from '../shared/metrics.js';
+import { tracer } from '../shared/tracing.js';
 
 interface ClientConnection {
-  ws: any;
+  outbound: OutboundQueue;
   clientId: string;
   role: 'controller' | 'follower';
   connectedAt: number;
   lastHeartbeat: number;
+  gameRunning?: boolean; // follower's last GAME_STATUS
 }
 
 interface Session {
   token: string;
   createdAt: number;
+  lastActivity: number;
+  ownerIp?: string;       // IP that created the session (sessionsByIp key)
+  ips: Set<string>;       // ipToSession keys pointing at this session
   controller?: ClientConnection;
+  status?: ControllerStatus; // controller's last STATUS_UPDATE, cleared when it leaves
   followers: Map<string, ClientConnection>;
+  federated?: boolean;    // a peer relay confirmed it serves this session too (its controller may be there)
 }
 
+export interface SessionLimits {
+  maxAgeMs: number;              // sessions older than this are cleaned up
+  maxOwnerlessSessions: number;  // sessions nobody has joined (e.g. POST /create-session)
+  maxSessionsPerIp: number;      // sessions created from one IP
+}
+
+export const DEFAULT_SESSION_LIMITS: SessionLimits = {
+  maxAgeMs: 24 * 60 * 60 * 1000,
+  maxOwnerlessSessions: 1000,
+  maxSessionsPerIp: 16
+};
+
+/**
+ * One SessionManager mutation, as streamed to a standby relay. Clients
+ * are not replicated (they reconnect); sessions, the IPs that auto-join
+ * them and commands followers have not finished are.
+ */
+export type ReplicationOp =
+  | { op: 'session'; token: string; createdAt: number; ownerIp?: string }
+  | { op: 'ip'; ip: string; token: string }
+  | { op: 'session_removed'; token: string }
+  | { op: 'command'; token: string; commandId: string; type: string; data: string; followers: number }
+  | { op: 'command_done'; token: string; commandId: string };
+
+// Commands kept for redelivery after a failover
+const MAX_REPLAY = 1024;
+
+const sessionGauge = metrics.gauge('relay.sessions.count');
+const ownerlessGauge = metrics.gauge('relay.sessions.ownerless');
+const evictedCounter = metrics.counter('relay.sessions.evicted');
+const refusedCounter = metrics.counter('relay.sessions.refused');
+const replayedCounter = metrics.counter('relay.replication.replayed');
+const unresumedCounter = metrics.counter('relay.replication.unresumed');
+
+/**
+ * Every index entry belongs to exactly one session: clientToSession and
+ * clientToIp through the session's controller/followers, ipToSession through
+ * session.ips and sessionsByIp through session.ownerIp. removeSession drops
+ * all of them together, so cleanup and eviction can't leave orphans behind.
+ */
 export class SessionManager {
   private logger: Logger;
   private emitter: EventEmitter;
+  private limits: SessionLimits;
+  private cleanupTimer: NodeJS.Timeout;
   private sessions: Map<string, Session> = new Map();
   private clientToSession: Map<string, string> = new Map();
   private ipToSession: Map<string, string> = new Map(); // IP -> Session Token
   private clientToIp: Map<string, string> = new Map(); // ClientId -> IP
-
-  constructor() {
+  private sessionsByIp: Map<string, Set<string>> = new Map(); // Creator IP -> Session Tokens
+  private ownerless: Set<string> = new Set(); // Never-joined sessions, least recently used first
+  private forwarder?: (token: string, target: 'followers' | 'controller', type: string, data: string) => void;
+  private replicator?: (op: ReplicationOp) => void;
+  private replay: Map<string, { token: string; commandId: string; type: string; data: string }> = new Map(); // "token:commandId" ->, oldest first
+  private resumeUntil: number = 0; // after a failover: followers joining until then get the replay commands
+  private resumeTimer?: NodeJS.Timeout;
+  private commands: CommandTracker;
+  private fleet: FleetStats = new FleetStats(); // counters follow every session/client/status change
+
+  constructor(limits: Partial<SessionLimits> = {}, retry: Partial<CommandRetryOptions> = {}) {
     this.logger = new Logger('SessionManager');
     this.emitter = new EventEmitter();
+    this.limits = { ...DEFAULT_SESSION_LIMITS, ...limits };
+    this.commands = new CommandTracker(retry);
     
     // Clean up old sessions every 5 minutes
-    setInterval(() => this.cleanupOldSessions(), 5 * 60 * 1000);
+    this.cleanupTimer = setInterval(() => this.cleanupOldSessions(), 5 * 60 * 1000);
+    this.cleanupTimer.unref();
+  }
+
+  /**
+   * Stop the cleanup timer
+   */
+  dispose(): void {
+    clearInterval(this.cleanupTimer);
+    if (this.resumeTimer) clearTimeout(this.resumeTimer);
+    this.commands.dispose();
+  }
+
+  /**
+   * Also hand every session message to this (the relay federation), so
+   * clients of the same session on other relays receive it
+   */
+  setForwarder(forwarder: (token: string, target: 'followers' | 'controller', type: string, data: string) => void): void {
+    this.forwarder = forwarder;
+  }
+
+  /**
+   * Also hand every replicated mutation to this (the replication stream to
+   * standby relays)
+   */
+  setReplicator(replicator: (op: ReplicationOp) => void): void {
+    this.replicator = replicator;
+  }
+
+  /**
+   * Ops that rebuild the current state on a new standby: every session,
+   * its auto-join IPs and the commands some follower has not finished
+   */
+  replicationSnapshot(): ReplicationOp[] {
+    const ops: ReplicationOp[] = [];
+    this.sessions.forEach(session => {
+      ops.push({ op: 'session', token: session.token, createdAt: session.createdAt, ownerIp: session.ownerIp });
+      session.ips.forEach(ip => ops.push({ op: 'ip', ip, token: session.token }));
+    });
+    this.commands.pending().forEach(command => ops.push({ op: 'command', ...command }));
+    return ops;
+  }
+
+  /**
+   * Apply a mutation streamed from the primary (standby relay). Replicated
+   * sessions are not ownerless: their clients are on the primary.
+   */
+  applyReplicated(op: ReplicationOp): void {
+    switch (op.op) {
+      case 'session':
+        if (this.sessions.has(op.token)) return;
+        this.createSession(op.token, op.ownerIp);
+        this.sessions.get(op.token)!.createdAt = op.createdAt;
+        this.ownerless.delete(op.token);
+        ownerlessGauge.set(this.ownerless.size);
+        return;
+      case 'ip':
+        if (this.sessions.has(op.token)) this.bindIp(op.ip, op.token);
+        return;
+      case 'session_removed':
+        this.removeSession(op.token, 'removed on primary');
+        return;
+      case 'command':
+        // Known here too, so the controller re-sending it is not a new command
+        if (!this.commands.has(op.token, op.commandId)) this.commands.begin(op.token, op.commandId, op.type);
+        if (op.followers > 0) this.keepForReplay(op.token, op.commandId, op.type, op.data);
+        return;
+      case 'command_done':
+        this.replay.delete(`${op.token}:${op.commandId}`);
+        return;
+    }
+  }
+
+  /**
+   * This standby took over: for graceMs, followers joining a session are
+   * redelivered the commands the primary had not seen finished (and those
+   * issued here meanwhile); followers drop command IDs they already ran.
+   * Sessions nobody rejoined by then are removed.
+   */
+  resume(graceMs: number): void {
+    this.resumeUntil = Date.now() + graceMs;
+    this.logger.info(`Resuming ${this.sessions.size} replicated session(s), ${this.replay.size} command(s) to redeliver`);
+    if (this.resumeTimer) clearTimeout(this.resumeTimer);
+    this.resumeTimer = setTimeout(() => {
+      this.resumeTimer = undefined;
+      this.replay.clear();
+      this.sessions.forEach((session, token) => {
+        if (session.controller || session.followers.size > 0 || this.ownerless.has(token)) return;
+        this.removeSession(token, 'not resumed after failover');
+        unresumedCounter.inc();
+      });
+    }, graceMs);
+    this.resumeTimer.unref();
+  }
+
+  private keepForReplay(token: string, commandId: string, type: string, data: string): void {
+    if (this.replay.size >= MAX_REPLAY) this.replay.delete(this.replay.keys().next().value!);
+    this.replay.set(`${token}:${commandId}`, { token, commandId, type, data });
+  }
+
+  private replayTo(session: Session, follower: ClientConnection): void {
+    this.replay.forEach(command => {
+      if (command.token !== session.token) return;
+      if (!this.commands.has(command.token, command.commandId)) this.commands.begin(command.token, command.commandId, command.type);
+      this.commands.deliver(command.token, command.commandId, follower.clientId, follower.outbound, command.data);
+      replayedCounter.inc();
+    });
+  }
+
+  /**
+   * Deliver a message forwarded by a peer relay to this relay's clients of
+   * the session; returns how many received it. Never forwarded again.
+   */
+  deliverFromPeer(token: string, target: 'followers' | 'controller', type: string, data: string): number {
+    const session = this.sessions.get(token);
+    if (!session) return 0;
+
+    const recipients = target === 'controller'
+      ? (session.controller ? [session.controller] : [])
+      : [...session.followers.values()];
+
+    // Commands are tracked by the relay each follower is connected to
+    if (target === 'followers' && TRACKED_COMMANDS.has(type)) {
+      const commandId: string | undefined = JSON.parse(data).commandId;
+      if (commandId) {
+        if (!this.commands.begin(token, commandId, type)) return 0;
+        recipients.forEach(client => this.commands.deliver(token, commandId, client.clientId, client.outbound, data));
+        this.commandIssued(session, commandId, type, data, recipients.length);
+        if (recipients.length > 0) this.touch(session);
+        return recipients.length;
+      }
+    }
+    recipients.forEach(client => client.outbound.enqueue(type, data));
+    if (recipients.length > 0) this.touch(session);
+    return recipients.length;
   }
 
   /**
    * Broadcast restart event to followers using a session token (admin/UI action)
    */
-  broadcastRestartByToken(token: string): number {
+  broadcastRestartByToken(token: string, commandId: string = crypto.randomUUID()): number {
     const session = this.sessions.get(token);
     if (!session) return 0;
+    this.touch(session);
 
     this.logger.info(`Admin broadcast: Restart event for session: ${token}`);
 
-    let sentCount = 0;
-    session.followers.forEach((follower) => {
-      try {
-        follower.ws.send(JSON.stringify({
-          type: 'CLIENT_RESTARTED',
-          timestamp: Date.now(),
-          sessionToken: token
-        }));
-        sentCount++;
-      } catch (error) {
-        this.logger.error(`Failed to send to follower ${follower.clientId}`, error as Error);
-      }
+    const sentCount = this.sendCommand(session, 'CLIENT_RESTARTED', commandId, {
+      timestamp: Date.now(),
+      sessionToken: token
     });
 
     this.logger.success(`Admin restart broadcast sent to ${sentCount} follower(s)`);
@@ -63,24 +255,16 @@ export class SessionManager {
   /**
    * Broadcast immediate start command to followers using a session token (admin/UI action)
    */
-  broadcastImmediateStartByToken(token: string): number {
+  broadcastImmediateStartByToken(token: string, commandId: string = crypto.randomUUID()): number {
     const session = this.sessions.get(token);
     if (!session) return 0;
+    this.touch(session);
 
     this.logger.info(`Admin broadcast: Immediate start for session: ${token}`);
 
-    let sentCount = 0;
-    session.followers.forEach((follower) => {
-      try {
-        follower.ws.send(JSON.stringify({
-          type: 'IMMEDIATE_START',
-          timestamp: Date.now(),
-          sessionToken: token
-        }));
-        sentCount++;
-      } catch (error) {
-        this.logger.error(`Failed to send immediate start to follower ${follower.clientId}`, error as Error);
-      }
+    const sentCount = this.sendCommand(session, 'IMMEDIATE_START', commandId, {
+      timestamp: Date.now(),
+      sessionToken: token
     });
 
     this.logger.success(`Admin immediate start sent to ${sentCount} follower(s)`);
@@ -90,21 +274,66 @@ export class SessionManager {
   /**
    * Generate a new session token
    */
-  generateToken(): string {
+  generateToken(ownerIp?: string): string | undefined {
     const token = crypto.randomBytes(16).toString('hex');
-    
+    return this.createSession(token, ownerIp) ? token : undefined;
+  }
+
+  /**
+   * Create a session under a token chosen elsewhere (no-op if it exists).
+   * Used by the controller's LAN relay to mirror its remote session token.
+   * Returns false if ownerIp is at its session limit and every one of its
+   * sessions still has a client connected.
+   */
+  createSession(token: string, ownerIp?: string): boolean {
+    if (this.sessions.has(token)) return true;
+
+    // Past the per-IP cap only sessions nobody is connected to are evicted
+    const owned = ownerIp ? this.sessionsByIp.get(ownerIp) : undefined;
+    const evictable: string[] = [];
+    if (owned && owned.size >= this.limits.maxSessionsPerIp) {
+      evictable.push(...this.idleByAge(owned).slice(0, owned.size - this.limits.maxSessionsPerIp + 1));
+      if (owned.size - evictable.length >= this.limits.maxSessionsPerIp) {
+        refusedCounter.inc();
+        this.logger.warn(`Session limit for ${ownerIp} reached and every session has clients: refusing ${token}`);
+        return false;
+      }
+    }
+
+    // Make room first so the new session is never the one evicted
+    evictable.forEach(evicted => {
+      this.removeSession(evicted, `session limit for ${ownerIp}`);
+      evictedCounter.inc();
+    });
+    while (this.ownerless.size > 0 && this.ownerless.size >= this.limits.maxOwnerlessSessions) {
+      this.removeSession(this.ownerless.values().next().value!, 'ownerless session limit');
+      evictedCounter.inc();
+    }
+
+    const now = Date.now();
     const session: Session = {
       token,
-      createdAt: Date.now(),
+      createdAt: now,
+      lastActivity: now,
+      ownerIp,
+      ips: new Set(),
       followers: new Map()
     };
 
     this.sessions.set(token, session);
+    this.fleet.sessionAdded();
+    this.ownerless.add(token);
+    if (ownerIp) {
+      if (!this.sessionsByIp.has(ownerIp)) this.sessionsByIp.set(ownerIp, new Set());
+      this.sessionsByIp.get(ownerIp)!.add(token);
+    }
+    sessionGauge.set(this.sessions.size);
+    ownerlessGauge.set(this.ownerless.size);
+    this.replicator?.({ op: 'session', token, createdAt: now, ownerIp });
     this.logger.success(`New session created: ${token}`);
-    this.emitter.emit('session_created', this.getSessionInfo(token));
-    this.emitter.emit('activity', { level: 'info', message: `New session created: ${token}`, timestamp: Date.now() });
-    
-    return token;
+    this.emit('session_created', this.getSessionInfo(token));
+    this.emit('activity', { level: 'info', message: `New session created: ${token}`, sessionToken: token, timestamp: Date.now() });
+    return true;
   }
 
   /**
@@ -112,7 +341,7 @@ export class SessionManager {
    */
   joinSession(
     token: string, 
-    ws: any, 
+    outbound: OutboundQueue, 
     clientId: string, 
     role: 'controller' | 'follower'
   ): boolean {
@@ -123,8 +352,19 @@ export class SessionManager {
       return false;
     }
 
+    // A socket re-joining holds one slot in one session, never two
+    const previousToken = this.clientToSession.get(clientId);
+    if (previousToken === token) {
+      if (session.controller?.clientId === clientId) this.setController(session, undefined);
+      this.deleteFollower(session, clientId);
+    } else if (previousToken) {
+      const ip = this.clientToIp.get(clientId);
+      this.removeClient(clientId);
+      if (ip) this.clientToIp.set(clientId, ip);
+    }
+
     const connection: ClientConnection = {
-      ws,
+      outbound,
       clientId,
       role,
       connectedAt: Date.now(),
@@ -134,20 +374,33 @@ export class SessionManager {
     if (role === 'controller') {
       if (session.controller) {
         this.logger.warn(`Controller already exists for session ${token}, replacing...`);
-        session.controller.ws.close();
+        // Drop its index entries now; its close event then finds nothing to clean up
+        this.clientToSession.delete(session.controller.clientId);
+        this.clientToIp.delete(session.controller.clientId);
+        session.controller.outbound.close();
       }
-      session.controller = connection;
+      this.setController(session, connection);
       this.logger.info(`Controller joined session: ${token}`);
-      this.emitter.emit('session_updated', this.getSessionInfo(token));
-      this.emitter.emit('activity', { level: 'info', message: `Controller joined session: ${token}`, timestamp: Date.now() });
+      this.emit('session_updated', this.getSessionInfo(token));
+      this.emit('activity', { level: 'info', message: `Controller joined session: ${token}`, sessionToken: token, timestamp: Date.now() });
     } else {
       session.followers.set(clientId, connection);
+      this.fleet.followerAdded();
+      if (Date.now() < this.resumeUntil) {
+        // After the caller's JOINED reply, so the follower is in the session when the commands arrive
+        queueMicrotask(() => {
+          if (session.followers.get(clientId) === connection) this.replayTo(session, connection);
+        });
+      }
       this.logger.info(`Follower ${clientId} joined session: ${token}`);
-      this.emitter.emit('session_updated', this.getSessionInfo(token));
-      this.emitter.emit('activity', { level: 'info', message: `Follower ${clientId} joined session: ${token}`, timestamp: Date.now() });
+      this.emit('session_updated', this.getSessionInfo(token));
+      this.emit('activity', { level: 'info', message: `Follower ${clientId} joined session: ${token}`, sessionToken: token, timestamp: Date.now() });
     }
 
     this.clientToSession.set(clientId, token);
+    this.ownerless.delete(token);
+    ownerlessGauge.set(this.ownerless.size);
+    this.touch(session);
     return true;
   }
 
@@ -163,48 +416,118 @@ export class SessionManager {
 
     if (session.controller?.clientId === clientId) {
       this.logger.info(`Controller disconnected from session: ${token}`);
-      session.controller = undefined;
-      this.emitter.emit('session_updated', this.getSessionInfo(token));
-      this.emitter.emit('activity', { level: 'info', message: `Controller disconnected: ${clientId} (session ${token})`, timestamp: Date.now() });
+      this.setController(session, undefined);
+      this.emit('session_updated', this.getSessionInfo(token));
+      this.emit('activity', { level: 'info', message: `Controller disconnected: ${clientId} (session ${token})`, sessionToken: token, timestamp: Date.now() });
     } else {
-      session.followers.delete(clientId);
+      this.deleteFollower(session, clientId);
       this.logger.info(`Follower ${clientId} disconnected from session: ${token}`);
-      this.emitter.emit('session_updated', this.getSessionInfo(token));
-      this.emitter.emit('activity', { level: 'info', message: `Follower disconnected: ${clientId} (session ${token})`, timestamp: Date.now() });
+      this.emit('session_updated', this.getSessionInfo(token));
+      this.emit('activity', { level: 'info', message: `Follower disconnected: ${clientId} (session ${token})`, sessionToken: token, timestamp: Date.now() });
     }
 
     this.clientToSession.delete(clientId);
     this.removeIpMapping(clientId);
+    this.commands.dropFollower(clientId);
 
     // Remove session if no clients
     if (!session.controller && session.followers.size === 0) {
-      this.sessions.delete(token);
-      this.logger.info(`Session ${token} removed (no clients)`);
-      this.emitter.emit('session_removed', token);
-      this.emitter.emit('activity', { level: 'info', message: `Session ${token} removed (no clients)`, timestamp: Date.now() });
+      this.removeSession(token, 'no clients');
+    } else {
+      this.touch(session);
     }
   }
 
+  /**
+   * Remove a session together with every index entry it owns
+   */
+  private removeSession(token: string, reason: string): void {
+    const session = this.sessions.get(token);
+    if (!session) return;
+
+    const clients = [...session.followers.values()];
+    if (session.controller) clients.push(session.controller);
+    clients.forEach(client => {
+      this.clientToSession.delete(client.clientId);
+      this.clientToIp.delete(client.clientId);
+      client.outbound.close();
+    });
+
+    session.ips.forEach(ip => {
+      if (this.ipToSession.get(ip) === token) this.ipToSession.delete(ip);
+    });
+    if (session.ownerIp) {
+      const owned = this.sessionsByIp.get(session.ownerIp);
+      owned?.delete(token);
+      if (owned?.size === 0) this.sessionsByIp.delete(session.ownerIp);
+    }
+    this.ownerless.delete(token);
+    this.sessions.delete(token);
+    session.followers.forEach(follower => this.fleet.followerRemoved(follower.gameRunning));
+    this.setController(session, undefined);
+    this.fleet.sessionRemoved();
+    sessionGauge.set(this.sessions.size);
+    ownerlessGauge.set(this.ownerless.size);
+
+    this.replicator?.({ op: 'session_removed', token });
+    this.logger.info(`Session ${token} removed (${reason})`);
+    this.emit('session_removed', token);
+    this.emit('activity', { level: 'info', message: `Session ${token} removed (${reason})`, sessionToken: token, timestamp: Date.now() });
+  }
+
+  /**
+   * Set or clear a session's controller. Its status goes with it: a new
+   * controller reports its own.
+   */
+  private setController(session: Session, controller: ClientConnection | undefined): void {
+    if (session.status && (!controller || session.controller !== controller)) {
+      this.fleet.statusChanged(session.status, undefined);
+      session.status = undefined;
+    }
+    this.fleet.controllerChanged(!!session.controller, !!controller);
+    session.controller = controller;
+  }
+
+  private deleteFollower(session: Session, clientId: string): void {
+    const follower = session.followers.get(clientId);
+    if (!follower) return;
+    session.followers.delete(clientId);
+    this.fleet.followerRemoved(follower.gameRunning);
+  }
+
+  private touch(session: Session): void {
+    session.lastActivity = Date.now();
+    if (this.ownerless.delete(session.token)) this.ownerless.add(session.token);
+  }
+
+  /**
+   * Sessions with no controller or follower connected, least recently used first
+   */
+  private idleByAge(tokens: Set<string>): string[] {
+    return [...tokens]
+      .map(token => this.sessions.get(token)!)
+      .filter(session => !session.controller && session.followers.size === 0)
+      .sort((a, b) => a.lastActivity - b.lastActivity)
+      .map(session => session.token);
+  }
+
   /**
    * Update heartbeat for client
    */
   updateHeartbeat(clientId: string): void {
-    const token = this.clientToSession.get(clientId);
-    if (!token) return;
-
-    const session = this.sessions.get(token);
+    const session = this.sessionOf(clientId);
     if (!session) return;
+    const token = session.token;
 
+    this.touch(session);
     if (session.controller?.clientId === clientId) {
       session.controller.lastHeartbeat = Date.now();
-      this.emitter.emit('session_updated', this.getSessionInfo(token));
-      this.emitter.emit('activity', { level: 'debug', message: `Heartbeat updated for controller ${clientId} in session ${token}`, timestamp: Date.now() });
+      this.emit('traffic', { sessionToken: token, kind: 'heartbeat' });
     } else {
       const follower = session.followers.get(clientId);
       if (follower) {
         follower.lastHeartbeat = Date.now();
-        this.emitter.emit('session_updated', this.getSessionInfo(token));
-        this.emitter.emit('activity', { level: 'debug', message: `Heartbeat updated for follower ${clientId} in session ${token}`, timestamp: Date.now() });
+        this.emit('traffic', { sessionToken: token, kind: 'heartbeat' });
       }
     }
   }
@@ -212,31 +535,20 @@ export class SessionManager {
   /**
    * Broadcast restart event from controller to all followers
    */
-  broadcastRestart(controllerClientId: string): number {
-    const token = this.clientToSession.get(controllerClientId);
-    if (!token) return 0;
-
-    const session = this.sessions.get(token);
+  broadcastRestart(controllerClientId: string, commandId: string = crypto.randomUUID()): number {
+    const session = this.sessionOf(controllerClientId);
     if (!session) return 0;
+    const token = session.token;
 
     this.logger.info(`Broadcasting restart event for session: ${token}`);
 
-    let sentCount = 0;
-    session.followers.forEach((follower) => {
-      try {
-        follower.ws.send(JSON.stringify({
-          type: 'CLIENT_RESTARTED',
-          timestamp: Date.now(),
-          sessionToken: token
-        }));
-        sentCount++;
-      } catch (error) {
-        this.logger.error(`Failed to send to follower ${follower.clientId}`, error as Error);
-      }
+    const sentCount = this.sendCommand(session, 'CLIENT_RESTARTED', commandId, {
+      timestamp: Date.now(),
+      sessionToken: token
     });
 
     this.logger.success(`Restart broadcast sent to ${sentCount} follower(s)`);
-    this.emitter.emit('activity', { level: 'info', message: `Restart broadcast from controller ${controllerClientId} for session ${token}`, timestamp: Date.now() });
+    this.emit('activity', { level: 'info', message: `Restart broadcast from controller ${controllerClientId} for session ${token}`, sessionToken: token, timestamp: Date.now() });
     return sentCount;
   }
 
@@ -244,30 +556,25 @@ export class SessionManager {
    * Broadcast status from controller to all followers
    */
   broadcastStatus(controllerClientId: string, status: { clientRunning: boolean; processCount: number }): number {
-    const token = this.clientToSession.get(controllerClientId);
-    if (!token) return 0;
-
-    const session = this.sessions.get(token);
+    const session = this.sessionOf(controllerClientId);
     if (!session) return 0;
+    const token = session.token;
 
     this.logger.info(`Broadcasting status for session: ${token}`);
+    // Only the controller's own status counts towards the fleet
+    if (session.controller?.clientId === controllerClientId) {
+      const next: ControllerStatus = { clientRunning: !!status.clientRunning, processCount: status.processCount };
+      this.fleet.statusChanged(session.status, next);
+      session.status = next;
+    }
 
-    let sentCount = 0;
-    session.followers.forEach((follower) => {
-      try {
-        follower.ws.send(JSON.stringify({
-          type: 'STATUS_UPDATE',
-          timestamp: Date.now(),
-          status
-        }));
-        sentCount++;
-      } catch (error) {
-        this.logger.error(`Failed to send status to follower ${follower.clientId}`, error as Error);
-      }
+    const sentCount = this.sendToFollowers(session, 'STATUS_UPDATE', {
+      timestamp: Date.now(),
+      status
     });
 
     this.logger.success(`Status sent to ${sentCount} follower(s)`);
-    this.emitter.emit('activity', { level: 'info', message: `Status update from controller ${controllerClientId} for session ${token}`, timestamp: Date.now(), status });
+    this.emit('traffic', { sessionToken: token, kind: 'status' });
     return sentCount;
   }
 
@@ -275,20 +582,17 @@ export class SessionManager {
    * Request status from controller
    */
   requestStatus(followerClientId: string): boolean {
-    const token = this.clientToSession.get(followerClientId);
-    if (!token) return false;
-
-    const session = this.sessions.get(token);
-    if (!session || !session.controller) return false;
+    const session = this.sessionOf(followerClientId);
+    if (!session || !this.canReachController(session)) return false;
+    const token = session.token;
 
     try {
-      session.controller.ws.send(JSON.stringify({
-        type: 'STATUS_REQUEST',
+      this.sendToController(session, 'STATUS_REQUEST', {
         timestamp: Date.now(),
         fromClient: followerClientId
-      }));
+      });
       this.logger.info(`Status request sent to controller for session: ${token}`);
-        this.emitter.emit('activity', { level: 'info', message: `Status request from follower ${followerClientId} forwarded to controller for session ${token}`, timestamp: Date.now() });
+      this.emit('traffic', { sessionToken: token, kind: 'status_request' });
       return true;
     } catch (error) {
       this.logger.error('Failed to send status request', error as Error);
@@ -300,21 +604,23 @@ export class SessionManager {
    * Forward game status from follower to controller
    */
   forwardGameStatus(followerClientId: string, gameRunning: boolean): boolean {
-    const token = this.clientToSession.get(followerClientId);
-    if (!token) return false;
-
-    const session = this.sessions.get(token);
-    if (!session || !session.controller) return false;
+    const session = this.sessionOf(followerClientId);
+    const follower = session?.followers.get(followerClientId);
+    if (follower) {
+      this.fleet.gameStatusChanged(follower.gameRunning, !!gameRunning);
+      follower.gameRunning = !!gameRunning;
+    }
+    if (!session || !this.canReachController(session)) return false;
+    const token = session.token;
 
     try {
-      session.controller.ws.send(JSON.stringify({
-        type: 'GAME_STATUS',
+      this.sendToController(session, 'GAME_STATUS', {
         timestamp: Date.now(),
         fromFollower: followerClientId,
         gameRunning
-      }));
+      });
       this.logger.info(`Game status (${gameRunning ? 'RUNNING' : 'STOPPED'}) forwarded from follower ${followerClientId} to controller for session: ${token}`);
-      this.emitter.emit('activity', { level: 'info', message: `Game status forwarded from follower ${followerClientId} to controller for session ${token}`, timestamp: Date.now() });
+      this.emit('traffic', { sessionToken: token, kind: 'game_status' });
       return true;
     } catch (error) {
       this.logger.error('Failed to forward game status', error as Error);
@@ -325,34 +631,142 @@ export class SessionManager {
   /**
    * Broadcast immediate start command from controller to all followers
    */
-  broadcastImmediateStart(controllerClientId: string): number {
-    const token = this.clientToSession.get(controllerClientId);
-    if (!token) return 0;
-
-    const session = this.sessions.get(token);
+  broadcastImmediateStart(controllerClientId: string, commandId: string = crypto.randomUUID()): number {
+    const session = this.sessionOf(controllerClientId);
     if (!session) return 0;
+    const token = session.token;
 
     this.logger.info(`Broadcasting immediate start command for session: ${token}`);
 
+    const sentCount = this.sendCommand(session, 'IMMEDIATE_START', commandId, {
+      timestamp: Date.now(),
+      sessionToken: token
+    });
+
+    this.logger.success(`Immediate start command sent to ${sentCount} follower(s)`);
+    this.emit('activity', { level: 'info', message: `Immediate start broadcast from controller ${controllerClientId} for session ${token}`, sessionToken: token, timestamp: Date.now() });
+    return sentCount;
+  }
+
+  /**
+   * Serialize a message once and queue it for every follower in the session
+   */
+  private sendToFollowers(session: Session, type: string, fields: Record<string, any>): number {
+    const span = tracer.span('send.followers').arg('followers', session.followers.size);
+    const data = JSON.stringify({ type, ...fields, trace: tracer.context() });
+
     let sentCount = 0;
     session.followers.forEach((follower) => {
+      const send = tracer.span('send.follower');
       try {
-        follower.ws.send(JSON.stringify({
-          type: 'IMMEDIATE_START',
-          timestamp: Date.now(),
-          sessionToken: token
-        }));
+        follower.outbound.enqueue(type, data);
         sentCount++;
       } catch (error) {
-        this.logger.error(`Failed to send immediate start to follower ${follower.clientId}`, error as Error);
+        this.logger.error(`Failed to send ${type} to follower ${follower.clientId}`, error as Error);
       }
+      send.end();
     });
-
-    this.logger.success(`Immediate start command sent to ${sentCount} follower(s)`);
-    this.emitter.emit('activity', { level: 'info', message: `Immediate start broadcast from controller ${controllerClientId} for session ${token}`, timestamp: Date.now() });
+    this.forwarder?.(session.token, 'followers', type, data);
+    span.end();
     return sentCount;
   }
 
+  /**
+   * Send a command with delivery tracking: each follower is redelivered it
+   * until it acks receipt. A command ID the session already issued is not
+   * sent again; the count of the original delivery is returned instead.
+   */
+  private sendCommand(session: Session, type: string, commandId: string, fields: Record<string, any>): number {
+    if (!this.commands.begin(session.token, commandId, type)) {
+      this.logger.info(`Ignoring repeated ${type} ${commandId} for session: ${session.token}`);
+      return this.commands.followerCount(session.token, commandId);
+    }
+
+    const span = tracer.span('send.followers').arg('followers', session.followers.size);
+    const data = JSON.stringify({ type, ...fields, commandId, trace: tracer.context() });
+    session.followers.forEach(follower => {
+      const send = tracer.span('send.follower');
+      this.commands.deliver(session.token, commandId, follower.clientId, follower.outbound, data);
+      send.end();
+    });
+    this.commandIssued(session, commandId, type, data, session.followers.size);
+    this.forwarder?.(session.token, 'followers', type, data);
+    span.end();
+    return session.followers.size;
+  }
+
+  /**
+   * Replicate a tracked command; while resuming after a failover, also
+   * keep it for followers that have not rejoined yet
+   */
+  private commandIssued(session: Session, commandId: string, type: string, data: string, followers: number): void {
+    this.replicator?.({ op: 'command', token: session.token, commandId, type, data, followers });
+    if (Date.now() < this.resumeUntil) this.keepForReplay(session.token, commandId, type, data);
+  }
+
+  /**
+   * A follower acknowledged receipt or completion of a command: report it
+   * to the controller and the admin feed
+   */
+  acknowledgeCommand(followerClientId: string, commandId: string, stage: AckStage, ok: boolean = true, detail?: string): boolean {
+    const session = this.sessionOf(followerClientId);
+    if (!session) return false;
+
+    const result = this.commands.ack(session.token, followerClientId, commandId, stage, ok);
+    if (!result) return false;
+    if (stage === 'completed' && result.completed + result.failed >= result.followers) {
+      this.replicator?.({ op: 'command_done', token: session.token, commandId });
+    }
+
+    if (this.canReachController(session)) {
+      this.sendToController(session, 'COMMAND_ACK', { ...result, ok, detail, timestamp: Date.now() });
+    }
+    this.emit('command_progress', { sessionToken: session.token, ...result, ok, detail });
+    if (stage === 'completed') {
+      this.emit('activity', { level: ok ? 'info' : 'warn', message: `Follower ${followerClientId} ${ok ? 'completed' : 'failed'} ${result.commandType} ${commandId} in ${result.latencyMs}ms${detail ? ` (${detail})` : ''}`, sessionToken: session.token, timestamp: Date.now() });
+    }
+    return true;
+  }
+
+  // With federation the controller may be connected to another relay serving the session
+  private canReachController(session: Session): boolean {
+    return !!session.controller || (!!this.forwarder && !!session.federated);
+  }
+
+  /**
+   * Send to the session's controller, or to the peer relays when it isn't
+   * connected here
+   */
+  private sendToController(session: Session, type: string, fields: Record<string, any>): void {
+    const data = JSON.stringify({ type, ...fields, trace: tracer.context() });
+    if (session.controller) {
+      session.controller.outbound.enqueue(type, data);
+    } else {
+      this.forwarder?.(session.token, 'controller', type, data);
+    }
+  }
+
+  /**
+   * Token of the session a client is in
+   */
+  sessionTokenOf(clientId: string): string | undefined {
+    return this.clientToSession.get(clientId);
+  }
+
+  private sessionOf(clientId: string): Session | undefined {
+    const span = tracer.span('session.lookup');
+    const token = this.clientToSession.get(clientId);
+    const session = token ? this.sessions.get(token) : undefined;
+    span.end();
+    return session;
+  }
+
+  private emit(event: string, payload: any): void {
+    const span = tracer.span('emit').arg('event', event);
+    this.emitter.emit(event, payload);
+    span.end();
+  }
+
   /**
    * Get session info
    */
@@ -372,42 +786,127 @@ export class SessionManager {
     };
   }
 
+  /**
+   * Fleet-wide totals, maintained incrementally (no walk over the sessions)
+   */
+  getFleetSummary(): FleetSummary {
+    return this.fleet.snapshot();
+  }
+
+  /**
+   * Changes since start; lets callers skip unchanged summaries
+   */
+  get fleetVersion(): number {
+    return this.fleet.changes;
+  }
+
   /**
    * Get all sessions
    */
   getAllSessions() {
-    return Array.from(this.sessions.values()).map(session => ({
+    return Array.from(this.sessions.values()).map(session => this.summarize(session));
+  }
+
+  /**
+   * One session in the getAllSessions() shape
+   */
+  getSessionSummary(token: string) {
+    const session = this.sessions.get(token);
+    return session ? this.summarize(session) : null;
+  }
+
+  private summarize(session: Session) {
+    return {
       token: session.token,
       createdAt: session.createdAt,
       hasController: !!session.controller,
       followerCount: session.followers.size
-    }));
+    };
   }
 
   // Admin subscriptions
-  on(event: 'session_created' | 'session_updated' | 'session_removed' | 'activity', fn: (payload: any) => void) {
+  on(event: 'session_created' | 'session_updated' | 'session_removed' | 'activity' | 'command_progress' | 'traffic', fn: (payload: any) => void) {
     this.emitter.on(event, fn);
   }
 
   /**
    * Cleanup old sessions (24 hours)
    */
-  private cleanupOldSessions(): void {
+  cleanupOldSessions(): void {
     const now = Date.now();
-    const maxAge = 24 * 60 * 60 * 1000; // 24 hours
 
     this.sessions.forEach((session, token) => {
-      if (now - session.createdAt > maxAge) {
-        // Close all connections
-        session.controller?.ws.close();
-        session.followers.forEach(f => f.ws.close());
-        
-        this.sessions.delete(token);
-        this.logger.info(`Cleaned up old session: ${token}`);
+      if (now - session.createdAt > this.limits.maxAgeMs) {
+        // Closes all connections and drops the session's index entries
+        this.removeSession(token, 'expired');
       }
     });
   }
 
+  /**
+   * Index sizes plus entries that no longer line up with a live session.
+   * Every orphan count should stay at zero; anything else is a leak.
+   */
+  checkIndexes() {
+    const orphans: string[] = [];
+
+    this.clientToSession.forEach((token, clientId) => {
+      const session = this.sessions.get(token);
+      if (!session || (session.controller?.clientId !== clientId && !session.followers.has(clientId))) {
+        orphans.push(`clientToSession ${clientId} -> ${token}`);
+      }
+    });
+    this.clientToIp.forEach((ip, clientId) => {
+      if (!this.clientToSession.has(clientId)) orphans.push(`clientToIp ${clientId} -> ${ip}`);
+    });
+    this.ipToSession.forEach((token, ip) => {
+      if (!this.sessions.get(token)?.ips.has(ip)) orphans.push(`ipToSession ${ip} -> ${token}`);
+    });
+    this.sessionsByIp.forEach((tokens, ip) => {
+      tokens.forEach(token => {
+        if (this.sessions.get(token)?.ownerIp !== ip) orphans.push(`sessionsByIp ${ip} -> ${token}`);
+      });
+    });
+    this.ownerless.forEach(token => {
+      const session = this.sessions.get(token);
+      if (!session || session.controller || session.followers.size > 0) orphans.push(`ownerless ${token}`);
+    });
+    this.sessions.forEach((session, token) => {
+      const clients = [...session.followers.keys()];
+      if (session.controller) clients.push(session.controller.clientId);
+      clients.forEach(clientId => {
+        if (this.clientToSession.get(clientId) !== token) orphans.push(`session ${token} client ${clientId} not indexed`);
+      });
+    });
+
+    // The incremental fleet counters must match a recount
+    const fleet = this.fleet.snapshot();
+    const recounted = recountFleet([...this.sessions.values()].map(session => ({
+      controller: !!session.controller,
+      status: session.status,
+      followers: [...session.followers.values()].map(follower => follower.gameRunning)
+    }))).snapshot();
+    for (const key of ['sessions', 'withController', 'followers', 'clientRunning', 'processCount', 'gameRunning'] as const) {
+      if (JSON.stringify(fleet[key]) !== JSON.stringify(recounted[key])) {
+        orphans.push(`fleet ${key} ${JSON.stringify(fleet[key])} != ${JSON.stringify(recounted[key])}`);
+      }
+    }
+
+    return {
+      sizes: {
+        sessions: this.sessions.size,
+        ownerless: this.ownerless.size,
+        clientToSession: this.clientToSession.size,
+        clientToIp: this.clientToIp.size,
+        ipToSession: this.ipToSession.size,
+        sessionsByIp: this.sessionsByIp.size
+      },
+      limits: this.limits,
+      orphanCount: orphans.length,
+      orphans: orphans.slice(0, 100)
+    };
+  }
+
   /**
    * Check if session exists
    */
@@ -415,16 +914,26 @@ export class SessionManager {
     return this.sessions.has(token);
   }
 
+  /**
+   * A peer relay serves this session too: messages for a controller that
+   * isn't connected here go to the peers
+   */
+  markFederated(token: string): void {
+    const session = this.sessions.get(token);
+    if (session) session.federated = true;
+  }
+
   /**
    * Find or create session by IP address
-   * If same IP has a controller session, automatically join it
+   * If same IP has a controller session, automatically join it.
+   * Undefined if the IP is at its session limit (see createSession).
    */
   findOrCreateSessionByIp(
     ip: string,
-    ws: any,
+    outbound: OutboundQueue,
     clientId: string,
     role: 'controller' | 'follower'
-  ): { token: string; isNew: boolean } {
+  ): { token: string; isNew: boolean } | undefined {
     // Normalize IP (handle IPv6 mapped IPv4)
     const normalizedIp = ip?.replace(/^::ffff:/, '') || 'unknown';
 
@@ -434,7 +943,7 @@ export class SessionManager {
     if (existingToken && this.sessions.has(existingToken)) {
       // Existing session found, join it
       this.logger.info(`Found existing session for IP ${normalizedIp}: ${existingToken}`);
-      const joined = this.joinSession(existingToken, ws, clientId, role);
+      const joined = this.joinSession(existingToken, outbound, clientId, role);
       if (joined) {
         this.clientToIp.set(clientId, normalizedIp);
         return { token: existingToken, isNew: false };
@@ -442,11 +951,12 @@ export class SessionManager {
     }
 
     // No existing session or join failed, create new one
-    const token = this.generateToken();
-    this.ipToSession.set(normalizedIp, token);
+    const token = this.generateToken(normalizedIp);
+    if (!token) return undefined;
+    this.bindIp(normalizedIp, token);
     this.clientToIp.set(clientId, normalizedIp);
     
-    const joined = this.joinSession(token, ws, clientId, role);
+    const joined = this.joinSession(token, outbound, clientId, role);
     if (joined) {
       this.logger.success(`Created new session for IP ${normalizedIp}: ${token}`);
       return { token, isNew: true };
@@ -455,26 +965,23 @@ export class SessionManager {
     return { token, isNew: true };
   }
 
+  /**
+   * Point an IP at a session for auto-join, moving it off any previous one
+   */
+  private bindIp(ip: string, token: string): void {
+    const previous = this.ipToSession.get(ip);
+    if (previous) this.sessions.get(previous)?.ips.delete(ip);
+    this.ipToSession.set(ip, token);
+    this.sessions.get(token)?.ips.add(ip);
+    this.replicator?.({ op: 'ip', ip, token });
+  }
+
   /**
    * Remove IP mapping when client disconnects
-   * Keep IP mapping if session still exists (for reconnect)
+   * The IP -> session mapping lives as long as the session (for reconnect)
+   * and is dropped by removeSession once the session is empty.
    */
   removeIpMapping(clientId: string): void {
-    const ip = this.clientToIp.get(clientId);
-    if (ip) {
-      const token = this.ipToSession.get(ip);
-      const session = token ? this.sessions.get(token) : null;
-      
-      // Only remove IP mapping if session is completely empty
-      if (session && !session.controller && session.followers.size === 0) {
-        this.ipToSession.delete(ip);
-        this.logger.info(`Removed IP mapping for ${ip} (session empty)`);
-      } else if (session) {
-        // Session still has clients, keep IP mapping for reconnect
-        this.logger.info(`Keeping IP mapping for ${ip} (session has other clients or will be reused)`);
-      }
-      
-      this.clientToIp.delete(clientId);
-    }
+    this.clientToIp.delete(clientId);
   }
 }
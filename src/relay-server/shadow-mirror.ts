@@ -0,0 +1,429 @@
+import WebSocket from 'ws';
+import { readFileSync } from 'fs';
+import { Logger } from '../shared/logger.js';
+import { metrics, Histogram } from '../shared/metrics.js';
+import { TRACKED_COMMANDS } from './command-tracker.js';
+import type { OutboundMeter } from './outbound-queue.js';
+
+const logger = new Logger('ShadowMirror');
+
+export interface MirrorOptions {
+  target: string;             // ws:// or wss:// URL of the canary relay
+  secret: string;             // the canary's canary.secret
+  caFile?: string;            // extra CA for a canary with a self-signed certificate
+  maxBufferedFrames?: number; // frames and deliveries waiting for the next flush before new ones are dropped
+  maxBufferedBytes?: number;  // unsent bytes per canary socket before frames to it are dropped
+}
+
+export interface CanaryOptions {
+  secret: string; // accept SHADOW_HELLO from a primary mirroring with this secret
+}
+
+export interface MirrorReport {
+  target: string;
+  mirrored: number;    // client frames written to the canary
+  dropped: number;     // frames or deliveries not mirrored because a buffer was full
+  clients: number;     // primary clients with a shadow socket, open or recently closed
+  lost: number;        // shadow sockets the canary closed while the client was still on the primary
+  diverged: number;    // clients whose canary copy missed at least one frame
+  overheadMs: number;  // event-loop time spent mirroring and comparing
+  delivered: Record<string, { primary: number; canary: number }>;
+  mismatches: Array<{ clientId: string; type: string; primary: number; canary: number; diverged: boolean }>;
+  latencyMs: Record<string, { primary: ReturnType<Histogram['snapshot']>; canary: ReturnType<Histogram['snapshot']> }>;
+}
+
+const DEFAULT_MAX_BUFFERED_FRAMES = 10_000;
+const DEFAULT_MAX_BUFFERED_BYTES = 1024 * 1024;
+const FLUSH_BATCH = 256;         // entries per event-loop turn; client I/O runs in between
+const MAX_BACKLOG = 256;          // frames for a shadow socket that is still connecting
+const MAX_PENDING_REPLIES = 8;    // per client and request type
+const MAX_COMMANDS = 1024;        // command send times kept for fan-out latency
+const MAX_TOKENS = 4096;          // primary -> canary session token pairs
+const MAX_CLOSED_CLIENTS = 1000;  // closed clients kept for the report
+const MAX_MISMATCHES = 20;
+
+// Direct answers to a client's own request: latency is request -> reply
+const REPLY_TO: Record<string, string> = {
+  JOINED: 'JOIN',
+  SESSION_CREATED: 'CREATE_SESSION',
+  HEARTBEAT_ACK: 'HEARTBEAT',
+  RESTART_BROADCASTED: 'RESTART',
+  IMMEDIATE_START_BROADCASTED: 'IMMEDIATE_START',
+  STATUS_BROADCASTED: 'STATUS_UPDATE',
+  GAME_STATUS_RECEIVED: 'GAME_STATUS'
+};
+const REQUESTS: ReadonlySet<string> = new Set(Object.values(REPLY_TO));
+// Controller commands fanned out to followers: latency is command -> follower delivery
+const COMMANDS: ReadonlySet<string> = new Set(['RESTART', 'IMMEDIATE_START']);
+// Client protocol: the only frames mirrored. A socket that sends anything else (admin,
+// peer, standby or mirror links, some carrying secrets) is excluded from mirroring
+const CLIENT_TYPES: ReadonlySet<string> = new Set([
+  'JOIN', 'HEARTBEAT', 'CREATE_SESSION', 'STATUS_UPDATE', 'STATUS_REQUEST', 'RESTART', 'IMMEDIATE_START', 'GAME_STATUS', 'COMMAND_ACK'
+]);
+
+const mirroredCounter = metrics.counter('relay.mirror.mirrored');
+const droppedCounter = metrics.counter('relay.mirror.dropped');
+const lostCounter = metrics.counter('relay.mirror.lost');
+const linksGauge = metrics.gauge('relay.mirror.links_open');
+const flushHistogram = metrics.histogram('relay.mirror.flush_ms');
+
+// Every frame either relay writes starts with its type; no need to parse the rest
+const typeOf = (frame: string): string => {
+  const type = /^\{"type":"([A-Z_]+)"/.exec(frame)?.[1];
+  if (type) return type;
+  // Not serialized type-first
+  try {
+    const parsed = JSON.parse(frame)?.type;
+    return typeof parsed === 'string' ? parsed : 'INVALID';
+  } catch {
+    return 'INVALID';
+  }
+};
+const commandIdOf = (frame: string): string | undefined => /"commandId":"([^"]+)"/.exec(frame)?.[1];
+
+interface JournalEntry {
+  kind: 'opened' | 'inbound' | 'delivered' | 'closed';
+  clientId: string;
+  at: number;     // performance.now() on the primary
+  data?: string;  // client frame, delivered frame or client IP
+  type?: string;  // delivered
+}
+
+/** What one relay did for one client */
+class LinkSide {
+  delivered: Map<string, number> = new Map();
+  pending: Map<string, number[]> = new Map(); // request type -> when requests still awaiting a reply were handed over
+  token?: string;                             // session the relay last put the client in
+}
+
+/** Relay-wide timing of one relay */
+class Side {
+  delivered: Map<string, number> = new Map();
+  latency: Map<string, Histogram> = new Map();
+  commands: Map<string, number> = new Map(); // commandId -> when the command was handed over
+
+  requested(link: LinkSide, type: string, frame: string, at: number): void {
+    if (REQUESTS.has(type)) {
+      const pending = link.pending.get(type) ?? [];
+      if (pending.length >= MAX_PENDING_REPLIES) pending.shift(); // unanswered (e.g. ERROR instead)
+      pending.push(at);
+      link.pending.set(type, pending);
+    }
+    const commandId = COMMANDS.has(type) ? commandIdOf(frame) : undefined;
+    if (commandId) {
+      if (this.commands.size >= MAX_COMMANDS) this.commands.delete(this.commands.keys().next().value!);
+      this.commands.set(commandId, at);
+    }
+  }
+
+  deliver(link: LinkSide, type: string, frame: string, at: number): void {
+    link.delivered.set(type, (link.delivered.get(type) ?? 0) + 1);
+    this.delivered.set(type, (this.delivered.get(type) ?? 0) + 1);
+
+    let since: number | undefined;
+    if (type in REPLY_TO) since = link.pending.get(REPLY_TO[type])?.shift();
+    else if (TRACKED_COMMANDS.has(type)) since = this.commands.get(commandIdOf(frame) ?? '');
+    if (since !== undefined) {
+      let histogram = this.latency.get(type);
+      if (!histogram) this.latency.set(type, histogram = new Histogram(256));
+      histogram.record(at - since);
+    }
+
+    if (type === 'JOINED' || type === 'SESSION_CREATED') {
+      const message = JSON.parse(frame);
+      link.token = message.sessionToken ?? message.token;
+    }
+  }
+}
+
+/** The canary's copy of one primary client */
+class ShadowLink {
+  ws?: WebSocket;
+  open: boolean = false;
+  backlog: string[] = [];
+  primary: LinkSide = new LinkSide();
+  canary: LinkSide = new LinkSide();
+  excluded: boolean = false; // not a client socket (admin, peer, standby...); not mirrored
+  diverged: boolean = false;
+  closed: boolean = false;   // the client left the primary
+
+  constructor(readonly clientId: string, readonly ip: string) {}
+}
+
+/**
+ * Shadow traffic for a canary relay build. Every frame a client sends to
+ * this (primary) relay is also sent to the canary over a socket of its own,
+ * so the canary sees the same clients, sessions and commands; whatever the
+ * canary sends back is only counted and timed, never delivered. report()
+ * compares what each relay delivered to each client and how fast.
+ *
+ * On the primary path a frame or delivery only costs an array push: the
+ * journal is processed in small batches on later turns of the event loop,
+ * and dropped, not grown, when it is full. A client whose frame was dropped is marked
+ * diverged, since its canary copy may no longer match.
+ */
+export class ShadowMirror {
+  private journal: JournalEntry[] = [];
+  private scheduled: boolean = false;
+  private links: Map<string, ShadowLink> = new Map();
+  private closedLinks: string[] = []; // oldest first
+  private tokens: Map<string, string> = new Map(); // primary session token -> canary session token
+  private primary: Side = new Side();
+  private canary: Side = new Side();
+  private maxFrames: number;
+  private maxBytes: number;
+  private ca?: Buffer;
+  private mirrored: number = 0;
+  private dropped: number = 0;
+  private lost: number = 0;
+  private overheadMs: number = 0;
+  private canaryDown: boolean = false;
+
+  constructor(private options: MirrorOptions) {
+    this.maxFrames = options.maxBufferedFrames ?? DEFAULT_MAX_BUFFERED_FRAMES;
+    this.maxBytes = options.maxBufferedBytes ?? DEFAULT_MAX_BUFFERED_BYTES;
+    this.ca = options.caFile ? readFileSync(options.caFile) : undefined;
+    logger.info(`Mirroring client traffic to canary ${options.target}`);
+  }
+
+  opened(clientId: string, ip: string): void {
+    this.record({ kind: 'opened', clientId, at: performance.now(), data: ip });
+  }
+
+  inbound(clientId: string, frame: string): void {
+    this.record({ kind: 'inbound', clientId, at: performance.now(), data: frame });
+  }
+
+  closed(clientId: string): void {
+    this.record({ kind: 'closed', clientId, at: performance.now() });
+  }
+
+  /**
+   * Wrap a client's outbound meter so the primary's deliveries are compared too
+   */
+  meter(clientId: string, inner: OutboundMeter): OutboundMeter {
+    return {
+      sent: (type, bytes, data) => {
+        inner.sent(type, bytes);
+        this.record({ kind: 'delivered', clientId, at: performance.now(), data, type });
+      }
+    };
+  }
+
+  report(): MirrorReport {
+    const delivered: MirrorReport['delivered'] = {};
+    this.primary.delivered.forEach((count, type) => delivered[type] = { primary: count, canary: 0 });
+    this.canary.delivered.forEach((count, type) => (delivered[type] ??= { primary: 0, canary: 0 }).canary = count);
+
+    const mismatches: MirrorReport['mismatches'] = [];
+    let clients = 0;
+    let diverged = 0;
+    this.links.forEach(link => {
+      if (link.excluded) return;
+      clients++;
+      if (link.diverged) diverged++;
+      new Set([...link.primary.delivered.keys(), ...link.canary.delivered.keys()]).forEach(type => {
+        const primary = link.primary.delivered.get(type) ?? 0;
+        const canary = link.canary.delivered.get(type) ?? 0;
+        if (primary !== canary) mismatches.push({ clientId: link.clientId, type, primary, canary, diverged: link.diverged });
+      });
+    });
+    mismatches.sort((a, b) => Math.abs(b.primary - b.canary) - Math.abs(a.primary - a.canary));
+
+    const latencyMs: MirrorReport['latencyMs'] = {};
+    const empty = new Histogram(1).snapshot();
+    new Set([...this.primary.latency.keys(), ...this.canary.latency.keys()]).forEach(type => {
+      latencyMs[type] = {
+        primary: this.primary.latency.get(type)?.snapshot() ?? empty,
+        canary: this.canary.latency.get(type)?.snapshot() ?? empty
+      };
+    });
+
+    return {
+      target: this.options.target,
+      mirrored: this.mirrored,
+      dropped: this.dropped,
+      clients,
+      lost: this.lost,
+      diverged,
+      overheadMs: Math.round(this.overheadMs * 1000) / 1000,
+      delivered,
+      mismatches: mismatches.slice(0, MAX_MISMATCHES),
+      latencyMs
+    };
+  }
+
+  stop(): void {
+    this.journal = [];
+    this.links.forEach(link => {
+      link.closed = true;
+      link.ws?.terminate();
+    });
+  }
+
+  private record(entry: JournalEntry): void {
+    // opened/closed are bounded by the number of sockets; always keep them so links are not leaked
+    if (this.journal.length >= this.maxFrames && (entry.kind === 'inbound' || entry.kind === 'delivered')) {
+      this.drop(this.links.get(entry.clientId));
+      return;
+    }
+    this.journal.push(entry);
+    if (!this.scheduled) {
+      this.scheduled = true;
+      setImmediate(() => this.flush());
+    }
+  }
+
+  private flush(): void {
+    const start = performance.now();
+    const batch = this.journal.length <= FLUSH_BATCH ? this.journal : this.journal.splice(0, FLUSH_BATCH);
+    if (batch === this.journal) this.journal = [];
+    if (this.journal.length > 0) setImmediate(() => this.flush());
+    else this.scheduled = false;
+    for (const entry of batch) {
+      try {
+        this.apply(entry);
+      } catch (error) {
+        logger.error(`Failed to mirror ${entry.clientId}`, error as Error);
+      }
+    }
+    const elapsed = performance.now() - start;
+    flushHistogram.record(elapsed);
+    this.overheadMs += elapsed;
+  }
+
+  private apply(entry: JournalEntry): void {
+    if (entry.kind === 'opened') {
+      this.links.set(entry.clientId, new ShadowLink(entry.clientId, entry.data!));
+      return;
+    }
+
+    const link = this.links.get(entry.clientId);
+    if (!link) return;
+    if (entry.kind === 'closed') {
+      link.closed = true;
+      link.ws?.terminate();
+      this.retire(link);
+      return;
+    }
+    if (link.excluded) return;
+
+    switch (entry.kind) {
+      case 'inbound': {
+        const type = typeOf(entry.data!);
+        if (type === 'INVALID') return; // the primary only logs it
+        if (!CLIENT_TYPES.has(type)) {
+          this.exclude(link);
+          return;
+        }
+        this.primary.requested(link.primary, type, entry.data!, entry.at);
+        this.forward(link, type === 'JOIN' ? this.rewriteToken(entry.data!) : entry.data!);
+        return;
+      }
+      case 'delivered':
+        if (entry.data === undefined) return;
+        this.primary.deliver(link.primary, entry.type!, entry.data, entry.at);
+        this.pairTokens(link);
+        return;
+    }
+  }
+
+  private forward(link: ShadowLink, frame: string): void {
+    if (!link.ws) this.connect(link);
+    if (!link.open) {
+      if (link.backlog.length < MAX_BACKLOG) link.backlog.push(frame);
+      else this.drop(link);
+      return;
+    }
+    if (link.ws!.bufferedAmount > this.maxBytes) {
+      this.drop(link);
+      return;
+    }
+    this.canary.requested(link.canary, typeOf(frame), frame, performance.now());
+    link.ws!.send(frame);
+    this.mirrored++;
+    mirroredCounter.inc();
+  }
+
+  private connect(link: ShadowLink): void {
+    const ws = new WebSocket(this.options.target, { ca: this.ca });
+    link.ws = ws;
+
+    ws.on('open', () => {
+      if (this.canaryDown) logger.success(`Canary ${this.options.target} is reachable again`);
+      this.canaryDown = false;
+      link.open = true;
+      linksGauge.add(1);
+      ws.send(JSON.stringify({ type: 'SHADOW_HELLO', secret: this.options.secret, ip: link.ip }));
+      const backlog = link.backlog;
+      link.backlog = [];
+      backlog.forEach(frame => this.forward(link, frame));
+    });
+
+    ws.on('message', (data: Buffer) => {
+      const start = performance.now();
+      const frame = data.toString();
+      this.canary.deliver(link.canary, typeOf(frame), frame, start);
+      this.pairTokens(link);
+      this.overheadMs += performance.now() - start;
+    });
+
+    ws.on('close', () => {
+      if (link.open) linksGauge.add(-1);
+      link.open = false;
+      if (link.closed) return;
+      // The canary's state for this client is gone; it is not rebuilt mid-session
+      link.diverged = true;
+      link.excluded = true;
+      this.lost++;
+      lostCounter.inc();
+    });
+
+    ws.on('error', (error: Error) => {
+      if (!this.canaryDown) logger.warn(`Canary ${this.options.target}: ${error.message}`);
+      this.canaryDown = true;
+    });
+  }
+
+  /**
+   * Sessions the canary created itself have tokens of its own; a JOIN with
+   * the primary's token is sent with the canary's instead
+   */
+  private rewriteToken(frame: string): string {
+    if (this.tokens.size === 0) return frame;
+    const message = JSON.parse(frame);
+    const token = message.sessionToken && this.tokens.get(message.sessionToken);
+    if (!token) return frame;
+    message.sessionToken = token;
+    return JSON.stringify(message);
+  }
+
+  private pairTokens(link: ShadowLink): void {
+    const { token: primary } = link.primary;
+    const { token: canary } = link.canary;
+    if (!primary || !canary || primary === canary || this.tokens.get(primary) === canary) return;
+    if (this.tokens.size >= MAX_TOKENS) this.tokens.delete(this.tokens.keys().next().value!);
+    this.tokens.set(primary, canary);
+  }
+
+  private exclude(link: ShadowLink): void {
+    // Whatever it got before identifying itself (CONNECTED) stays out of the totals too
+    link.primary.delivered.forEach((count, type) => this.primary.delivered.set(type, this.primary.delivered.get(type)! - count));
+    link.canary.delivered.forEach((count, type) => this.canary.delivered.set(type, this.canary.delivered.get(type)! - count));
+    link.excluded = true;
+    link.closed = true;
+    link.ws?.terminate();
+  }
+
+  private drop(link?: ShadowLink): void {
+    if (link) link.diverged = true;
+    this.dropped++;
+    droppedCounter.inc();
+  }
+
+  private retire(link: ShadowLink): void {
+    this.closedLinks.push(link.clientId);
+    if (link.excluded) this.links.delete(link.clientId);
+    while (this.closedLinks.length > MAX_CLOSED_CLIENTS) this.links.delete(this.closedLinks.shift()!);
+  }
+}
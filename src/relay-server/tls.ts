@@ -0,0 +1,95 @@
+import { readFileSync, writeFileSync, existsSync, watchFile, unwatchFile } from 'fs';
+import crypto from 'crypto';
+import type { Server as HttpsServer, ServerOptions } from 'https';
+import { Logger } from '../shared/logger.js';
+
+const logger = new Logger('RelayTLS');
+
+export interface RelayTlsOptions {
+  certFile: string;
+  keyFile: string;
+  caFile?: string;
+  sessionTimeout?: number;    // seconds a resumable session stays valid (default 1 hour)
+  reloadIntervalMs?: number;  // poll certificate files for changes; 0 disables hot reload
+  ticketKeyFile?: string;     // persist ticket keys so tickets survive a relay restart
+}
+
+let ticketKeys: Buffer | undefined;
+
+/**
+ * Session ticket keys are loaded once per process and reused on every
+ * certificate reload. With ticketKeyFile set they are also kept on disk, so
+ * clients reconnecting after a pm2 restart still resume their sessions.
+ */
+function getTicketKeys(tls: RelayTlsOptions): Buffer {
+  if (ticketKeys) return ticketKeys;
+
+  if (tls.ticketKeyFile && existsSync(tls.ticketKeyFile)) {
+    const stored = readFileSync(tls.ticketKeyFile);
+    if (stored.length === 48) {
+      ticketKeys = stored;
+      return ticketKeys;
+    }
+    logger.warn(`Ignoring ticket key file ${tls.ticketKeyFile} (expected 48 bytes, got ${stored.length})`);
+  }
+
+  ticketKeys = crypto.randomBytes(48);
+  if (tls.ticketKeyFile) {
+    try {
+      writeFileSync(tls.ticketKeyFile, ticketKeys, { mode: 0o600 });
+    } catch (error) {
+      logger.warn(`Failed to persist ticket keys: ${error instanceof Error ? error.message : String(error)}`);
+    }
+  }
+  return ticketKeys;
+}
+
+function loadCredentials(tls: RelayTlsOptions) {
+  return {
+    cert: readFileSync(tls.certFile),
+    key: readFileSync(tls.keyFile),
+    ca: tls.caFile ? readFileSync(tls.caFile) : undefined
+  };
+}
+
+/**
+ * Build https.Server options: TLS 1.2+ with Node's default AEAD cipher list,
+ * session tickets and a server-side session timeout for resumption.
+ */
+export function createTlsServerOptions(tls: RelayTlsOptions): ServerOptions {
+  return {
+    ...loadCredentials(tls),
+    minVersion: 'TLSv1.2',
+    honorCipherOrder: true,
+    ecdhCurve: 'X25519:prime256v1:secp384r1',
+    sessionTimeout: tls.sessionTimeout ?? 3600,
+    ticketKeys: getTicketKeys(tls)
+  };
+}
+
+/**
+ * Watch certificate files and swap the secure context in place when they
+ * change. Existing connections keep their context; new handshakes (including
+ * resumptions) pick up the new certificate. Returns a stop function.
+ */
+export function watchCertificates(server: HttpsServer, tls: RelayTlsOptions): () => void {
+  const interval = tls.reloadIntervalMs ?? 60000;
+  if (interval <= 0) return () => {};
+
+  const reload = () => {
+    try {
+      server.setSecureContext({ ...createTlsServerOptions(tls) });
+      logger.success(`Reloaded TLS certificate from ${tls.certFile}`);
+    } catch (error) {
+      logger.error('Failed to reload TLS certificate, keeping the previous one', error as Error);
+    }
+  };
+
+  watchFile(tls.certFile, { interval, persistent: false }, reload);
+  watchFile(tls.keyFile, { interval, persistent: false }, reload);
+
+  return () => {
+    unwatchFile(tls.certFile, reload);
+    unwatchFile(tls.keyFile, reload);
+  };
+}
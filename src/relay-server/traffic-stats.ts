@@ -0,0 +1,293 @@
+export type TopDimension = 'bytes' | 'messages' | 'cpu';
+export const TOP_DIMENSIONS: ReadonlySet<string> = new Set(['bytes', 'messages', 'cpu']);
+
+export interface TrafficStatsOptions {
+  windowMs: number; // counts cover roughly the last windowMs
+  buckets: number;  // window slices; the oldest one is cleared as the window slides
+}
+
+export const DEFAULT_TRAFFIC_STATS_OPTIONS: TrafficStatsOptions = {
+  windowMs: 60_000,
+  buckets: 6
+};
+
+// Counters per (message type, bucket) row
+const MESSAGES_IN = 0;
+const BYTES_IN = 1;
+const MESSAGES_OUT = 2;
+const BYTES_OUT = 3;
+const CPU_MICROS = 4; // handling time of received messages
+const FIELDS = 5;
+
+const MAX_UINT32 = 0xffffffff;
+
+// Message types come from clients too; past this many distinct names the rest count as OTHER
+const MAX_TYPES = 64;
+const OTHER = 'OTHER';
+
+export interface TrafficCounts {
+  messagesIn: number;
+  bytesIn: number;
+  messagesOut: number;
+  bytesOut: number;
+  cpuMs: number;
+}
+
+export interface ClientTrafficSummary extends TrafficCounts {
+  clientId: string;
+  ip: string;
+  session?: string;
+  connected: boolean;
+  byType: Record<string, TrafficCounts>;
+}
+
+export interface SessionTrafficSummary extends TrafficCounts {
+  token: string;
+  clients: number;
+}
+
+export interface TopReport {
+  by: TopDimension;
+  windowMs: number;
+  clients: ClientTrafficSummary[];
+  sessions: SessionTrafficSummary[];
+}
+
+const emptyCounts = (): TrafficCounts => ({ messagesIn: 0, bytesIn: 0, messagesOut: 0, bytesOut: 0, cpuMs: 0 });
+
+function score(counts: TrafficCounts, by: TopDimension): number {
+  if (by === 'bytes') return counts.bytesIn + counts.bytesOut;
+  if (by === 'messages') return counts.messagesIn + counts.messagesOut;
+  return counts.cpuMs;
+}
+
+function busiest<T extends TrafficCounts>(list: T[], by: TopDimension, n: number): T[] {
+  return [...list].sort((a, b) => score(b, by) - score(a, by)).slice(0, n);
+}
+
+function addCounts(into: TrafficCounts, from: TrafficCounts): void {
+  into.messagesIn += from.messagesIn;
+  into.bytesIn += from.bytesIn;
+  into.messagesOut += from.messagesOut;
+  into.bytesOut += from.bytesOut;
+  into.cpuMs += from.cpuMs;
+}
+
+/**
+ * One connection's counters: a Uint32Array with a row per message type
+ * seen and bucket. Recording a message is a few array writes; buckets that
+ * slid out of the window are cleared lazily on the next write or read.
+ */
+export class ClientTraffic {
+  session?: string;
+  connected: boolean = true;
+  private types: number[] = []; // type ids, in row order
+  private counts: Uint32Array = new Uint32Array(0);
+  private epoch: number;   // buckets are cleared up to this one
+  lastActive: number;      // epoch of the last recorded message
+
+  constructor(private stats: TrafficStats, readonly clientId: string, readonly ip: string) {
+    this.epoch = stats.epoch;
+    this.lastActive = stats.epoch;
+  }
+
+  received(type: string, bytes: number, micros: number): void {
+    const row = this.row(type);
+    this.add(row + MESSAGES_IN, 1);
+    this.add(row + BYTES_IN, bytes);
+    this.add(row + CPU_MICROS, Math.round(micros));
+  }
+
+  sent(type: string, bytes: number): void {
+    const row = this.row(type);
+    this.add(row + MESSAGES_OUT, 1);
+    this.add(row + BYTES_OUT, bytes);
+  }
+
+  // byType is only filled in with withTypes; ranking needs just the totals
+  summary(withTypes: boolean = true): ClientTrafficSummary {
+    this.roll();
+    const { buckets } = this.stats;
+    const total = emptyCounts();
+    const byType: Record<string, TrafficCounts> = {};
+    if (!withTypes) {
+      const counts = this.counts;
+      for (let row = 0; row < counts.length; row += FIELDS) {
+        total.messagesIn += counts[row + MESSAGES_IN];
+        total.bytesIn += counts[row + BYTES_IN];
+        total.messagesOut += counts[row + MESSAGES_OUT];
+        total.bytesOut += counts[row + BYTES_OUT];
+        total.cpuMs += counts[row + CPU_MICROS];
+      }
+      total.cpuMs = +(total.cpuMs / 1000).toFixed(3);
+      return { clientId: this.clientId, ip: this.ip, session: this.session, connected: this.connected, ...total, byType };
+    }
+    this.types.forEach((typeId, index) => {
+      const counts = emptyCounts();
+      for (let bucket = 0; bucket < buckets; bucket++) {
+        const row = (index * buckets + bucket) * FIELDS;
+        counts.messagesIn += this.counts[row + MESSAGES_IN];
+        counts.bytesIn += this.counts[row + BYTES_IN];
+        counts.messagesOut += this.counts[row + MESSAGES_OUT];
+        counts.bytesOut += this.counts[row + BYTES_OUT];
+        counts.cpuMs += this.counts[row + CPU_MICROS];
+      }
+      counts.cpuMs = +(counts.cpuMs / 1000).toFixed(3);
+      if (counts.messagesIn + counts.messagesOut === 0) return;
+      if (withTypes) byType[this.stats.typeName(typeId)] = counts;
+      addCounts(total, counts);
+    });
+    total.cpuMs = +total.cpuMs.toFixed(3);
+    return { clientId: this.clientId, ip: this.ip, session: this.session, connected: this.connected, ...total, byType };
+  }
+
+  // Offset of the current bucket's row for this type, adding the type if new
+  private row(type: string): number {
+    this.roll();
+    this.lastActive = this.stats.epoch;
+    const typeId = this.stats.typeId(type);
+    let index = this.types.indexOf(typeId);
+    if (index === -1) {
+      index = this.types.length;
+      this.types.push(typeId);
+      const grown = new Uint32Array(this.counts.length + this.stats.buckets * FIELDS);
+      grown.set(this.counts);
+      this.counts = grown;
+    }
+    return (index * this.stats.buckets + this.stats.epoch % this.stats.buckets) * FIELDS;
+  }
+
+  // Saturate instead of wrapping; a full bucket is already an obvious hot spot
+  private add(offset: number, value: number): void {
+    const sum = this.counts[offset] + value;
+    this.counts[offset] = sum > MAX_UINT32 ? MAX_UINT32 : sum;
+  }
+
+  // Clear the buckets the window slid past since this client was last touched
+  private roll(): void {
+    const { epoch, buckets } = this.stats;
+    if (this.epoch === epoch) return;
+    const steps = Math.min(epoch - this.epoch, buckets);
+    for (let step = 1; step <= steps; step++) {
+      const bucket = (this.epoch + step) % buckets;
+      for (let index = 0; index < this.types.length; index++) {
+        const row = (index * buckets + bucket) * FIELDS;
+        this.counts.fill(0, row, row + FIELDS);
+      }
+    }
+    this.epoch = epoch;
+  }
+}
+
+/**
+ * Per-connection traffic accounting over a sliding window: messages and
+ * bytes in/out by type, and handling time. Sessions are aggregated from
+ * their clients when asked, so the message path only touches the client.
+ * Disconnected clients stay listed until their traffic slides out of the
+ * window, so a follower reconnecting in a loop still shows up.
+ */
+export class TrafficStats {
+  readonly windowMs: number;
+  readonly buckets: number;
+  epoch: number = 0;
+  private clients: Map<string, ClientTraffic> = new Map();
+  private typeIds: Map<string, number> = new Map();
+  private typeNames: string[] = [];
+  private timer: NodeJS.Timeout;
+
+  constructor(options: Partial<TrafficStatsOptions> = {}) {
+    this.windowMs = options.windowMs ?? DEFAULT_TRAFFIC_STATS_OPTIONS.windowMs;
+    this.buckets = options.buckets ?? DEFAULT_TRAFFIC_STATS_OPTIONS.buckets;
+    this.typeId(OTHER);
+    this.timer = setInterval(() => this.slide(), this.windowMs / this.buckets);
+    this.timer.unref();
+  }
+
+  /**
+   * Start accounting for a new connection
+   */
+  client(clientId: string, ip: string): ClientTraffic {
+    const client = new ClientTraffic(this, clientId, ip);
+    this.clients.set(clientId, client);
+    return client;
+  }
+
+  /**
+   * The connection closed; its counts age out with the window
+   */
+  disconnected(clientId: string): void {
+    const client = this.clients.get(clientId);
+    if (client) client.connected = false;
+  }
+
+  /**
+   * The n busiest clients and sessions, optionally only within some sessions
+   */
+  top(by: TopDimension, n: number, sessions?: ReadonlySet<string>): TopReport {
+    const totals = this.summarize(sessions);
+    return { by, windowMs: this.windowMs, clients: this.detailed(busiest(totals.clients, by, n)), sessions: busiest(totals.sessions, by, n) };
+  }
+
+  /**
+   * top() for every dimension from one pass over the clients
+   */
+  hotspots(n: number, sessions?: ReadonlySet<string>): Record<TopDimension, TopReport> {
+    const totals = this.summarize(sessions);
+    const report = (by: TopDimension): TopReport =>
+      ({ by, windowMs: this.windowMs, clients: this.detailed(busiest(totals.clients, by, n)), sessions: busiest(totals.sessions, by, n) });
+    return { bytes: report('bytes'), messages: report('messages'), cpu: report('cpu') };
+  }
+
+  typeId(type: string): number {
+    let id = this.typeIds.get(type);
+    if (id === undefined) {
+      if (this.typeNames.length >= MAX_TYPES) return this.typeId(OTHER);
+      id = this.typeNames.length;
+      this.typeNames.push(type);
+      this.typeIds.set(type, id);
+    }
+    return id;
+  }
+
+  typeName(id: number): string {
+    return this.typeNames[id];
+  }
+
+  dispose(): void {
+    clearInterval(this.timer);
+  }
+
+  private summarize(sessions?: ReadonlySet<string>): { clients: ClientTrafficSummary[]; sessions: SessionTrafficSummary[] } {
+    const clients: ClientTrafficSummary[] = [];
+    const bySession: Map<string, SessionTrafficSummary> = new Map();
+    this.clients.forEach(client => {
+      if (sessions && (!client.session || !sessions.has(client.session))) return;
+      const summary = client.summary(false);
+      if (summary.messagesIn + summary.messagesOut === 0) return;
+      clients.push(summary);
+      if (!summary.session) return;
+      let session = bySession.get(summary.session);
+      if (!session) {
+        session = { token: summary.session, clients: 0, ...emptyCounts() };
+        bySession.set(summary.session, session);
+      }
+      session.clients++;
+      addCounts(session, summary);
+    });
+    bySession.forEach(session => { session.cpuMs = +session.cpuMs.toFixed(3); });
+    return { clients, sessions: [...bySession.values()] };
+  }
+
+  // Per-type breakdown for the few clients that made the list
+  private detailed(summaries: ClientTrafficSummary[]): ClientTrafficSummary[] {
+    return summaries.map(summary => this.clients.get(summary.clientId)?.summary() ?? summary);
+  }
+
+  // Advance one bucket and forget disconnected clients with nothing left in the window
+  private slide(): void {
+    this.epoch++;
+    this.clients.forEach((client, clientId) => {
+      if (!client.connected && this.epoch - client.lastActive >= this.buckets) this.clients.delete(clientId);
+    });
+  }
+}
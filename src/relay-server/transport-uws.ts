@@ -0,0 +1,267 @@
+import EventEmitter from 'events';
+import { Writable } from 'stream';
+import { STATUS_CODES } from 'http';
+import type { IncomingMessage, ServerResponse } from 'http';
+import { Logger } from '../shared/logger.js';
+import { ADMIN_PATH } from './compression.js';
+import type { AdminCompressionOptions } from './compression.js';
+import { normalizeIp } from './transport.js';
+import type { RelayTransport, TransportOptions } from './transport.js';
+
+const logger = new Logger('UwsTransport');
+
+// Same numeric states as ws, so callers can compare against WebSocket.OPEN
+const OPEN = 1;
+const CLOSING = 2;
+const CLOSED = 3;
+
+// uWebSockets.js is an optional native dependency without npm types; keep
+// the module name out of static analysis so the ws engine builds without it
+const UWS_MODULE = 'uWebSockets.js';
+
+// The relay's OutboundQueue bounds what it hands over; this only guards against runaway buffers
+const MAX_BACKPRESSURE = 16 * 1024 * 1024;
+const MAX_PAYLOAD = 1024 * 1024;
+
+/**
+ * uWS has no zlib knobs, only presets sized by deflate memory. Pick the
+ * largest one within what the admin options would allocate.
+ */
+function adminCompressor(uws: any, options: AdminCompressionOptions): number {
+  if (!options.enabled) return uws.DISABLED;
+  const bytes = 2 ** (options.windowBits + 2) + 2 ** (options.memLevel + 9);
+  const sizes = [256, 128, 64, 32, 16, 8, 4, 3];
+  const kb = sizes.find(size => size * 1024 <= bytes) ?? 3;
+  return uws[`DEDICATED_COMPRESSOR_${kb}KB`] | uws.DEDICATED_DECOMPRESSOR_1KB;
+}
+
+/**
+ * ws-compatible wrapper around a uWS WebSocket. The native socket is
+ * invalid once closed, so every call checks readyState first.
+ */
+class UwsSocket extends EventEmitter {
+  readyState: number = OPEN;
+  private drainCallbacks: Array<(error?: Error) => void> = [];
+
+  constructor(private ws: any, private compressAbove: number) {
+    super();
+  }
+
+  get bufferedAmount(): number {
+    return this.readyState === OPEN ? this.ws.getBufferedAmount() : 0;
+  }
+
+  send(data: string, cb?: (error?: Error) => void): void {
+    if (this.readyState !== OPEN) {
+      cb?.(new Error('WebSocket is not open'));
+      return;
+    }
+    // 0 = buffered (backpressure), 1 = written, 2 = dropped over maxBackpressure
+    const status = this.ws.send(data, false, data.length >= this.compressAbove);
+    if (!cb) return;
+    if (status === 2) setImmediate(cb, new Error('Send dropped: backpressure limit'));
+    else if (status === 1) setImmediate(cb);
+    else this.drainCallbacks.push(cb);
+  }
+
+  close(): void {
+    if (this.readyState !== OPEN) return;
+    this.readyState = CLOSING;
+    this.ws.end(1000);
+  }
+
+  terminate(): void {
+    if (this.readyState === CLOSED) return;
+    this.readyState = CLOSING;
+    this.ws.close();
+  }
+
+  // Called by the uWS drain handler; each callback re-checks bufferedAmount itself
+  drained(): void {
+    const callbacks = this.drainCallbacks;
+    this.drainCallbacks = [];
+    callbacks.forEach(cb => cb());
+  }
+
+  closed(): void {
+    this.readyState = CLOSED;
+    const callbacks = this.drainCallbacks;
+    this.drainCallbacks = [];
+    callbacks.forEach(cb => cb(new Error('WebSocket closed')));
+    this.emit('close');
+  }
+}
+
+/**
+ * Just enough of ServerResponse for the relay's handlers: setHeader,
+ * writeHead, end, and piping a file into it. The body is collected and
+ * written to uWS in one corked call.
+ */
+class UwsResponse extends Writable {
+  statusCode: number = 200;
+  private headers: Map<string, string> = new Map();
+  private chunks: Buffer[] = [];
+  private aborted: boolean = false;
+
+  constructor(private res: any) {
+    super();
+    res.onAborted(() => {
+      this.aborted = true;
+      this.destroy();
+    });
+  }
+
+  setHeader(name: string, value: string | number): this {
+    this.headers.set(name, String(value));
+    return this;
+  }
+
+  // Headers as an object or the flat [name, value, ...] list http-router.ts pre-builds
+  writeHead(status: number, headers?: Record<string, string> | string[]): this {
+    this.statusCode = status;
+    if (Array.isArray(headers)) {
+      for (let i = 0; i < headers.length; i += 2) this.setHeader(headers[i], headers[i + 1]);
+    } else {
+      Object.entries(headers ?? {}).forEach(([name, value]) => this.setHeader(name, value));
+    }
+    return this;
+  }
+
+  _write(chunk: Buffer | string, _encoding: BufferEncoding, callback: (error?: Error | null) => void): void {
+    this.chunks.push(Buffer.isBuffer(chunk) ? chunk : Buffer.from(chunk));
+    callback();
+  }
+
+  _final(callback: (error?: Error | null) => void): void {
+    if (!this.aborted) {
+      this.res.cork(() => {
+        this.res.writeStatus(`${this.statusCode} ${STATUS_CODES[this.statusCode] ?? ''}`);
+        this.headers.forEach((value, name) => this.res.writeHeader(name, value));
+        this.res.end(Buffer.concat(this.chunks));
+      });
+    }
+    callback();
+  }
+}
+
+/**
+ * Native engine on uWebSockets.js: epoll/kqueue I/O, framing and
+ * permessage-deflate in C++, outside the V8 heap. HTTP requests are passed
+ * to the same handler as the ws engine through small req/res shims.
+ * TLS certificates are read once at start; hot reload and persisted
+ * session tickets are ws-engine features.
+ */
+export class UwsTransport extends EventEmitter implements RelayTransport {
+  readonly engine = 'uws';
+  private listenSocket: any;
+  private port: number;
+  private sockets: Set<UwsSocket> = new Set();
+
+  private constructor(private uws: any, private options: TransportOptions) {
+    super();
+    this.port = options.port;
+  }
+
+  static async create(options: TransportOptions): Promise<UwsTransport> {
+    let uws: any;
+    try {
+      const module: any = await import(UWS_MODULE);
+      uws = module.default ?? module;
+    } catch (error) {
+      throw new Error(`The uws transport engine needs the optional ${UWS_MODULE} dependency: ${error instanceof Error ? error.message : String(error)}`);
+    }
+    return new UwsTransport(uws, options);
+  }
+
+  listen(): Promise<void> {
+    const { tls, compression, idleTimeoutSec } = this.options;
+    const uws = this.uws;
+    if (tls && (tls.reloadIntervalMs !== 0 || tls.ticketKeyFile)) {
+      logger.warn('uws engine: certificate hot reload and ticketKeyFile are not supported; restart the relay to load a new certificate');
+    }
+    const app = tls
+      ? uws.SSLApp({ cert_file_name: tls.certFile, key_file_name: tls.keyFile, ca_file_name: tls.caFile })
+      : uws.App();
+
+    // uWS requires an idle timeout of 0 or at least 8s in steps of 4
+    const idleTimeout = idleTimeoutSec > 0 ? Math.max(8, Math.ceil(idleTimeoutSec / 4) * 4) : 0;
+    const behavior = (compressor: number, compressAbove: number) => ({
+      compression: compressor,
+      maxPayloadLength: MAX_PAYLOAD,
+      maxBackpressure: MAX_BACKPRESSURE,
+      closeOnBackpressureLimit: false,
+      idleTimeout,
+      sendPingsAutomatically: idleTimeout > 0,
+      upgrade: (res: any, req: any, context: any) => {
+        const ip = normalizeIp(Buffer.from(res.getRemoteAddressAsText()).toString());
+        res.upgrade({ ip },
+          req.getHeader('sec-websocket-key'),
+          req.getHeader('sec-websocket-protocol'),
+          req.getHeader('sec-websocket-extensions'),
+          context);
+      },
+      open: (ws: any) => {
+        const socket = new UwsSocket(ws, compressAbove);
+        const data = ws.getUserData();
+        data.socket = socket;
+        this.sockets.add(socket);
+        this.emit('connection', socket, data.ip);
+      },
+      message: (ws: any, message: ArrayBuffer) => {
+        // The ArrayBuffer is only valid during this call; decoding copies it
+        ws.getUserData().socket.emit('message', Buffer.from(message).toString());
+      },
+      drain: (ws: any) => ws.getUserData().socket.drained(),
+      close: (ws: any) => {
+        const socket: UwsSocket = ws.getUserData().socket;
+        this.sockets.delete(socket);
+        socket.closed();
+      }
+    });
+
+    // Compression is negotiated per connection class, chosen by path at upgrade
+    app.ws(ADMIN_PATH, behavior(adminCompressor(uws, compression.admin), compression.admin.threshold));
+    app.ws('/*', behavior(uws.DISABLED, Infinity));
+    app.any('/*', (res: any, req: any) => this.handleRequest(res, req));
+
+    return new Promise((resolve, reject) => {
+      app.listen(this.options.host, this.options.port, (listenSocket: any) => {
+        if (!listenSocket) {
+          reject(new Error(`uws engine failed to listen on ${this.options.host}:${this.options.port}`));
+          return;
+        }
+        this.listenSocket = listenSocket;
+        this.port = uws.us_socket_local_port(listenSocket);
+        resolve();
+      });
+    });
+  }
+
+  address(): number {
+    return this.port;
+  }
+
+  close(): Promise<void> {
+    if (this.listenSocket) this.uws.us_listen_socket_close(this.listenSocket);
+    this.listenSocket = undefined;
+    this.sockets.forEach(socket => socket.terminate());
+    return Promise.resolve();
+  }
+
+  // uWS request objects are only valid synchronously, so copy what the handler reads
+  private handleRequest(res: any, req: any): void {
+    const headers: Record<string, string> = {};
+    req.forEach((name: string, value: string) => {
+      headers[name] = value;
+    });
+    const query = req.getQuery();
+    const request = {
+      url: req.getUrl() + (query ? `?${query}` : ''),
+      method: req.getMethod().toUpperCase(),
+      headers,
+      socket: { remoteAddress: Buffer.from(res.getRemoteAddressAsText()).toString() }
+    };
+    const response = new UwsResponse(res);
+    this.options.onRequest(request as unknown as IncomingMessage, response as unknown as ServerResponse);
+  }
+}
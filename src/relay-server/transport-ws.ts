@@ -0,0 +1,93 @@
+import EventEmitter from 'events';
+import { createServer } from 'http';
+import type { Server as HttpServer } from 'http';
+import { createServer as createHttpsServer } from 'https';
+import type { Server as HttpsServer } from 'https';
+import { WebSocketServer, WebSocket } from 'ws';
+import { createTlsServerOptions, watchCertificates } from './tls.js';
+import { ADMIN_PATH, adminDeflateOptions } from './compression.js';
+import { normalizeIp } from './transport.js';
+import type { RelayTransport, TransportOptions } from './transport.js';
+
+/**
+ * The pure-JS engine: Node's http(s) server with ws on top. Supports
+ * certificate hot reload and persistent session tickets (see tls.ts).
+ */
+export class WsTransport extends EventEmitter implements RelayTransport {
+  readonly engine = 'ws';
+  private httpServer: HttpServer | HttpsServer;
+  private wss: WebSocketServer;
+  private adminWss: WebSocketServer; // ADMIN_PATH, with permessage-deflate
+  private stopCertificateWatch?: () => void;
+  private pingTimer?: NodeJS.Timeout;
+  private alive: WeakSet<WebSocket> = new WeakSet();
+
+  constructor(private options: TransportOptions) {
+    super();
+
+    // Terminate TLS natively when configured, otherwise serve plaintext
+    if (options.tls) {
+      const httpsServer = createHttpsServer(createTlsServerOptions(options.tls), options.onRequest);
+      this.stopCertificateWatch = watchCertificates(httpsServer, options.tls);
+      this.httpServer = httpsServer;
+    } else {
+      this.httpServer = createServer(options.onRequest);
+    }
+
+    // Compression is negotiated per connection class, chosen by path at upgrade
+    this.wss = new WebSocketServer({ noServer: true, perMessageDeflate: false });
+    this.adminWss = new WebSocketServer({ noServer: true, perMessageDeflate: adminDeflateOptions(options.compression.admin) });
+    this.httpServer.on('upgrade', (req, socket, head) => {
+      const wss = req.url?.split('?')[0] === ADMIN_PATH ? this.adminWss : this.wss;
+      wss.handleUpgrade(req, socket, head, ws => {
+        this.alive.add(ws);
+        ws.on('pong', () => this.alive.add(ws));
+        this.emit('connection', ws, normalizeIp(req.socket.remoteAddress));
+      });
+    });
+
+    // ws has no idle timeout of its own: ping every half period, drop sockets that missed one
+    if (options.idleTimeoutSec > 0) {
+      this.pingTimer = setInterval(() => this.pingAll(), options.idleTimeoutSec * 500);
+      this.pingTimer.unref();
+    }
+  }
+
+  listen(): Promise<void> {
+    return new Promise((resolve, reject) => {
+      // EADDRINUSE, EACCES...: the caller's start() rejects instead of the process crashing
+      const fail = (error: Error) => reject(error);
+      this.httpServer.once('error', fail);
+      this.httpServer.listen(this.options.port, this.options.host, () => {
+        this.httpServer.off('error', fail);
+        resolve();
+      });
+    });
+  }
+
+  address(): number {
+    const address = this.httpServer.address();
+    return typeof address === 'object' && address ? address.port : this.options.port;
+  }
+
+  close(): Promise<void> {
+    this.stopCertificateWatch?.();
+    clearInterval(this.pingTimer);
+    [this.wss, this.adminWss].forEach(wss => {
+      wss.clients.forEach(ws => ws.terminate());
+      wss.close();
+    });
+    return new Promise(resolve => this.httpServer.close(() => resolve()));
+  }
+
+  private pingAll(): void {
+    [this.wss, this.adminWss].forEach(wss => wss.clients.forEach(ws => {
+      if (!this.alive.has(ws)) {
+        ws.terminate();
+        return;
+      }
+      this.alive.delete(ws);
+      ws.ping();
+    }));
+  }
+}
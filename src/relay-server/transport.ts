@@ -0,0 +1,72 @@
+import type EventEmitter from 'events';
+import type { IncomingMessage, ServerResponse } from 'http';
+import type { RelaySocket } from './outbound-queue.js';
+import type { RelayTlsOptions } from './tls.js';
+import type { CompressionOptions } from './compression.js';
+
+export type TransportEngine = 'ws' | 'uws';
+
+/**
+ * An accepted client connection. Same surface as a ws WebSocket / IpcSocket:
+ * readyState, send with a completion callback (resumes the OutboundQueue
+ * after backpressure), bufferedAmount, close, terminate, and the 'message'
+ * (string), 'close' and 'error' events.
+ */
+export type TransportSocket = RelaySocket & EventEmitter;
+
+export interface TransportOptions {
+  port: number;
+  host: string;
+  tls?: RelayTlsOptions;
+  compression: CompressionOptions;
+  idleTimeoutSec: number; // ping idle sockets; close those that stay silent this long (0 = off)
+  onRequest: (req: IncomingMessage, res: ServerResponse) => void;
+}
+
+export interface TransportSettings {
+  engine: TransportEngine;
+  idleTimeoutSec: number;
+}
+
+export const DEFAULT_TRANSPORT_SETTINGS: TransportSettings = {
+  engine: 'ws',
+  idleTimeoutSec: 120
+};
+
+/**
+ * Accepts WebSocket clients and serves HTTP requests on one port. Emits
+ * 'connection' (socket: TransportSocket, ip: string) for every client,
+ * whatever its path; the relay does all routing above this.
+ */
+export interface RelayTransport extends EventEmitter {
+  readonly engine: TransportEngine;
+  listen(): Promise<void>;
+  address(): number;
+  /**
+   * Stop accepting and drop every open socket
+   */
+  close(): Promise<void>;
+}
+
+/**
+ * Build a transport. The uws engine is an optional native dependency and
+ * only loaded when selected.
+ */
+export async function createTransport(engine: TransportEngine, options: TransportOptions): Promise<RelayTransport> {
+  switch (engine) {
+    case 'ws': {
+      const { WsTransport } = await import('./transport-ws.js');
+      return new WsTransport(options);
+    }
+    case 'uws': {
+      const { UwsTransport } = await import('./transport-uws.js');
+      return UwsTransport.create(options);
+    }
+    default:
+      throw new Error(`Unknown transport engine: ${engine}`);
+  }
+}
+
+export function normalizeIp(address: string | undefined): string {
+  return (address || 'unknown').replace(/^::ffff:/, '');
+}
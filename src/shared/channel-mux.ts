@@ -0,0 +1,180 @@
+import EventEmitter from 'events';
+
+// Same numeric states as ws, so callers can compare against WebSocket.OPEN
+const CONNECTING = 0;
+const OPEN = 1;
+const CLOSED = 3;
+
+export const MAX_CHANNELS = 16;
+
+// Channel frames are relay messages with the channel ID spliced in front:
+// {"channel":"c1","type":"JOIN",...}. Routing only looks at that prefix.
+const CHANNEL_PREFIX = /^\{"channel":"([A-Za-z0-9_-]{1,32})",/;
+
+/**
+ * The part of a ws WebSocket / IpcSocket a multiplexed connection runs on
+ */
+export interface MuxParent extends EventEmitter {
+  readonly readyState: number;
+  readonly bufferedAmount?: number;
+  send(data: string, cb?: (error?: Error) => void): void;
+  close(): void;
+  terminate?(): void;
+}
+
+/**
+ * Add a channel ID to an already serialized message (a JSON object)
+ */
+export function tagChannel(channel: string, data: string): string {
+  return `{"channel":"${channel}",${data.slice(1)}`;
+}
+
+/**
+ * One logical relay connection inside a multiplexed socket. Exposes the
+ * same surface as a ws WebSocket, so SessionClient, OutboundQueue and the
+ * relay's client handling work on it unchanged. 'message' receives the
+ * frame with the channel ID already stripped.
+ */
+export class ChannelSocket extends EventEmitter {
+  readyState: number = CONNECTING;
+
+  constructor(readonly id: string, private mux: ChannelMux) {
+    super();
+  }
+
+  // Channels share the socket buffer, so backpressure is per connection
+  get bufferedAmount(): number {
+    return this.mux.parent.bufferedAmount ?? 0;
+  }
+
+  send(data: string, cb?: (error?: Error) => void): void {
+    if (this.readyState !== OPEN) {
+      cb?.(new Error(`Channel ${this.id} is not open`));
+      return;
+    }
+    this.mux.parent.send(tagChannel(this.id, data), cb);
+  }
+
+  /**
+   * Close this channel only; the socket stays up for the others
+   */
+  close(): void {
+    if (this.readyState === CLOSED) return;
+    if (this.mux.parent.readyState === OPEN) {
+      this.mux.parent.send(JSON.stringify({ channel: this.id, type: 'CHANNEL_CLOSE' }));
+    }
+    this.mux.remove(this.id);
+  }
+
+  /**
+   * A stuck channel means a stuck socket: drop the whole connection
+   */
+  terminate(): void {
+    if (this.mux.parent.terminate) this.mux.parent.terminate();
+    else this.mux.parent.close();
+  }
+
+  /** @internal */
+  opened(): void {
+    if (this.readyState !== CONNECTING) return;
+    this.readyState = OPEN;
+    this.emit('open');
+  }
+
+  /** @internal */
+  closed(): void {
+    if (this.readyState === CLOSED) return;
+    this.readyState = CLOSED;
+    this.emit('close');
+  }
+}
+
+/**
+ * Routes channel frames on one socket to their ChannelSockets. The relay
+ * side accepts channels the peer opens (emitting 'channel'); the client
+ * side opens them. Frames without a channel prefix belong to the socket
+ * itself and are left to the caller.
+ */
+export class ChannelMux extends EventEmitter {
+  private channels: Map<string, ChannelSocket> = new Map();
+  private nextId: number = 1;
+
+  constructor(readonly parent: MuxParent, private accept: boolean) {
+    super();
+    parent.on('open', () => this.channels.forEach(channel => {
+      this.announce(channel);
+      channel.opened();
+    }));
+    parent.on('close', () => [...this.channels.keys()].forEach(id => this.remove(id)));
+    parent.on('error', (error: Error) => this.channels.forEach(channel => channel.emit('error', error)));
+  }
+
+  get size(): number {
+    return this.channels.size;
+  }
+
+  forEach(fn: (channel: ChannelSocket) => void): void {
+    this.channels.forEach(fn);
+  }
+
+  /**
+   * Open a new channel (client side); it emits 'open' with the socket
+   */
+  open(): ChannelSocket {
+    const channel = new ChannelSocket(`c${this.nextId++}`, this);
+    this.channels.set(channel.id, channel);
+    if (this.parent.readyState === OPEN) {
+      this.announce(channel);
+      // Let the caller attach its listeners first
+      queueMicrotask(() => channel.opened());
+    }
+    // Otherwise announced and opened together with the socket
+    return channel;
+  }
+
+  private announce(channel: ChannelSocket): void {
+    this.parent.send(JSON.stringify({ channel: channel.id, type: 'CHANNEL_OPEN' }));
+  }
+
+  /**
+   * Deliver a frame to its channel; false if it isn't a channel frame
+   */
+  route(frame: string): boolean {
+    const match = CHANNEL_PREFIX.exec(frame);
+    if (!match) return false;
+
+    const id = match[1];
+    const body = '{' + frame.slice(match[0].length);
+    let channel = this.channels.get(id);
+
+    if (body.startsWith('{"type":"CHANNEL_OPEN"')) {
+      if (!this.accept || channel) return true;
+      if (this.channels.size >= MAX_CHANNELS) {
+        this.parent.send(JSON.stringify({ channel: id, type: 'ERROR', message: `At most ${MAX_CHANNELS} channels per connection` }));
+        return true;
+      }
+      channel = new ChannelSocket(id, this);
+      this.channels.set(id, channel);
+      channel.opened();
+      this.emit('channel', channel);
+      return true;
+    }
+
+    if (body.startsWith('{"type":"CHANNEL_CLOSE"')) {
+      this.remove(id);
+      return true;
+    }
+
+    channel?.emit('message', body);
+    return true;
+  }
+
+  /** @internal */
+  remove(id: string): void {
+    const channel = this.channels.get(id);
+    if (!channel) return;
+    this.channels.delete(id);
+    channel.closed();
+    this.emit('removed', channel);
+  }
+}
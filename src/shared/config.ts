@@ -1,21 +1,112 @@
 import { readFileSync } from 'fs';
 import { join } from 'path';
+import type { TracingOptions } from './tracing.js';
+import type { SamplingOptions } from './sampling-cadence.js';
 
 interface RelayConfig {
   port: number;
   host: string;
+  outbound?: {
+    highWaterMark?: number;   // bytes buffered on a socket before messages are held in the queue
+    maxInfoDepth?: number;    // informational messages kept per connection before dropping
+    maxCommandDepth?: number; // queued commands before a connection is treated as stuck
+  };
+  ipc?: boolean;      // also listen on a Unix socket / named pipe for same-host clients
+  ipcPath?: string;   // defaults to $XDG_RUNTIME_DIR/league-relay.sock, <tmpdir>/league-relay-<uid>/league-relay.sock or \\.\pipe\league-relay-<user>
+  tls?: {
+    certFile: string;
+    keyFile: string;
+    caFile?: string;
+    sessionTimeout?: number;   // seconds
+    reloadIntervalMs?: number; // certificate hot-reload poll interval, 0 = off
+    ticketKeyFile?: string;    // keeps session tickets valid across restarts
+  };
+  sessions?: {
+    maxAgeMs?: number;              // default 24 hours
+    maxOwnerlessSessions?: number;  // sessions nobody joined yet, LRU-evicted past this (default 1000)
+    maxSessionsPerIp?: number;      // sessions one IP may create; past this idle ones are LRU-evicted, else refused (default 16)
+  };
+  federation?: {
+    peers: string[];    // ws(s):// URLs of every other relay clients may use
+    secret: string;     // same on every relay
+    caFile?: string;
+  };
+  mirror?: {
+    target: string;             // ws(s):// URL of a canary relay that gets a copy of all client traffic
+    secret: string;             // the canary's canary.secret
+    caFile?: string;
+    maxBufferedFrames?: number; // frames waiting to be mirrored before new ones are dropped (default 10000)
+    maxBufferedBytes?: number;  // unsent bytes per mirrored client before frames are dropped (default 1 MiB)
+  };
+  canary?: {
+    secret: string;   // accept mirrored clients from a primary relay (see mirror)
+  };
+  replication?: {
+    secret: string;          // same on the primary and its standby
+    standbyOf?: string;      // ws(s):// URL of the primary; makes this relay its hot standby
+    caFile?: string;
+    heartbeatMs?: number;    // primary -> standby ping interval (default 250)
+    timeoutMs?: number;      // standby reconnects after this long without hearing from the primary, and takes over if that fails (default 5000)
+    resumeGraceMs?: number;  // after taking over, sessions nobody rejoined within this are dropped (default 60000)
+    stateFile?: string;      // keeps the term and role across restarts (default ./replication-<port>.json)
+    advertiseUrl?: string;   // ws(s):// URL other relays reach this one at, for a primary that steps down to follow it
+  };
+  admin?: {
+    trafficIntervalMs?: number; // heartbeat/status counts are sent to admins this often (default 5000)
+    trafficWindowMs?: number;   // per-client traffic accounting window for /debug/top and hotspots (default 60000)
+  };
+  compression?: {
+    admin?: { enabled?: boolean; level?: number; windowBits?: number; memLevel?: number; threshold?: number }; // ws path /admin
+    http?: { enabled?: boolean; level?: number; threshold?: number };  // GET /sessions, /metrics
+  };
+  transport?: {
+    engine?: 'ws' | 'uws';   // WebSocket engine; uws needs the optional uWebSockets.js package (default ws)
+    idleTimeoutSec?: number; // ping idle sockets, drop those silent this long (default 120, 0 = off)
+  };
+  tracing?: TracingOptions;  // Chrome trace-event spans (RELAY_TRACE=1 also enables)
+  debug?: {
+    token: string;        // bearer token for /debug/* (endpoints are off without it)
+    dir?: string;         // profile output directory (default ./profiles)
+    maxFiles?: number;    // profiles kept before the oldest is deleted (default 10)
+    maxSeconds?: number;  // longest cpu/alloc capture window (default 60)
+  };
 }
 
 interface ControllerConfig {
   relayServerHost: string;
   relayServerPort: number;
-  monitorInterval: number;
+  relayEndpoints?: string[];    // "host:port" list; the lowest-RTT relay is used and the others are failovers
+  relayProbeIntervalMs?: number; // RTT re-probe interval (default 60000)
+  relayMultiplex?: boolean;     // one socket per relay for all of this process's roles
+  relayServerTls?: boolean;     // connect with wss://
+  relayServerCaFile?: string;   // extra CA for self-signed relay certificates
+  relayIpc?: boolean;           // prefer the relay's local socket when it runs on this host and TLS is off (default false)
+  relayIpcPath?: string;
+  lanDirect?: boolean;          // host a LAN relay for followers on this network (remote relay stays as fallback)
+  lanPort?: number;             // LAN relay port (default 8081)
+  lanDiscoveryPort?: number;    // UDP announcement port (default 8089)
+  lanSecret?: string;           // signs LAN announcements; followers without a token need the same secret
+  tracing?: TracingOptions;
+  sampling?: Partial<SamplingOptions>; // LeagueClient/game probe cadence (fast around changes, backing off when stable)
+  monitorInterval?: number;            // older fixed probe interval; used only when sampling is not set
   killGameProcess: boolean;
 }
 
 interface FollowerConfig {
   relayServerHost: string;
   relayServerPort: number;
+  relayEndpoints?: string[];
+  relayProbeIntervalMs?: number;
+  relayMultiplex?: boolean;
+  relayServerTls?: boolean;
+  relayServerCaFile?: string;
+  relayIpc?: boolean;
+  relayIpcPath?: string;
+  lanDirect?: boolean;          // prefer a controller's LAN relay when one is announced
+  lanDiscoveryPort?: number;
+  lanSecret?: string;           // accept only announcements signed with this (the controller's lanSecret)
+  tracing?: TracingOptions;
+  sampling?: Partial<SamplingOptions>; // game process check cadence
   restartDelay: number;
 }
 
@@ -48,7 +139,6 @@ export function loadConfig(): Config {
       controller: {
         relayServerHost: 'localhost',
         relayServerPort: 8080,
-        monitorInterval: 5000,
         killGameProcess: true
       },
       follower: {
@@ -0,0 +1,143 @@
+import EventEmitter from 'events';
+import net from 'net';
+import { existsSync, mkdirSync, statSync } from 'fs';
+import { tmpdir, userInfo } from 'os';
+import { dirname, join } from 'path';
+
+// Same numeric states as ws, so callers can compare against WebSocket.OPEN
+const CONNECTING = 0;
+const OPEN = 1;
+const CLOSING = 2;
+const CLOSED = 3;
+
+const MAX_LINE_LENGTH = 1024 * 1024;
+
+/**
+ * Default local endpoint for the relay fast path: a Unix domain socket in a
+ * directory only this user can reach ($XDG_RUNTIME_DIR, else
+ * <tmpdir>/league-relay-<uid>), or a per-user named pipe on Windows.
+ */
+export function defaultIpcPath(): string {
+  if (process.platform === 'win32') return `\\\\.\\pipe\\league-relay-${userInfo().username}`;
+  const dir = process.env.XDG_RUNTIME_DIR || join(tmpdir(), `league-relay-${process.getuid!()}`);
+  return join(dir, 'league-relay.sock');
+}
+
+/**
+ * True when the socket's directory belongs to this user (or root) and
+ * nobody else can write to it, so no other local user can have put a
+ * socket there (not checked for Windows named pipes)
+ */
+export function isPrivateIpcPath(path: string): boolean {
+  if (process.platform === 'win32') return true;
+  try {
+    const stats = statSync(dirname(path));
+    return stats.isDirectory() && (stats.uid === process.getuid!() || stats.uid === 0) && (stats.mode & 0o022) === 0;
+  } catch {
+    return false;
+  }
+}
+
+/**
+ * Relay side: create the socket's directory private to this user if it
+ * isn't there, and refuse one that others could write to
+ */
+export function preparePrivateIpcDir(path: string): void {
+  if (process.platform === 'win32') return;
+  const dir = dirname(path);
+  if (!existsSync(dir)) mkdirSync(dir, { recursive: true, mode: 0o700 });
+  if (!isPrivateIpcPath(path)) throw new Error(`IPC directory ${dir} must belong to this user and not be writable by others`);
+}
+
+/**
+ * True when a relay host refers to this machine
+ */
+export function isLocalHost(host: string): boolean {
+  return host === 'localhost' || host === '127.0.0.1' || host === '::1';
+}
+
+/**
+ * Local socket a client should prefer, or undefined to always use TCP.
+ * Opt-in (relayIpc), and only when the configured relay host is this
+ * machine; never with TLS, which the local socket would bypass.
+ */
+export function resolveClientIpcPath(relayHost: string, enabled: boolean = false, path?: string, tls: boolean = false): string | undefined {
+  if (!enabled || tls || !isLocalHost(relayHost)) return undefined;
+  return path ?? defaultIpcPath();
+}
+
+/**
+ * Relay protocol over a local stream socket. Carries the same JSON messages
+ * as the WebSocket transport, framed as one message per line (JSON.stringify
+ * never emits a raw newline), which skips the HTTP upgrade, WebSocket framing
+ * and masking. Emits 'open', 'message' (string), 'close' and 'error' and
+ * exposes the subset of the ws API the relay and SessionClient use.
+ */
+export class IpcSocket extends EventEmitter {
+  readyState: number;
+  private buffer: string = '';
+
+  constructor(private socket: net.Socket, connected: boolean) {
+    super();
+    this.readyState = connected ? OPEN : CONNECTING;
+    socket.setEncoding('utf8');
+    socket.setNoDelay?.(true);
+
+    socket.on('connect', () => {
+      this.readyState = OPEN;
+      this.emit('open');
+    });
+    socket.on('data', (chunk: string) => this.onData(chunk));
+    socket.on('error', (error) => this.emit('error', error));
+    socket.on('close', () => {
+      this.readyState = CLOSED;
+      this.emit('close');
+    });
+  }
+
+  /**
+   * Connect to a relay listening on a Unix socket or named pipe
+   */
+  static connect(path: string): IpcSocket {
+    return new IpcSocket(net.createConnection(path), false);
+  }
+
+  get bufferedAmount(): number {
+    return this.socket.writableLength;
+  }
+
+  send(data: string, cb?: (error?: Error) => void): void {
+    if (this.readyState !== OPEN) {
+      cb?.(new Error('IPC socket is not open'));
+      return;
+    }
+    this.socket.write(data + '\n', cb);
+  }
+
+  close(): void {
+    if (this.readyState === CLOSED) return;
+    this.readyState = CLOSING;
+    this.socket.end();
+  }
+
+  terminate(): void {
+    this.readyState = CLOSING;
+    this.socket.destroy();
+  }
+
+  private onData(chunk: string): void {
+    this.buffer += chunk;
+
+    let newline: number;
+    while ((newline = this.buffer.indexOf('\n')) !== -1) {
+      const line = this.buffer.slice(0, newline);
+      this.buffer = this.buffer.slice(newline + 1);
+      if (line.length > 0) this.emit('message', line);
+    }
+
+    if (this.buffer.length > MAX_LINE_LENGTH) {
+      this.emit('error', new Error(`IPC frame exceeds ${MAX_LINE_LENGTH} bytes`));
+      this.terminate();
+    }
+  }
+}
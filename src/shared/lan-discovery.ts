@@ -0,0 +1,248 @@
+import dgram from 'dgram';
+import EventEmitter from 'events';
+import crypto from 'crypto';
+import os from 'os';
+import { Logger } from './logger.js';
+import { secretMatches } from './secrets.js';
+
+export const DEFAULT_DISCOVERY_PORT = 8089;
+const ANNOUNCE_TYPE = 'LEAGUE_RELAY_ANNOUNCE';
+const MAX_CLOCK_SKEW_MS = 60_000; // signed announcements from further off are ignored
+
+export interface LanRelayAnnouncement {
+  host: string;
+  port: number;
+  sessionToken: string;
+}
+
+// HMAC of an announcement, keyed by the LAN secret or else the session token.
+// It covers the announcing host's addresses, so a copy sent from any other host fails.
+function signature(key: string, port: number, hosts: string[], sentAt: number, sealedToken: string = ''): string {
+  return crypto.createHmac('sha256', key).update(`${port}:${hosts.join(',')}:${sentAt}:${sealedToken}`).digest('hex');
+}
+
+// The session token, encrypted under the LAN secret (AES-256-GCM): iv, tag and ciphertext, base64
+function sealToken(secret: string, token: string): string {
+  const iv = crypto.randomBytes(12);
+  const cipher = crypto.createCipheriv('aes-256-gcm', crypto.createHash('sha256').update(secret).digest(), iv);
+  const sealed = Buffer.concat([cipher.update(token, 'utf8'), cipher.final()]);
+  return Buffer.concat([iv, cipher.getAuthTag(), sealed]).toString('base64');
+}
+
+function openToken(secret: string, sealed: string): string | undefined {
+  try {
+    const data = Buffer.from(sealed, 'base64');
+    const decipher = crypto.createDecipheriv('aes-256-gcm', crypto.createHash('sha256').update(secret).digest(), data.subarray(0, 12));
+    decipher.setAuthTag(data.subarray(12, 28));
+    return Buffer.concat([decipher.update(data.subarray(28)), decipher.final()]).toString('utf8');
+  } catch {
+    return undefined;
+  }
+}
+
+// IPv4 addresses this host may announce from
+function localAddresses(): string[] {
+  return Object.values(os.networkInterfaces())
+    .flatMap(addresses => addresses ?? [])
+    .filter(address => address.family === 'IPv4')
+    .map(address => address.address);
+}
+
+/**
+ * Periodically broadcasts the controller's LAN relay on the local network.
+ * The session token never goes out in the clear: every announcement is
+ * signed over the relay port, this host's addresses and the time, keyed by
+ * the LAN secret when there is one (which also seals the token for
+ * followers started without it) and by the session token otherwise.
+ */
+export class LanAnnouncer {
+  private logger: Logger;
+  private socket?: dgram.Socket;
+  private timer?: NodeJS.Timeout;
+
+  constructor(
+    private relayPort: number,
+    private sessionToken: string,
+    private discoveryPort: number = DEFAULT_DISCOVERY_PORT,
+    private intervalMs: number = 2000,
+    private address: string = '255.255.255.255',
+    private secret?: string
+  ) {
+    this.logger = new Logger('LanAnnouncer');
+  }
+
+  start(): void {
+    this.socket = dgram.createSocket({ type: 'udp4', reuseAddr: true });
+    this.socket.on('error', (error) => this.logger.error('Discovery socket error', error));
+    this.socket.bind(() => {
+      this.socket!.setBroadcast(true);
+      this.announce();
+      this.timer = setInterval(() => this.announce(), this.intervalMs);
+    });
+    this.logger.info(`Announcing LAN relay on udp/${this.discoveryPort} every ${this.intervalMs / 1000}s`);
+  }
+
+  setSessionToken(token: string): void {
+    this.sessionToken = token;
+    this.announce();
+  }
+
+  stop(): void {
+    if (this.timer) {
+      clearInterval(this.timer);
+      this.timer = undefined;
+    }
+    this.socket?.close();
+    this.socket = undefined;
+  }
+
+  private announce(): void {
+    if (!this.socket) return;
+    const sentAt = Date.now();
+    const hosts = localAddresses();
+    const sealedToken = this.secret ? sealToken(this.secret, this.sessionToken) : undefined;
+    const payload = Buffer.from(JSON.stringify({
+      type: ANNOUNCE_TYPE,
+      port: this.relayPort,
+      hosts,
+      sentAt,
+      sealedToken,
+      signature: signature(this.secret ?? this.sessionToken, this.relayPort, hosts, sentAt, sealedToken)
+    }));
+    this.socket.send(payload, this.discoveryPort, this.address, (error) => {
+      if (error) this.logger.warn(`Announce failed: ${error.message}`);
+    });
+  }
+}
+
+/**
+ * Listens for LAN relay announcements. Emits 'found' when a relay appears
+ * (or changes) and 'lost' once it has been silent for expiryMs.
+ * An announcement is trusted only with a valid signature, keyed by the
+ * shared secret or else by this follower's session token, from one of the
+ * addresses it names, and newer than the last one accepted. With neither
+ * a secret nor a token nothing can be checked, so every announcement is
+ * ignored.
+ */
+export class LanDiscovery extends EventEmitter {
+  private logger: Logger;
+  private socket?: dgram.Socket;
+  private current?: LanRelayAnnouncement;
+  private lastSeen: number = 0;
+  private expiryTimer?: NodeJS.Timeout;
+  private rejected: Set<string> = new Set(); // hosts already logged for unauthenticated announcements
+  private lastSentAt: number = 0;            // newest signed announcement accepted
+
+  constructor(
+    private sessionToken?: string,
+    private discoveryPort: number = DEFAULT_DISCOVERY_PORT,
+    private expiryMs: number = 6000,
+    private secret?: string
+  ) {
+    super();
+    this.logger = new Logger('LanDiscovery');
+  }
+
+  start(): void {
+    if (!this.sessionToken && !this.secret) {
+      this.logger.warn('No session token or LAN secret set: ignoring LAN relay announcements');
+    }
+    this.socket = dgram.createSocket({ type: 'udp4', reuseAddr: true });
+    this.socket.on('error', (error) => this.logger.error('Discovery socket error', error));
+    this.socket.on('message', (data, rinfo) => this.onAnnouncement(data, rinfo.address));
+    this.socket.bind(this.discoveryPort);
+
+    this.expiryTimer = setInterval(() => {
+      if (this.current && Date.now() - this.lastSeen > this.expiryMs) {
+        this.logger.warn(`LAN relay ${this.current.host}:${this.current.port} stopped announcing`);
+        this.current = undefined;
+        this.lastSentAt = 0;
+        this.emit('lost');
+      }
+    }, Math.max(500, this.expiryMs / 3));
+  }
+
+  stop(): void {
+    if (this.expiryTimer) {
+      clearInterval(this.expiryTimer);
+      this.expiryTimer = undefined;
+    }
+    this.socket?.close();
+    this.socket = undefined;
+  }
+
+  relay(): LanRelayAnnouncement | undefined {
+    return this.current;
+  }
+
+  /**
+   * Resolve with the first matching relay, or undefined after timeoutMs
+   */
+  waitForRelay(timeoutMs: number): Promise<LanRelayAnnouncement | undefined> {
+    if (this.current) return Promise.resolve(this.current);
+
+    return new Promise(resolve => {
+      const timer = setTimeout(() => {
+        this.off('found', onFound);
+        resolve(undefined);
+      }, timeoutMs);
+      const onFound = (relay: LanRelayAnnouncement) => {
+        clearTimeout(timer);
+        resolve(relay);
+      };
+      this.once('found', onFound);
+    });
+  }
+
+  private onAnnouncement(data: Buffer, host: string): void {
+    let message: any;
+    try {
+      message = JSON.parse(data.toString());
+    } catch {
+      return;
+    }
+    if (message.type !== ANNOUNCE_TYPE || typeof message.port !== 'number') return;
+    const sessionToken = this.authenticated(message, host);
+    if (!sessionToken) {
+      // (a duplicate from the relay in use is just late, not worth a warning)
+      if (host !== this.current?.host && !this.rejected.has(host)) {
+        this.rejected.add(host);
+        this.logger.warn(`Ignoring a LAN relay announcement not signed for this follower from ${host}:${message.port}`);
+      }
+      return;
+    }
+    this.lastSentAt = message.sentAt;
+
+    this.lastSeen = Date.now();
+    const changed = !this.current
+      || this.current.host !== host
+      || this.current.port !== message.port
+      || this.current.sessionToken !== sessionToken;
+
+    if (changed) {
+      this.current = { host, port: message.port, sessionToken };
+      this.logger.success(`Found LAN relay at ${host}:${message.port}`);
+      this.emit('found', this.current);
+    }
+  }
+
+  /**
+   * The session token of a trusted announcement from host, or undefined
+   */
+  private authenticated(message: any, host: string): string | undefined {
+    const key = this.secret ?? this.sessionToken;
+    if (!key) return undefined;
+    const hosts: unknown = message.hosts;
+    if (!Array.isArray(hosts) || !hosts.every(entry => typeof entry === 'string') || !hosts.includes(host)) return undefined;
+    // The signed timestamp must move forward and be recent: a replayed copy is dropped
+    if (typeof message.sentAt !== 'number' || message.sentAt <= this.lastSentAt) return undefined;
+    if (Math.abs(Date.now() - message.sentAt) > MAX_CLOCK_SKEW_MS) return undefined;
+    const sealedToken = typeof message.sealedToken === 'string' ? message.sealedToken : undefined;
+    if (!secretMatches(message.signature, signature(key, message.port, hosts as string[], message.sentAt, sealedToken))) return undefined;
+    if (!this.secret) return this.sessionToken;
+
+    const sessionToken = sealedToken && openToken(this.secret, sealedToken);
+    if (!sessionToken || (this.sessionToken && sessionToken !== this.sessionToken)) return undefined;
+    return sessionToken;
+  }
+}
@@ -1,3 +1,5 @@
+import { tracer } from './tracing.js';
+
 export class Logger {
   private prefix: string;
 
@@ -19,7 +21,9 @@ export class Logger {
   }
 
   info(message: string): void {
+    const span = tracer.span('log');
     console.log(this.formatMessage('INFO', message));
+    span.end();
   }
 
   warn(message: string): void {
@@ -35,6 +39,8 @@ export class Logger {
   }
 
   success(message: string): void {
+    const span = tracer.span('log');
     console.log(this.formatMessage('SUCCESS', message));
+    span.end();
   }
 }
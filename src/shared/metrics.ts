@@ -0,0 +1,126 @@
+/**
+ * Minimal in-process metrics registry.
+ * Counters, gauges and rolling histograms are registered by name and
+ * exported as a flat JSON snapshot (served by the relay on /metrics).
+ */
+
+export class Counter {
+  private value: number = 0;
+
+  inc(amount: number = 1): void {
+    this.value += amount;
+  }
+
+  get(): number {
+    return this.value;
+  }
+}
+
+export class Gauge {
+  private value: number = 0;
+  private max: number = 0;
+
+  set(value: number): void {
+    this.value = value;
+    if (value > this.max) this.max = value;
+  }
+
+  add(delta: number): void {
+    this.set(this.value + delta);
+  }
+
+  get(): number {
+    return this.value;
+  }
+
+  snapshot() {
+    return { value: this.value, max: this.max };
+  }
+}
+
+/**
+ * Histogram over the most recent samples (fixed-size ring buffer), so
+ * percentiles reflect current behaviour rather than the whole uptime.
+ */
+export class Histogram {
+  private samples: Float64Array;
+  private next: number = 0;
+  private filled: number = 0;
+  private count: number = 0;
+  private sum: number = 0;
+  private max: number = 0;
+
+  constructor(capacity: number = 1024) {
+    this.samples = new Float64Array(capacity);
+  }
+
+  record(value: number): void {
+    this.samples[this.next] = value;
+    this.next = (this.next + 1) % this.samples.length;
+    if (this.filled < this.samples.length) this.filled++;
+    this.count++;
+    this.sum += value;
+    if (value > this.max) this.max = value;
+  }
+
+  snapshot() {
+    const window = Array.from(this.samples.subarray(0, this.filled)).sort((a, b) => a - b);
+    const pick = (q: number) => window.length ? window[Math.min(window.length - 1, Math.floor(q * window.length))] : 0;
+    return {
+      count: this.count,
+      mean: this.count ? this.sum / this.count : 0,
+      max: this.max,
+      p50: pick(0.5),
+      p90: pick(0.9),
+      p99: pick(0.99)
+    };
+  }
+}
+
+export class Metrics {
+  private counters: Map<string, Counter> = new Map();
+  private gauges: Map<string, Gauge> = new Map();
+  private histograms: Map<string, Histogram> = new Map();
+
+  counter(name: string): Counter {
+    let counter = this.counters.get(name);
+    if (!counter) {
+      counter = new Counter();
+      this.counters.set(name, counter);
+    }
+    return counter;
+  }
+
+  gauge(name: string): Gauge {
+    let gauge = this.gauges.get(name);
+    if (!gauge) {
+      gauge = new Gauge();
+      this.gauges.set(name, gauge);
+    }
+    return gauge;
+  }
+
+  histogram(name: string): Histogram {
+    let histogram = this.histograms.get(name);
+    if (!histogram) {
+      histogram = new Histogram();
+      this.histograms.set(name, histogram);
+    }
+    return histogram;
+  }
+
+  snapshot() {
+    const counters: Record<string, number> = {};
+    const gauges: Record<string, { value: number; max: number }> = {};
+    const histograms: Record<string, ReturnType<Histogram['snapshot']>> = {};
+
+    this.counters.forEach((c, name) => { counters[name] = c.get(); });
+    this.gauges.forEach((g, name) => { gauges[name] = g.snapshot(); });
+    this.histograms.forEach((h, name) => { histograms[name] = h.snapshot(); });
+
+    return { counters, gauges, histograms };
+  }
+}
+
+// Process-wide registry
+export const metrics = new Metrics();
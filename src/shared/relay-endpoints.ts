@@ -0,0 +1,227 @@
+import http from 'http';
+import https from 'https';
+import EventEmitter from 'events';
+import { readFileSync } from 'fs';
+import { Logger } from './logger.js';
+import { metrics } from './metrics.js';
+
+const logger = new Logger('RelaySelector');
+
+export interface RelayEndpoint {
+  host: string;
+  port: number;
+}
+
+export interface RelayProbeOptions {
+  tls?: boolean;
+  caFile?: string;
+  samples?: number;     // timed requests per endpoint, median taken (default 3)
+  timeoutMs?: number;   // per request (default 2000)
+}
+
+export interface RelaySelectorOptions extends RelayProbeOptions {
+  probeIntervalMs?: number;  // re-probe period, 0 = only at startup and on failover (default 60000)
+}
+
+const failoverCounter = metrics.counter('client.relay.failovers');
+const switchCounter = metrics.counter('client.relay.switches');
+const selectedRttGauge = metrics.gauge('client.relay.selected_rtt_ms');
+
+/**
+ * "host:port" (or "host", with defaultPort)
+ */
+export function parseEndpoint(value: string, defaultPort: number): RelayEndpoint {
+  const match = /^\[?([^\]]+?)\]?(?::(\d+))?$/.exec(value.trim());
+  if (!match) throw new Error(`Invalid relay endpoint: ${value}`);
+  return { host: match[1], port: match[2] ? Number(match[2]) : defaultPort };
+}
+
+export function endpointKey(endpoint: RelayEndpoint): string {
+  return `${endpoint.host}:${endpoint.port}`;
+}
+
+/**
+ * Median round trip of GET /health over one kept-alive connection, so the
+ * TCP/TLS handshake of the first request isn't counted; undefined if the
+ * relay didn't answer. Includes the relay's own response time, so a
+ * saturated relay ranks behind an idle one at the same distance.
+ */
+export async function probeRtt(endpoint: RelayEndpoint, options: RelayProbeOptions = {}): Promise<number | undefined> {
+  const samples = options.samples ?? 3;
+  const timeoutMs = options.timeoutMs ?? 2000;
+  const agent = options.tls
+    ? new https.Agent({ keepAlive: true, maxSockets: 1, ca: options.caFile ? readFileSync(options.caFile) : undefined })
+    : new http.Agent({ keepAlive: true, maxSockets: 1 });
+  const get = options.tls ? https.get : http.get;
+
+  const request = () => new Promise<number>((resolve, reject) => {
+    const start = performance.now();
+    const req = get({ host: endpoint.host, port: endpoint.port, path: '/health', agent, timeout: timeoutMs }, res => {
+      res.resume();
+      res.on('end', () => res.statusCode === 200 ? resolve(performance.now() - start) : reject(new Error(`HTTP ${res.statusCode}`)));
+    });
+    req.on('timeout', () => req.destroy(new Error('timeout')));
+    req.on('error', reject);
+  });
+
+  try {
+    await request(); // connection setup
+    const rtts: number[] = [];
+    for (let i = 0; i < samples; i++) rtts.push(await request());
+    return rtts.sort((a, b) => a - b)[Math.floor(rtts.length / 2)];
+  } catch {
+    return undefined;
+  } finally {
+    agent.destroy();
+  }
+}
+
+/**
+ * The relay settings shared by the controller and follower config sections
+ */
+export interface RelayEndpointConfig {
+  relayServerHost: string;
+  relayServerPort: number;
+  relayEndpoints?: string[];
+  relayProbeIntervalMs?: number;
+  relayServerTls?: boolean;
+  relayServerCaFile?: string;
+}
+
+/**
+ * The relay to connect to first: the lowest-RTT one of relayEndpoints
+ * (with a selector for failover), or relayServerHost:relayServerPort
+ */
+export async function selectRelay(config: RelayEndpointConfig): Promise<{ endpoint: RelayEndpoint; selector?: RelaySelector }> {
+  const endpoints = (config.relayEndpoints ?? []).map(value => parseEndpoint(value, config.relayServerPort));
+  if (endpoints.length === 0) {
+    return { endpoint: { host: config.relayServerHost, port: config.relayServerPort } };
+  }
+
+  const selector = new RelaySelector(endpoints, {
+    tls: config.relayServerTls,
+    caFile: config.relayServerCaFile,
+    probeIntervalMs: config.relayProbeIntervalMs
+  });
+  return { endpoint: await selector.selectBest(), selector };
+}
+
+/**
+ * Picks the relay with the lowest measured RTT from a configured list,
+ * re-probes periodically and hands out the next best one on failover.
+ * Emits 'switch' (endpoint, rttMs) when another relay has become clearly
+ * better than the current one.
+ */
+export class RelaySelector extends EventEmitter {
+  private rtts: Map<string, number | undefined> = new Map();
+  private selected: RelayEndpoint;
+  private timer?: NodeJS.Timeout;
+
+  constructor(private endpoints: RelayEndpoint[], private options: RelaySelectorOptions = {}) {
+    super();
+    if (endpoints.length === 0) throw new Error('No relay endpoints configured');
+    this.selected = endpoints[0];
+  }
+
+  current(): RelayEndpoint {
+    return this.selected;
+  }
+
+  includes(endpoint: RelayEndpoint): boolean {
+    return this.endpoints.some(e => endpointKey(e) === endpointKey(endpoint));
+  }
+
+  /**
+   * Probe every endpoint in parallel and record the results
+   */
+  async probe(): Promise<void> {
+    const results = await Promise.all(this.endpoints.map(endpoint => probeRtt(endpoint, this.options)));
+    this.endpoints.forEach((endpoint, i) => {
+      const key = endpointKey(endpoint);
+      this.rtts.set(key, results[i]);
+      metrics.gauge(`client.relay.rtt_ms.${key}`).set(results[i] ?? -1);
+    });
+    logger.info(`Relay RTTs: ${this.endpoints.map(e => `${endpointKey(e)}=${this.describe(e)}`).join(', ')}`);
+  }
+
+  /**
+   * Probe and select the best relay (the first one if none answered)
+   */
+  async selectBest(): Promise<RelayEndpoint> {
+    await this.probe();
+    this.select(this.best() ?? this.endpoints[0]);
+    return this.selected;
+  }
+
+  /**
+   * The relay in use failed: re-probe the others and move to the best
+   * reachable one. Undefined when none answered (keep retrying this one).
+   */
+  async failover(failed: RelayEndpoint): Promise<RelayEndpoint | undefined> {
+    await this.probe();
+    this.rtts.set(endpointKey(failed), undefined);
+    const next = this.best();
+    if (!next) {
+      logger.warn(`No other relay reachable, staying on ${endpointKey(failed)}`);
+      return undefined;
+    }
+    failoverCounter.inc();
+    logger.warn(`Failing over from ${endpointKey(failed)} to ${endpointKey(next)} (${this.describe(next)})`);
+    this.select(next);
+    return next;
+  }
+
+  /**
+   * Re-probe every probeIntervalMs and emit 'switch' when another relay is
+   * at least 30% and 20ms faster (or the current one stopped answering)
+   */
+  start(): void {
+    const interval = this.options.probeIntervalMs ?? 60000;
+    if (interval <= 0 || this.endpoints.length < 2) return;
+
+    this.timer = setInterval(async () => {
+      await this.probe();
+      const best = this.best();
+      if (!best || endpointKey(best) === endpointKey(this.selected)) return;
+
+      const currentRtt = this.rtts.get(endpointKey(this.selected));
+      const bestRtt = this.rtts.get(endpointKey(best))!;
+      if (currentRtt === undefined || (bestRtt < currentRtt * 0.7 && currentRtt - bestRtt > 20)) {
+        logger.info(`Relay ${endpointKey(best)} (${this.describe(best)}) is faster than ${endpointKey(this.selected)} (${this.describe(this.selected)}), switching`);
+        switchCounter.inc();
+        this.select(best);
+        this.emit('switch', best, bestRtt);
+      }
+    }, interval);
+    this.timer.unref();
+  }
+
+  stop(): void {
+    if (this.timer) clearInterval(this.timer);
+  }
+
+  private best(): RelayEndpoint | undefined {
+    let best: RelayEndpoint | undefined;
+    let bestRtt = Infinity;
+    for (const endpoint of this.endpoints) {
+      const rtt = this.rtts.get(endpointKey(endpoint));
+      if (rtt !== undefined && rtt < bestRtt) {
+        best = endpoint;
+        bestRtt = rtt;
+      }
+    }
+    return best;
+  }
+
+  private select(endpoint: RelayEndpoint): void {
+    this.selected = endpoint;
+    const rtt = this.rtts.get(endpointKey(endpoint));
+    selectedRttGauge.set(rtt ?? -1);
+    logger.success(`Using relay ${endpointKey(endpoint)} (${this.describe(endpoint)})`);
+  }
+
+  private describe(endpoint: RelayEndpoint): string {
+    const rtt = this.rtts.get(endpointKey(endpoint));
+    return rtt === undefined ? 'unreachable' : `${rtt.toFixed(1)}ms`;
+  }
+}
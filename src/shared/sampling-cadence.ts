@@ -0,0 +1,122 @@
+import { metrics } from './metrics.js';
+import type { Counter, Gauge, Histogram } from './metrics.js';
+
+export interface SamplingOptions {
+  fastMs: number;  // interval while a transition is in progress or just seen
+  maxMs: number;   // ceiling of the back-off once state is stable
+  backoff: number; // interval multiplier per unchanged sample
+  burstMs: number; // how long a launch, kill or command keeps sampling fast
+}
+
+export const DEFAULT_SAMPLING_OPTIONS: SamplingOptions = {
+  fastMs: 1000,
+  maxMs: 15000,
+  backoff: 2,
+  burstMs: 30000
+};
+
+/**
+ * Probe scheduling for process monitors on platforms without process
+ * events. Samples every fastMs after a sample that saw a change, for
+ * burstMs after burst() (a launch, kill or received command) and while
+ * any hold() is set (waiting on a process-count threshold). Otherwise each
+ * unchanged sample multiplies the interval by backoff, up to maxMs.
+ * burst() and hold() also cut a longer pending wait short.
+ *
+ * Metrics: <name>.cadence_ms (current interval), <name>.probes and
+ * <name>.probe_ms (wall time of one sample).
+ */
+export class SamplingCadence {
+  private options: SamplingOptions;
+  private interval: number;
+  private burstUntil: number = 0;
+  private holds: Set<string> = new Set();
+  private timer?: NodeJS.Timeout;
+  private dueAt: number = 0;
+  private running: boolean = false;
+  private cadenceGauge: Gauge;
+  private probeCounter: Counter;
+  private probeHistogram: Histogram;
+
+  /**
+   * sample() resolves true when it saw the monitored state change
+   */
+  constructor(name: string, private sample: () => Promise<boolean>, options: Partial<SamplingOptions> = {}) {
+    this.options = { ...DEFAULT_SAMPLING_OPTIONS, ...options };
+    this.interval = this.options.fastMs;
+    this.cadenceGauge = metrics.gauge(`${name}.cadence_ms`);
+    this.probeCounter = metrics.counter(`${name}.probes`);
+    this.probeHistogram = metrics.histogram(`${name}.probe_ms`);
+  }
+
+  start(): void {
+    if (this.running) return;
+    this.running = true;
+    this.schedule(this.options.fastMs);
+  }
+
+  stop(): void {
+    this.running = false;
+    if (this.timer) clearTimeout(this.timer);
+    this.timer = undefined;
+  }
+
+  /**
+   * Something was just launched, killed or commanded: sample fast for a while
+   */
+  burst(): void {
+    this.burstUntil = Date.now() + this.options.burstMs;
+    this.hurry();
+  }
+
+  /**
+   * Keep sampling fast until released (e.g. while waiting on a threshold)
+   */
+  hold(reason: string, on: boolean = true): void {
+    if (!on) {
+      this.holds.delete(reason);
+      return;
+    }
+    this.holds.add(reason);
+    this.hurry();
+  }
+
+  /**
+   * Interval until the next sample after the current one
+   */
+  currentMs(): number {
+    return this.interval;
+  }
+
+  private hurry(): void {
+    this.interval = this.options.fastMs;
+    // A sample in flight schedules the next one itself when it finishes
+    if (this.timer && this.dueAt > Date.now() + this.options.fastMs) this.schedule(this.options.fastMs);
+  }
+
+  private schedule(delayMs: number): void {
+    if (this.timer) clearTimeout(this.timer);
+    this.dueAt = Date.now() + delayMs;
+    this.cadenceGauge.set(delayMs);
+    this.timer = setTimeout(() => this.run(), delayMs);
+  }
+
+  private async run(): Promise<void> {
+    this.timer = undefined;
+    const start = performance.now();
+    let changed = false;
+    try {
+      changed = await this.sample();
+    } catch {
+      // The monitor logs its own probe failures; a failed sample counts as unchanged
+    }
+    this.probeHistogram.record(performance.now() - start);
+    this.probeCounter.inc();
+    if (!this.running) return;
+
+    const { fastMs, maxMs, backoff } = this.options;
+    const fast = changed || this.holds.size > 0 || Date.now() < this.burstUntil;
+    this.interval = fast ? fastMs : Math.min(maxMs, this.interval * backoff);
+    this.schedule(this.interval);
+  }
+}
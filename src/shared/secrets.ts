@@ -0,0 +1,12 @@
+import crypto from 'crypto';
+
+/**
+ * Constant-time check of a presented secret or token. Both sides are
+ * hashed first, so the comparison doesn't leak the expected length either.
+ */
+export function secretMatches(presented: unknown, expected: string): boolean {
+  if (typeof presented !== 'string') return false;
+  const a = crypto.createHash('sha256').update(presented).digest();
+  const b = crypto.createHash('sha256').update(expected).digest();
+  return crypto.timingSafeEqual(a, b);
+}
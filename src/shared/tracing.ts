@@ -0,0 +1,192 @@
+import { appendFileSync, existsSync, renameSync, statSync, unlinkSync, writeFileSync } from 'fs';
+import crypto from 'crypto';
+
+export interface TracingOptions {
+  enabled: boolean;
+  file?: string;        // Chrome trace-event JSON (default ./trace-<process>.json)
+  sampleRate?: number;  // fraction of root spans recorded (default 0.01)
+  maxBytes?: number;    // rotate the file past this size (default 50MB)
+  maxFiles?: number;    // rotated files kept (default 3)
+}
+
+/**
+ * Carried in command messages so the relay and followers can continue a
+ * controller's trace. Only present when the trace is sampled.
+ */
+export interface TraceContext {
+  traceId: string;
+  spanId: string;
+}
+
+export interface Span {
+  /** Attach an argument shown in the trace viewer */
+  arg(key: string, value: unknown): Span;
+  end(): void;
+}
+
+const NOOP_SPAN: Span = {
+  arg() { return this; },
+  end() {}
+};
+
+// Microseconds on the wall clock, so files from different processes line up
+const nowMicros = () => Math.round((performance.timeOrigin + performance.now()) * 1000);
+
+class RecordingSpan implements Span {
+  readonly spanId: string;
+  private args?: Record<string, unknown>;
+
+  constructor(
+    private tracer: Tracer,
+    readonly name: string,
+    readonly traceId: string,
+    readonly parent?: RecordingSpan,
+    private start: number = nowMicros()
+  ) {
+    this.spanId = crypto.randomBytes(8).toString('hex');
+  }
+
+  arg(key: string, value: unknown): Span {
+    (this.args ??= {})[key] = value;
+    return this;
+  }
+
+  end(): void {
+    this.tracer.finish(this, this.start, nowMicros() - this.start, this.args);
+  }
+}
+
+/**
+ * Span tracing that writes Chrome trace-event JSON (open in chrome://tracing
+ * or Perfetto). Spans nest through an active-span stack, which is sound
+ * because every traced path is synchronous. When tracing is off, or a root
+ * span isn't sampled, every call returns a shared no-op span, so the cost
+ * is one property check.
+ */
+export class Tracer {
+  private enabled: boolean = false;
+  private sampleRate: number = 0.01;
+  private file: string = '';
+  private maxBytes: number = 50 * 1024 * 1024;
+  private maxFiles: number = 3;
+  private pid: number = process.pid;
+  private active?: RecordingSpan;
+  private buffer: string[] = [];
+  private bytes: number = 0;
+  private flushTimer?: NodeJS.Timeout;
+
+  configure(options: TracingOptions | undefined, processName: string): void {
+    this.enabled = !!options?.enabled;
+    if (!this.enabled) return;
+
+    this.sampleRate = options!.sampleRate ?? 0.01;
+    this.file = options!.file ?? `trace-${processName}.json`;
+    this.maxBytes = options!.maxBytes ?? 50 * 1024 * 1024;
+    this.maxFiles = options!.maxFiles ?? 3;
+    this.bytes = existsSync(this.file) ? statSync(this.file).size : 0;
+    if (this.bytes === 0) this.startFile();
+
+    this.emit({ ph: 'M', name: 'process_name', pid: this.pid, tid: 0, args: { name: processName } });
+    this.flushTimer = setInterval(() => this.flush(), 1000);
+    this.flushTimer.unref();
+    process.on('exit', () => this.flush());
+  }
+
+  disable(): void {
+    this.flush();
+    this.enabled = false;
+    if (this.flushTimer) clearInterval(this.flushTimer);
+  }
+
+  /**
+   * Timestamp to start a span retroactively (e.g. before the message that
+   * carries the trace context is parsed); 0 when tracing is off
+   */
+  now(): number {
+    return this.enabled ? nowMicros() : 0;
+  }
+
+  /**
+   * Start a trace, or continue one received in a message. Sampled
+   * locally unless a context arrived (the sender already sampled it).
+   */
+  root(name: string, context?: TraceContext, start?: number): Span {
+    if (!this.enabled) return NOOP_SPAN;
+    if (!context && Math.random() >= this.sampleRate) return NOOP_SPAN;
+
+    const span = new RecordingSpan(this, name, context?.traceId ?? crypto.randomBytes(8).toString('hex'), this.active, start || undefined);
+    this.active = span;
+    // Flow arrow from the sender's span to this one
+    if (context) this.emit({ ph: 'f', bp: 'e', cat: 'flow', name: 'message', id: context.spanId, ts: nowMicros(), pid: this.pid, tid: 0 });
+    return span;
+  }
+
+  /**
+   * Child of the active span; a no-op outside a sampled trace
+   */
+  span(name: string, start?: number): Span {
+    if (!this.active) return NOOP_SPAN;
+    const span = new RecordingSpan(this, name, this.active.traceId, this.active, start || undefined);
+    this.active = span;
+    return span;
+  }
+
+  /**
+   * Context to put in an outgoing message, or undefined if not tracing
+   */
+  context(): TraceContext | undefined {
+    const span = this.active;
+    if (!span) return undefined;
+    this.emit({ ph: 's', cat: 'flow', name: 'message', id: span.spanId, ts: nowMicros(), pid: this.pid, tid: 0 });
+    return { traceId: span.traceId, spanId: span.spanId };
+  }
+
+  /** @internal called by RecordingSpan.end */
+  finish(span: RecordingSpan, ts: number, dur: number, args?: Record<string, unknown>): void {
+    if (this.active === span) this.active = span.parent;
+    this.emit({
+      ph: 'X', name: span.name, cat: 'relay', ts, dur, pid: this.pid, tid: 0,
+      args: { traceId: span.traceId, ...args }
+    });
+  }
+
+  private emit(event: object): void {
+    this.buffer.push(JSON.stringify(event) + ',\n');
+    if (this.buffer.length >= 1000) this.flush();
+  }
+
+  private flush(): void {
+    if (this.buffer.length === 0) return;
+    const chunk = this.buffer.join('');
+    this.buffer = [];
+
+    try {
+      if (this.bytes + chunk.length > this.maxBytes) this.rotate();
+      appendFileSync(this.file, chunk);
+      this.bytes += chunk.length;
+    } catch (error) {
+      console.error(`Failed to write trace file ${this.file}: ${error instanceof Error ? error.message : String(error)}`);
+    }
+  }
+
+  /**
+   * trace.json -> trace.json.1 -> ... -> trace.json.<maxFiles> (deleted)
+   */
+  private rotate(): void {
+    const oldest = `${this.file}.${this.maxFiles}`;
+    if (existsSync(oldest)) unlinkSync(oldest);
+    for (let i = this.maxFiles - 1; i >= 1; i--) {
+      if (existsSync(`${this.file}.${i}`)) renameSync(`${this.file}.${i}`, `${this.file}.${i + 1}`);
+    }
+    if (existsSync(this.file)) renameSync(this.file, `${this.file}.1`);
+    this.startFile();
+  }
+
+  // JSON array format: the closing bracket is optional for trace viewers
+  private startFile(): void {
+    writeFileSync(this.file, '[\n');
+    this.bytes = 2;
+  }
+}
+
+export const tracer = new Tracer();